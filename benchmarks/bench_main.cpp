@@ -0,0 +1,411 @@
+/**
+ * bench_transpiler: throughput benchmarks for the parser, the analysis
+ * passes and the Rust/Go code generators over synthetic inputs
+ *
+ * Each benchmark repeats its body until --min-time has elapsed and reports
+ * the mean time per iteration plus a throughput figure (MB/s of input or
+ * output, or ns per analyzed function).
+ */
+
+#include "analysis_pass.h"
+#include "codegen.h"
+#include "declaration_index.h"
+#include "incremental_session.h"
+#include "ir_serializer.h"
+#include "parser.h"
+#include "synthetic_input.h"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace hybrid;
+using namespace hybrid::bench;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Per-benchmark iteration state; pause()/resume() keep setup out of the timing
+ */
+class BenchState {
+public:
+    explicit BenchState(double min_seconds) : min_seconds_(min_seconds) {}
+
+    bool keepRunning() {
+        if (iterations_ == 0) {
+            resume();
+        } else if (elapsed_ns_ + running() >= min_seconds_ * 1e9 && iterations_ >= 3) {
+            pause();
+            return false;
+        }
+        ++iterations_;
+        return true;
+    }
+
+    void pause() {
+        elapsed_ns_ += running();
+        paused_ = true;
+    }
+
+    void resume() {
+        start_ = Clock::now();
+        paused_ = false;
+    }
+
+    void setBytesPerIteration(uint64_t bytes) { bytes_ = bytes; }
+    void setItemsPerIteration(uint64_t items, const char* unit) { items_ = items; unit_ = unit; }
+
+    uint64_t iterations() const { return iterations_; }
+    double nanoseconds() const { return elapsed_ns_; }
+    uint64_t bytes() const { return bytes_; }
+    uint64_t items() const { return items_; }
+    const char* unit() const { return unit_; }
+
+private:
+    double min_seconds_;
+    uint64_t iterations_ = 0;
+    double elapsed_ns_ = 0;
+    bool paused_ = true;
+    Clock::time_point start_;
+    uint64_t bytes_ = 0;
+    uint64_t items_ = 0;
+    const char* unit_ = "";
+
+    double running() const {
+        if (paused_) return 0;
+        return static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count());
+    }
+};
+
+/**
+ * Sink that only counts bytes, so codegen is measured without I/O
+ */
+class CountingSink : public OutputSink {
+public:
+    void write(std::string_view text) override { bytes_ += text.size(); }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    uint64_t bytes_ = 0;
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(BenchState&)> run;
+};
+
+/**
+ * Parsed input for one shape, built once and shared by its benchmarks
+ */
+struct Corpus {
+    SyntheticShape shape;
+    std::shared_ptr<const SourceBuffer> buffer;
+    IR ir;
+    size_t functions = 0;
+};
+
+size_t countFunctions(const IR& ir) {
+    size_t count = ir.getFunctions().size();
+    for (const auto& class_decl : ir.getClasses()) {
+        count += class_decl.methods.size();
+    }
+    return count;
+}
+
+void benchParse(BenchState& state, const Corpus& corpus) {
+    state.setBytesPerIteration(corpus.buffer->size());
+    while (state.keepRunning()) {
+        IR ir = Parser::parseBuffer(corpus.buffer);
+        if (ir.getClasses().size() != corpus.shape.classes) {
+            std::cerr << "parse produced " << ir.getClasses().size() << " classes, expected "
+                      << corpus.shape.classes << "\n";
+            std::exit(1);
+        }
+    }
+}
+
+void benchAnalyze(BenchState& state, const Corpus& corpus) {
+    AnalysisPassManager manager = AnalysisPassManager::createDefault();
+    state.setItemsPerIteration(corpus.functions, "function");
+    while (state.keepRunning()) {
+        state.pause();
+        IR ir = corpus.ir;          // Passes annotate in place; start each run clean
+        state.resume();
+        manager.run(ir);
+    }
+}
+
+void benchSerialize(BenchState& state, const Corpus& corpus) {
+    state.setBytesPerIteration(IRSerializer::serialize(corpus.ir).size());
+    while (state.keepRunning()) {
+        IRSerializer::serialize(corpus.ir);
+    }
+}
+
+void benchDeserialize(BenchState& state, const Corpus& corpus) {
+    auto data = SourceBuffer::fromString(IRSerializer::serialize(corpus.ir));
+    state.setBytesPerIteration(data->size());
+    std::string error;
+    while (state.keepRunning()) {
+        IR ir;
+        if (!IRSerializer::deserialize(data, ir, error)) {
+            std::cerr << error << "\n";
+            std::exit(1);
+        }
+    }
+}
+
+void benchIndex(BenchState& state, const Corpus& corpus) {
+    state.setBytesPerIteration(corpus.buffer->size());
+    while (state.keepRunning()) {
+        DeclarationIndex index(corpus.buffer);
+        if (index.getEntries().size() != corpus.shape.classes) {
+            std::cerr << "index found " << index.getEntries().size() << " classes, expected "
+                      << corpus.shape.classes << "\n";
+            std::exit(1);
+        }
+    }
+}
+
+void benchDeclaration(BenchState& state, const Corpus& corpus) {
+    // One class from the middle of the file: cost should not depend on the file size
+    DeclarationIndex index(corpus.buffer);
+    const std::string& name = index.getEntries()[index.getEntries().size() / 2].name;
+    RustCodeGenerator generator;
+    state.setItemsPerIteration(1, "declaration");
+    while (state.keepRunning()) {
+        IR ir = index.parseDeclaration(name);
+        CountingSink sink;
+        generator.generateDeclaration(ir, name, sink);
+    }
+}
+
+void benchIncremental(BenchState& state, const Corpus& corpus) {
+    // Alternate between the corpus and a copy with one class edited in the middle
+    DeclarationIndex index(corpus.buffer);
+    const SourceSpan& span = index.getEntries()[index.getEntries().size() / 2].span;
+    std::string edited(corpus.buffer->text());
+    edited.insert(edited.find('{', span.offset) + 1, "\n    int edited_field;");
+    std::shared_ptr<const SourceBuffer> versions[2] = {
+        corpus.buffer, SourceBuffer::fromString(edited, corpus.buffer->getPath())};
+
+    IncrementalSession session(TargetLanguage::Rust);
+    session.update(versions[0]);
+    state.setItemsPerIteration(1, "edit");
+    size_t version = 0;
+    while (state.keepRunning()) {
+        version ^= 1;
+        session.update(versions[version]);
+        CountingSink sink;
+        session.write(sink);
+    }
+}
+
+template <typename Generator>
+void benchCodegen(BenchState& state, const Corpus& corpus, size_t jobs) {
+    Generator generator;
+    generator.setJobs(jobs);
+    uint64_t bytes = 0;
+    while (state.keepRunning()) {
+        CountingSink sink;
+        generator.generate(corpus.ir, sink);
+        bytes = sink.bytes();
+    }
+    state.setBytesPerIteration(bytes);
+}
+
+bool matchesFilter(const std::string& name, const std::vector<std::string>& filters) {
+    if (filters.empty()) return true;
+    for (const auto& filter : filters) {
+        if (name.find(filter) != std::string::npos) return true;
+    }
+    return false;
+}
+
+void printHeader() {
+    std::cout << std::left << std::setw(28) << "Benchmark" << std::right
+              << std::setw(10) << "Iters"
+              << std::setw(14) << "ms/iter"
+              << std::setw(14) << "Throughput" << "\n";
+}
+
+void printResult(const std::string& name, const BenchState& state) {
+    double per_iteration = state.iterations() ? state.nanoseconds() / state.iterations() : 0;
+
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setw(10) << state.iterations()
+              << std::setw(14) << std::setprecision(3) << per_iteration / 1e6;
+    if (state.bytes() && per_iteration > 0) {
+        std::cout << std::setw(14) << std::setprecision(2)
+                  << (state.bytes() / 1e6) / (per_iteration / 1e9) << " MB/s";
+    } else if (state.items()) {
+        std::cout << std::setw(14) << std::setprecision(1)
+                  << per_iteration / state.items() << " ns/" << state.unit();
+    }
+    std::cout << "\n";
+    std::cout.flags(flags);
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n\n"
+              << "Options:\n"
+              << "  --filter <text>      Run benchmarks whose name contains text (repeatable)\n"
+              << "  --min-time <sec>     Minimum time per benchmark (default: 0.5)\n"
+              << "  --scale <factor>     Multiply the class count of every shape (default: 1.0)\n"
+              << "  --list               List benchmark names and exit\n"
+              << "  --generate <shape>   Print the synthetic input for a shape and exit\n"
+              << "  -h, --help           Show this help message\n\n"
+              << "Shapes:";
+    for (const auto& shape : standardShapes()) {
+        std::cout << " " << shape.name;
+    }
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> filters;
+    double min_time = 0.5;
+    double scale = 1.0;
+    bool list_only = false;
+    std::string generate_shape;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--filter" || arg == "--min-time" || arg == "--scale" || arg == "--generate") &&
+            i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires a value\n";
+            return 1;
+        }
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--filter") {
+            filters.push_back(argv[++i]);
+        } else if (arg == "--min-time") {
+            min_time = std::atof(argv[++i]);
+        } else if (arg == "--scale") {
+            scale = std::atof(argv[++i]);
+        } else if (arg == "--list") {
+            list_only = true;
+        } else if (arg == "--generate") {
+            generate_shape = argv[++i];
+        } else {
+            std::cerr << "Error: Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (scale <= 0) {
+        std::cerr << "Error: --scale must be positive\n";
+        return 1;
+    }
+
+    if (!generate_shape.empty()) {
+        SyntheticShape shape;
+        if (!findShape(generate_shape, scale, shape)) {
+            std::cerr << "Error: Unknown shape: " << generate_shape << "\n";
+            return 1;
+        }
+        std::cout << generateSource(shape);
+        return 0;
+    }
+
+    // Corpora are generated and parsed lazily, only for shapes that are run
+    std::vector<SyntheticShape> shapes = standardShapes(scale);
+    std::map<std::string, std::unique_ptr<Corpus>> corpora;
+    auto corpus = [&](const SyntheticShape& shape) -> const Corpus& {
+        auto& entry = corpora[shape.name];
+        if (!entry) {
+            entry = std::make_unique<Corpus>();
+            entry->shape = shape;
+            entry->buffer = SourceBuffer::fromString(generateSource(shape), shape.name + ".cpp");
+            entry->ir = Parser::parseBuffer(entry->buffer);
+            entry->functions = countFunctions(entry->ir);
+        }
+        return *entry;
+    };
+
+    std::vector<Benchmark> benchmarks;
+    for (const auto& shape : shapes) {
+        benchmarks.push_back({"parse/" + shape.name, [&, shape](BenchState& state) {
+            benchParse(state, corpus(shape));
+        }});
+    }
+    for (const auto& shape : shapes) {
+        benchmarks.push_back({"index/" + shape.name, [&, shape](BenchState& state) {
+            benchIndex(state, corpus(shape));
+        }});
+        benchmarks.push_back({"declaration/" + shape.name, [&, shape](BenchState& state) {
+            benchDeclaration(state, corpus(shape));
+        }});
+        benchmarks.push_back({"incremental/" + shape.name, [&, shape](BenchState& state) {
+            benchIncremental(state, corpus(shape));
+        }});
+    }
+    for (const auto& shape : shapes) {
+        benchmarks.push_back({"analyze/" + shape.name, [&, shape](BenchState& state) {
+            benchAnalyze(state, corpus(shape));
+        }});
+    }
+    for (const auto& shape : shapes) {
+        benchmarks.push_back({"serialize_ir/" + shape.name, [&, shape](BenchState& state) {
+            benchSerialize(state, corpus(shape));
+        }});
+        benchmarks.push_back({"deserialize_ir/" + shape.name, [&, shape](BenchState& state) {
+            benchDeserialize(state, corpus(shape));
+        }});
+    }
+    for (const auto& shape : shapes) {
+        benchmarks.push_back({"codegen_rust/" + shape.name, [&, shape](BenchState& state) {
+            benchCodegen<RustCodeGenerator>(state, corpus(shape), 1);
+        }});
+        benchmarks.push_back({"codegen_go/" + shape.name, [&, shape](BenchState& state) {
+            benchCodegen<GoCodeGenerator>(state, corpus(shape), 1);
+        }});
+    }
+    benchmarks.push_back({"codegen_rust_parallel/wide", [&](BenchState& state) {
+        benchCodegen<RustCodeGenerator>(state, corpus(shapes[0]), 0);
+    }});
+    benchmarks.push_back({"codegen_go_parallel/wide", [&](BenchState& state) {
+        benchCodegen<GoCodeGenerator>(state, corpus(shapes[0]), 0);
+    }});
+
+    if (list_only) {
+        for (const auto& benchmark : benchmarks) {
+            if (matchesFilter(benchmark.name, filters)) {
+                std::cout << benchmark.name << "\n";
+            }
+        }
+        return 0;
+    }
+
+    printHeader();
+    size_t ran = 0;
+    for (const auto& benchmark : benchmarks) {
+        if (!matchesFilter(benchmark.name, filters)) continue;
+
+        BenchState state(min_time);
+        benchmark.run(state);
+        printResult(benchmark.name, state);
+        ++ran;
+    }
+
+    if (ran == 0) {
+        std::cerr << "Error: No benchmark matches the filter\n";
+        return 1;
+    }
+    return 0;
+}
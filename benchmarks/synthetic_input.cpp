@@ -0,0 +1,242 @@
+#include "synthetic_input.h"
+
+namespace hybrid {
+namespace bench {
+
+namespace {
+
+/**
+ * Small deterministic generator (LCG) so inputs are stable across runs
+ */
+class Random {
+public:
+    explicit Random(uint32_t seed) : state_(seed ? seed : 1) {}
+
+    uint32_t next() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return state_ >> 8;
+    }
+
+    size_t pick(size_t count) { return count ? next() % count : 0; }
+
+private:
+    uint32_t state_;
+};
+
+const char* const kScalarTypes[] = {"int", "double", "bool", "std::string", "int64_t", "float"};
+const char* const kReturnTypes[] = {"int", "double", "void", "bool", "std::string"};
+
+std::string scalarType(Random& random) {
+    return kScalarTypes[random.pick(sizeof(kScalarTypes) / sizeof(kScalarTypes[0]))];
+}
+
+std::string nestedType(Random& random, size_t depth) {
+    if (depth == 0) {
+        return scalarType(random);
+    }
+    std::string inner = nestedType(random, depth - 1);
+    switch (random.pick(4)) {
+        case 0: return "std::vector<" + inner + ">";
+        case 1: return "std::map<std::string, " + inner + ">";
+        case 2: return "std::unordered_map<int, " + inner + ">";
+        default: return "std::pair<int, " + inner + ">";
+    }
+}
+
+std::string stlType(Random& random, size_t class_index) {
+    switch (random.pick(7)) {
+        case 0: return "std::vector<int>";
+        case 1: return "std::map<std::string, double>";
+        case 2: return "std::unique_ptr<Node" + std::to_string(class_index) + ">";
+        case 3: return "std::shared_ptr<std::vector<std::string>>";
+        case 4: return "std::set<int>";
+        case 5: return "std::unordered_map<std::string, std::vector<int>>";
+        default: return "std::string";
+    }
+}
+
+void appendPlainStatement(std::string& out, Random& random, size_t k) {
+    std::string n = std::to_string(k);
+    switch (random.pick(4)) {
+        case 0:
+            out += "        int v" + n + " = a * " + std::to_string(random.pick(97) + 1) + " + " + n + ";\n";
+            break;
+        case 1:
+            out += "        if (a > " + n + ") { a -= " + n + "; } else { a += 1; }\n";
+            break;
+        case 2:
+            out += "        for (int i = 0; i < " + std::to_string(random.pick(16) + 1) +
+                   "; ++i) { a += i * " + n + "; }\n";
+            break;
+        default:
+            out += "        a = (a << 1) ^ " + n + ";\n";
+            break;
+    }
+}
+
+void appendConcurrentStatement(std::string& out, Random& random, size_t k) {
+    std::string n = std::to_string(k);
+    switch (random.pick(8)) {
+        case 0:
+            out += "        std::lock_guard<std::mutex> guard" + n + "(mtx_);\n";
+            break;
+        case 1:
+            out += "        std::thread worker" + n + "(process, a, " + n + ");\n"
+                   "        worker" + n + ".join();\n";
+            break;
+        case 2:
+            out += "        counter_.fetch_add(" + n + ");\n";
+            break;
+        case 3:
+            out += "        cv_.notify_one();\n";
+            break;
+        case 4:
+            out += "        auto task" + n + " = std::async(std::launch::async, compute, " + n + ");\n";
+            break;
+        case 5:
+            out += "        co_await schedule(" + n + ");\n";
+            break;
+        case 6:
+            out += "        try { risky(" + n + "); } catch (const std::exception& e) { log(e.what()); }\n";
+            break;
+        default:
+            out += "        if (a < 0) { throw std::runtime_error(\"negative " + n + "\"); }\n";
+            break;
+    }
+}
+
+} // namespace
+
+std::vector<SyntheticShape> standardShapes(double scale) {
+    auto scaled = [scale](size_t count) {
+        size_t value = static_cast<size_t>(static_cast<double>(count) * scale);
+        return value > 0 ? value : 1;
+    };
+
+    std::vector<SyntheticShape> shapes(5);
+
+    shapes[0].name = "wide";
+    shapes[0].classes = scaled(1000);
+    shapes[0].methods_per_class = 20;
+
+    shapes[1].name = "templates";
+    shapes[1].classes = scaled(500);
+    shapes[1].methods_per_class = 4;
+    shapes[1].fields_per_class = 8;
+    shapes[1].template_depth = 6;
+
+    shapes[2].name = "stl";
+    shapes[2].classes = scaled(500);
+    shapes[2].methods_per_class = 6;
+    shapes[2].fields_per_class = 12;
+    shapes[2].stl_fields = true;
+
+    shapes[3].name = "bodies";
+    shapes[3].classes = scaled(200);
+    shapes[3].methods_per_class = 10;
+    shapes[3].body_statements = 40;
+    shapes[3].concurrency = true;
+
+    shapes[4].name = "comments";
+    shapes[4].classes = scaled(300);
+    shapes[4].methods_per_class = 10;
+    shapes[4].doc_lines = 8;
+
+    return shapes;
+}
+
+bool findShape(const std::string& name, double scale, SyntheticShape& shape) {
+    for (auto& candidate : standardShapes(scale)) {
+        if (candidate.name == name) {
+            shape = std::move(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string generateSource(const SyntheticShape& shape, uint32_t seed) {
+    Random random(seed);
+    std::string out;
+    out.reserve(shape.classes * (shape.methods_per_class * (64 + shape.body_statements * 48) + 256));
+
+    out += "// Synthetic input: " + shape.name + "\n";
+    out += "#include <map>\n#include <memory>\n#include <string>\n#include <vector>\n\n";
+
+    for (size_t c = 0; c < shape.classes; ++c) {
+        std::string class_name = "Node" + std::to_string(c);
+        out += "class " + class_name + " {\n";
+        out += "private:\n";
+
+        for (size_t f = 0; f < shape.fields_per_class; ++f) {
+            std::string type;
+            if (shape.template_depth > 0) {
+                type = nestedType(random, 1 + random.pick(shape.template_depth));
+            } else if (shape.stl_fields) {
+                type = stlType(random, c);
+            } else {
+                type = scalarType(random);
+            }
+            out += "    " + type + " field" + std::to_string(f) + "_;\n";
+        }
+        if (shape.concurrency) {
+            out += "    std::mutex mtx_;\n";
+            out += "    std::atomic<int> counter_;\n";
+            out += "    std::condition_variable cv_;\n";
+        }
+
+        out += "\npublic:\n";
+        out += "    " + class_name + "() {}\n";
+
+        for (size_t m = 0; m < shape.methods_per_class; ++m) {
+            std::string return_type = kReturnTypes[random.pick(sizeof(kReturnTypes) / sizeof(kReturnTypes[0]))];
+            if (shape.doc_lines > 0) {
+                out += "    /**\n";
+                for (size_t d = 0; d < shape.doc_lines; ++d) {
+                    out += "     * Step " + std::to_string(d) + " of method" + std::to_string(m) +
+                           ": updates the running value \"a\" and keeps field invariants intact.\n";
+                }
+                out += "     */\n";
+            }
+            out += "    " + return_type + " method" + std::to_string(m) + "(int a";
+            size_t extra = random.pick(3);
+            for (size_t p = 0; p < extra; ++p) {
+                out += ", " + scalarType(random) + " p" + std::to_string(p);
+            }
+            out += ")";
+            if (random.pick(3) == 0) {
+                out += " const";
+            }
+            out += " {\n";
+
+            for (size_t s = 0; s < shape.body_statements; ++s) {
+                if (s % 8 == 7) {
+                    out += "        // step " + std::to_string(s) + "\n";
+                }
+                if (shape.concurrency && random.pick(2) == 0) {
+                    appendConcurrentStatement(out, random, s);
+                } else {
+                    appendPlainStatement(out, random, s);
+                }
+            }
+
+            if (return_type == "void") {
+                // Nothing to return
+            } else if (return_type == "std::string") {
+                out += "        return std::to_string(a);\n";
+            } else if (return_type == "bool") {
+                out += "        return a > 0;\n";
+            } else {
+                out += "        return a;\n";
+            }
+            out += "    }\n";
+        }
+
+        out += "};\n\n";
+    }
+
+    return out;
+}
+
+} // namespace bench
+} // namespace hybrid
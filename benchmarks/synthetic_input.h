@@ -0,0 +1,50 @@
+#ifndef HYBRID_BENCH_SYNTHETIC_INPUT_H
+#define HYBRID_BENCH_SYNTHETIC_INPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hybrid {
+namespace bench {
+
+/**
+ * Shape of a generated C++ translation unit
+ */
+struct SyntheticShape {
+    std::string name;
+    size_t classes = 100;
+    size_t methods_per_class = 10;
+    size_t fields_per_class = 4;
+    size_t template_depth = 0;      // Nesting depth of container field types (0 = scalars)
+    bool stl_fields = false;        // Fields use std:: containers and smart pointers
+    size_t body_statements = 2;     // Statements per method body
+    bool concurrency = false;       // Bodies use threads, locks, atomics, coroutines, try/catch
+    size_t doc_lines = 0;           // Lines of /** */ documentation before each method
+};
+
+/**
+ * Built-in shapes: "wide" (N classes x M methods), "templates" (deep
+ * template nesting), "stl" (heavy STL fields), "bodies" (long bodies
+ * with threads and coroutines) and "comments" (documented headers, mostly
+ * comment text). scale multiplies the class count.
+ */
+std::vector<SyntheticShape> standardShapes(double scale = 1.0);
+
+/**
+ * Find a standard shape by name
+ * @return false if there is no such shape
+ */
+bool findShape(const std::string& name, double scale, SyntheticShape& shape);
+
+/**
+ * Generate deterministic C++ source for a shape; the same shape and seed
+ * always produce the same text
+ */
+std::string generateSource(const SyntheticShape& shape, uint32_t seed = 1);
+
+} // namespace bench
+} // namespace hybrid
+
+#endif // HYBRID_BENCH_SYNTHETIC_INPUT_H
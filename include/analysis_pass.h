@@ -0,0 +1,189 @@
+#ifndef HYBRID_ANALYSIS_PASS_H
+#define HYBRID_ANALYSIS_PASS_H
+
+#include "ir.h"
+#include "lexer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Tokenized view of one function body, shared by every analysis pass
+ *
+ * The body is lexed once (comments and preprocessor lines dropped) and
+ * bracket pairs are matched up front, so passes can walk patterns like
+ * "std :: thread name ( ... )" by index instead of re-scanning text.
+ */
+class BodyScan {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit BodyScan(const SourceText& body);
+
+    /** Number of tokens, not counting the trailing EndOfFile */
+    size_t size() const { return tokens_.size() - 1; }
+
+    /** Token at index, or the EndOfFile token when out of range */
+    const Token& at(size_t index) const {
+        return index < tokens_.size() ? tokens_[index] : tokens_.back();
+    }
+
+    /** Index of the bracket matching ( [ { or ) ] } at index, npos if unbalanced */
+    size_t matching(size_t index) const {
+        return index < match_.size() ? match_[index] : npos;
+    }
+
+    /**
+     * Index of the '>' closing a template argument list opened at index.
+     * Stops (returning npos) at ';', '{' or '}' so comparisons cannot run away.
+     */
+    size_t matchingAngle(size_t index) const;
+
+    /**
+     * Operator spelled by the adjacent punctuation starting at index
+     * ("++", "+=", "<<=", "=="), which the lexer leaves as single characters.
+     * Its size is the number of tokens it spans; empty if index is not punctuation.
+     */
+    std::string_view punctuator(size_t index) const;
+
+    /** True if the token at index is preceded by "qualifier ::" */
+    bool isQualified(size_t index, std::string_view qualifier) const {
+        return index >= 2 && at(index - 1).isPunct("::") && at(index - 2).isIdentifier(qualifier);
+    }
+
+    /** Source text from the start of token first to the end of token last */
+    std::string_view text(size_t first, size_t last) const;
+
+    /** Raw text strictly between two tokens (e.g. the inside of a bracket pair) */
+    std::string_view between(size_t open, size_t close) const;
+
+    /**
+     * Same as between(), but as SourceText that keeps pointing into the
+     * original source buffer when the body itself is a view
+     */
+    SourceText sliceBetween(size_t open, size_t close) const;
+
+    /**
+     * Split the tokens strictly between a bracket pair at top-level commas
+     * @return Trimmed text of each argument
+     */
+    std::vector<std::string> splitArguments(size_t open, size_t close) const;
+
+    /** 1-based line of a token; absolute in the source buffer when the body is a view */
+    uint32_t line(size_t index) const;
+
+private:
+    const SourceText& body_;
+    std::string_view text_;
+    std::vector<Token> tokens_;
+    std::vector<size_t> match_;
+};
+
+/**
+ * A function-body analysis driven by the AnalysisPassManager
+ *
+ * A pass declares the identifiers (keywords included) it cares about; the
+ * manager scans each body once and calls onToken() for every occurrence.
+ * Per-function state may be kept between beginFunction() and endFunction(),
+ * so a pass instance must not be shared between threads.
+ */
+class AnalysisPass {
+public:
+    virtual ~AnalysisPass() = default;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * Identifier spellings that trigger onToken()
+     * The views must refer to storage that outlives the pass (string literals).
+     */
+    virtual std::vector<std::string_view> interests() const = 0;
+
+    /**
+     * Identifiers of one function that also trigger onToken(), such as its
+     * parameter names; called after beginFunction(). The views must stay
+     * valid until endFunction().
+     */
+    virtual void functionInterests(const Function& func, std::vector<std::string_view>& interests) const {
+        (void)func;
+        (void)interests;
+    }
+
+    virtual void beginFunction(Function& func) { (void)func; }
+    virtual void onToken(const BodyScan& scan, size_t index, Function& func) = 0;
+    virtual void endFunction(Function& func) { (void)func; }
+
+    /** Class-level facts that need no body scan (e.g. member types) */
+    virtual void analyzeClass(ClassDecl& class_decl) { (void)class_decl; }
+};
+
+/**
+ * Time spent in one pass across every function it was run on (measured
+ * only while the Profiler is enabled; dispatches are always counted)
+ */
+struct PassTiming {
+    std::string name;
+    uint64_t nanoseconds = 0;
+    size_t dispatches = 0;      // onToken() calls
+};
+
+/**
+ * Runs a set of analysis passes over functions with a single scan per body
+ *
+ * Interests of all passes are merged into one identifier table, so adding a
+ * pass adds work only where its identifiers actually occur.
+ */
+class AnalysisPassManager {
+public:
+    /**
+     * Manager with the thread, async, exception and ownership passes registered
+     */
+    static AnalysisPassManager createDefault();
+
+    void addPass(std::unique_ptr<AnalysisPass> pass);
+
+    /**
+     * Analyze every free function, class and method in the IR
+     */
+    void run(IR& ir);
+
+    void runOnFunction(Function& func);
+    void runOnClass(ClassDecl& class_decl);
+
+    /**
+     * Run a single pass over one function without a manager (no timing)
+     */
+    static void runPass(AnalysisPass& pass, Function& func);
+
+    size_t getPassCount() const { return passes_.size(); }
+    const std::vector<PassTiming>& getTimings() const { return timings_; }
+
+    /** Time spent lexing bodies, shared by all passes (while profiling) */
+    uint64_t getScanNanoseconds() const { return scan_nanoseconds_; }
+    size_t getFunctionCount() const { return functions_analyzed_; }
+
+    void resetTimings();
+
+private:
+    std::vector<std::unique_ptr<AnalysisPass>> passes_;
+    std::unordered_map<std::string_view, std::vector<size_t>> interests_;
+    std::vector<std::pair<std::string_view, size_t>> function_interests_;  // Of the function being run, by pass
+    std::vector<PassTiming> timings_;
+    uint64_t scan_nanoseconds_ = 0;
+    size_t functions_analyzed_ = 0;
+};
+
+// Passes defined alongside their analyzers
+std::unique_ptr<AnalysisPass> createThreadAnalysisPass();
+std::unique_ptr<AnalysisPass> createAsyncAnalysisPass();
+std::unique_ptr<AnalysisPass> createExceptionAnalysisPass();
+std::unique_ptr<AnalysisPass> createOwnershipAnalysisPass();
+
+} // namespace hybrid
+
+#endif // HYBRID_ANALYSIS_PASS_H
@@ -0,0 +1,63 @@
+#ifndef HYBRID_BUILD_CACHE_H
+#define HYBRID_BUILD_CACHE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace hybrid {
+
+struct TranspilerOptions;
+
+/**
+ * Content-addressed on-disk cache of generated code
+ *
+ * Entries are keyed by a hash of the input source, every option that
+ * affects code generation and the tool version, so a hit can skip parsing
+ * and code generation entirely. Entries are written to a temporary file
+ * and renamed into place, which makes concurrent batch workers safe.
+ */
+class BuildCache {
+public:
+    explicit BuildCache(std::string cache_dir);
+
+    /**
+     * Compute the cache key for a source buffer under the given options
+     * @param dependencies Hash of the headers the output also depends on
+     *        (HeaderCache::dependencyHash, with resolve_includes)
+     */
+    static std::string computeKey(std::string_view source, const TranspilerOptions& options,
+                                  std::string_view dependencies = {});
+
+    /**
+     * Load a cached output
+     * @return true on a cache hit
+     */
+    bool lookup(const std::string& key, std::string& output) const;
+
+    /**
+     * Store generated output; failures are ignored (the cache is advisory)
+     */
+    void store(const std::string& key, const std::string& output) const;
+
+    const std::string& getDirectory() const { return cache_dir_; }
+
+    /**
+     * 64-bit FNV-1a of data, continuing from seed
+     */
+    static uint64_t hashBytes(std::string_view data, uint64_t seed);
+
+    /**
+     * 128-bit FNV-1a of data as 32 hex digits (content identity, not a cache key)
+     */
+    static std::string contentHash(std::string_view data);
+
+private:
+    std::string cache_dir_;
+
+    std::string entryPath(const std::string& key) const;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_BUILD_CACHE_H
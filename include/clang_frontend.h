@@ -0,0 +1,78 @@
+#ifndef HYBRID_CLANG_FRONTEND_H
+#define HYBRID_CLANG_FRONTEND_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hybrid {
+
+class IR;
+class SourceBuffer;
+
+/**
+ * Settings of the Clang front end
+ */
+struct ClangFrontEndOptions {
+    std::string compile_commands_dir;       // Directory of compile_commands.json (empty = search up from each input)
+    std::vector<std::string> extra_args;    // Appended to every compile command
+    bool share_preambles = false;           // Precompile #include blocks that several inputs start with
+};
+
+/**
+ * Builds the IR from Clang's AST (--frontend clang)
+ *
+ * Each input is compiled with its command from the compilation database
+ * (loaded once per database and shared by every file), or with
+ * "-std=c++17" and the extra arguments when it has none. Only what the
+ * IR keeps is built: function bodies outside the main file are skipped,
+ * and bodies, initializers and default arguments in the main file become
+ * spans into its source buffer, exactly as with the built-in parser.
+ *
+ * With share_preambles (batches), the leading #include block of each
+ * input is compiled once into a precompiled header per distinct block and
+ * compile command, and every input starting with the same block loads it
+ * instead of parsing its headers again.
+ *
+ * parse() may be called from several threads at once. Builds without
+ * Clang (HYBRID_HAVE_CLANG unset) keep the interface; parse() then fails.
+ */
+class ClangFrontEnd {
+public:
+    explicit ClangFrontEnd(ClangFrontEndOptions options = {});
+    ~ClangFrontEnd();
+
+    ClangFrontEnd(const ClangFrontEnd&) = delete;
+    ClangFrontEnd& operator=(const ClangFrontEnd&) = delete;
+
+    /**
+     * Whether this build of the transpiler links Clang
+     */
+    static bool isAvailable();
+
+    /**
+     * Parse a source into 'ir', replacing its contents
+     * @return false with error set to the first compiler error
+     */
+    bool parse(const std::shared_ptr<const SourceBuffer>& source, IR& ir, std::string& error);
+
+    /**
+     * Toggle preamble sharing; call between batches, not during parse()
+     */
+    void setSharePreambles(bool share) { options_.share_preambles = share; }
+
+    /**
+     * Precompiled preambles built so far
+     */
+    size_t getPreambleCount() const;
+
+private:
+    struct State;
+
+    ClangFrontEndOptions options_;
+    std::unique_ptr<State> state_;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_CLANG_FRONTEND_H
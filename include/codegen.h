@@ -2,11 +2,59 @@
 #define HYBRID_CODEGEN_H
 
 #include "ir.h"
+#include "output_sink.h"
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace hybrid {
 
+/**
+ * Target spelling of each canonical type node a generator has converted
+ *
+ * Interned types are shared, so a type repeated across a class's
+ * signatures is converted once. Entries keep their node alive, so a
+ * cached address is never reused by another type. Copies start empty:
+ * clones working in parallel fill their own.
+ */
+class TypeSpellingCache {
+public:
+    TypeSpellingCache() = default;
+    TypeSpellingCache(const TypeSpellingCache&) {}
+    TypeSpellingCache& operator=(const TypeSpellingCache&) { clear(); return *this; }
+
+    /**
+     * Cached spelling of a type, or nullptr (counted as a miss)
+     */
+    const std::string* find(const Type* type);
+
+    const std::string& insert(const std::shared_ptr<Type>& type, std::string spelling);
+    void clear();
+
+    size_t size() const { return entries_.size(); }
+    size_t getHits() const { return hits_; }
+    size_t getMisses() const { return misses_; }
+
+private:
+    struct Entry {
+        std::shared_ptr<Type> type;
+        std::string spelling;
+    };
+
+    // Bounds a long-lived generator fed many unrelated IRs
+    static constexpr size_t kMaxEntries = 1 << 16;
+
+    std::unordered_map<const Type*, Entry> entries_;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
 /**
  * Base class for code generators
  */
@@ -19,24 +67,334 @@ public:
      * @param ir The intermediate representation
      * @return Generated source code as string
      */
-    virtual std::string generate(const IR& ir) = 0;
+    std::string generate(const IR& ir);
+
+    /**
+     * Generate code from IR, streaming it into a sink as it is produced
+     * @param ir The intermediate representation
+     * @param sink Destination; flushed before returning
+     * @return false if the sink reported a write failure
+     */
+    bool generate(const IR& ir, OutputSink& sink);
+
+    /**
+     * Generate a single class of the IR, without the file header
+     *
+     * The rest of the IR is only consulted for lookups (base-class virtual
+     * methods), so it may hold just the class and its bases.
+     * @return false if the IR has no such class or the sink failed
+     */
+    bool generateDeclaration(const IR& ir, const std::string& name, OutputSink& sink);
+
+    /**
+     * Same, for a class that is already resolved (e.g. one of several
+     * classes sharing a name)
+     */
+    bool generateDeclaration(const IR& ir, const ClassDecl& class_decl, OutputSink& sink);
+
+    /**
+     * Generate what generate() writes before the first declaration (file
+     * header, imports) and after the last one (global variables). With
+     * generateDeclaration() for each class in between, the result is
+     * byte-identical to generate(). The template plan made by the prologue
+     * (see TemplatePlan) serves the declarations until the epilogue, so
+     * do not change the IR in between.
+     */
+    bool generatePrologue(const IR& ir, OutputSink& sink);
+    bool generateEpilogue(const IR& ir, OutputSink& sink);
+
+    /**
+     * Benchmark harness for the code generate() writes: one benchmark per
+     * public method of each class that can be instantiated, named
+     * <Class>_<method> as in generateCppBenchmarks(), so the three compare
+     * one to one. Criterion functions for Rust, testing.B for Go.
+     * @param module File name of the generated code, next to which the harness goes
+     * @return Empty if there is nothing to benchmark
+     */
+    std::string generateBenchmarks(const IR& ir, const std::string& module);
+
+    /**
+     * Google Benchmark stubs for the original C++, with the same names
+     * @param header Path to include for the classes, relative to the stubs
+     * @return Empty if there is nothing to benchmark
+     */
+    static std::string generateCppBenchmarks(const IR& ir, const std::string& header);
+
+    /**
+     * Threads used to generate the declarations of one IR
+     * (1 = serial, 0 = hardware concurrency). Output is identical either way.
+     */
+    void setJobs(size_t jobs) { jobs_ = jobs; }
+    size_t getJobs() const { return jobs_; }
+
+    /**
+     * TranspilerOptions::optimization_level. Levels 0 and 1 emit the
+     * readable lowering; 2 and 3 may trade it for faster target code.
+     */
+    void setOptimizationLevel(int level) { optimization_level_ = level; }
+    int getOptimizationLevel() const { return optimization_level_; }
+
+    /**
+     * TranspilerOptions::monomorphization_budget: a class template with more
+     * distinct instantiations than this in the IR is emitted once with its
+     * type parameters erased (trait objects, interfaces) where its bounds
+     * allow. 0 = always generic.
+     */
+    void setMonomorphizationBudget(size_t budget) { monomorphization_budget_ = budget; }
+    size_t getMonomorphizationBudget() const { return monomorphization_budget_; }
+
+    /**
+     * Canonical spelling of a C++ type or template argument, with spacing and
+     * integer spellings folded ("std::uint32_t" and "unsigned" are "unsigned int"),
+     * optionally substituting identifiers
+     */
+    static std::string canonicalSpelling(std::string_view spelling,
+                                         const std::unordered_map<std::string, std::string>* substitutions = nullptr);
+
+    const TypeSpellingCache& getTypeSpellings() const { return type_spellings_; }
+
+    /**
+     * Drop cached spellings (and the types they pin) of IRs no longer in use
+     */
+    void clearTypeSpellings() { type_spellings_.clear(); }
 
 protected:
-    std::stringstream output_;
+    OutputSink* sink_ = nullptr;    // Destination of writeLine/writeIndent
     int indent_level_ = 0;
+    const IR* ir_ = nullptr;        // IR being generated, for symbol lookups
+    TypeSpellingCache type_spellings_;  // Memoizes convertType()
+    int optimization_level_ = 0;
+
+    /**
+     * Emit the whole translation unit through writeLine()
+     */
+    virtual void emit(const IR& ir) = 0;
+
+    /**
+     * Emit one class exactly as emit() would inside a whole file
+     */
+    virtual void emitDeclaration(const ClassDecl& class_decl) = 0;
+
+    /**
+     * Emit the parts of emit() around the declarations
+     */
+    virtual void emitPrologue(const IR& ir) = 0;
+    virtual void emitEpilogue(const IR& ir) = 0;
+
+    /**
+     * Generator with the same configuration, used by parallel workers
+     */
+    virtual std::unique_ptr<CodeGenerator> clone() const = 0;
+
+    /**
+     * A method generateBenchmarks() times, under its shared benchmark name
+     */
+    struct BenchmarkedMethod {
+        const ClassDecl* owner;
+        const Function* method;
+        std::string name;               // <Class>_<method>, numbered from the second overload
+    };
+
+    /**
+     * Public, non-template, synchronous methods of classes that can be
+     * instantiated, skipping constructors, destructors and operators
+     */
+    static std::vector<BenchmarkedMethod> benchmarkedMethods(const IR& ir);
+
+    /**
+     * Constructor the harnesses build their instance with: the first one,
+     * as the generators only translate that one (nullptr = none declared)
+     */
+    static const Function* benchmarkConstructor(const ClassDecl& class_decl);
+
+    /**
+     * Emit the harness of generateBenchmarks(), for a non-empty list
+     */
+    virtual void emitBenchmarks(const std::vector<BenchmarkedMethod>& methods, const std::string& module) = 0;
+
+    /**
+     * Render items [0, count) in order. With more than one job, runs of
+     * items are rendered concurrently by clones of this generator into
+     * separate fragments (each starting at the current indent level) that
+     * are then written in order. render() must therefore write only
+     * through the generator it is given and leave its indent unchanged.
+     */
+    void emitEach(size_t count, const std::function<void(CodeGenerator&, size_t)>& render);
+
+    /**
+     * How the class being generated is lowered at optimization level 2 and
+     * up, planned from the analysis results before its fields are emitted
+     */
+    struct ClassLowering {
+        std::vector<std::string> atomic_counters;   // Integer fields only ever updated under counter_mutexes
+        std::vector<std::string> counter_mutexes;   // Mutexes that guarded nothing else: dropped
+        std::vector<std::string> shared_mutexes;    // std::shared_mutex (already reader-writer)
+    };
+    ClassLowering lowering_;
+
+    /**
+     * Fill lowering_ for a class (left empty below level 2)
+     */
+    void planClassLowering(const ClassDecl& class_decl);
+
+    /**
+     * How the class templates of an IR are emitted, planned over the whole
+     * IR before any of it is generated
+     *
+     * Explicit specializations are keyed by their canonical argument list
+     * (spacing and integer spellings folded: "unsigned int", "uint32_t"
+     * and "unsigned" are one instantiation). One repeating an earlier
+     * specialization, or the primary template with its arguments
+     * substituted, is not emitted: uses resolve to the first one or to the
+     * shared generic. The others are emitted under a monomorphized name.
+     */
+    struct TemplatePlan {
+        // Operations the methods of a template apply to values of a type parameter
+        enum Bound : unsigned {
+            Equatable = 1 << 0,     // == !=
+            Ordered = 1 << 1,       // < > <= >=
+            Addable = 1 << 2,
+            Subtractable = 1 << 3,
+            Multipliable = 1 << 4,
+            Divisible = 1 << 5,
+            Printable = 1 << 6,     // Streamed with << or passed to std::to_string
+            Arithmetic = Addable | Subtractable | Multipliable | Divisible
+        };
+
+        struct Template {
+            const ClassDecl* primary = nullptr;
+            std::vector<unsigned> bounds;       // Per template parameter
+            size_t instantiations = 0;          // Distinct argument lists used in the IR
+            bool over_budget = false;
+            bool erased = false;                // Over budget and erasable: emitted once, type-erased
+        };
+
+        std::unordered_map<std::string, Template> templates;                   // By template name
+        std::unordered_map<const ClassDecl*, std::string> specializations;     // Emitted -> canonical arguments
+        std::unordered_map<std::string, const ClassDecl*> specialized;         // "Name<canonical arguments>"
+        std::unordered_set<const ClassDecl*> duplicates;                       // Not emitted
+    };
+    std::shared_ptr<const TemplatePlan> templates_;     // Shared with clones; null if the IR has no templates
+
+    /**
+     * Template parameters visible while a class or method is generated,
+     * each with the spelling its uses get (its name, or the erased type)
+     */
+    std::vector<std::pair<std::string, std::string>> template_scope_;
+
+    /**
+     * Restores template_scope_ when the class or method it was opened for is done
+     */
+    class TemplateScope {
+    public:
+        explicit TemplateScope(CodeGenerator& gen) : gen_(gen), mark_(gen.template_scope_.size()) {}
+        ~TemplateScope() { gen_.template_scope_.resize(mark_); }
+        TemplateScope(const TemplateScope&) = delete;
+        TemplateScope& operator=(const TemplateScope&) = delete;
+
+    private:
+        CodeGenerator& gen_;
+        size_t mark_;
+    };
+
+    /**
+     * Fill templates_ for an IR (called by every generate entry point)
+     */
+    void planTemplates(const IR& ir);
+
+    /**
+     * Bounds a type-erased parameter may carry in this target
+     */
+    virtual unsigned erasableBounds() const { return TemplatePlan::Printable; }
+
+    /**
+     * Whether the type spellings of this IR depend on the template plan or
+     * scope, so they must not come from (or go into) the spelling cache
+     */
+    bool spellsTemplates() const { return templates_ || !template_scope_.empty(); }
+
+    /** Spelling of a type parameter in scope, or nullptr */
+    const std::string* templateParameterSpelling(std::string_view name) const;
+
+    /** Plan of the template a class is the primary of, or nullptr */
+    const TemplatePlan::Template* templatePlan(const ClassDecl& class_decl) const;
+
+    /** Whether a class is emitted (false for a specialization made redundant) */
+    bool isEmitted(const ClassDecl& class_decl) const;
+
+    /** Whether a class is emitted with type parameters (a template not erased) */
+    bool emitsGeneric(const ClassDecl& class_decl) const;
+
+    /** Canonical arguments of an emitted explicit specialization, or nullptr */
+    const std::string* specializationArguments(const ClassDecl& class_decl) const;
+
+    /**
+     * A C++ class spelling split for the generators: "ns::Box<int, T>" is
+     * Box with arguments {"int", "T"} (canonical), and names the template
+     * or specialization it resolves to
+     */
+    struct ClassSpelling {
+        std::string name;                       // As written, without arguments
+        std::vector<std::string> arguments;     // Canonical
+        const TemplatePlan::Template* plan = nullptr;   // If name is a planned template
+        const ClassDecl* specialization = nullptr;      // If the arguments select an emitted one
+    };
+    ClassSpelling resolveClassSpelling(const std::string& spelling) const;
+
+    /**
+     * Target atomic type for an integer counter field, or empty if the
+     * target has none of that width (the mutex is then kept)
+     */
+    virtual std::string atomicCounterType(const std::shared_ptr<Type>& type) {
+        (void)type;
+        return "";
+    }
+
+    /**
+     * The method's guarded update when its counter was made atomic, or nullptr
+     */
+    const GuardedUpdate* lockFreeUpdate(const Function& func) const;
+
+    /**
+     * Whether a method is virtual in its class, either declared so or
+     * overriding a virtual method of a base class known to the IR
+     */
+    bool isVirtualMethod(const Function& method, const ClassDecl& owner) const;
+
+    /**
+     * Whether a function returns a value; constructors have no return type
+     */
+    static bool returnsValue(const Function& func) {
+        return func.return_type && func.return_type->kind != TypeKind::Void;
+    }
 
     void indent() { indent_level_++; }
     void dedent() { indent_level_--; }
-    void writeLine(const std::string& line);
+    void writeLine(std::string_view line);
     void writeIndent();
+
+private:
+    size_t jobs_ = 1;
+    size_t monomorphization_budget_ = 0;
+    const IR* planned_ir_ = nullptr;    // Set from generatePrologue() to generateEpilogue()
+
+    // Below this many items the fragment bookkeeping costs more than it saves
+    static constexpr size_t kMinParallelItems = 64;
+    static constexpr size_t kMinItemsPerTask = 16;
+    static constexpr size_t kTasksPerThread = 4;
 };
 
 /**
  * Rust code generator
  */
 class RustCodeGenerator : public CodeGenerator {
-public:
-    std::string generate(const IR& ir) override;
+protected:
+    void emit(const IR& ir) override;
+    void emitDeclaration(const ClassDecl& class_decl) override;
+    void emitPrologue(const IR& ir) override;
+    void emitEpilogue(const IR& ir) override;
+    std::unique_ptr<CodeGenerator> clone() const override;
+    void emitBenchmarks(const std::vector<BenchmarkedMethod>& methods, const std::string& module) override;
 
 private:
     void generateClass(const ClassDecl& class_decl);
@@ -50,7 +408,7 @@ private:
 
     // Threading code generation
     void generateThreadingCode(const Function& func);
-    void generateThreadCreation(const ThreadInfo& thread);
+    void generateThreadCreation(const ThreadInfo& thread, bool scoped);
     void generateLockScope(const LockInfo& lock);
     void generateAtomicOperations(const AtomicInfo& atomic);
     void generateConditionVariable(const ConditionVariableInfo& cv);
@@ -63,20 +421,38 @@ private:
     void generateFuture(const FutureInfo& future);
 
     // Template code generation
-    std::string convertTemplateParametersToRust(const std::vector<TemplateParameter>& params);
+    std::string convertTemplateParametersToRust(const std::vector<TemplateParameter>& params,
+                                                const std::vector<unsigned>* bounds = nullptr);
     std::string convertTemplateArgsToRust(const std::vector<TemplateParameter>& params);
+    std::string className(const ClassDecl& class_decl);
+    std::string convertClassSpelling(const std::string& spelling);
+    std::string convertTemplateArgument(const std::string& argument);
+    std::string mangleArgument(const std::string& argument);
 
     std::string convertType(const std::shared_ptr<Type>& type);
+    std::string convertTypeUncached(const std::shared_ptr<Type>& type);
     std::string convertSmartPointer(const std::shared_ptr<Type>& type);
     std::string sanitizeName(const std::string& name);
+
+    // Performance lowering (optimization level 2 and up)
+    std::string convertParameterType(const Function& func, const Parameter& param);
+    std::string atomicCounterType(const std::shared_ptr<Type>& type) override;
+    void generateLockFreeUpdate(const GuardedUpdate& update);
+    void generateCapacityHints(const Function& func);
 };
 
 /**
  * Go code generator
  */
 class GoCodeGenerator : public CodeGenerator {
-public:
-    std::string generate(const IR& ir) override;
+protected:
+    void emit(const IR& ir) override;
+    void emitDeclaration(const ClassDecl& class_decl) override;
+    void emitPrologue(const IR& ir) override;
+    void emitEpilogue(const IR& ir) override;
+    std::unique_ptr<CodeGenerator> clone() const override;
+    void emitBenchmarks(const std::vector<BenchmarkedMethod>& methods, const std::string& module) override;
+    unsigned erasableBounds() const override;
 
 private:
     void generateClass(const ClassDecl& class_decl);
@@ -99,11 +475,34 @@ private:
     void generateAsyncFunction(const Function& func);
     void generateCoroutineAsGoroutine(const Function& func);
     void generateChannelOperation(const AsyncOperation& op);
-    void generateAsyncTask(const AsyncTaskInfo& task);
+    void generateAsyncTask(const AsyncTaskInfo& task, bool wait);
 
     std::string convertType(const std::shared_ptr<Type>& type);
+    std::string convertTypeUncached(const std::shared_ptr<Type>& type);
     std::string sanitizeName(const std::string& name);
     std::string capitalize(const std::string& name);
+
+    // Generics (Go 1.18 type parameters)
+    std::string className(const ClassDecl& class_decl);
+    std::string typeParameters(const ClassDecl& class_decl);
+    std::string typeArguments(const ClassDecl& class_decl);
+    std::string convertClassSpelling(const std::string& spelling);
+    std::string convertTemplateArgument(const std::string& argument);
+    std::string mangleArgument(const std::string& argument);
+    void generateConstraints();
+    static const char* goConstraint(unsigned bounds);   // Local constraint for a parameter's bounds
+
+    // Performance lowering (optimization level 2 and up)
+    std::vector<std::string> requiredImports(const IR& ir);
+    std::string convertFieldType(const Variable& field);
+    std::string convertSpelledType(const std::string& cpp_type);
+    std::string atomicCounterType(const std::shared_ptr<Type>& type) override;
+    void generateLockFreeUpdate(const GuardedUpdate& update);
+    void generateCapacityHints(const Function& func, const std::string& receiver_type);
+    void generatePools(const Function& func, const std::string& receiver_type);
+    std::string capacityHintType(const CapacityHint& hint);
+    bool isPooled(const CapacityHint& hint);
+    std::string poolName(const Function& func, const std::string& receiver_type, const CapacityHint& hint);
 };
 
 } // namespace hybrid
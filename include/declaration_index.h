@@ -0,0 +1,61 @@
+#ifndef HYBRID_DECLARATION_INDEX_H
+#define HYBRID_DECLARATION_INDEX_H
+
+#include "ir.h"
+#include "source_buffer.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Location of one class definition found by the index
+ */
+struct DeclarationEntry {
+    std::string name;
+    SourceSpan span;        // 'class' keyword through the closing brace
+    uint32_t line = 1;      // Line of the 'class' keyword
+    std::vector<std::string> bases;     // Base names as written, template arguments dropped
+};
+
+/**
+ * Boundaries of the class definitions in a source buffer
+ *
+ * Built with one streaming lexer pass (no token vector, no IR), so it is
+ * much cheaper than a full parse. parseDeclaration() then lexes and parses
+ * only the requested class and the base classes it names, which makes a
+ * lookup cost proportional to those declarations rather than to the file.
+ * Declarations are found exactly where the full parser finds them.
+ */
+class DeclarationIndex {
+public:
+    explicit DeclarationIndex(std::shared_ptr<const SourceBuffer> buffer);
+
+    const std::vector<DeclarationEntry>& getEntries() const { return entries_; }
+    const std::shared_ptr<const SourceBuffer>& getSource() const { return buffer_; }
+
+    /**
+     * First definition with this name, or nullptr
+     */
+    const DeclarationEntry* find(const std::string& name) const;
+
+    /**
+     * Parse one class plus, transitively, the base classes defined in the
+     * same buffer. The requested class is the IR's first class.
+     * Throws std::runtime_error if the index has no such class.
+     */
+    IR parseDeclaration(const std::string& name) const;
+
+private:
+    std::shared_ptr<const SourceBuffer> buffer_;
+    std::vector<DeclarationEntry> entries_;
+    std::unordered_map<std::string, size_t> by_name_;  // First entry per name
+
+    void scan();
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_DECLARATION_INDEX_H
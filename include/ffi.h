@@ -17,18 +17,35 @@
 namespace hybrid_transpiler {
 namespace ffi {
 
+/**
+ * @brief How a value crosses the C ABI
+ *
+ * Views pass a pointer and a length into memory the caller owns, so
+ * strings and contiguous containers are neither copied nor reallocated
+ * on the foreign side. Handles are opaque pointers to C++ objects.
+ */
+enum class FFIPassing {
+    Value,          // Scalar, passed as is
+    Pointer,        // Raw pointer, passed through
+    StringView,     // std::string_view, const std::string&: (const char*, size_t)
+    SliceView,      // std::span<T>, const std::vector<T>&: (T*, size_t)
+    Handle          // Class by pointer or reference (or returned by value): opaque pointer
+};
+
 /**
  * @brief Represents a function parameter for FFI
  */
 struct FFIParameter {
     std::string name;
     std::string cpp_type;      // Original C++ type
-    std::string c_type;        // C-compatible type
-    std::string rust_type;     // Rust FFI type
+    std::string c_type;        // C-compatible type (element type for views, class for handles)
+    std::string rust_type;     // Rust FFI type (element type for views)
     std::string go_type;       // Go FFI type (cgo)
-    bool is_pointer;
-    bool is_const;
-    bool is_reference;
+    bool is_pointer = false;
+    bool is_const = false;
+    bool is_reference = false;
+    FFIPassing passing = FFIPassing::Value;
+    std::string view_type;     // C++ type the wrapper rebuilds from a view (std::string, std::span<const T>, ...)
 };
 
 /**
@@ -41,13 +58,15 @@ struct FFIFunction {
     std::string return_type;    // Original C++ return type
     std::string c_return_type;  // C-compatible return type
     std::vector<FFIParameter> parameters;
-    bool is_method;             // true if member function
-    bool is_static;             // true if static member function
-    bool is_const;              // true if const member function
+    bool is_method = false;     // true if member function
+    bool is_static = false;     // true if static member function
+    bool is_const = false;      // true if const member function
+    bool is_constructor = false;
     std::string class_name;     // Class name if member function
-    bool is_virtual;            // true if virtual function
-    bool can_use_ffi;           // true if FFI-compatible
+    bool is_virtual = false;    // true if virtual function
+    bool can_use_ffi = false;   // true if FFI-compatible
     std::string reason;         // Reason if not FFI-compatible
+    FFIParameter result;        // Return type, classified like a parameter (Value for void)
 };
 
 /**
@@ -55,14 +74,29 @@ struct FFIFunction {
  */
 struct FFIClass {
     std::string name;
+    std::string c_name;         // Symbol prefix of the handle functions (<c_name>_new, <c_name>_delete)
+    std::vector<FFIFunction> constructors;
     std::vector<FFIFunction> methods;
     std::vector<FFIFunction> static_methods;
     std::vector<FFIParameter> fields;
-    bool has_virtual_functions;
-    bool is_polymorphic;
-    bool is_abstract;
-    size_t size;                // Size in bytes
-    size_t alignment;           // Alignment requirement
+    bool has_virtual_functions = false;
+    bool is_polymorphic = false;
+    bool is_abstract = false;
+    size_t size = 0;            // Size in bytes
+    size_t alignment = 0;       // Alignment requirement
+};
+
+/**
+ * @brief Options shared by the binding generators
+ */
+struct FFIOptions {
+    /**
+     * Also emit <name>_batch entry points for functions and methods whose
+     * parameters and result are all scalars: one call takes arrays of
+     * arguments (and an array for the results) and loops on the C++ side,
+     * so a hot loop crosses the boundary once instead of once per element
+     */
+    bool batched = false;
 };
 
 /**
@@ -73,23 +107,47 @@ struct FFIClass {
  */
 class FFIAnalyzer {
 public:
-    FFIAnalyzer() = default;
+    FFIAnalyzer();
     ~FFIAnalyzer() = default;
 
+    /**
+     * @brief Prepended to every C symbol, e.g. "mylib_" (empty by default)
+     */
+    void setSymbolPrefix(const std::string& prefix) { symbol_prefix_ = prefix; }
+
     /**
      * @brief Analyze a C++ function for FFI compatibility
-     * @param function_decl Function declaration to analyze
+     *
+     * Classes analyzed before are known: their pointers and references
+     * become handles.
+     * @param function_decl Function declaration to analyze (a body, if any, is ignored)
      * @return FFIFunction with compatibility information
      */
     FFIFunction analyzeFunction(const std::string& function_decl);
 
     /**
      * @brief Analyze a C++ class for FFI compatibility
+     *
+     * Its public constructors and methods are analyzed as functions on an
+     * opaque handle, and the class becomes known to later calls.
      * @param class_decl Class declaration to analyze
      * @return FFIClass with compatibility information
      */
     FFIClass analyzeClass(const std::string& class_decl);
 
+    /**
+     * @brief Classify how a parameter or result of a C++ type crosses the ABI
+     * @return Parameter with passing, c_type, rust_type and go_type set
+     *         (empty c_type if the type cannot cross)
+     */
+    FFIParameter analyzeParameter(const std::string& cpp_type, const std::string& name);
+
+    /**
+     * @brief Whether a batched entry point can be generated: every
+     * parameter and the result are scalars (a void result is allowed)
+     */
+    static bool isBatchable(const FFIFunction& func);
+
     /**
      * @brief Check if a C++ type is FFI-compatible
      * @param cpp_type C++ type to check
@@ -125,6 +183,8 @@ private:
     std::unordered_map<std::string, std::string> cpp_to_c_types_;
     std::unordered_map<std::string, std::string> cpp_to_rust_types_;
     std::unordered_map<std::string, std::string> cpp_to_go_types_;
+    std::vector<std::string> classes_;     // Analyzed so far: passed as handles
+    std::string symbol_prefix_;
 
     /**
      * @brief Initialize type mapping tables
@@ -137,7 +197,7 @@ private:
  */
 class RustFFIGenerator {
 public:
-    RustFFIGenerator() = default;
+    explicit RustFFIGenerator(const FFIOptions& options = FFIOptions()) : options_(options) {}
     ~RustFFIGenerator() = default;
 
     /**
@@ -173,6 +233,9 @@ public:
         const std::vector<FFIClass>& classes,
         const std::string& library_name
     );
+
+private:
+    FFIOptions options_;
 };
 
 /**
@@ -180,7 +243,7 @@ public:
  */
 class GoFFIGenerator {
 public:
-    GoFFIGenerator() = default;
+    explicit GoFFIGenerator(const FFIOptions& options = FFIOptions()) : options_(options) {}
     ~GoFFIGenerator() = default;
 
     /**
@@ -216,6 +279,9 @@ public:
         const std::vector<FFIClass>& classes,
         const std::string& library_name
     );
+
+private:
+    FFIOptions options_;
 };
 
 /**
@@ -226,7 +292,7 @@ public:
  */
 class CWrapperGenerator {
 public:
-    CWrapperGenerator() = default;
+    explicit CWrapperGenerator(const FFIOptions& options = FFIOptions()) : options_(options) {}
     ~CWrapperGenerator() = default;
 
     /**
@@ -268,6 +334,9 @@ public:
         const std::vector<FFIClass>& classes,
         const std::string& library_name
     );
+
+private:
+    FFIOptions options_;
 };
 
 /**
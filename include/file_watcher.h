@@ -0,0 +1,78 @@
+#ifndef HYBRID_FILE_WATCHER_H
+#define HYBRID_FILE_WATCHER_H
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * One change reported by a FileWatcher
+ */
+struct FileEvent {
+    std::string path;           // Watched directory joined with the entry name
+    bool structural = false;    // Created, removed or renamed (not just written)
+};
+
+/**
+ * Change notifications for the entries of watched directories
+ *
+ * Uses inotify on Linux, which costs nothing while nothing changes.
+ * Elsewhere it falls back to comparing modification times of the watched
+ * directories' entries on every wait(). Directories rather than files are
+ * watched so that editors that save by renaming a temporary file over the
+ * original are still seen.
+ */
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * Watch the direct entries of a directory; watching twice is a no-op
+     * @param recursive Also watch every subdirectory, including ones created later
+     * @return false with error set if the directory cannot be watched
+     */
+    bool watchDirectory(const std::string& dir, bool recursive, std::string& error);
+
+    /**
+     * Wait up to timeout_ms for changes
+     * @return The changes seen, possibly several per file; empty on timeout.
+     *         An event with an empty path means events were lost and
+     *         everything should be rescanned.
+     */
+    std::vector<FileEvent> wait(int timeout_ms);
+
+    /**
+     * Whether changes come from the OS rather than from polling
+     */
+    bool isNative() const;
+
+    size_t getDirectoryCount() const { return directories_.size(); }
+
+private:
+    struct Directory {
+        std::string path;
+        bool recursive = false;
+        std::map<std::string, std::filesystem::file_time_type> entries;    // Polling fallback
+    };
+
+    int fd_ = -1;                                   // inotify descriptor
+    std::unordered_map<int, Directory> directories_; // By watch descriptor (or sequence number)
+    std::unordered_map<std::string, int> watched_;  // Directory path -> key in directories_
+    int next_key_ = 0;
+
+    std::vector<FileEvent> readNative(int timeout_ms);
+    std::vector<FileEvent> pollTimes(int timeout_ms);
+    static void snapshot(Directory& dir, std::vector<FileEvent>* changes);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_FILE_WATCHER_H
@@ -0,0 +1,88 @@
+#ifndef HYBRID_HEADER_CACHE_H
+#define HYBRID_HEADER_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace hybrid {
+
+class IR;
+class SourceBuffer;
+
+/**
+ * Declarations of the headers the inputs include, parsed once per build
+ *
+ * The built-in front end sees only the file it is given, so a class whose
+ * base is defined in a shared header would not find it. With
+ * resolve_includes, the quoted #includes of each input (and, transitively,
+ * of the headers) are resolved next to the including file, then in the
+ * include directories, and their declarations are looked up here.
+ *
+ * Headers are keyed by a hash of their content: the first worker that
+ * needs one parses (and analyzes) it, workers asking meanwhile wait for
+ * that parse, and every includer then shares the resulting IR read-only.
+ * Editing a header changes its key, so watch and server runs pick up the
+ * new declarations. Angle-bracket includes are not followed.
+ */
+class HeaderCache {
+public:
+    explicit HeaderCache(std::vector<std::string> include_dirs = {});
+
+    HeaderCache(const HeaderCache&) = delete;
+    HeaderCache& operator=(const HeaderCache&) = delete;
+
+    /**
+     * Declarations of every header 'source' includes, transitively, each
+     * once, in include order. Headers that cannot be read or parsed are
+     * skipped. May be called from several threads at once.
+     */
+    std::vector<std::shared_ptr<const IR>> resolve(const SourceBuffer& source, bool analyze);
+
+    /**
+     * Hash of the contents of every header resolve() would read for
+     * 'source' (empty if there are none); part of its BuildCache key
+     */
+    std::string dependencyHash(const SourceBuffer& source) const;
+
+    /**
+     * Declarations of one header, parsed unless one with the same content was
+     * (nullptr if it does not parse)
+     */
+    std::shared_ptr<const IR> declarations(const std::shared_ptr<const SourceBuffer>& header, bool analyze);
+
+    /**
+     * Quoted include targets of a source, as written, in order
+     */
+    static std::vector<std::string> quotedIncludes(std::string_view text);
+
+    size_t getParseCount() const;       // Distinct headers parsed
+    size_t getReuseCount() const;       // Lookups served by an earlier parse
+
+private:
+    std::vector<std::string> include_dirs_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<const IR>>> entries_;  // Content hash -> IR
+    size_t parsed_ = 0;
+    size_t reused_ = 0;
+
+    std::string findHeader(const std::string& includer, const std::string& name) const;
+
+    /**
+     * Visit every header 'source' includes, transitively, once each; the
+     * IRs visit returns are collected in include order
+     */
+    using Visit = std::function<std::shared_ptr<const IR>(const std::shared_ptr<const SourceBuffer>&)>;
+    std::vector<std::shared_ptr<const IR>> walk(const SourceBuffer& source, const Visit& visit) const;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_HEADER_CACHE_H
@@ -0,0 +1,99 @@
+#ifndef HYBRID_INCREMENTAL_SESSION_H
+#define HYBRID_INCREMENTAL_SESSION_H
+
+#include "ir.h"
+#include "output_sink.h"
+#include "source_buffer.h"
+#include "transpiler.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hybrid {
+
+class AnalysisPassManager;
+class CodeGenerator;
+
+/**
+ * One class definition tracked by an IncrementalSession
+ */
+struct IncrementalDeclaration {
+    std::string name;
+    SourceSpan span;            // In the current version of the source
+    uint32_t line = 1;
+    uint64_t text_hash = 0;     // Fingerprint of the definition's own text
+    uint64_t fragment_key = 0;  // text_hash combined with the fingerprints of its bases
+    size_t first_class = 0;     // Its classes are [first_class, first_class + class_count) in the IR
+    size_t class_count = 0;
+    std::string fragment;       // Generated code for those classes
+};
+
+/**
+ * What the last update() had to redo
+ */
+struct IncrementalStats {
+    size_t declarations = 0;
+    size_t reparsed = 0;        // New or edited: lexed, parsed and analyzed again
+    size_t regenerated = 0;     // Fragment rebuilt: reparsed, or a base class changed
+    size_t discarded = 0;       // Old definitions with no identical text left (edited or deleted)
+};
+
+/**
+ * Re-transpiles successive versions of one source
+ *
+ * Each class definition is fingerprinted by its text. An update locates
+ * the definitions with a DeclarationIndex scan, carries the IR of every
+ * unchanged one over (wherever it moved to) and parses and analyzes only
+ * the rest. A fragment is regenerated only if its class was reparsed or
+ * one of its base classes changed, since generation also reads the bases.
+ * In a source with class templates any edit regenerates every fragment:
+ * how a template is emitted depends on all of its uses.
+ * The assembled output is byte-identical to transpiling the version from
+ * scratch.
+ */
+class IncrementalSession {
+public:
+    explicit IncrementalSession(TargetLanguage target, int optimization_level = 0,
+                                size_t monomorphization_budget = 0);
+    ~IncrementalSession();
+
+    /**
+     * Run these passes on reparsed classes (not owned). Without them (the
+     * default) the IR is left unanalyzed, as in the Transpiler pipeline.
+     */
+    void setAnalysis(AnalysisPassManager* analysis) { analysis_ = analysis; }
+
+    /**
+     * Bring the IR and the output up to date with a new version of the source
+     * @return false with getLastError() set if parsing fails; the previous
+     *         version is kept in that case
+     */
+    bool update(std::shared_ptr<const SourceBuffer> source);
+
+    /**
+     * Write the output for the current version
+     * @return false if the sink reported a write failure
+     */
+    bool write(OutputSink& sink) const;
+    std::string getOutput() const;
+
+    const IR& getIR() const { return ir_; }
+    const std::vector<IncrementalDeclaration>& getDeclarations() const { return declarations_; }
+    const IncrementalStats& getLastStats() const { return stats_; }
+    const std::string& getLastError() const { return last_error_; }
+
+private:
+    std::unique_ptr<CodeGenerator> codegen_;
+    AnalysisPassManager* analysis_ = nullptr;
+    IR ir_;
+    std::vector<IncrementalDeclaration> declarations_;
+    std::string prologue_;
+    std::string epilogue_;
+    IncrementalStats stats_;
+    std::string last_error_;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_INCREMENTAL_SESSION_H
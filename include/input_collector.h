@@ -0,0 +1,74 @@
+#ifndef HYBRID_INPUT_COLLECTOR_H
+#define HYBRID_INPUT_COLLECTOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+namespace hybrid {
+
+/**
+ * One resolved input file
+ */
+struct InputFile {
+    std::string path;       // Path as given or discovered
+    std::string base_dir;   // Root it was found under; used to mirror outputs
+};
+
+/**
+ * Expands command line input specs into a list of source files
+ *
+ * A spec is a file, a directory (searched recursively for C++ sources),
+ * a glob pattern ('*', '?' and '**' for any number of directories) or
+ * '@file', a response file listing one spec per line. Files are returned
+ * once each, in the order they were first found. Directory and glob
+ * matches are sorted so runs are reproducible.
+ */
+class InputCollector {
+public:
+    /**
+     * Add one input spec
+     * @return false with error set if the spec matches nothing
+     */
+    bool addSpec(const std::string& spec, std::string& error);
+
+    const std::vector<InputFile>& getFiles() const { return files_; }
+
+    /**
+     * Output path for an input mirrored under output_dir with the
+     * target extension (base_dir/sub/foo.cpp -> output_dir/sub/foo.rs)
+     */
+    static std::string mirrorOutputPath(const InputFile& input, const std::string& output_dir,
+                                        const std::string& extension);
+
+    /**
+     * Rename outputs that two inputs would share (foo.h and foo.cpp both
+     * giving foo.rs): the source keeps the name, others get their extension
+     * as a suffix (foo_h.rs)
+     * @return false with error set if a collision remains
+     */
+    static bool disambiguateOutputs(const std::vector<InputFile>& inputs, std::vector<std::string>& outputs,
+                                    std::string& error);
+
+    /**
+     * Whether a path has a C++ source or header extension
+     */
+    static bool isSourceFile(const std::string& path);
+
+private:
+    std::vector<InputFile> files_;
+    std::unordered_set<std::string> seen_;
+    int response_depth_ = 0;
+
+    bool addResponseFile(const std::string& path, std::string& error);
+    bool addDirectory(const std::string& dir, std::string& error);
+    bool addGlob(const std::string& pattern, std::string& error);
+    void addFile(const std::string& path, const std::string& base_dir);
+
+    static bool hasWildcard(const std::string& text);
+    static bool matchComponent(const char* pattern, const char* name);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_INPUT_COLLECTOR_H
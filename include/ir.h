@@ -5,6 +5,8 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include "source_buffer.h"
 
 namespace hybrid {
 
@@ -74,6 +76,39 @@ public:
     explicit Type(TypeKind k) : kind(k) {}
 };
 
+/**
+ * Hash-consing arena for Type nodes
+ *
+ * intern() maps structurally identical types onto one canonical node, so
+ * every "int" or "std::vector<std::string>" in an IR shares a single
+ * object and interned types can be compared by pointer. Canonical nodes
+ * are shared and must not be modified after interning.
+ */
+class TypeArena {
+public:
+    /**
+     * Return the canonical node for a type, interning its children first
+     */
+    std::shared_ptr<Type> intern(const std::shared_ptr<Type>& type);
+
+    /**
+     * Create and intern a named type of the given kind
+     */
+    std::shared_ptr<Type> get(TypeKind kind, const std::string& name, bool is_const = false);
+
+    /**
+     * Number of distinct canonical types
+     */
+    size_t size() const { return count_; }
+
+private:
+    std::unordered_map<size_t, std::vector<std::shared_ptr<Type>>> buckets_;
+    size_t count_ = 0;
+
+    static size_t hashNode(const Type& type);
+    static bool sameNode(const Type& a, const Type& b);
+};
+
 /**
  * Variable/field representation
  */
@@ -83,7 +118,7 @@ public:
     std::shared_ptr<Type> type;
     bool is_static = false;
     bool is_const = false;
-    std::string initializer;
+    SourceText initializer;
 };
 
 /**
@@ -94,7 +129,7 @@ public:
     std::string name;
     std::shared_ptr<Type> type;
     bool has_default = false;
-    std::string default_value;
+    SourceText default_value;
 };
 
 /**
@@ -112,12 +147,12 @@ public:
  */
 class TryCatchBlock {
 public:
-    std::string try_body;
+    SourceText try_body;
 
     struct CatchClause {
         std::string exception_type;
         std::string exception_var;
-        std::string handler_body;
+        SourceText handler_body;
     };
 
     std::vector<CatchClause> catch_clauses;
@@ -139,7 +174,7 @@ public:
     std::string default_value;
 
     // For non-type parameters
-    std::shared_ptr<Type> param_type;
+    std::shared_ptr<hybrid::Type> param_type;
 
     // Constraints (C++20 concepts)
     std::vector<std::string> constraints;
@@ -221,6 +256,36 @@ public:
     std::vector<std::string> wait_conditions;
 };
 
+/**
+ * Capacity reserved for a local container: std::vector<T> v; v.reserve(n);
+ */
+class CapacityHint {
+public:
+    std::string var_name;
+    TypeKind container = TypeKind::StdVector;  // StdVector, StdDeque, StdString, StdUnorderedMap or StdUnorderedSet
+    std::string capacity;                      // Argument of reserve(), valid at function entry
+    std::vector<std::string> type_args;        // C++ spelling of the template arguments ("int")
+    bool escapes = false;                      // Returned, moved, copied or passed out of the function
+};
+
+/**
+ * A body that only updates or reads one variable under a lock:
+ * std::lock_guard<std::mutex> lock(m); count += n;
+ */
+class GuardedUpdate {
+public:
+    enum Operation {
+        Read,           // return count;
+        Add,            // count += n, ++count, count++
+        Subtract
+    };
+
+    Operation operation = Read;
+    std::string mutex_name;
+    std::string var_name;
+    std::string operand;        // Amount added or subtracted ("1" for ++ and --)
+};
+
 /**
  * Async/Coroutine operation types
  */
@@ -279,6 +344,7 @@ public:
     std::vector<std::string> arguments;
     std::shared_ptr<Type> result_type;
     bool detached = false;
+    bool follows_wait = false;      // Launched after an earlier task's .get()/.wait()
 };
 
 /**
@@ -289,7 +355,8 @@ public:
     std::string name;
     std::shared_ptr<Type> return_type;
     std::vector<Parameter> parameters;
-    std::string body;
+    SourceText body;
+    SourceSpan location;     // Whole declaration in the source buffer
 
     bool is_const = false;
     bool is_static = false;
@@ -317,8 +384,12 @@ public:
     std::vector<LockInfo> lock_scopes;
     std::vector<AtomicInfo> atomic_operations;
     std::vector<ConditionVariableInfo> condition_variables;
+    std::vector<GuardedUpdate> guarded_updates;     // At most one: the whole body
     bool uses_threading = false;
 
+    // Reserved capacities of local containers
+    std::vector<CapacityHint> capacity_hints;
+
     // Async/Coroutine information
     CoroutineInfo coroutine_info;
     std::vector<FutureInfo> futures;
@@ -333,6 +404,7 @@ class ClassDecl {
 public:
     std::string name;
     bool is_struct = false;
+    SourceSpan location;     // Whole declaration in the source buffer
 
     std::vector<Variable> fields;
     std::vector<Function> methods;
@@ -369,19 +441,57 @@ public:
     void addFunction(const Function& func);
     void addGlobalVariable(const Variable& var);
 
+    // Move overloads: take ownership of bodies and analyzer data without copying
+    void addClass(ClassDecl&& class_decl);
+    void addFunction(Function&& func);
+    void addGlobalVariable(Variable&& var);
+
     const std::vector<ClassDecl>& getClasses() const { return classes_; }
     const std::vector<Function>& getFunctions() const { return functions_; }
     const std::vector<Variable>& getGlobalVariables() const { return global_vars_; }
 
+    // In-place annotation (analysis passes); declaration names must not change
+    ClassDecl& getClass(size_t index) { return classes_[index]; }
+    Function& getFunction(size_t index) { return functions_[index]; }
+
+    // Symbol lookup (hashed, kept in sync by addClass/addFunction).
+    // findClass also finds the classes of included headers.
+    const ClassDecl* findClass(const std::string& name) const;
+    const Function* findFunction(const std::string& name) const;
+    const std::vector<size_t>* findFunctionOverloads(const std::string& name) const;
+
     // Type lookup
     std::shared_ptr<Type> findType(const std::string& name) const;
     void registerType(const std::string& name, std::shared_ptr<Type> type);
+    const std::unordered_map<std::string, std::shared_ptr<Type>>& getTypeRegistry() const {
+        return type_registry_;
+    }
+
+    // Source buffer the IR's spans point into (may be null for hand-built IR)
+    void setSource(std::shared_ptr<const SourceBuffer> source) { source_ = std::move(source); }
+    const std::shared_ptr<const SourceBuffer>& getSource() const { return source_; }
+
+    // Declarations of included headers (HeaderCache) or other files
+    // (ShardMerger): found by findClass, never generated and not serialized
+    void addIncluded(std::shared_ptr<const IR> header) { included_.push_back(std::move(header)); }
+    const std::vector<std::shared_ptr<const IR>>& getIncluded() const { return included_; }
+
+    // Canonical type storage shared by everything in this IR
+    TypeArena& getTypeArena() { return type_arena_; }
+    const TypeArena& getTypeArena() const { return type_arena_; }
 
 private:
     std::vector<ClassDecl> classes_;
     std::vector<Function> functions_;
     std::vector<Variable> global_vars_;
-    std::map<std::string, std::shared_ptr<Type>> type_registry_;
+    std::unordered_map<std::string, std::shared_ptr<Type>> type_registry_;
+    TypeArena type_arena_;
+    std::shared_ptr<const SourceBuffer> source_;
+    std::vector<std::shared_ptr<const IR>> included_;
+
+    // Indexes into classes_ / functions_; positions stay valid when the IR is copied
+    std::unordered_map<std::string, size_t> class_index_;
+    std::unordered_map<std::string, std::vector<size_t>> function_index_;
 };
 
 } // namespace hybrid
@@ -0,0 +1,56 @@
+#ifndef HYBRID_IR_SERIALIZER_H
+#define HYBRID_IR_SERIALIZER_H
+
+#include "ir.h"
+#include "source_buffer.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace hybrid {
+
+/**
+ * Compact binary form of an analyzed IR (.hir files)
+ *
+ * Lets parsing and analysis run once, on one machine, and code generation
+ * for any target run later or elsewhere. Everything the generators read is
+ * kept: declarations, the analyzer results (threading, async, exceptions,
+ * templates) and the type registry.
+ *
+ * Layout, after a magic and a format version: a string pool holding every
+ * distinct name once, a type table in which each interned type appears
+ * once (children before parents), the source text the IR's spans point
+ * into, then the declarations. Integers are LEB128 varints. Loading
+ * a file read with SourceBuffer::fromFile (memory-mapped when large)
+ * copies only names; bodies and initializers stay views into the
+ * embedded source, which is never copied.
+ */
+class IRSerializer {
+public:
+    static constexpr uint32_t kFormatVersion = 4;     // 2: guarded updates and capacity hints, 3: hint types, 4: task order
+    static constexpr const char* kFileExtension = ".hir";
+
+    /**
+     * Encode an IR; the bytes depend only on its contents
+     */
+    static std::string serialize(const IR& ir);
+
+    /**
+     * Whether data starts like serialized IR (any version)
+     */
+    static bool isSerialized(std::string_view data);
+
+    /**
+     * Decode serialized IR into 'ir', replacing its contents
+     *
+     * The loaded IR keeps 'data' alive and points into it.
+     * @return false with error set if the data is truncated, corrupt or
+     *         from another format version; 'ir' is unchanged then
+     */
+    static bool deserialize(const std::shared_ptr<const SourceBuffer>& data, IR& ir, std::string& error);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_IR_SERIALIZER_H
@@ -0,0 +1,91 @@
+#ifndef HYBRID_JSON_H
+#define HYBRID_JSON_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Minimal JSON document model for the server protocol and tool output
+ *
+ * Objects keep their members in insertion order; lookups are linear,
+ * which is fine for the small messages this is used for.
+ */
+class JsonValue {
+public:
+    enum class Kind { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+    JsonValue(bool value) : kind_(Kind::Bool), bool_(value) {}
+    JsonValue(int value) : kind_(Kind::Number), number_(value) {}
+    JsonValue(int64_t value) : kind_(Kind::Number), number_(static_cast<double>(value)) {}
+    JsonValue(uint64_t value) : kind_(Kind::Number), number_(static_cast<double>(value)) {}
+    JsonValue(double value) : kind_(Kind::Number), number_(value) {}
+    JsonValue(std::string value) : kind_(Kind::String), string_(std::move(value)) {}
+    JsonValue(const char* value) : kind_(Kind::String), string_(value) {}
+
+    static JsonValue array();
+    static JsonValue object();
+
+    Kind kind() const { return kind_; }
+    bool isNull() const { return kind_ == Kind::Null; }
+    bool isBool() const { return kind_ == Kind::Bool; }
+    bool isNumber() const { return kind_ == Kind::Number; }
+    bool isString() const { return kind_ == Kind::String; }
+    bool isArray() const { return kind_ == Kind::Array; }
+    bool isObject() const { return kind_ == Kind::Object; }
+
+    bool asBool(bool fallback = false) const { return isBool() ? bool_ : fallback; }
+    double asNumber(double fallback = 0) const { return isNumber() ? number_ : fallback; }
+
+    /** String value; empty for non-strings */
+    const std::string& asString() const;
+
+    /**
+     * Object member, or a null value if absent or this is not an object
+     */
+    const JsonValue& operator[](std::string_view key) const;
+    bool has(std::string_view key) const;
+
+    /** Add or replace an object member (turns null into an object) */
+    JsonValue& set(std::string_view key, JsonValue value);
+
+    /** Append an array element (turns null into an array) */
+    JsonValue& push(JsonValue value);
+
+    const std::vector<JsonValue>& items() const { return items_; }
+    const std::vector<std::pair<std::string, JsonValue>>& members() const { return members_; }
+
+    /**
+     * Compact serialization (no whitespace, no trailing newline)
+     */
+    std::string dump() const;
+    void dump(std::string& out) const;
+
+    /**
+     * Parse a complete JSON text
+     * @return false with error set on malformed input
+     */
+    static bool parse(std::string_view text, JsonValue& value, std::string& error);
+
+private:
+    Kind kind_ = Kind::Null;
+    bool bool_ = false;
+    double number_ = 0;
+    std::string string_;
+    std::vector<JsonValue> items_;
+    std::vector<std::pair<std::string, JsonValue>> members_;
+};
+
+/**
+ * Append text as a quoted, escaped JSON string
+ */
+void appendJsonString(std::string& out, std::string_view text);
+
+} // namespace hybrid
+
+#endif // HYBRID_JSON_H
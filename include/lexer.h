@@ -0,0 +1,112 @@
+#ifndef HYBRID_LEXER_H
+#define HYBRID_LEXER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace hybrid {
+
+/**
+ * Token categories produced by the lexer
+ */
+enum class TokenKind {
+    Identifier,     // Identifiers and keywords
+    Number,         // Integer and floating point literals
+    String,         // String literals (including raw strings)
+    Char,           // Character literals
+    Punct,          // Operators and punctuation
+    Comment,        // Line and block comments
+    Preprocessor,   // Whole preprocessor directive line
+    EndOfFile
+};
+
+/**
+ * A single token with its location in the source buffer
+ */
+class Token {
+public:
+    TokenKind kind = TokenKind::EndOfFile;
+    size_t offset = 0;          // Byte offset of the first character
+    size_t length = 0;          // Length in bytes
+    uint32_t line = 1;          // 1-based line of the first character
+    std::string_view text;      // View into the source buffer
+
+    size_t end() const { return offset + length; }
+
+    bool isPunct(std::string_view p) const {
+        return kind == TokenKind::Punct && text == p;
+    }
+
+    bool isIdentifier(std::string_view name) const {
+        return kind == TokenKind::Identifier && text == name;
+    }
+};
+
+/**
+ * C++ Lexer
+ *
+ * Single linear pass over the source producing a flat token stream.
+ * Tokens are views into the source buffer, which must outlive them.
+ *
+ * Multi-character punctuation is limited to "::", "->" and "..." so that
+ * nested template closers ("> >" and ">>") always come out as single '>'.
+ */
+class Lexer {
+public:
+    explicit Lexer(std::string_view source)
+        : source_(source), begin_(0), end_(source.size()), pos_(0) {}
+
+    /**
+     * Lex only bytes [begin, end) of source; offsets and views stay relative
+     * to the whole source. begin must be at a token boundary on 'line'.
+     */
+    Lexer(std::string_view source, size_t begin, size_t end, uint32_t line)
+        : source_(source), begin_(begin), end_(end < source.size() ? end : source.size()),
+          pos_(begin), line_(line), first_line_(line) {}
+
+    /**
+     * Tokenize the whole buffer (or range)
+     * @param keep_comments Emit Comment tokens instead of dropping them
+     * @return Tokens in source order, terminated by an EndOfFile token
+     */
+    std::vector<Token> tokenize(bool keep_comments = true);
+
+    /**
+     * Produce the next token without materializing the stream; a Lexer is
+     * cheap to copy, so a copy can serve as a backtracking point
+     * @return false at the end of the input
+     */
+    bool next(Token& token, bool keep_comments = true);
+
+private:
+    std::string_view source_;
+    size_t begin_;
+    size_t end_;
+    size_t pos_;
+    uint32_t line_ = 1;
+    uint32_t first_line_ = 1;
+    bool at_line_start_ = true;
+
+    char peek(size_t ahead = 0) const {
+        return pos_ + ahead < end_ ? source_[pos_ + ahead] : '\0';
+    }
+
+    void advance(size_t count = 1);
+    void advanceTo(size_t target);      // Counts the newlines passed over
+    Token makeToken(TokenKind kind, size_t start, uint32_t line) const;
+
+    void skipLineComment();
+    void skipBlockComment();
+    void skipPreprocessorLine();
+    void skipQuoted(char quote);
+    void skipRawString();
+    void skipNumber();
+    void skipIdentifier();
+    bool isStringPrefix(std::string_view ident) const;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_LEXER_H
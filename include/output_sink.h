@@ -0,0 +1,127 @@
+#ifndef HYBRID_OUTPUT_SINK_H
+#define HYBRID_OUTPUT_SINK_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Destination for generated code
+ *
+ * Code generators write through a sink as they go, so output never has
+ * to be assembled in memory before it reaches its destination.
+ */
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    virtual void write(std::string_view text) = 0;
+
+    /**
+     * Push buffered bytes to the destination
+     * @return false if any write so far has failed
+     */
+    virtual bool flush() { return good(); }
+
+    virtual bool good() const { return true; }
+};
+
+/**
+ * Collects output in a string (tests, caching, string-returning generate())
+ */
+class StringSink : public OutputSink {
+public:
+    void write(std::string_view text) override { buffer_.append(text); }
+
+    const std::string& str() const { return buffer_; }
+    std::string take() { return std::move(buffer_); }
+
+    // Empty the buffer but keep its capacity for the next output
+    void clear() { buffer_.clear(); }
+
+private:
+    std::string buffer_;
+};
+
+/**
+ * Base for sinks that batch small writes into one large reusable buffer
+ */
+class BufferedSink : public OutputSink {
+public:
+    static constexpr size_t kDefaultBufferSize = 256 * 1024;
+
+    explicit BufferedSink(size_t buffer_size = kDefaultBufferSize);
+
+    void write(std::string_view text) override;
+    bool flush() override;
+    bool good() const override { return !failed_; }
+
+    /** Bytes accepted by write() so far */
+    size_t bytesWritten() const { return written_; }
+
+protected:
+    /**
+     * Write raw bytes to the destination
+     * @return false on failure
+     */
+    virtual bool writeRaw(const char* data, size_t size) = 0;
+
+    bool failed_ = false;
+
+private:
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    size_t written_ = 0;
+};
+
+/**
+ * Buffered sink writing to a file opened by path
+ */
+class FileSink : public BufferedSink {
+public:
+    explicit FileSink(size_t buffer_size = kDefaultBufferSize) : BufferedSink(buffer_size) {}
+    ~FileSink() override;
+
+    /**
+     * Open (truncate) the output file
+     * @return false if it cannot be created
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Flush and close; returns false if anything failed to reach the file
+     */
+    bool close();
+
+    bool isOpen() const { return file_ != nullptr; }
+
+protected:
+    bool writeRaw(const char* data, size_t size) override;
+
+private:
+    std::FILE* file_ = nullptr;
+};
+
+/**
+ * Buffered sink writing to an already open file descriptor (stdout, pipes)
+ * The descriptor is not closed by the sink.
+ */
+class FdSink : public BufferedSink {
+public:
+    explicit FdSink(int fd, size_t buffer_size = kDefaultBufferSize)
+        : BufferedSink(buffer_size), fd_(fd) {}
+    ~FdSink() override;
+
+protected:
+    bool writeRaw(const char* data, size_t size) override;
+
+private:
+    int fd_;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_OUTPUT_SINK_H
@@ -3,6 +3,7 @@
 
 #include "ir.h"
 #include <string>
+#include <vector>
 
 namespace hybrid {
 
@@ -28,6 +29,37 @@ public:
      * @return Intermediate representation of the parsed code
      */
     static IR parseString(const std::string& source);
+
+    /**
+     * Parse a shared source buffer without copying it
+     *
+     * @param buffer Source contents; the returned IR keeps it alive
+     * @return Intermediate representation of the parsed code
+     */
+    static IR parseBuffer(std::shared_ptr<const SourceBuffer> buffer);
+
+    /**
+     * Same, into an existing empty IR
+     *
+     * If parsing stops with an exception (BudgetExceeded), the IR keeps
+     * the classes parsed before it.
+     */
+    static void parseBuffer(std::shared_ptr<const SourceBuffer> buffer, IR& ir);
+
+    /**
+     * Parse only the declarations inside the given spans of a buffer
+     *
+     * Each span must start at a token boundary; classes are added in span
+     * order. Used for on-demand parsing through a DeclarationIndex.
+     */
+    static IR parseSpans(std::shared_ptr<const SourceBuffer> buffer, const std::vector<SourceSpan>& spans);
+
+    /**
+     * Same, appending the classes to an existing IR and interning their
+     * types in its arena; the IR's source buffer is left as it is
+     */
+    static void parseSpans(const std::shared_ptr<const SourceBuffer>& buffer,
+                           const std::vector<SourceSpan>& spans, IR& ir);
 };
 
 } // namespace hybrid
@@ -0,0 +1,148 @@
+#ifndef HYBRID_PROFILER_H
+#define HYBRID_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hybrid {
+
+namespace detail {
+// Per-thread counters behind Profiler::threadAllocations(), bumped by allocation_hooks.cpp
+extern thread_local uint64_t tl_allocations;
+extern thread_local uint64_t tl_allocated_bytes;
+} // namespace detail
+
+/**
+ * One timed phase (a Chrome trace "complete" event)
+ */
+struct ProfileEvent {
+    const char* category = "";
+    const char* name = "";
+    std::string detail;             // File, class or function name (optional)
+    uint32_t thread = 0;            // Small per-process thread index
+    uint64_t start_ns = 0;          // Relative to Profiler::start()
+    uint64_t duration_ns = 0;
+    uint64_t allocations = 0;       // operator new calls on this thread during the phase
+    uint64_t allocated_bytes = 0;
+    uint64_t bytes = 0;             // Bytes processed (read, parsed, generated, written)
+};
+
+/**
+ * Process-wide phase profiler behind --stats and --trace
+ *
+ * Disabled by default; a disabled ProfileScope costs one relaxed atomic
+ * load. Allocation counts come from the counting global operator new in
+ * allocation_hooks.cpp, which only the executables link (the library
+ * leaves its host's allocator alone and reports zero), and are attributed
+ * to the thread that opened the scope.
+ */
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static Profiler& global();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * Clear previous results and start recording
+     */
+    void start();
+    void stop();
+
+    /** Nanoseconds since start() */
+    uint64_t now() const;
+
+    void record(ProfileEvent event);
+
+    /**
+     * Add time measured elsewhere (e.g. per analysis pass) to the summary;
+     * totals have no position on the timeline and are left out of traces
+     */
+    void recordTotal(const char* category, const char* name, uint64_t nanoseconds, uint64_t calls);
+
+    /**
+     * Per-phase summary: calls, wall time, allocations and bytes
+     */
+    void writeStats(std::ostream& out) const;
+
+    /**
+     * Write all events as Chrome trace-event JSON (chrome://tracing, Perfetto)
+     * @return false with error set if the file cannot be written
+     */
+    bool writeTrace(const std::string& path, std::string& error) const;
+
+    std::vector<ProfileEvent> getEvents() const;
+
+    static uint32_t threadIndex();
+
+    /** Allocation counters of the calling thread */
+    static uint64_t threadAllocations();
+    static uint64_t threadAllocatedBytes();
+
+private:
+    struct Total {
+        const char* category;
+        const char* name;
+        uint64_t nanoseconds;
+        uint64_t calls;
+    };
+
+    static std::atomic<bool> enabled_;
+
+    mutable std::mutex mutex_;
+    std::vector<ProfileEvent> events_;
+    std::vector<Total> totals_;
+    Clock::time_point epoch_ = Clock::now();
+    uint64_t stop_ns_ = 0;
+};
+
+/**
+ * RAII timer for one phase; records an event when profiling is enabled
+ *
+ * category and name must be string literals (they are stored unowned).
+ */
+class ProfileScope {
+public:
+    ProfileScope(const char* category, const char* name,
+                 std::string_view detail = std::string_view(), uint64_t bytes = 0)
+        : active_(Profiler::enabled()) {
+        if (active_) {
+            begin(category, name, detail, bytes);
+        }
+    }
+
+    ~ProfileScope() {
+        if (active_) {
+            end();
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    void addBytes(uint64_t bytes) {
+        if (active_) {
+            event_.bytes += bytes;
+        }
+    }
+
+private:
+    bool active_;
+    ProfileEvent event_;
+    uint64_t allocations_start_ = 0;
+    uint64_t allocated_bytes_start_ = 0;
+
+    void begin(const char* category, const char* name, std::string_view detail, uint64_t bytes);
+    void end();
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_PROFILER_H
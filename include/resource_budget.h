@@ -0,0 +1,130 @@
+#ifndef HYBRID_RESOURCE_BUDGET_H
+#define HYBRID_RESOURCE_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace hybrid {
+
+/**
+ * Thrown when a file runs over its time or memory budget
+ */
+class BudgetExceeded : public std::runtime_error {
+public:
+    BudgetExceeded(const std::string& message, const char* phase)
+        : std::runtime_error(message), phase_(phase) {}
+
+    /** Phase that was running: "parse", "analysis" or "codegen" */
+    const char* getPhase() const { return phase_; }
+
+private:
+    const char* phase_;
+};
+
+/**
+ * Wall-time and memory limits for transpiling one file
+ *
+ * Loops that can run long on a pathological input (members of a class,
+ * functions being analyzed, declarations being generated) call
+ * checkpoint(), and the large allocations (token arrays, IR declarations,
+ * comment-stripped copies) call charge(), against the budget a
+ * BudgetScope installed on the current thread. Going over a limit throws
+ * BudgetExceeded from there, which unwinds just that file. Without an
+ * installed budget both are no-ops.
+ *
+ * Memory is the transpiler's own accounting of those structures rather
+ * than the process's resident size, so it is deterministic and also works
+ * in embedders without the counting allocator. Several threads may share
+ * one budget; once it trips, every one of them stops at its next check.
+ */
+class ResourceBudget {
+public:
+    /**
+     * @param time_ms Wall-time limit from now (0 = none)
+     * @param memory_bytes Limit on charged bytes (0 = none)
+     */
+    ResourceBudget(uint64_t time_ms, uint64_t memory_bytes);
+
+    bool isLimited() const { return time_ms_ != 0 || memory_bytes_ != 0; }
+
+    /**
+     * Throw BudgetExceeded if the time is up (or another thread tripped it)
+     */
+    void check(const char* phase);
+
+    /**
+     * Account for an allocation, then check() both limits
+     */
+    void charge(uint64_t bytes, const char* phase);
+
+    uint64_t getCharged() const { return charged_.load(std::memory_order_relaxed); }
+    double getElapsedMs() const;
+
+    /**
+     * Budget installed on this thread, or nullptr
+     */
+    static ResourceBudget* current() { return tl_current_; }
+
+    /**
+     * Cheap check for loops: reads the clock every kCheckInterval calls
+     */
+    static void checkpoint(const char* phase) {
+        ResourceBudget* budget = tl_current_;
+        if (budget && ++tl_ticks_ % kCheckInterval == 0) {
+            budget->check(phase);
+        }
+    }
+
+    static void chargeCurrent(uint64_t bytes, const char* phase) {
+        if (ResourceBudget* budget = tl_current_) {
+            budget->charge(bytes, phase);
+        }
+    }
+
+private:
+    friend class BudgetScope;
+
+    static constexpr uint32_t kCheckInterval = 16;
+
+    static inline thread_local ResourceBudget* tl_current_ = nullptr;
+    static inline thread_local uint32_t tl_ticks_ = 0;
+
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point deadline_;
+    uint64_t time_ms_;
+    uint64_t memory_bytes_;
+    std::atomic<uint64_t> charged_{0};
+    std::atomic<bool> exceeded_{false};
+
+    // First overrun, reported by every thread that stops on it
+    std::mutex mutex_;
+    std::string message_;
+    const char* phase_ = "";
+
+    [[noreturn]] void exceed(std::string message, const char* phase);
+};
+
+/**
+ * Installs a budget (or none, with nullptr) on the current thread for its lifetime
+ */
+class BudgetScope {
+public:
+    explicit BudgetScope(ResourceBudget* budget) : previous_(ResourceBudget::tl_current_) {
+        ResourceBudget::tl_current_ = budget;
+    }
+    ~BudgetScope() { ResourceBudget::tl_current_ = previous_; }
+
+    BudgetScope(const BudgetScope&) = delete;
+    BudgetScope& operator=(const BudgetScope&) = delete;
+
+private:
+    ResourceBudget* previous_;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_RESOURCE_BUDGET_H
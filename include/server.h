@@ -0,0 +1,109 @@
+#ifndef HYBRID_SERVER_H
+#define HYBRID_SERVER_H
+
+#include "json.h"
+#include "transpiler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Long-lived transpile server behind --server
+ *
+ * Speaks JSON-RPC 2.0, one message per line, over stdin/stdout or a Unix
+ * domain socket. One Transpiler per target and an in-memory cache of
+ * recent outputs stay warm between requests, so a warm request only pays
+ * for parsing and code generation (or a cache hit).
+ *
+ * Methods:
+ *   transpile  {source | path, [target], [declaration], [output]} -> {code | output, cached}
+ *   status     {} -> request and cache counters
+ *   shutdown   {} -> null; the server stops after answering
+ */
+class TranspileServer {
+public:
+    static constexpr size_t kDefaultCacheBytes = 64 * 1024 * 1024;
+
+    explicit TranspileServer(const TranspilerOptions& options,
+                             size_t cache_bytes = kDefaultCacheBytes);
+    ~TranspileServer();
+
+    /**
+     * Serve requests line by line until end of input or shutdown
+     */
+    void serveStream(std::istream& in, std::ostream& out);
+
+    /**
+     * Listen on a Unix domain socket until shutdown (or SIGINT/SIGTERM);
+     * each connection is served on its own thread
+     * @return false with error set if the socket cannot be created
+     */
+    bool serveSocket(const std::string& path, std::string& error);
+
+    /**
+     * Handle one request and return its response line (without newline);
+     * notifications (requests without an id) return an empty string
+     */
+    std::string handleMessage(std::string_view message);
+
+    bool isShutdownRequested() const { return shutdown_.load(); }
+
+private:
+    struct CacheEntry {
+        std::string key;
+        std::string code;
+    };
+
+    TranspilerOptions options_;
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<bool> shutdown_{false};
+
+    // Requests are handled one at a time; connections only read and write concurrently
+    std::mutex mutex_;
+    std::unique_ptr<Transpiler> transpilers_[2];    // Indexed by TargetLanguage
+
+    // LRU of generated code keyed by BuildCache::computeKey
+    std::list<CacheEntry> lru_;
+    std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache_index_;
+    size_t cache_bytes_ = 0;
+    size_t cache_limit_;
+
+    uint64_t requests_ = 0;
+    uint64_t transpiled_ = 0;
+    uint64_t cache_hits_ = 0;
+    uint64_t failures_ = 0;
+
+    // Socket mode: woken on shutdown so blocked accept/recv calls return
+    std::atomic<int> listen_fd_{-1};
+    std::mutex connections_mutex_;
+    std::vector<int> connections_;
+    std::vector<std::thread::id> finished_workers_;    // Closed connections, joined by the accept loop
+
+    JsonValue dispatch(const std::string& method, const JsonValue& params,
+                       int& error_code, std::string& error);
+    JsonValue transpileRequest(const JsonValue& params, int& error_code, std::string& error);
+    JsonValue statusRequest() const;
+
+    Transpiler& transpilerFor(TargetLanguage target);
+    bool cacheLookup(const std::string& key, std::string& code);
+    void cacheStore(const std::string& key, const std::string& code);
+
+    void serveConnection(int fd);
+    void wakeListener();
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_SERVER_H
@@ -0,0 +1,126 @@
+#ifndef HYBRID_SHARD_MANIFEST_H
+#define HYBRID_SHARD_MANIFEST_H
+
+#include "transpiler.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hybrid {
+
+class JsonValue;
+
+/**
+ * One shard of a batch split over several machines (--shard i/N)
+ */
+struct ShardSpec {
+    size_t index = 0;       // 0-based; written 1-based ("1/4" is index 0)
+    size_t count = 1;
+
+    /**
+     * Parse "i/N" with 1 <= i <= N
+     * @return false with error set if malformed
+     */
+    static bool parse(const std::string& text, ShardSpec& spec, std::string& error);
+
+    std::string toString() const;
+
+    /**
+     * Shard of every input, balanced by size
+     *
+     * Inputs are dealt largest first (ties by path) to the shard with the
+     * fewest bytes so far (ties to the lowest index), so every machine given
+     * the same input list and tree computes the same split. Unreadable
+     * inputs count as empty; they fail in whichever shard gets them.
+     */
+    static std::vector<size_t> assign(const std::vector<std::string>& inputs, size_t count);
+    static std::vector<size_t> assign(const std::vector<std::string>& inputs,
+                                      const std::vector<uint64_t>& sizes, size_t count);
+};
+
+/**
+ * What a shard did with one of its inputs
+ */
+struct ManifestEntry {
+    std::string input_path;
+    std::vector<std::string> output_paths;  // One per target, in manifest target order
+    std::string ir_path;                    // Serialized IR (empty if the file failed or ran out of budget)
+    std::string source_hash;                // BuildCache::contentHash of the input
+    double elapsed_ms = 0.0;
+    bool success = false;
+    bool cache_hit = false;
+    bool over_budget = false;
+    std::string diagnostic;                 // Error, or what ran out
+    std::vector<std::string> resolved_bases;    // Set by merge: bases defined in other files
+};
+
+/**
+ * Record of one shard's run, and of a merge of all of them
+ *
+ * Written as JSON next to the outputs. It carries the options that shape
+ * the generated code, so the merge regenerates exactly as the shards did.
+ * Paths are as the shard saw them: shards and the merge run from the same
+ * directory layout (a shared checkout or file system).
+ */
+struct ShardManifest {
+    static constexpr int kFormatVersion = 1;
+
+    ShardSpec shard;
+    std::vector<TargetLanguage> targets;
+    int optimization_level = 0;
+    size_t monomorphization_budget = 0;
+    bool enable_safety_checks = true;
+    bool preserve_comments = true;
+    bool generate_tests = false;
+    std::vector<ManifestEntry> entries;
+
+    static ShardManifest fromBatch(const ShardSpec& shard, const TranspilerOptions& options,
+                                   const std::vector<FileResult>& results);
+
+    /**
+     * Options to regenerate this manifest's outputs with
+     */
+    TranspilerOptions options() const;
+
+    JsonValue toJson() const;
+    static bool fromJson(const JsonValue& json, ShardManifest& manifest, std::string& error);
+
+    /**
+     * @return false with error set on I/O or format errors
+     */
+    bool write(const std::string& path, std::string& error) const;
+    static bool read(const std::string& path, ShardManifest& manifest, std::string& error);
+};
+
+/**
+ * Outcome of ShardMerger::merge()
+ */
+struct MergeResult {
+    bool success = false;
+    std::string error;
+    ShardManifest manifest;                 // Every shard's entries, in input order of shard 1, 2, ...
+    size_t regenerated = 0;                 // Files rewritten with bases from other files
+    std::vector<std::string> unresolved;    // "Class: Base" pairs no shard defines
+};
+
+/**
+ * Combines the manifests of every shard of a batch
+ *
+ * Each shard sees only its own files, so a class whose base is defined in
+ * a file of another shard (or just another file) was generated without
+ * the base's virtual methods. The merge loads every file's IR, attaches the
+ * IRs that define the missing bases (transitively) to each file that
+ * needs them, and regenerates only those files. Nothing is parsed again.
+ */
+class ShardMerger {
+public:
+    /**
+     * Fails if shards disagree on the count or options, one is missing or
+     * repeated, or an IR cannot be loaded.
+     */
+    static MergeResult merge(const std::vector<ShardManifest>& shards);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_SHARD_MANIFEST_H
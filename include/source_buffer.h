@@ -0,0 +1,208 @@
+#ifndef HYBRID_SOURCE_BUFFER_H
+#define HYBRID_SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Byte range in a source buffer
+ */
+struct SourceSpan {
+    size_t offset = 0;
+    size_t length = 0;
+
+    bool empty() const { return length == 0; }
+    size_t end() const { return offset + length; }
+};
+
+/**
+ * 1-based line/column position
+ */
+struct SourceLocation {
+    uint32_t line = 0;
+    uint32_t column = 0;
+};
+
+/**
+ * Immutable contents of one input file
+ *
+ * Shared by the IR and every SourceText that points into it, so the file
+ * is held in memory exactly once however many slices the IR keeps.
+ */
+class SourceBuffer {
+public:
+    /**
+     * Wrap an in-memory source
+     */
+    static std::shared_ptr<const SourceBuffer> fromString(std::string content,
+                                                          std::string path = "");
+
+    /**
+     * Read a file; throws std::runtime_error if it cannot be opened
+     *
+     * Regular files of kMapThreshold bytes or more are memory-mapped
+     * read-only, so the bytes the IR points into are never copied; smaller
+     * files, pipes and anything mmap refuses are read with one bulk read.
+     * A mapped file that is truncated while mapped faults (SIGBUS) on
+     * access, so long-running callers reading files that are being edited
+     * pass allow_map = false.
+     */
+    static std::shared_ptr<const SourceBuffer> fromFile(const std::string& path, bool allow_map = true);
+
+    /**
+     * Below this size a read is cheaper than setting up a mapping
+     */
+    static constexpr size_t kMapThreshold = 64 * 1024;
+
+    /**
+     * View a range of another buffer as a source of its own, without
+     * copying it; the new buffer keeps 'parent' alive. Offsets, lines and
+     * columns are relative to the start of the range.
+     */
+    static std::shared_ptr<const SourceBuffer> fromRange(std::shared_ptr<const SourceBuffer> parent,
+                                                         SourceSpan span, std::string path);
+
+    std::string_view text() const { return text_; }
+    const std::string& getPath() const { return path_; }
+    size_t size() const { return text_.size(); }
+    bool isMapped() const { return mapping_ != nullptr; }
+
+    std::string_view slice(const SourceSpan& span) const {
+        return span.offset < text_.size() ? text_.substr(span.offset, span.length)
+                                          : std::string_view();
+    }
+
+    /**
+     * Line and column of a byte offset (line table built on first use)
+     */
+    SourceLocation locate(size_t offset) const;
+
+    SourceBuffer(std::string content, std::string path);
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+private:
+    std::string storage_;
+    std::string_view text_;         // storage_ or the mapping
+    std::string path_;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    std::shared_ptr<const SourceBuffer> parent_;    // Owner of text_ for fromRange()
+
+    SourceBuffer(void* mapping, size_t size, std::string path);
+
+    mutable std::once_flag lines_once_;
+    mutable std::vector<size_t> line_starts_;
+};
+
+/**
+ * Text stored in the IR (bodies, initializers, default values)
+ *
+ * Either a span into a shared SourceBuffer, which costs no copy of the
+ * text, or an owned string for text that does not exist verbatim in the
+ * source (comment-stripped slices, analyzer output, hand-built IR).
+ * When the text came from the source, span() is its exact location.
+ */
+class SourceText {
+public:
+    SourceText() = default;
+    SourceText(std::string text) : owned_(std::move(text)) {}
+    SourceText(const char* text) : owned_(text) {}
+
+    SourceText(std::shared_ptr<const SourceBuffer> buffer, SourceSpan span)
+        : buffer_(std::move(buffer)), span_(span), is_view_(true) {}
+
+    /**
+     * Owned text with its originating span kept for diagnostics
+     */
+    SourceText(std::string text, std::shared_ptr<const SourceBuffer> buffer, SourceSpan span)
+        : owned_(std::move(text)), buffer_(std::move(buffer)), span_(span) {}
+
+    SourceText& operator=(std::string text) {
+        owned_ = std::move(text);
+        buffer_.reset();
+        span_ = SourceSpan{};
+        is_view_ = false;
+        return *this;
+    }
+
+    SourceText& operator=(const char* text) { return *this = std::string(text); }
+
+    std::string_view view() const {
+        return is_view_ && buffer_ ? buffer_->slice(span_) : std::string_view(owned_);
+    }
+
+    std::string str() const { return std::string(view()); }
+
+    operator std::string_view() const { return view(); }
+    operator std::string() const { return str(); }
+
+    bool empty() const { return view().empty(); }
+    size_t size() const { return view().size(); }
+
+    size_t find(std::string_view needle, size_t pos = 0) const { return view().find(needle, pos); }
+
+    /**
+     * Sub-range of this text; stays a view into the buffer when this one is
+     */
+    SourceText substr(size_t pos, size_t count) const {
+        std::string_view text = view().substr(pos, count);
+        if (is_view_ && buffer_) {
+            return SourceText(buffer_, SourceSpan{span_.offset + pos, text.size()});
+        }
+        return SourceText(std::string(text));
+    }
+
+    /**
+     * Point at the same text in another buffer, 'delta' bytes further on;
+     * used to carry an unchanged declaration over to an edited source
+     */
+    void rebase(const std::shared_ptr<const SourceBuffer>& buffer, std::ptrdiff_t delta) {
+        if (!buffer_) return;
+        buffer_ = buffer;
+        span_.offset = static_cast<size_t>(static_cast<std::ptrdiff_t>(span_.offset) + delta);
+    }
+
+    bool isView() const { return is_view_; }
+    const SourceSpan& span() const { return span_; }
+    const SourceBuffer* getBuffer() const { return buffer_.get(); }
+
+    friend bool operator==(const SourceText& a, std::string_view b) { return a.view() == b; }
+    friend bool operator!=(const SourceText& a, std::string_view b) { return a.view() != b; }
+
+    friend std::ostream& operator<<(std::ostream& os, const SourceText& text) {
+        return os << text.view();
+    }
+
+    friend std::string operator+(const std::string& a, const SourceText& b) {
+        std::string result = a;
+        result.append(b.view());
+        return result;
+    }
+
+    friend std::string operator+(const SourceText& a, const std::string& b) {
+        std::string result = a.str();
+        result += b;
+        return result;
+    }
+
+private:
+    std::string owned_;
+    std::shared_ptr<const SourceBuffer> buffer_;
+    SourceSpan span_;
+    bool is_view_ = false;
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_SOURCE_BUFFER_H
@@ -0,0 +1,69 @@
+#ifndef HYBRID_THREAD_POOL_H
+#define HYBRID_THREAD_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hybrid {
+
+/**
+ * Work-stealing thread pool
+ *
+ * Each worker owns a deque of task indices. A worker pops from the back of
+ * its own deque and, once empty, steals from the front of the others, so a
+ * few slow inputs do not leave the remaining workers idle.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @param num_threads Number of workers; 0 selects hardware concurrency
+     */
+    explicit WorkStealingPool(size_t num_threads = 0);
+
+    /**
+     * Run task(i) for every i in [0, count) and wait for completion.
+     * A task that throws does not stop the others; once all are done, the
+     * exception of the lowest such index is rethrown.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    size_t getThreadCount() const { return num_threads_; }
+
+    /**
+     * Resolve a --jobs value (0 = hardware concurrency, at least 1)
+     */
+    static size_t resolveThreadCount(size_t requested);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    /**
+     * First exception (by task index) of a parallelFor() call
+     */
+    struct Failure {
+        std::mutex mutex;
+        std::exception_ptr error;
+        size_t index = 0;
+
+        void record(size_t task, std::exception_ptr exception);
+    };
+
+    size_t num_threads_;
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+
+    bool popLocal(size_t worker, size_t& task);
+    bool steal(size_t thief, size_t& task);
+    void workerLoop(size_t worker, const std::function<void(size_t)>& task, Failure& failure);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_THREAD_POOL_H
@@ -0,0 +1,118 @@
+#ifndef HYBRID_TRANSPILE_SESSION_H
+#define HYBRID_TRANSPILE_SESSION_H
+
+#include "transpiler.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hybrid {
+
+class BuildCache;
+class ClangFrontEnd;
+class HeaderCache;
+class IR;
+class SourceBuffer;
+
+/**
+ * One call to TranspileSession::transpile()
+ */
+struct SessionRequest {
+    std::shared_ptr<const SourceBuffer> source;
+    std::vector<TargetLanguage> targets;    // Empty = the session's targets
+    std::string declaration;                // Only this class, without the file header (empty = whole source)
+};
+
+/**
+ * Generated code for one target of a request
+ */
+struct SessionOutput {
+    TargetLanguage target = TargetLanguage::Rust;
+    std::string code;                       // Serialized IR with emit_ir
+    bool cache_hit = false;
+};
+
+/**
+ * Outcome of one call; nothing about it is kept in the session
+ */
+struct SessionResult {
+    bool success = false;
+    bool over_budget = false;               // Outputs are signatures only (still a success)
+    std::string error;                      // Failure, or with over_budget what ran out
+    std::vector<SessionOutput> outputs;     // One per target, in request order
+    size_t classes = 0;                     // Declarations in the parsed IR (0 if every output was cached)
+    size_t functions = 0;
+    double parse_ms = 0.0;
+    double generate_ms = 0.0;
+};
+
+/**
+ * Reentrant transpiler for embedding (libhybrid_core)
+ *
+ * Unlike Transpiler, which keeps its IR, generator and last error between
+ * calls and so serves one caller at a time, a session keeps no per-call
+ * state: transpile() may be called from any number of threads at once.
+ * Each call borrows a workspace (code generators and an output buffer)
+ * from a pool and returns it afterwards, so a steady stream of calls
+ * reuses their allocations instead of making new ones. The pool grows to
+ * the number of concurrent callers.
+ *
+ * Options are fixed at construction. Code is generated on the calling
+ * thread (options.jobs is not used); concurrency comes from the callers.
+ * With options.cache_dir, outputs are cached as in batch runs, and each
+ * call has its own time and memory budget as each file of a batch does.
+ */
+class TranspileSession {
+public:
+    explicit TranspileSession(const TranspilerOptions& options);
+    ~TranspileSession();
+
+    TranspileSession(const TranspileSession&) = delete;
+    TranspileSession& operator=(const TranspileSession&) = delete;
+
+    SessionResult transpile(const SessionRequest& request);
+
+    /**
+     * Whole source, to the session's targets
+     */
+    SessionResult transpile(const std::shared_ptr<const SourceBuffer>& source);
+
+    /**
+     * Read a file (or serialized IR) and transpile it
+     */
+    SessionResult transpileFile(const std::string& input_path);
+
+    const TranspilerOptions& getOptions() const { return options_; }
+
+    /**
+     * Workspaces created so far (the most calls that have run at once)
+     */
+    size_t getWorkspaceCount() const;
+
+private:
+    struct Workspace;
+
+    const TranspilerOptions options_;
+    std::unique_ptr<BuildCache> cache_;
+    std::unique_ptr<ClangFrontEnd> clang_;
+    std::unique_ptr<HeaderCache> headers_;     // With resolve_includes; shared by every call
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Workspace>> idle_;
+    size_t workspaces_ = 0;
+
+    std::unique_ptr<Workspace> acquire();
+    void release(std::unique_ptr<Workspace> workspace);
+
+    /**
+     * Generate the outputs that were not cached; sets result.error on failure
+     */
+    void generateOutputs(const SessionRequest& request, const IR& ir,
+                         const std::vector<size_t>& pending, const std::vector<std::string>& keys,
+                         Workspace& workspace, SessionResult& result);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_TRANSPILE_SESSION_H
@@ -1,15 +1,24 @@
 #ifndef HYBRID_TRANSPILER_H
 #define HYBRID_TRANSPILER_H
 
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
 
+#define HYBRID_TRANSPILER_VERSION "0.1.0"
+
 namespace hybrid {
 
 // Forward declarations
 class IR;
 class CodeGenerator;
+class BuildCache;
+class SourceBuffer;
+class FileSink;
+class DeclarationIndex;
+class ClangFrontEnd;
+class HeaderCache;
 
 /**
  * Target language for transpilation
@@ -19,18 +28,57 @@ enum class TargetLanguage {
     Go
 };
 
+/**
+ * C++ front end that builds the IR
+ */
+enum class FrontEnd {
+    Simple,     // Built-in parser (default)
+    Clang       // Clang AST; needs a build with Clang
+};
+
 /**
  * Transpilation options
  */
 struct TranspilerOptions {
     TargetLanguage target = TargetLanguage::Rust;
+    std::vector<TargetLanguage> targets;    // Generate all of these from one parse (empty = target only)
     int optimization_level = 0;
+    size_t monomorphization_budget = 0;     // Instantiations of a class template before it is type-erased (0 = no limit)
     bool enable_safety_checks = true;
     bool preserve_comments = true;
     bool generate_tests = false;
+    bool generate_benchmarks = false;       // Also write benchmark harnesses (see Transpiler::benchmarkOutputPath)
     bool verbose = false;           // Verbose output
     bool quiet = false;             // Minimal output
+    int jobs = 1;                   // Parallel jobs (0 = hardware concurrency)
+    std::string output_path;
+    std::string cache_dir;          // Output cache directory (empty = disabled)
+    bool emit_ir = false;           // Write analyzed, serialized IR (.hir) instead of code
+    bool keep_ir = false;           // Also write each file's IR next to its output (Transpiler::irOutputPath)
+    FrontEnd frontend = FrontEnd::Simple;
+    std::string compile_commands_dir;       // Clang: directory of compile_commands.json
+    std::vector<std::string> clang_args;    // Clang: appended to every compile command
+    bool resolve_includes = false;          // Built-in front end: see the classes of quoted #includes (HeaderCache)
+    std::vector<std::string> include_dirs;  // Searched for quoted #includes after the including file's directory
+    uint64_t time_budget_ms = 0;            // Per-file wall-time limit (0 = none)
+    uint64_t memory_budget_mb = 0;          // Per-file limit on tokens, IR and copies (0 = none)
+};
+
+/**
+ * Outcome of transpiling one file in a batch
+ */
+struct FileResult {
+    std::string input_path;
     std::string output_path;
+    std::vector<std::string> output_paths;  // Every file written, one per target
+    std::vector<std::string> benchmark_paths;   // With generate_benchmarks: harnesses, then the C++ stubs
+    std::string ir_path;        // With keep_ir or emit_ir: the file's serialized IR
+    std::string source_hash;    // With keep_ir: BuildCache::contentHash of the input
+    double elapsed_ms = 0.0;    // Wall time spent on this file
+    bool success = false;
+    bool cache_hit = false;
+    bool over_budget = false;   // Ran out of budget; signatures only were written (still a success)
+    std::string error;          // Failure, or with over_budget what ran out
 };
 
 /**
@@ -50,24 +98,177 @@ public:
 
     /**
      * Transpile multiple C++ source files
+     *
+     * Files are processed on options.jobs workers, each with its own IR and
+     * code generators. A failing file does not stop the batch; per-file
+     * outcomes are available from getBatchResults() in input order.
+     * With several targets each file is parsed once and every generator
+     * reads the same IR, concurrently when jobs are left over.
+     *
      * @param input_paths Vector of paths to C++ source files
      * @return true if all successful, false otherwise
      */
     bool transpileBatch(const std::vector<std::string>& input_paths);
 
+    /**
+     * Transpile multiple files with explicit output paths
+     * @param output_paths One output path per input, same order
+     */
+    bool transpileBatch(const std::vector<std::string>& input_paths,
+                        const std::vector<std::string>& output_paths);
+
+    /**
+     * Transpile an in-memory source into a string
+     *
+     * Reuses this Transpiler's code generator and cache across calls, which
+     * is what keeps a long-lived caller (the server) warm.
+     * @return false with getLastError() set on failure
+     */
+    bool transpileSource(const std::shared_ptr<const SourceBuffer>& source, std::string& code);
+
+    /**
+     * Transpile one class of an indexed source, without the file header
+     *
+     * Only the class and the base classes it names are parsed, so the cost
+     * follows their size rather than the file's. Build the index once per
+     * source version and reuse it for every lookup.
+     * @return false with getLastError() set if the class is unknown or fails
+     */
+    bool transpileDeclaration(const DeclarationIndex& index, const std::string& name, std::string& code);
+
+    const TranspilerOptions& getOptions() const { return options_; }
+
     /**
      * Get the last error message
      */
     const std::string& getLastError() const { return last_error_; }
 
+    /**
+     * Per-file results of the last transpileBatch() call, in input order
+     */
+    const std::vector<FileResult>& getBatchResults() const { return batch_results_; }
+
+    /**
+     * Headers shared by the inputs so far, with resolve_includes (else nullptr)
+     */
+    const HeaderCache* getHeaderCache() const { return headers_.get(); }
+
+    /**
+     * Targets to generate: options.targets, or just options.target
+     */
+    static std::vector<TargetLanguage> getTargets(const TranspilerOptions& options);
+
+    /**
+     * Where one of several targets goes: output_path with that target's extension
+     */
+    static std::string targetOutputPath(const std::string& output_path, TargetLanguage target);
+
+    /**
+     * Output path derived from the input name (foo.cpp -> foo.rs / foo.go)
+     */
+    static std::string defaultOutputPath(const std::string& input_path, TargetLanguage target);
+    static std::string defaultOutputPath(const std::string& input_path, const TranspilerOptions& options);
+
+    /**
+     * Where the benchmark harness for a target's output goes: foo_bench.rs
+     * (a Criterion bench) or foo_test.go (testing.B, same package)
+     */
+    static std::string benchmarkOutputPath(const std::string& output_path, TargetLanguage target);
+
+    /**
+     * Where the matching Google Benchmark stubs for the C++ go: foo_bench.cpp
+     */
+    static std::string cppBenchmarkOutputPath(const std::string& output_path);
+
+    /**
+     * Where keep_ir writes a file's IR: the output path with ".hir"
+     */
+    static std::string irOutputPath(const std::string& output_path);
+
+    /**
+     * File extension for generated code (".rs" / ".go"), or ".hir" with emit_ir
+     */
+    static std::string outputExtension(TargetLanguage target);
+    static std::string outputExtension(const TranspilerOptions& options);
+
+    /**
+     * Write generated code, creating missing parent directories
+     * @return false with error set on failure
+     */
+    static bool writeOutputFile(const std::string& output_path, const std::string& code, std::string& error);
+
+    /**
+     * Code generator for a target language, at an optimization level (0-3)
+     */
+    static std::unique_ptr<CodeGenerator> createCodeGenerator(TargetLanguage target, int optimization_level = 0);
+
+    /**
+     * Same, with every generator setting the options carry
+     * (optimization level, monomorphization budget)
+     */
+    static std::unique_ptr<CodeGenerator> createCodeGenerator(TargetLanguage target, const TranspilerOptions& options);
+
+    /**
+     * Fallback output for a file that ran out of budget
+     *
+     * Drops bodies and their analysis from the IR (what was parsed before
+     * the budget ran out, possibly only part of the file), then generates
+     * the remaining declarations with a leading comment with the
+     * diagnostic, or serializes them with options.emit_ir.
+     */
+    static std::string generateSignaturesOnly(IR& ir, TargetLanguage target, const TranspilerOptions& options,
+                                              const std::string& diagnostic);
+
+    /**
+     * Read an input once into a buffer shared by the cache key and the IR
+     * @return false with error set if it cannot be read
+     */
+    static bool readSourceFile(const std::string& input_path,
+                               std::shared_ptr<const SourceBuffer>& source, std::string& error);
+
+    /**
+     * Whether outputs are generated from an analyzed IR: serialized IR
+     * keeps the analysis, and levels 2 and up lower from its results
+     */
+    static bool needsAnalysis(const TranspilerOptions& options) {
+        return options.emit_ir || options.optimization_level >= 2;
+    }
+
+    /**
+     * Parse a C++ source (with Clang when 'clang' is set, and analyze it
+     * when 'analyze'), or load it if it is serialized IR. With 'headers',
+     * the declarations of the headers the source includes are attached to
+     * the IR. Safe to call concurrently with distinct IRs.
+     * @return false with error set on failure
+     */
+    static bool loadIR(const std::shared_ptr<const SourceBuffer>& source, ClangFrontEnd* clang,
+                       HeaderCache* headers, bool analyze, IR& ir, std::string& error);
+
 private:
     TranspilerOptions options_;
     std::unique_ptr<IR> ir_;
     std::unique_ptr<CodeGenerator> codegen_;
+    std::unique_ptr<BuildCache> cache_;
+    std::unique_ptr<ClangFrontEnd> clang_;  // With FrontEnd::Clang
+    std::unique_ptr<HeaderCache> headers_;  // With resolve_includes; shared by batch workers
     std::string last_error_;
+    std::vector<FileResult> batch_results_;
+
+    bool parseSourceFile(const std::shared_ptr<const SourceBuffer>& source);
+
+    // Self-contained pipeline for one batch entry; safe to run concurrently
+    FileResult transpileFile(const std::string& input_path, const std::string& output_path,
+                             size_t codegen_jobs) const;
+    std::string batchOutputPath(const std::string& input_path, size_t batch_size) const;
+
+    // Benchmark harnesses for every target of a generated file, and the C++ stubs
+    bool writeBenchmarks(const IR& ir, const std::vector<TargetLanguage>& targets, FileResult& result) const;
+
+    static bool openOutputFile(const std::string& output_path, FileSink& sink, std::string& error);
 
-    bool parseSourceFile(const std::string& input_path);
-    bool generateCode(const std::string& output_path);
+    // Stream generated code to output_path; 'captured' (optional) also receives the text
+    static bool emitCode(CodeGenerator& codegen, const IR& ir, const std::string& output_path,
+                         std::string* captured, std::string& error);
 };
 
 } // namespace hybrid
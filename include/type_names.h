@@ -0,0 +1,199 @@
+#ifndef HYBRID_TYPE_NAMES_H
+#define HYBRID_TYPE_NAMES_H
+
+#include "ir.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace hybrid {
+
+/**
+ * A C++ builtin type with its size and its spelling in each target
+ */
+struct BuiltinTypeName {
+    std::string_view name;
+    TypeKind kind;
+    uint8_t size_bytes;
+    std::string_view rust;
+    std::string_view go;
+};
+
+/**
+ * A standard library class (unqualified name) and the kind it maps to
+ */
+struct STLTypeName {
+    std::string_view name;
+    TypeKind kind;
+};
+
+inline constexpr BuiltinTypeName kBuiltinTypeNames[] = {
+    {"void", TypeKind::Void, 0, "()", ""},
+    {"bool", TypeKind::Bool, 1, "bool", "bool"},
+    {"char", TypeKind::Integer, 1, "i8", "int8"},
+    {"short", TypeKind::Integer, 2, "i16", "int16"},
+    {"int", TypeKind::Integer, 4, "i32", "int32"},
+    {"long", TypeKind::Integer, 8, "i64", "int64"},
+    {"long long", TypeKind::Integer, 8, "i64", "int64"},
+    {"unsigned char", TypeKind::Integer, 1, "u8", "uint8"},
+    {"unsigned short", TypeKind::Integer, 2, "u16", "uint16"},
+    {"unsigned int", TypeKind::Integer, 4, "u32", "uint32"},
+    {"unsigned long", TypeKind::Integer, 8, "u64", "uint64"},
+    {"unsigned long long", TypeKind::Integer, 8, "u64", "uint64"},
+    {"int8_t", TypeKind::Integer, 1, "i8", "int8"},
+    {"int16_t", TypeKind::Integer, 2, "i16", "int16"},
+    {"int32_t", TypeKind::Integer, 4, "i32", "int32"},
+    {"int64_t", TypeKind::Integer, 8, "i64", "int64"},
+    {"uint8_t", TypeKind::Integer, 1, "u8", "uint8"},
+    {"uint16_t", TypeKind::Integer, 2, "u16", "uint16"},
+    {"uint32_t", TypeKind::Integer, 4, "u32", "uint32"},
+    {"uint64_t", TypeKind::Integer, 8, "u64", "uint64"},
+    {"size_t", TypeKind::Integer, 8, "usize", "uint"},
+    {"float", TypeKind::Float, 4, "f32", "float32"},
+    {"double", TypeKind::Float, 8, "f64", "float64"},
+};
+
+inline constexpr STLTypeName kSTLTypeNames[] = {
+    {"vector", TypeKind::StdVector},
+    {"list", TypeKind::StdList},
+    {"deque", TypeKind::StdDeque},
+    {"map", TypeKind::StdMap},
+    {"unordered_map", TypeKind::StdUnorderedMap},
+    {"set", TypeKind::StdSet},
+    {"unordered_set", TypeKind::StdUnorderedSet},
+    {"string", TypeKind::StdString},
+    {"pair", TypeKind::StdPair},
+    {"optional", TypeKind::StdOptional},
+    {"thread", TypeKind::StdThread},
+    {"mutex", TypeKind::StdMutex},
+    {"recursive_mutex", TypeKind::StdRecursiveMutex},
+    {"shared_mutex", TypeKind::StdSharedMutex},
+    {"condition_variable", TypeKind::StdConditionVariable},
+    {"atomic", TypeKind::StdAtomic},
+    {"lock_guard", TypeKind::StdLockGuard},
+    {"unique_lock", TypeKind::StdUniqueLock},
+    {"shared_lock", TypeKind::StdSharedLock},
+    {"future", TypeKind::StdFuture},
+    {"promise", TypeKind::StdPromise},
+};
+
+/**
+ * Seeded FNV-1a with the high half folded into the low bits
+ */
+constexpr uint32_t hashTypeName(std::string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+/**
+ * Perfect hash over a fixed table of names, built at compile time
+ *
+ * Each entry owns one of Slots slots (hash % Slots); a lookup hashes once
+ * and compares one name. The seed is chosen so that no two entries share
+ * a slot, which isPerfect() lets a static_assert check.
+ */
+template <typename Entry, size_t Count, size_t Slots>
+class PerfectHashTable {
+public:
+    constexpr PerfectHashTable(const Entry (&entries)[Count], uint32_t seed)
+        : entries_(entries), seed_(seed) {
+        static_assert(Count < 256, "slots hold 8-bit indexes");
+        for (size_t i = 0; i < Count; ++i) {
+            size_t slot = hashTypeName(entries[i].name, seed) % Slots;
+            perfect_ = perfect_ && slots_[slot] == 0;
+            slots_[slot] = static_cast<uint8_t>(i + 1);
+        }
+    }
+
+    constexpr bool isPerfect() const { return perfect_; }
+
+    /**
+     * Index of the entry with this name, or Count if there is none
+     */
+    constexpr size_t indexOf(std::string_view name) const {
+        uint8_t index = slots_[hashTypeName(name, seed_) % Slots];
+        if (index == 0 || entries_[index - 1].name != name) {
+            return Count;
+        }
+        return index - 1;
+    }
+
+    constexpr const Entry* find(std::string_view name) const {
+        size_t index = indexOf(name);
+        return index < Count ? &entries_[index] : nullptr;
+    }
+
+private:
+    const Entry* entries_;
+    uint32_t seed_;
+    std::array<uint8_t, Slots> slots_{};    // Entry index + 1, 0 when empty
+    bool perfect_ = true;
+};
+
+inline constexpr PerfectHashTable<BuiltinTypeName, std::size(kBuiltinTypeNames), 32>
+    kBuiltinTypeTable(kBuiltinTypeNames, 44859);
+inline constexpr PerfectHashTable<STLTypeName, std::size(kSTLTypeNames), 32>
+    kSTLTypeTable(kSTLTypeNames, 4272);
+
+static_assert(kBuiltinTypeTable.isPerfect(), "builtin type names collide; choose another seed");
+static_assert(kSTLTypeTable.isPerfect(), "STL type names collide; choose another seed");
+
+/**
+ * Look up a builtin type by its exact spelling ("unsigned int", "size_t")
+ * @return nullptr if the name is not a builtin type
+ */
+constexpr const BuiltinTypeName* findBuiltinType(std::string_view name) {
+    return kBuiltinTypeTable.find(name);
+}
+
+/**
+ * Kind of a standard library class named without "std::" ("vector", "mutex")
+ * @return TypeKind::Template if the name is not a known one
+ */
+constexpr TypeKind findSTLTypeKind(std::string_view name) {
+    // By index: comparing member addresses with null is not constant under sanitizers
+    size_t index = kSTLTypeTable.indexOf(name);
+    return index < std::size(kSTLTypeNames) ? kSTLTypeNames[index].kind : TypeKind::Template;
+}
+
+/**
+ * Kind of a standard type, also when the front end left it as a class
+ * named by its spelling ("std::mutex", "std::vector<int>")
+ */
+inline TypeKind standardTypeKind(const Type& type) {
+    if (type.kind != TypeKind::Class || type.name.compare(0, 5, "std::") != 0) {
+        return type.kind;
+    }
+    std::string_view name(type.name);
+    name = name.substr(5, name.find('<') - 5);
+    TypeKind kind = findSTLTypeKind(name);
+    return kind == TypeKind::Template ? type.kind : kind;
+}
+
+/**
+ * Number of template arguments the generators read for a standard kind
+ * (the value type of a container, key and value of a map)
+ */
+constexpr size_t stdTemplateArity(TypeKind kind) {
+    switch (kind) {
+        case TypeKind::StdMap:
+        case TypeKind::StdUnorderedMap:
+        case TypeKind::StdPair:
+            return 2;
+        case TypeKind::StdString:
+        case TypeKind::StdThread:
+        case TypeKind::StdConditionVariable:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+} // namespace hybrid
+
+#endif // HYBRID_TYPE_NAMES_H
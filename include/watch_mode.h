@@ -0,0 +1,102 @@
+#ifndef HYBRID_WATCH_MODE_H
+#define HYBRID_WATCH_MODE_H
+
+#include "file_watcher.h"
+#include "transpiler.h"
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hybrid {
+
+class AnalysisPassManager;
+class BuildCache;
+class IncrementalSession;
+
+/**
+ * Outcome of rebuilding one input in watch mode
+ */
+struct WatchResult {
+    FileResult file;
+    bool unchanged = false;     // Same content hash as the last build; nothing written
+    size_t reparsed = 0;        // Classes the incremental session had to parse again
+    size_t declarations = 0;
+};
+
+/**
+ * --watch: keep outputs up to date as inputs change
+ *
+ * Directories of the inputs are watched through a FileWatcher. Changes
+ * are debounced, then the affected inputs are rebuilt on the worker pool
+ * (options.jobs). An input whose content hash (BuildCache::computeKey)
+ * matches its last build is skipped, a hit in the --cache-dir cache is
+ * written as is, and anything else goes through the input's
+ * IncrementalSession, so only edited classes are parsed again.
+ */
+class WatchMode {
+public:
+    /**
+     * Resolve the current inputs and their output paths; called at start
+     * and whenever source files or directories appear or disappear
+     */
+    using Collector = std::function<bool(std::vector<std::string>& inputs,
+                                         std::vector<std::string>& outputs, std::string& error)>;
+
+    WatchMode(const TranspilerOptions& options, Collector collect);
+    ~WatchMode();
+
+    /**
+     * Also watch a directory tree given as input, so files created in it
+     * (or in new subdirectories) are picked up
+     */
+    void addTree(const std::string& dir, bool recursive);
+
+    /**
+     * Build everything, then rebuild on changes until SIGINT/SIGTERM
+     * @return Process exit code
+     */
+    int run(std::ostream& log);
+
+    /**
+     * Re-resolve the inputs and watch their directories
+     * @return false with error set if the collector fails; inputs are kept
+     */
+    bool refresh(std::string& error);
+
+    /**
+     * Rebuild the inputs named in paths, plus every input not built yet
+     */
+    std::vector<WatchResult> rebuild(const std::vector<std::string>& paths);
+
+    size_t getInputCount() const { return files_.size(); }
+    const FileWatcher& getWatcher() const { return watcher_; }
+
+private:
+    struct WatchedFile {
+        std::string input;
+        std::string output;
+        std::string key;            // Cache key of the last successful build
+        bool built = false;
+        std::unique_ptr<IncrementalSession> session;
+        std::unique_ptr<AnalysisPassManager> analysis;     // As in batch runs (see Transpiler::needsAnalysis)
+    };
+
+    TranspilerOptions options_;
+    Collector collect_;
+    std::unique_ptr<BuildCache> cache_;
+    FileWatcher watcher_;
+    std::vector<std::pair<std::string, bool>> trees_;
+    std::unordered_map<std::string, std::unique_ptr<WatchedFile>> by_path_;  // Normalized input path
+    std::vector<WatchedFile*> files_;                                       // Collector order
+
+    WatchResult build(WatchedFile& file) const;
+    void report(const std::vector<WatchResult>& results, double milliseconds, std::ostream& log) const;
+    static std::string normalize(const std::string& path);
+};
+
+} // namespace hybrid
+
+#endif // HYBRID_WATCH_MODE_H
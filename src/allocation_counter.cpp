@@ -0,0 +1,28 @@
+/**
+ * Allocation counters for the profiler
+ *
+ * The counting operator new lives in allocation_hooks.cpp, linked only
+ * into executables: a library must not replace its host's allocator.
+ */
+
+#include "profiler.h"
+
+namespace hybrid {
+
+namespace detail {
+
+// Plain counters: safe to touch from operator new at any point of a thread's life
+thread_local uint64_t tl_allocations = 0;
+thread_local uint64_t tl_allocated_bytes = 0;
+
+} // namespace detail
+
+uint64_t Profiler::threadAllocations() {
+    return detail::tl_allocations;
+}
+
+uint64_t Profiler::threadAllocatedBytes() {
+    return detail::tl_allocated_bytes;
+}
+
+} // namespace hybrid
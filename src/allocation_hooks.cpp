@@ -0,0 +1,38 @@
+/**
+ * Counting global operator new for the profiler
+ *
+ * Kept in its own translation unit so the replaced global allocator is not
+ * inlined into code that also allocates (and stays easy to drop). Linked
+ * into the executables only, never into hybrid_core.
+ */
+
+#include "profiler.h"
+#include <cstdlib>
+#include <new>
+
+void* operator new(std::size_t size) {
+    ++hybrid::detail::tl_allocations;
+    hybrid::detail::tl_allocated_bytes += size;
+    if (size == 0) {
+        size = 1;
+    }
+    for (;;) {
+        if (void* p = std::malloc(size)) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+// The array forms of the standard library forward to these
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    ::operator delete(p);
+}
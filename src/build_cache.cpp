@@ -0,0 +1,169 @@
+#include "build_cache.h"
+#include "profiler.h"
+#include "transpiler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+namespace hybrid {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * 128-bit FNV-1a, fed in pieces; the state is kept as two 64-bit halves
+ */
+class Fnv128 {
+public:
+    void update(std::string_view data) {
+        // Multiply by the prime 2^88 + 0x13b, modulo 2^128
+        constexpr uint64_t kLowPrime = 0x13b;
+        for (unsigned char c : data) {
+            lo_ ^= c;
+            uint64_t carry = ((lo_ >> 32) * kLowPrime + (((lo_ & 0xffffffffULL) * kLowPrime) >> 32)) >> 32;
+            hi_ = hi_ * kLowPrime + carry + (lo_ << 24);
+            lo_ *= kLowPrime;
+        }
+    }
+
+    std::string hex() const {
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                      static_cast<unsigned long long>(hi_),
+                      static_cast<unsigned long long>(lo_));
+        return buffer;
+    }
+
+private:
+    uint64_t hi_ = 0x6c62272e07bb0142ULL;   // Offset basis
+    uint64_t lo_ = 0x62b821756295c58dULL;
+};
+
+} // namespace
+
+BuildCache::BuildCache(std::string cache_dir)
+    : cache_dir_(std::move(cache_dir)) {
+}
+
+uint64_t BuildCache::hashBytes(std::string_view data, uint64_t seed) {
+    // 64-bit FNV-1a
+    uint64_t hash = seed;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string BuildCache::contentHash(std::string_view data) {
+    Fnv128 hash;
+    hash.update(data);
+    return hash.hex();
+}
+
+std::string BuildCache::computeKey(std::string_view source, const TranspilerOptions& options,
+                                   std::string_view dependencies) {
+    ProfileScope scope("cache", "key", std::string_view(), source.size());
+
+    // Only options that change the generated text take part in the key
+    std::ostringstream material;
+    material << HYBRID_TRANSPILER_VERSION << '\n'
+             << static_cast<int>(options.target) << '\n'
+             << options.optimization_level << '\n'
+             << options.enable_safety_checks << '\n'
+             << options.preserve_comments << '\n'
+             << options.generate_tests << '\n'
+             << options.emit_ir << '\n'
+             << source.size() << '\n';
+    if (options.monomorphization_budget > 0) {
+        // Only when set, so entries made without a budget stay valid
+        material << "mono " << options.monomorphization_budget << '\n';
+    }
+    if (options.resolve_includes && options.frontend == FrontEnd::Simple) {
+        // Editing a header changes the declarations the source is generated against
+        material << "includes\n";
+        for (const auto& dir : options.include_dirs) {
+            material << dir << '\n';
+        }
+        material << dependencies << '\n';
+    }
+    if (options.frontend == FrontEnd::Clang) {
+        // Headers are not hashed: a Clang build's cache holds until the source changes
+        material << "clang\n" << options.compile_commands_dir << '\n';
+        for (const auto& arg : options.clang_args) {
+            material << arg << '\n';
+        }
+    }
+    Fnv128 hash;
+    hash.update(material.str());
+    hash.update(source);
+    return hash.hex();
+}
+
+std::string BuildCache::entryPath(const std::string& key) const {
+    // Two-character fan-out keeps directories small on large projects
+    return (fs::path(cache_dir_) / key.substr(0, 2) / key).string();
+}
+
+bool BuildCache::lookup(const std::string& key, std::string& output) const {
+    ProfileScope scope("cache", "lookup", key);
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::ostringstream content;
+    content << file.rdbuf();
+    if (file.bad()) {
+        return false;
+    }
+
+    output = content.str();
+    return true;
+}
+
+void BuildCache::store(const std::string& key, const std::string& output) const {
+    ProfileScope scope("cache", "store", key, output.size());
+    static std::atomic<uint64_t> counter{0};
+
+    std::error_code ec;
+    fs::path target(entryPath(key));
+    fs::create_directories(target.parent_path(), ec);
+    if (ec) {
+        return;
+    }
+
+    // Unique temporary name per writer, then an atomic rename into place
+    std::ostringstream suffix;
+    suffix << ".tmp." << std::hash<std::thread::id>{}(std::this_thread::get_id())
+           << '.' << counter.fetch_add(1)
+           << '.' << std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path temp = target;
+    temp += suffix.str();
+
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        file << output;
+        if (!file) {
+            file.close();
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+
+    fs::rename(temp, target, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+    }
+}
+
+} // namespace hybrid
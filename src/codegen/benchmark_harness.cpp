@@ -0,0 +1,177 @@
+/**
+ * Benchmark harnesses
+ * Which methods are benchmarked, under which names, and the Google
+ * Benchmark stubs for the original C++ that the generated ones mirror
+ */
+
+#include "codegen.h"
+#include <algorithm>
+#include <cctype>
+
+namespace hybrid {
+
+namespace {
+
+bool isPublicMember(const ClassDecl& class_decl, const std::string& name) {
+    bool declared = false;
+    for (const auto& section : class_decl.access_sections) {
+        if (std::find(section.members.begin(), section.members.end(), name) == section.members.end()) {
+            continue;
+        }
+        if (section.level == ClassDecl::AccessSection::Public) {
+            return true;
+        }
+        declared = true;
+    }
+    return !declared && class_decl.is_struct;
+}
+
+/** Parameters the harnesses can pass a value-initialized argument for */
+bool hasDefaultArguments(const Function& func) {
+    for (const auto& param : func.parameters) {
+        const Type* type = param.type.get();
+        if (type && type->kind == TypeKind::Reference) {
+            type = type->element_type.get();
+            if (type && type->kind == TypeKind::Reference) return false;     // T&&
+        }
+        if (!type || type->name.empty() || type->kind == TypeKind::Void ||
+            type->kind == TypeKind::Array || type->kind == TypeKind::Function) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isInstantiable(const ClassDecl& class_decl, const Function* constructor) {
+    // Specializations too: the stubs would have to spell their arguments
+    if (class_decl.is_template || !class_decl.specialization.specialized_args.empty()) return false;
+    for (const auto& method : class_decl.methods) {
+        if (method.is_pure_virtual) return false;
+    }
+    return !constructor || (isPublicMember(class_decl, constructor->name) && hasDefaultArguments(*constructor));
+}
+
+/** C++ spelling of a value-initialized local the argument binds to */
+std::string cppArgumentType(const Type& type) {
+    if (type.kind == TypeKind::Reference && type.element_type) {
+        return type.element_type->name;
+    }
+    return type.name;
+}
+
+std::string identifier(const std::string& name) {
+    std::string result = name;
+    for (char& c : result) {
+        if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<CodeGenerator::BenchmarkedMethod> CodeGenerator::benchmarkedMethods(const IR& ir) {
+    std::vector<BenchmarkedMethod> methods;
+    for (const auto& class_decl : ir.getClasses()) {
+        if (!isInstantiable(class_decl, benchmarkConstructor(class_decl))) continue;
+
+        std::vector<std::string> names;
+        for (const auto& method : class_decl.methods) {
+            if (method.is_constructor || method.is_destructor || method.is_template || method.is_async ||
+                method.coroutine_info.is_coroutine || method.name.compare(0, 8, "operator") == 0 ||
+                !method.return_type || !isPublicMember(class_decl, method.name) || !hasDefaultArguments(method)) {
+                continue;
+            }
+
+            std::string name = identifier(class_decl.name) + "_" + identifier(method.name);
+            names.push_back(name);
+            size_t overload = std::count(names.begin(), names.end(), name);
+            if (overload > 1) {
+                name += "_" + std::to_string(overload);
+            }
+            methods.push_back({&class_decl, &method, std::move(name)});
+        }
+    }
+    return methods;
+}
+
+const Function* CodeGenerator::benchmarkConstructor(const ClassDecl& class_decl) {
+    for (const auto& method : class_decl.methods) {
+        if (method.is_constructor) return &method;
+    }
+    return nullptr;
+}
+
+std::string CodeGenerator::generateBenchmarks(const IR& ir, const std::string& module) {
+    std::vector<BenchmarkedMethod> methods = benchmarkedMethods(ir);
+    if (methods.empty()) {
+        return "";
+    }
+
+    StringSink sink;
+    sink_ = &sink;
+    indent_level_ = 0;
+    ir_ = &ir;
+    planTemplates(ir);
+
+    emitBenchmarks(methods, module);
+
+    sink_ = nullptr;
+    ir_ = nullptr;
+    templates_ = nullptr;
+    return sink.take();
+}
+
+std::string CodeGenerator::generateCppBenchmarks(const IR& ir, const std::string& header) {
+    std::vector<BenchmarkedMethod> methods = benchmarkedMethods(ir);
+    if (methods.empty()) {
+        return "";
+    }
+
+    std::string out;
+    out += "// Auto-generated Google Benchmark stubs for the original C++\n";
+    out += "// Generated by Hybrid Transpiler\n\n";
+    out += "#include <benchmark/benchmark.h>\n";
+    out += "#include \"" + header + "\"\n\n";
+
+    for (const auto& benchmarked : methods) {
+        const ClassDecl& owner = *benchmarked.owner;
+        const Function& method = *benchmarked.method;
+        out += "static void BM_" + benchmarked.name + "(benchmark::State& state) {\n";
+
+        std::string args;
+        for (size_t i = 0; i < method.parameters.size(); ++i) {
+            out += "    " + cppArgumentType(*method.parameters[i].type) + " arg" + std::to_string(i) + "{};\n";
+            args += (i > 0 ? ", arg" : "arg") + std::to_string(i);
+        }
+
+        std::string call;
+        if (method.is_static) {
+            call = owner.name + "::" + method.name + "(" + args + ")";
+        } else {
+            const Function* constructor = benchmarkConstructor(owner);
+            std::string init;
+            for (size_t i = 0; constructor && i < constructor->parameters.size(); ++i) {
+                out += "    " + cppArgumentType(*constructor->parameters[i].type) + " init" + std::to_string(i) + "{};\n";
+                init += (i > 0 ? ", init" : "init") + std::to_string(i);
+            }
+            out += "    " + owner.name + " target" + (init.empty() ? "" : "(" + init + ")") + ";\n";
+            call = "target." + method.name + "(" + args + ")";
+        }
+
+        out += "    for (auto _ : state) {\n";
+        if (method.return_type->kind == TypeKind::Void) {
+            out += "        " + call + ";\n";
+            out += "        benchmark::ClobberMemory();\n";
+        } else {
+            out += "        benchmark::DoNotOptimize(" + call + ");\n";
+        }
+        out += "    }\n";
+        out += "}\n";
+        out += "BENCHMARK(BM_" + benchmarked.name + ")->Name(\"" + benchmarked.name + "\");\n\n";
+    }
+
+    out += "BENCHMARK_MAIN();\n";
+    return out;
+}
+
+} // namespace hybrid
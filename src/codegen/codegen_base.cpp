@@ -1,18 +1,295 @@
 #include "codegen.h"
+#include "resource_budget.h"
+#include "thread_pool.h"
+#include "type_names.h"
+#include <algorithm>
+#include <cctype>
+#include <exception>
 
 namespace hybrid {
 
-void CodeGenerator::writeLine(const std::string& line) {
+namespace {
+
+bool contains(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// Whether text names the identifier (not as part of a longer one)
+bool mentions(const std::string& text, const std::string& identifier) {
+    auto isWordChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    for (size_t pos = text.find(identifier); pos != std::string::npos; pos = text.find(identifier, pos + 1)) {
+        size_t end = pos + identifier.size();
+        if ((pos == 0 || !isWordChar(text[pos - 1])) && (end == text.size() || !isWordChar(text[end]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+const std::string* TypeSpellingCache::find(const Type* type) {
+    auto it = entries_.find(type);
+    if (it == entries_.end()) {
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    return &it->second.spelling;
+}
+
+const std::string& TypeSpellingCache::insert(const std::shared_ptr<Type>& type, std::string spelling) {
+    if (entries_.size() >= kMaxEntries) {
+        entries_.clear();
+    }
+    Entry& entry = entries_[type.get()];
+    entry.type = type;
+    entry.spelling = std::move(spelling);
+    return entry.spelling;
+}
+
+void TypeSpellingCache::clear() {
+    entries_.clear();
+}
+
+std::string CodeGenerator::generate(const IR& ir) {
+    StringSink sink;
+    generate(ir, sink);
+    return sink.take();
+}
+
+bool CodeGenerator::generate(const IR& ir, OutputSink& sink) {
+    sink_ = &sink;
+    indent_level_ = 0;
+    ir_ = &ir;
+    planTemplates(ir);
+
+    emit(ir);
+
+    sink_ = nullptr;
+    ir_ = nullptr;
+    templates_ = nullptr;
+    return sink.flush();
+}
+
+bool CodeGenerator::generateDeclaration(const IR& ir, const std::string& name, OutputSink& sink) {
+    const ClassDecl* class_decl = ir.findClass(name);
+    if (!class_decl) {
+        return false;
+    }
+    return generateDeclaration(ir, *class_decl, sink);
+}
+
+bool CodeGenerator::generateDeclaration(const IR& ir, const ClassDecl& class_decl, OutputSink& sink) {
+    sink_ = &sink;
+    indent_level_ = 0;
+    ir_ = &ir;
+    // Between generatePrologue() and generateEpilogue() the plan is already made
+    bool planned = planned_ir_ == &ir;
+    if (!planned) {
+        planTemplates(ir);
+    }
+
+    emitDeclaration(class_decl);
+
+    sink_ = nullptr;
+    ir_ = nullptr;
+    if (!planned) {
+        templates_ = nullptr;
+    }
+    return sink.flush();
+}
+
+bool CodeGenerator::generatePrologue(const IR& ir, OutputSink& sink) {
+    sink_ = &sink;
+    indent_level_ = 0;
+    ir_ = &ir;
+    planTemplates(ir);
+    planned_ir_ = &ir;
+
+    emitPrologue(ir);
+
+    sink_ = nullptr;
+    ir_ = nullptr;
+    return sink.flush();
+}
+
+bool CodeGenerator::generateEpilogue(const IR& ir, OutputSink& sink) {
+    sink_ = &sink;
+    indent_level_ = 0;
+    ir_ = &ir;
+    if (planned_ir_ != &ir) {
+        planTemplates(ir);
+    }
+
+    emitEpilogue(ir);
+
+    sink_ = nullptr;
+    ir_ = nullptr;
+    planned_ir_ = nullptr;
+    templates_ = nullptr;
+    return sink.flush();
+}
+
+void CodeGenerator::emitEach(size_t count, const std::function<void(CodeGenerator&, size_t)>& render) {
+    size_t threads = jobs_ == 1 ? 1 : WorkStealingPool::resolveThreadCount(jobs_);
+    size_t tasks = std::min(threads * kTasksPerThread, count / kMinItemsPerTask);
+    if (threads == 1 || count < kMinParallelItems || tasks < 2) {
+        for (size_t i = 0; i < count; ++i) {
+            ResourceBudget::checkpoint("codegen");
+            render(*this, i);
+        }
+        return;
+    }
+
+    // Each task renders a contiguous run of items with its own generator,
+    // so no mutable state is shared; joining in task order keeps the bytes
+    // identical to a serial run
+    std::vector<std::string> fragments(tasks);
+    std::vector<std::exception_ptr> errors(tasks);
+    // Workers draw on the caller's budget
+    ResourceBudget* budget = ResourceBudget::current();
+    WorkStealingPool pool(threads);
+    pool.parallelFor(tasks, [&](size_t task) {
+        BudgetScope budget_scope(budget);
+        try {
+            std::unique_ptr<CodeGenerator> worker = clone();
+            StringSink fragment;
+            worker->sink_ = &fragment;
+            worker->ir_ = ir_;
+            worker->indent_level_ = indent_level_;
+            worker->jobs_ = 1;
+
+            size_t end = count * (task + 1) / tasks;
+            for (size_t i = count * task / tasks; i < end; ++i) {
+                ResourceBudget::checkpoint("codegen");
+                render(*worker, i);
+            }
+            fragments[task] = fragment.take();
+        } catch (...) {
+            errors[task] = std::current_exception();
+        }
+    });
+
+    for (size_t task = 0; task < tasks; ++task) {
+        if (errors[task]) {
+            std::rethrow_exception(errors[task]);
+        }
+        sink_->write(fragments[task]);
+        std::string().swap(fragments[task]);
+    }
+}
+
+void CodeGenerator::writeLine(std::string_view line) {
     if (!line.empty()) {
         writeIndent();
-        output_ << line;
+        sink_->write(line);
     }
-    output_ << "\n";
+    sink_->write("\n");
+}
+
+void CodeGenerator::planClassLowering(const ClassDecl& class_decl) {
+    lowering_ = ClassLowering();
+    if (optimization_level_ < 2) return;
+
+    for (const auto& mutex : class_decl.fields) {
+        TypeKind kind = mutex.type ? standardTypeKind(*mutex.type) : TypeKind::Void;
+        if (kind == TypeKind::StdSharedMutex) {
+            lowering_.shared_mutexes.push_back(mutex.name);
+            continue;
+        }
+        if (kind != TypeKind::StdMutex) continue;
+
+        // A mutex whose every use is one locked counter update becomes atomics.
+        // Any other mention (manual lock()/unlock(), std::scoped_lock, passing
+        // it on) is not a recorded lock scope, so the mutex is kept.
+        std::vector<std::string> counters;
+        bool only_counters = true;
+        for (const auto& method : class_decl.methods) {
+            bool locks = std::any_of(method.lock_scopes.begin(), method.lock_scopes.end(),
+                                     [&](const LockInfo& lock) { return lock.mutex_name == mutex.name; });
+            if (!locks) {
+                only_counters &= !mentions(method.body, mutex.name);
+                continue;
+            }
+
+            const GuardedUpdate* update = method.guarded_updates.empty() ? nullptr : &method.guarded_updates[0];
+            const Variable* counter = nullptr;
+            if (update && method.lock_scopes.size() == 1 && method.condition_variables.empty() && !method.may_throw) {
+                for (const auto& field : class_decl.fields) {
+                    if (field.name == update->var_name && field.type && field.type->kind == TypeKind::Integer) {
+                        counter = &field;
+                    }
+                }
+            }
+            if (!counter || atomicCounterType(counter->type).empty()) {
+                only_counters = false;
+            } else if (!contains(counters, counter->name)) {
+                counters.push_back(counter->name);
+            }
+        }
+
+        if (only_counters && !counters.empty()) {
+            lowering_.counter_mutexes.push_back(mutex.name);
+            lowering_.atomic_counters.insert(lowering_.atomic_counters.end(), counters.begin(), counters.end());
+        }
+    }
+}
+
+const GuardedUpdate* CodeGenerator::lockFreeUpdate(const Function& func) const {
+    if (func.guarded_updates.empty() || !contains(lowering_.atomic_counters, func.guarded_updates[0].var_name) ||
+        !contains(lowering_.counter_mutexes, func.guarded_updates[0].mutex_name)) {
+        return nullptr;
+    }
+    return &func.guarded_updates[0];
+}
+
+bool CodeGenerator::isVirtualMethod(const Function& method, const ClassDecl& owner) const {
+    if (method.is_virtual) {
+        return true;
+    }
+    if (!ir_) {
+        return false;
+    }
+
+    // Walk the base chain through the IR's class index; the depth bound
+    // guards against malformed (cyclic) hierarchies
+    std::vector<const ClassDecl*> pending;
+    for (const auto& base_name : owner.base_classes) {
+        if (const ClassDecl* base = ir_->findClass(base_name)) {
+            pending.push_back(base);
+        }
+    }
+
+    for (size_t visited = 0; !pending.empty() && visited < 64; ++visited) {
+        const ClassDecl* base = pending.back();
+        pending.pop_back();
+
+        for (const auto& base_method : base->methods) {
+            if (base_method.is_virtual && base_method.name == method.name) {
+                return true;
+            }
+        }
+        for (const auto& base_name : base->base_classes) {
+            if (const ClassDecl* next = ir_->findClass(base_name)) {
+                pending.push_back(next);
+            }
+        }
+    }
+
+    return false;
 }
 
 void CodeGenerator::writeIndent() {
-    for (int i = 0; i < indent_level_; ++i) {
-        output_ << "    "; // 4 spaces per indent level
+    static const std::string_view spaces =
+        "                                                                ";
+
+    // 4 spaces per indent level, written in as few chunks as possible
+    size_t pending = static_cast<size_t>(indent_level_ > 0 ? indent_level_ : 0) * 4;
+    while (pending > 0) {
+        size_t chunk = std::min(pending, spaces.size());
+        sink_->write(spaces.substr(0, chunk));
+        pending -= chunk;
     }
 }
 
@@ -1,13 +1,139 @@
 #include "codegen.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include "type_names.h"
 #include <algorithm>
 #include <cctype>
 
 namespace hybrid {
 
-std::string GoCodeGenerator::generate(const IR& ir) {
-    output_.str("");
-    output_.clear();
+namespace {
 
+bool contains(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool isMutexKind(TypeKind kind) {
+    return kind == TypeKind::StdMutex || kind == TypeKind::StdRecursiveMutex || kind == TypeKind::StdSharedMutex;
+}
+
+/** "v.size()" and "v.length()" become len(v); anything else is kept */
+std::string convertCapacity(const std::string& capacity) {
+    for (std::string_view member : {".size()", ".length()"}) {
+        size_t dot = capacity.size() > member.size() ? capacity.size() - member.size() : 0;
+        if (dot == 0 || capacity.compare(dot, std::string::npos, member) != 0) continue;
+
+        bool identifier = std::all_of(capacity.begin(), capacity.begin() + dot, [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        });
+        if (identifier) {
+            return "len(" + capacity.substr(0, dot) + ")";
+        }
+    }
+    return capacity;
+}
+
+/** Zero-value literal of a Go type, from its spelling */
+std::string zeroValue(const std::string& type) {
+    static constexpr std::string_view kNilPrefixes[] = {"*", "[]", "map[", "chan ", "func(", "interface{"};
+    static constexpr std::string_view kNumbers[] = {
+        "int", "int8", "int16", "int32", "int64", "uint", "uint8", "uint16", "uint32", "uint64",
+        "uintptr", "byte", "rune", "float32", "float64"
+    };
+    for (std::string_view prefix : kNilPrefixes) {
+        if (type.compare(0, prefix.size(), prefix) == 0) return "nil";
+    }
+    if (std::find(std::begin(kNumbers), std::end(kNumbers), type) != std::end(kNumbers)) return "0";
+    if (type == "string") return "\"\"";
+    if (type == "bool") return "false";
+    if (type == "error") return "nil";
+    return type + "{}";
+}
+
+} // namespace
+
+void GoCodeGenerator::emit(const IR& ir) {
+    emitPrologue(ir);
+
+    // Generate classes/structs, then standalone functions
+    const auto& classes = ir.getClasses();
+    const auto& functions = ir.getFunctions();
+    emitEach(classes.size() + functions.size(), [&](CodeGenerator& gen, size_t i) {
+        auto& self = static_cast<GoCodeGenerator&>(gen);
+        if (i < classes.size()) {
+            self.emitDeclaration(classes[i]);
+            return;
+        }
+
+        const Function& func = functions[i - classes.size()];
+        ProfileScope scope("codegen", "function", func.name);
+        self.generateFunction(func);
+        self.writeLine("");
+    });
+
+    emitEpilogue(ir);
+}
+
+void GoCodeGenerator::emitBenchmarks(const std::vector<BenchmarkedMethod>& methods, const std::string& module) {
+    writeLine("// Auto-generated Go benchmarks for " + module);
+    writeLine("// Generated by Hybrid Transpiler");
+    writeLine("");
+    writeLine("package main");
+    writeLine("");
+    writeLine("import \"testing\"");
+    writeLine("");
+
+    // Results go to a package-level sink so the calls are not optimized away
+    bool returns = std::any_of(methods.begin(), methods.end(), [](const BenchmarkedMethod& benchmarked) {
+        return returnsValue(*benchmarked.method);
+    });
+    if (returns) {
+        writeLine("var benchmarkSink interface{}");
+        writeLine("");
+    }
+
+    auto arguments = [&](const Function& func) {
+        std::string args;
+        for (const auto& param : func.parameters) {
+            args += (args.empty() ? "" : ", ") + zeroValue(convertType(param.type));
+        }
+        return args;
+    };
+
+    for (const auto& benchmarked : methods) {
+        const ClassDecl& owner = *benchmarked.owner;
+        const Function& method = *benchmarked.method;
+        std::string struct_name = capitalize(sanitizeName(owner.name));
+
+        writeLine("func Benchmark" + benchmarked.name + "(b *testing.B) {");
+        indent();
+        if (const Function* constructor = benchmarkConstructor(owner)) {
+            writeLine("target := New" + struct_name + "(" + arguments(*constructor) + ")");
+        } else {
+            writeLine("target := &" + struct_name + "{}");
+        }
+        writeLine("b.ResetTimer()");
+        writeLine("for i := 0; i < b.N; i++ {");
+        indent();
+
+        std::string call = "target." + capitalize(sanitizeName(method.name)) + "(" + arguments(method) + ")";
+        if (!returnsValue(method)) {
+            writeLine(call);
+        } else if (method.may_throw) {
+            writeLine("benchmarkSink, _ = " + call);
+        } else {
+            writeLine("benchmarkSink = " + call);
+        }
+
+        dedent();
+        writeLine("}");
+        dedent();
+        writeLine("}");
+        writeLine("");
+    }
+}
+
+void GoCodeGenerator::emitPrologue(const IR& ir) {
     // Generate file header
     writeLine("// Auto-generated Go code from C++ source");
     writeLine("// Generated by Hybrid Transpiler");
@@ -15,6 +141,22 @@ std::string GoCodeGenerator::generate(const IR& ir) {
     writeLine("package main");
     writeLine("");
 
+    if (optimization_level_ >= 2) {
+        std::vector<std::string> imports = requiredImports(ir);
+        if (!imports.empty()) {
+            writeLine("import (");
+            indent();
+            for (const auto& import : imports) {
+                writeLine("\"" + import + "\"");
+            }
+            dedent();
+            writeLine(")");
+            writeLine("");
+        }
+        generateConstraints();
+        return;
+    }
+
     // Generate imports if needed
     bool needs_imports = false;
     for (const auto& class_decl : ir.getClasses()) {
@@ -34,36 +176,100 @@ std::string GoCodeGenerator::generate(const IR& ir) {
         writeLine(")");
         writeLine("");
     }
+    generateConstraints();
+}
 
-    // Generate classes/structs
-    for (const auto& class_decl : ir.getClasses()) {
-        generateClass(class_decl);
+void GoCodeGenerator::generateConstraints() {
+    if (!templates_) return;
+
+    // Declared locally rather than taken from the cmp or constraints packages (Go 1.21+)
+    bool numeric = false;
+    bool ordered = false;
+    for (const auto& [name, plan] : templates_->templates) {
+        if (!plan.primary || plan.erased) continue;
+        for (size_t i = 0; i < plan.bounds.size(); ++i) {
+            if (plan.primary->template_parameters[i].kind != TemplateParameter::Type) continue;
+            std::string_view constraint = goConstraint(plan.bounds[i]);
+            numeric |= constraint == "numeric";
+            ordered |= constraint == "ordered";
+        }
+    }
+    static constexpr const char* kNumbers =
+        "~int | ~int8 | ~int16 | ~int32 | ~int64 | ~uint | ~uint8 | ~uint16 | ~uint32 | ~uint64 | ~uintptr | "
+        "~float32 | ~float64";
+    if (numeric) {
+        writeLine("type numeric interface {");
+        indent();
+        writeLine(kNumbers);
+        dedent();
+        writeLine("}");
         writeLine("");
     }
-
-    // Generate standalone functions
-    for (const auto& func : ir.getFunctions()) {
-        generateFunction(func);
+    if (ordered) {
+        writeLine("type ordered interface {");
+        indent();
+        writeLine(std::string(kNumbers) + " | ~string");
+        dedent();
+        writeLine("}");
         writeLine("");
     }
+}
 
+void GoCodeGenerator::emitEpilogue(const IR& ir) {
     // Generate global variables
     for (const auto& var : ir.getGlobalVariables()) {
         generateVariable(var);
     }
+}
+
+void GoCodeGenerator::emitDeclaration(const ClassDecl& class_decl) {
+    if (!isEmitted(class_decl)) return;
+
+    ProfileScope scope("codegen", "class", class_decl.name);
+    generateClass(class_decl);
+    writeLine("");
+}
 
-    return output_.str();
+std::unique_ptr<CodeGenerator> GoCodeGenerator::clone() const {
+    return std::make_unique<GoCodeGenerator>(*this);
+}
+
+unsigned GoCodeGenerator::erasableBounds() const {
+    // fmt prints and == compares an interface value of any dynamic type
+    return TemplatePlan::Printable | TemplatePlan::Equatable;
 }
 
 void GoCodeGenerator::generateClass(const ClassDecl& class_decl) {
+    planClassLowering(class_decl);
+
+    // Type parameters spell as themselves, or as any once erased
+    const TemplatePlan::Template* plan = templatePlan(class_decl);
+    TemplateScope template_scope(*this);
+    for (const auto& param : class_decl.template_parameters) {
+        if (emitsGeneric(class_decl)) {
+            template_scope_.emplace_back(param.name, param.name);
+        } else if (plan) {
+            template_scope_.emplace_back(param.name, "any");
+        }
+    }
+    if (plan && plan->over_budget) {
+        writeLine("// " + class_decl.name + ": " + std::to_string(plan->instantiations) +
+                  " instantiations exceed the monomorphization budget of " +
+                  std::to_string(getMonomorphizationBudget()) +
+                  (plan->erased ? "; type parameters erased to any" : "; kept generic for its constraints"));
+    }
+
     // Generate struct definition
-    std::string struct_name = capitalize(sanitizeName(class_decl.name));
-    writeLine("type " + struct_name + " struct {");
+    std::string struct_name = className(class_decl);
+    std::string type_args = typeArguments(class_decl);
+    writeLine("type " + struct_name + typeParameters(class_decl) + " struct {");
     indent();
 
     for (const auto& field : class_decl.fields) {
+        if (contains(lowering_.counter_mutexes, field.name)) continue;
+
         std::string field_name = capitalize(sanitizeName(field.name));
-        std::string field_type = convertType(field.type);
+        std::string field_type = convertFieldType(field);
 
         writeLine(field_name + " " + field_type);
     }
@@ -81,7 +287,7 @@ void GoCodeGenerator::generateClass(const ClassDecl& class_decl) {
                 has_constructor = true;
 
                 std::stringstream sig;
-                sig << "func New" << struct_name << "(";
+                sig << "func New" << struct_name << typeParameters(class_decl) << "(";
 
                 for (size_t i = 0; i < method.parameters.size(); ++i) {
                     const auto& param = method.parameters[i];
@@ -92,10 +298,10 @@ void GoCodeGenerator::generateClass(const ClassDecl& class_decl) {
                     }
                 }
 
-                sig << ") *" << struct_name << " {";
+                sig << ") *" << struct_name << type_args << " {";
                 writeLine(sig.str());
                 indent();
-                writeLine("return &" + struct_name + "{");
+                writeLine("return &" + struct_name + type_args + "{");
                 indent();
 
                 // Initialize fields
@@ -114,12 +320,14 @@ void GoCodeGenerator::generateClass(const ClassDecl& class_decl) {
         }
 
         // Generate methods
-        for (const auto& method : class_decl.methods) {
-            if (!method.is_constructor && !method.is_destructor) {
-                generateFunction(method, struct_name);
-                writeLine("");
+        const auto& methods = class_decl.methods;
+        emitEach(methods.size(), [&](CodeGenerator& gen, size_t i) {
+            if (!methods[i].is_constructor && !methods[i].is_destructor) {
+                auto& self = static_cast<GoCodeGenerator&>(gen);
+                self.generateFunction(methods[i], struct_name + type_args);
+                self.writeLine("");
             }
-        }
+        });
     }
 
     // Generate interfaces for inheritance
@@ -127,15 +335,21 @@ void GoCodeGenerator::generateClass(const ClassDecl& class_decl) {
         generateInterfaceImplementations(class_decl);
         writeLine("");
     }
+
+    lowering_ = ClassLowering();
 }
 
 void GoCodeGenerator::generateFunction(const Function& func, const std::string& receiver_type) {
+    ResourceBudget::checkpoint("codegen");
+
     // If function is async or coroutine, use async generation
     if (func.is_async || func.coroutine_info.is_coroutine) {
         generateAsyncFunction(func);
         return;
     }
 
+    generatePools(func, receiver_type);
+    const GuardedUpdate* lock_free = lockFreeUpdate(func);
     std::stringstream sig;
 
     sig << "func ";
@@ -169,20 +383,24 @@ void GoCodeGenerator::generateFunction(const Function& func, const std::string&
     // Return type - add error if function may throw
     if (func.may_throw) {
         // Function may throw - convert to multiple return values
-        if (func.return_type->kind != TypeKind::Void) {
+        if (returnsValue(func)) {
             sig << " (" << convertType(func.return_type) << ", error)";
         } else {
             sig << " error";
         }
-    } else if (func.return_type->kind != TypeKind::Void) {
+    } else if (returnsValue(func)) {
         sig << " " << convertType(func.return_type);
     }
 
     writeLine(sig.str() + " {");
     indent();
 
+    if (lock_free) {
+        generateLockFreeUpdate(*lock_free);
+    }
     // Function body with threading conversion
-    if (func.uses_threading) {
+    else if (func.uses_threading) {
+        generateCapacityHints(func, receiver_type);
         generateThreadingCode(func);
     }
     // Function body with exception handling conversion
@@ -194,10 +412,11 @@ void GoCodeGenerator::generateFunction(const Function& func, const std::string&
         if (func.may_throw) {
             writeLine("// Function may throw - return error on failure");
         }
+        generateCapacityHints(func, receiver_type);
         writeLine("// TODO: Implement function body");
         writeLine(func.body);
 
-        if (func.may_throw && func.return_type->kind != TypeKind::Void) {
+        if (func.may_throw && returnsValue(func)) {
             writeLine("// return result, nil");
         } else if (func.may_throw) {
             writeLine("return nil");
@@ -253,7 +472,7 @@ void GoCodeGenerator::generateTryCatchAsError(const Function& func) {
             writeLine(block.try_body);
         }
 
-        if (func.may_throw && func.return_type->kind != TypeKind::Void) {
+        if (func.may_throw && returnsValue(func)) {
             writeLine("// return result, nil");
         } else if (func.may_throw) {
             writeLine("// return nil");
@@ -278,6 +497,16 @@ void GoCodeGenerator::generateVariable(const Variable& var) {
 std::string GoCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
     if (!type) return "interface{}";
 
+    if (spellsTemplates()) return convertTypeUncached(type);
+
+    if (const std::string* cached = type_spellings_.find(type.get())) {
+        return *cached;
+    }
+    return type_spellings_.insert(type, convertTypeUncached(type));
+}
+
+std::string GoCodeGenerator::convertTypeUncached(const std::shared_ptr<Type>& type) {
+
     switch (type->kind) {
         case TypeKind::Void:
             return ""; // Go doesn't have void, just no return type
@@ -286,22 +515,13 @@ std::string GoCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
             return "bool";
 
         case TypeKind::Integer:
-            // Map C++ integer types to Go
-            if (type->name == "int" || type->name == "int32_t") return "int32";
-            if (type->name == "long" || type->name == "int64_t") return "int64";
-            if (type->name == "short" || type->name == "int16_t") return "int16";
-            if (type->name == "char" || type->name == "int8_t") return "int8";
-            if (type->name == "unsigned int" || type->name == "uint32_t") return "uint32";
-            if (type->name == "unsigned long" || type->name == "uint64_t") return "uint64";
-            if (type->name == "unsigned short" || type->name == "uint16_t") return "uint16";
-            if (type->name == "unsigned char" || type->name == "uint8_t") return "uint8";
-            if (type->name == "size_t") return "uint";
-            return "int32"; // default
-
-        case TypeKind::Float:
-            if (type->name == "float") return "float32";
-            if (type->name == "double") return "float64";
-            return "float64"; // default
+        case TypeKind::Float: {
+            const BuiltinTypeName* builtin = findBuiltinType(type->name);
+            if (builtin && builtin->kind == type->kind) {
+                return std::string(builtin->go);
+            }
+            return type->kind == TypeKind::Integer ? "int32" : "float64"; // default
+        }
 
         case TypeKind::Pointer:
             // Smart pointers become slices or direct values in Go
@@ -421,13 +641,114 @@ std::string GoCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
 
         case TypeKind::Struct:
         case TypeKind::Class:
-            return capitalize(sanitizeName(type->name));
+            return spellsTemplates() ? convertClassSpelling(type->name) : capitalize(sanitizeName(type->name));
 
         default:
             return "interface{} /* Unknown type: " + type->name + " */";
     }
 }
 
+std::string GoCodeGenerator::className(const ClassDecl& class_decl) {
+    std::string name = capitalize(sanitizeName(class_decl.name));
+
+    // Explicit specializations are separate types: BoxInt32 for Box<int>
+    if (const std::string* arguments = specializationArguments(class_decl)) {
+        for (const auto& argument : resolveClassSpelling(class_decl.name + "<" + *arguments + ">").arguments) {
+            name += capitalize(mangleArgument(argument));
+        }
+    }
+    return name;
+}
+
+const char* GoCodeGenerator::goConstraint(unsigned bounds) {
+    if (bounds & TemplatePlan::Arithmetic) return "numeric";
+    if (bounds & TemplatePlan::Ordered) return "ordered";
+    if (bounds & TemplatePlan::Equatable) return "comparable";
+    return "any";
+}
+
+std::string GoCodeGenerator::typeParameters(const ClassDecl& class_decl) {
+    if (!emitsGeneric(class_decl)) return "";
+
+    // Go has no non-type parameters; those stay C++ in the bodies
+    const TemplatePlan::Template* plan = templatePlan(class_decl);
+    std::string result;
+    for (size_t i = 0; i < class_decl.template_parameters.size(); ++i) {
+        const TemplateParameter& param = class_decl.template_parameters[i];
+        if (param.kind != TemplateParameter::Type) continue;
+        result += (result.empty() ? "[" : ", ") + param.name + " " + goConstraint(plan ? plan->bounds[i] : 0);
+    }
+    return result.empty() ? "" : result + "]";
+}
+
+std::string GoCodeGenerator::typeArguments(const ClassDecl& class_decl) {
+    if (!emitsGeneric(class_decl)) return "";
+
+    std::string result;
+    for (const auto& param : class_decl.template_parameters) {
+        if (param.kind != TemplateParameter::Type) continue;
+        result += (result.empty() ? "[" : ", ") + param.name;
+    }
+    return result.empty() ? "" : result + "]";
+}
+
+std::string GoCodeGenerator::convertClassSpelling(const std::string& spelling) {
+    if (const std::string* parameter = templateParameterSpelling(spelling)) {
+        return *parameter;
+    }
+    ClassSpelling resolved = resolveClassSpelling(spelling);
+    if (!resolved.plan || resolved.arguments.empty()) {
+        return capitalize(sanitizeName(spelling));
+    }
+    if (resolved.specialization) {
+        return className(*resolved.specialization);
+    }
+    if (resolved.plan->erased) {
+        return capitalize(sanitizeName(resolved.name));
+    }
+
+    const ClassDecl* primary = resolved.plan->primary;
+    std::string result;
+    for (size_t i = 0; i < resolved.arguments.size(); ++i) {
+        if (primary && i < primary->template_parameters.size() &&
+            primary->template_parameters[i].kind != TemplateParameter::Type) {
+            continue;
+        }
+        result += (result.empty() ? "[" : ", ") + convertTemplateArgument(resolved.arguments[i]);
+    }
+    return capitalize(sanitizeName(resolved.name)) + (result.empty() ? "" : result + "]");
+}
+
+std::string GoCodeGenerator::convertTemplateArgument(const std::string& argument) {
+    if (const std::string* parameter = templateParameterSpelling(argument)) {
+        return *parameter;
+    }
+    std::string spelled = convertSpelledType(argument);
+    if (!spelled.empty()) {
+        return spelled;
+    }
+    return convertClassSpelling(argument);
+}
+
+std::string GoCodeGenerator::mangleArgument(const std::string& argument) {
+    if (const BuiltinTypeName* builtin = findBuiltinType(argument)) {
+        return std::string(builtin->go);
+    }
+    std::string result;
+    bool word_start = true;
+    for (char c : argument) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            result += word_start ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+            word_start = false;
+        } else {
+            if (c == '*') result += "Ptr";
+            if (c == '&') result += "Ref";
+            word_start = true;
+        }
+    }
+    return result;
+}
+
 std::string GoCodeGenerator::sanitizeName(const std::string& name) {
     std::string result = name;
 
@@ -454,6 +775,171 @@ std::string GoCodeGenerator::capitalize(const std::string& name) {
     return result;
 }
 
+std::vector<std::string> GoCodeGenerator::requiredImports(const IR& ir) {
+    bool uses_sync = false;
+    bool uses_atomic = false;
+    auto scan = [&](const Function& func) {
+        uses_sync |= !func.threads_created.empty() || !func.condition_variables.empty();
+        uses_atomic |= !func.atomic_operations.empty();
+        for (const auto& hint : func.capacity_hints) {
+            uses_sync |= isPooled(hint);
+        }
+    };
+
+    for (const auto& class_decl : ir.getClasses()) {
+        planClassLowering(class_decl);
+        for (const auto& field : class_decl.fields) {
+            TypeKind kind = field.type ? standardTypeKind(*field.type) : TypeKind::Void;
+            uses_sync |= (isMutexKind(kind) && !contains(lowering_.counter_mutexes, field.name)) ||
+                         kind == TypeKind::StdConditionVariable;
+            uses_atomic |= kind == TypeKind::StdAtomic;
+        }
+        uses_atomic |= !lowering_.atomic_counters.empty();
+        for (const auto& method : class_decl.methods) {
+            scan(method);
+        }
+    }
+    lowering_ = ClassLowering();
+    for (const auto& func : ir.getFunctions()) {
+        scan(func);
+    }
+
+    std::vector<std::string> imports;
+    if (uses_sync) imports.push_back("sync");
+    if (uses_atomic) imports.push_back("sync/atomic");
+    return imports;
+}
+
+std::string GoCodeGenerator::convertFieldType(const Variable& field) {
+    if (contains(lowering_.atomic_counters, field.name)) {
+        return atomicCounterType(field.type);
+    }
+    if (contains(lowering_.shared_mutexes, field.name)) {
+        return "sync.RWMutex";
+    }
+    if (optimization_level_ >= 2 && field.type && isMutexKind(standardTypeKind(*field.type))) {
+        return "sync.Mutex";
+    }
+    return convertType(field.type);
+}
+
+std::string GoCodeGenerator::convertSpelledType(const std::string& cpp_type) {
+    if (const BuiltinTypeName* builtin = findBuiltinType(cpp_type)) {
+        return builtin->kind != TypeKind::Void ? std::string(builtin->go) : "";
+    }
+    if (cpp_type == "std::string" || cpp_type == "string") {
+        return "string";
+    }
+
+    // Compound and qualified spellings need the parser's type
+    if (cpp_type.empty() || cpp_type.find_first_of("<>*&[ :") != std::string::npos) {
+        return "";
+    }
+    return capitalize(sanitizeName(cpp_type));
+}
+
+std::string GoCodeGenerator::atomicCounterType(const std::shared_ptr<Type>& type) {
+    // Subtracting from atomic.Uint32/Uint64 needs two's-complement tricks; only signed counters are lowered
+    std::string spelling = convertType(type);
+    if (spelling == "int32") return "atomic.Int32";
+    if (spelling == "int64") return "atomic.Int64";
+    return "";
+}
+
+void GoCodeGenerator::generateLockFreeUpdate(const GuardedUpdate& update) {
+    std::string counter = "this." + capitalize(sanitizeName(update.var_name));
+    bool simple = std::all_of(update.operand.begin(), update.operand.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    });
+
+    writeLine("// Lock-free: the C++ mutex guarded only this counter");
+    switch (update.operation) {
+        case GuardedUpdate::Read:
+            writeLine("return " + counter + ".Load()");
+            break;
+        case GuardedUpdate::Add:
+            writeLine(counter + ".Add(" + update.operand + ")");
+            break;
+        case GuardedUpdate::Subtract:
+            writeLine(counter + ".Add(" + (simple ? "-" + update.operand : "-(" + update.operand + ")") + ")");
+            break;
+    }
+}
+
+std::string GoCodeGenerator::capacityHintType(const CapacityHint& hint) {
+    std::vector<std::string> args;
+    for (const auto& arg : hint.type_args) {
+        args.push_back(convertSpelledType(arg));
+        if (args.back().empty()) return "";
+    }
+
+    switch (hint.container) {
+        case TypeKind::StdVector:
+        case TypeKind::StdDeque:
+            return args.size() == 1 ? "[]" + args[0] : "";
+        case TypeKind::StdUnorderedMap:
+            return args.size() == 2 ? "map[" + args[0] + "]" + args[1] : "";
+        case TypeKind::StdUnorderedSet:
+            return args.size() == 1 ? "map[" + args[0] + "]bool" : "";
+        default:
+            return "";      // strings.Builder.Grow would need another import for little gain
+    }
+}
+
+bool GoCodeGenerator::isPooled(const CapacityHint& hint) {
+    // Without profiles every non-escaping slice is treated as hot, hence -O3 only
+    return optimization_level_ >= 3 && !hint.escapes && hint.container == TypeKind::StdVector &&
+           !capacityHintType(hint).empty();
+}
+
+std::string GoCodeGenerator::poolName(const Function& func, const std::string& receiver_type,
+                                      const CapacityHint& hint) {
+    std::string name = receiver_type.substr(0, receiver_type.find('[')) + capitalize(sanitizeName(func.name)) +
+                       capitalize(sanitizeName(hint.var_name)) + "Pool";
+    name[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[0])));
+    return name;
+}
+
+void GoCodeGenerator::generatePools(const Function& func, const std::string& receiver_type) {
+    for (const auto& hint : func.capacity_hints) {
+        if (!isPooled(hint)) continue;
+
+        writeLine("var " + poolName(func, receiver_type, hint) + " = sync.Pool{New: func() any { return new(" +
+                  capacityHintType(hint) + ") }}");
+        writeLine("");
+    }
+}
+
+void GoCodeGenerator::generateCapacityHints(const Function& func, const std::string& receiver_type) {
+    if (optimization_level_ < 2 || func.capacity_hints.empty()) return;
+
+    writeLine("// Capacity reserved in the C++ source");
+    for (const auto& hint : func.capacity_hints) {
+        std::string type = capacityHintType(hint);
+        if (type.empty()) continue;
+
+        std::string name = sanitizeName(hint.var_name);
+        std::string capacity = convertCapacity(hint.capacity);
+        if (isPooled(hint)) {
+            std::string pool = poolName(func, receiver_type, hint);
+            writeLine("// Pooled: " + name + " does not outlive the call, so its buffer is reused");
+            writeLine(name + "Buf := " + pool + ".Get().(*" + type + ")");
+            writeLine(name + " := (*" + name + "Buf)[:0]");
+            std::string needed = capacity.rfind("len(", 0) == 0 ? capacity : "int(" + capacity + ")";
+            writeLine("if cap(" + name + ") < " + needed + " {");
+            indent();
+            writeLine(name + " = make(" + type + ", 0, " + capacity + ")");
+            dedent();
+            writeLine("}");
+            writeLine("defer func() { *" + name + "Buf = " + name + "[:0]; " + pool + ".Put(" + name + "Buf) }()");
+        } else if (type[0] == '[') {
+            writeLine(name + " := make(" + type + ", 0, " + capacity + ")");
+        } else {
+            writeLine(name + " := make(" + type + ", " + capacity + ")");
+        }
+    }
+}
+
 void GoCodeGenerator::generateThreadingCode(const Function& func) {
     writeLine("// Threading code converted from C++");
     writeLine("");
@@ -551,6 +1037,7 @@ void GoCodeGenerator::generateGoroutineCreation(const ThreadInfo& thread) {
 void GoCodeGenerator::generateMutexLock(const LockInfo& lock) {
     std::stringstream ss;
 
+    // Only a std::shared_lock reads; const methods may update mutable state under a std::mutex
     switch (lock.type) {
         case LockInfo::LockGuard:
         case LockInfo::UniqueLock:
@@ -710,7 +1197,7 @@ void GoCodeGenerator::generateAsyncFunction(const Function& func) {
     sig << ")";
 
     // Return type - channel for async result
-    if (func.return_type->kind != TypeKind::Void) {
+    if (returnsValue(func)) {
         sig << " <-chan " << convertType(func.return_type);
     } else {
         sig << " <-chan struct{}";
@@ -720,7 +1207,7 @@ void GoCodeGenerator::generateAsyncFunction(const Function& func) {
     indent();
 
     // Create result channel
-    if (func.return_type->kind != TypeKind::Void) {
+    if (returnsValue(func)) {
         writeLine("resultChan := make(chan " + convertType(func.return_type) + ", 1)");
     } else {
         writeLine("resultChan := make(chan struct{}, 1)");
@@ -737,9 +1224,26 @@ void GoCodeGenerator::generateAsyncFunction(const Function& func) {
     if (func.coroutine_info.is_coroutine) {
         generateCoroutineAsGoroutine(func);
     } else if (!func.async_tasks.empty()) {
+        // At -O2 every task is started before the first wait, so they overlap,
+        // unless the source waits on one before launching the next
+        size_t awaited = std::count_if(func.async_tasks.begin(), func.async_tasks.end(), [](const AsyncTaskInfo& task) {
+            return !task.task_var_name.empty() && !task.detached;
+        });
+        bool ordered = std::any_of(func.async_tasks.begin(), func.async_tasks.end(),
+                                   [](const AsyncTaskInfo& task) { return task.follows_wait; });
+        bool overlap = optimization_level_ >= 2 && awaited > 1 && !ordered;
+
         // Generate async task spawning
         for (const auto& task : func.async_tasks) {
-            generateAsyncTask(task);
+            generateAsyncTask(task, !overlap);
+        }
+        if (overlap) {
+            writeLine("// Wait for the tasks, all started above so they run concurrently");
+            for (const auto& task : func.async_tasks) {
+                if (!task.task_var_name.empty() && !task.detached) {
+                    writeLine("<-" + sanitizeName(task.task_var_name));
+                }
+            }
         }
     } else if (!func.body.empty()) {
         writeLine("// Async function body:");
@@ -747,7 +1251,7 @@ void GoCodeGenerator::generateAsyncFunction(const Function& func) {
     }
 
     // Send result
-    if (func.return_type->kind != TypeKind::Void) {
+    if (returnsValue(func)) {
         writeLine("");
         writeLine("// Send result to channel");
         writeLine("resultChan <- result");
@@ -818,7 +1322,7 @@ void GoCodeGenerator::generateChannelOperation(const AsyncOperation& op) {
     }
 }
 
-void GoCodeGenerator::generateAsyncTask(const AsyncTaskInfo& task) {
+void GoCodeGenerator::generateAsyncTask(const AsyncTaskInfo& task, bool wait) {
     std::stringstream ss;
 
     writeLine("// Async task: " + task.task_var_name);
@@ -837,7 +1341,7 @@ void GoCodeGenerator::generateAsyncTask(const AsyncTaskInfo& task) {
         ss << ")";
         writeLine(ss.str());
 
-        if (!task.detached) {
+        if (!task.detached && wait) {
             writeLine("");
             writeLine("// Wait for task completion");
             writeLine("<-" + sanitizeName(task.task_var_name));
@@ -885,7 +1389,7 @@ void GoCodeGenerator::generateInterfaceForBaseClass(const std::string& base_clas
     // Extract public virtual methods to define interface
     bool has_virtual_methods = false;
     for (const auto& method : derived_class.methods) {
-        if (method.is_virtual && !method.is_constructor && !method.is_destructor) {
+        if (isVirtualMethod(method, derived_class) && !method.is_constructor && !method.is_destructor) {
             has_virtual_methods = true;
 
             // Generate interface method signature
@@ -905,7 +1409,7 @@ void GoCodeGenerator::generateInterfaceForBaseClass(const std::string& base_clas
             sig << ")";
 
             // Return type
-            if (method.return_type && method.return_type->kind != TypeKind::Void) {
+            if (returnsValue(method)) {
                 sig << " " << convertType(method.return_type);
             }
 
@@ -924,8 +1428,12 @@ void GoCodeGenerator::generateInterfaceForBaseClass(const std::string& base_clas
     writeLine("");
 
     // Add a comment showing that the derived class implements this interface
-    std::string struct_name = capitalize(sanitizeName(derived_class.name));
+    std::string struct_name = className(derived_class);
     writeLine("// " + struct_name + " implements " + interface_name + " interface");
+    if (emitsGeneric(derived_class)) {
+        // Only an instantiation can be checked, and which one is unknown here
+        return;
+    }
     writeLine("// Verification (compile-time check):");
     writeLine("var _ " + interface_name + " = (*" + struct_name + ")(nil)");
 }
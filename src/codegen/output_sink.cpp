@@ -0,0 +1,93 @@
+#include "output_sink.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace hybrid {
+
+BufferedSink::BufferedSink(size_t buffer_size)
+    : buffer_(buffer_size > 0 ? buffer_size : 1) {
+}
+
+void BufferedSink::write(std::string_view text) {
+    if (failed_) {
+        return;
+    }
+    written_ += text.size();
+
+    // Large chunks bypass the buffer once it has been drained
+    if (text.size() > buffer_.size() - used_) {
+        if (!flush()) {
+            return;
+        }
+        if (text.size() >= buffer_.size()) {
+            failed_ = !writeRaw(text.data(), text.size());
+            return;
+        }
+    }
+
+    std::memcpy(buffer_.data() + used_, text.data(), text.size());
+    used_ += text.size();
+}
+
+bool BufferedSink::flush() {
+    if (!failed_ && used_ > 0) {
+        failed_ = !writeRaw(buffer_.data(), used_);
+    }
+    used_ = 0;
+    return !failed_;
+}
+
+FileSink::~FileSink() {
+    close();
+}
+
+bool FileSink::open(const std::string& path) {
+    close();
+    failed_ = false;
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        failed_ = true;
+        return false;
+    }
+    // The sink does its own buffering
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    return true;
+}
+
+bool FileSink::close() {
+    if (!file_) {
+        return !failed_;
+    }
+    flush();
+    if (std::fclose(file_) != 0) {
+        failed_ = true;
+    }
+    file_ = nullptr;
+    return !failed_;
+}
+
+bool FileSink::writeRaw(const char* data, size_t size) {
+    return file_ && std::fwrite(data, 1, size, file_) == size;
+}
+
+FdSink::~FdSink() {
+    flush();
+}
+
+bool FdSink::writeRaw(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace hybrid
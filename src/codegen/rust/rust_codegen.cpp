@@ -1,44 +1,202 @@
 #include "codegen.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include "type_names.h"
 #include <algorithm>
 #include <cctype>
 
 namespace hybrid {
 
-std::string RustCodeGenerator::generate(const IR& ir) {
-    output_.str("");
-    output_.clear();
+namespace {
+
+// Larger bodies are left to the compiler's own inlining heuristics at -O3
+constexpr size_t kInlineBodyBytes = 160;
+
+bool contains(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+/** Parameter types worth passing by reference instead of by value */
+bool isCostlyToCopy(const Type& type) {
+    switch (type.kind) {
+        case TypeKind::StdVector:
+        case TypeKind::StdList:
+        case TypeKind::StdDeque:
+        case TypeKind::StdMap:
+        case TypeKind::StdUnorderedMap:
+        case TypeKind::StdSet:
+        case TypeKind::StdUnorderedSet:
+        case TypeKind::StdString:
+        case TypeKind::Struct:
+        case TypeKind::Class:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+void RustCodeGenerator::emit(const IR& ir) {
+    emitPrologue(ir);
+
+    // Generate classes/structs, then standalone functions
+    const auto& classes = ir.getClasses();
+    const auto& functions = ir.getFunctions();
+    emitEach(classes.size() + functions.size(), [&](CodeGenerator& gen, size_t i) {
+        auto& self = static_cast<RustCodeGenerator&>(gen);
+        if (i < classes.size()) {
+            self.emitDeclaration(classes[i]);
+            return;
+        }
+
+        const Function& func = functions[i - classes.size()];
+        ProfileScope scope("codegen", "function", func.name);
+        self.generateFunction(func);
+        self.writeLine("");
+    });
+
+    emitEpilogue(ir);
+}
+
+void RustCodeGenerator::emitPrologue(const IR& ir) {
+    (void)ir;
 
     // Generate file header
     writeLine("// Auto-generated Rust code from C++ source");
     writeLine("// Generated by Hybrid Transpiler");
     writeLine("");
+}
 
-    // Generate classes/structs
-    for (const auto& class_decl : ir.getClasses()) {
-        generateClass(class_decl);
-        writeLine("");
+void RustCodeGenerator::emitEpilogue(const IR& ir) {
+    // Generate global variables (as constants or static)
+    for (const auto& var : ir.getGlobalVariables()) {
+        generateVariable(var);
     }
+}
+
+void RustCodeGenerator::emitDeclaration(const ClassDecl& class_decl) {
+    if (!isEmitted(class_decl)) return;
+
+    ProfileScope scope("codegen", "class", class_decl.name);
+    generateClass(class_decl);
+    writeLine("");
+}
+
+std::unique_ptr<CodeGenerator> RustCodeGenerator::clone() const {
+    return std::make_unique<RustCodeGenerator>(*this);
+}
+
+void RustCodeGenerator::emitBenchmarks(const std::vector<BenchmarkedMethod>& methods, const std::string& module) {
+    writeLine("// Auto-generated Criterion benchmarks for " + module);
+    writeLine("// Generated by Hybrid Transpiler");
+    writeLine("");
+    writeLine("use criterion::{black_box, criterion_group, criterion_main, Criterion};");
+    writeLine("");
+    writeLine("#[path = \"" + module + "\"]");
+    writeLine("mod generated;");
+    writeLine("use generated::*;");
+    writeLine("");
+
+    // Default::default() for every argument, spelled to match the borrow the signature takes
+    auto arguments = [&](const Function& func) {
+        std::string args;
+        for (const auto& param : func.parameters) {
+            std::string type = convertParameterType(func, param);
+            std::string value = "Default::default()";
+            if (type.compare(0, 5, "&mut ") == 0) {
+                value = "&mut Default::default()";
+            } else if (type.compare(0, 7, "*const ") == 0) {
+                value = "std::ptr::null()";
+            } else if (type.compare(0, 5, "*mut ") == 0) {
+                value = "std::ptr::null_mut()";
+            } else if (type[0] == '&' && type != "&str" && type.compare(0, 2, "&[") != 0) {
+                value = "&Default::default()";
+            }
+            args += (args.empty() ? "black_box(" : ", black_box(") + value + ")";
+        }
+        return args;
+    };
+
+    std::vector<std::string> functions;
+    for (const auto& benchmarked : methods) {
+        const ClassDecl& owner = *benchmarked.owner;
+        const Function& method = *benchmarked.method;
+        std::string type_name = sanitizeName(owner.name);
+        functions.push_back(sanitizeName(benchmarked.name));
+
+        planClassLowering(owner);
+        writeLine("fn " + functions.back() + "(c: &mut Criterion) {");
+        indent();
+
+        std::string call;
+        if (method.is_static) {
+            call = type_name + "::" + sanitizeName(method.name) + "(" + arguments(method) + ")";
+        } else {
+            std::string target = method.is_const || lockFreeUpdate(method) ? "let target = " : "let mut target = ";
+            if (const Function* constructor = benchmarkConstructor(owner)) {
+                writeLine(target + type_name + "::new(" + arguments(*constructor) + ");");
+            } else {
+                std::string fields;
+                for (const auto& field : owner.fields) {
+                    if (contains(lowering_.counter_mutexes, field.name)) continue;
+                    fields += (fields.empty() ? " " : ", ") + sanitizeName(field.name) + ": Default::default()";
+                }
+                writeLine(target + type_name + " {" + fields + (fields.empty() ? "};" : " };"));
+            }
+            call = "target." + sanitizeName(method.name) + "(" + arguments(method) + ")";
+        }
 
-    // Generate standalone functions
-    for (const auto& func : ir.getFunctions()) {
-        generateFunction(func);
+        // A returned borrow of the target may not leave the closure
+        std::string routine = "|| " + call;
+        if (method.return_type && method.return_type->kind == TypeKind::Reference) {
+            routine = "|| { black_box(" + call + "); }";
+        }
+        writeLine("c.bench_function(\"" + benchmarked.name + "\", |b| b.iter(" + routine + "));");
+
+        dedent();
+        writeLine("}");
         writeLine("");
+        lowering_ = ClassLowering();
     }
 
-    // Generate global variables (as constants or static)
-    for (const auto& var : ir.getGlobalVariables()) {
-        generateVariable(var);
+    std::string group = "criterion_group!(benches";
+    for (const auto& function : functions) {
+        group += ", " + function;
     }
-
-    return output_.str();
+    writeLine(group + ");");
+    writeLine("criterion_main!(benches);");
 }
 
 void RustCodeGenerator::generateClass(const ClassDecl& class_decl) {
+    planClassLowering(class_decl);
+
+    // Type parameters spell as themselves, or as the trait object they are erased to
+    const TemplatePlan::Template* plan = templatePlan(class_decl);
+    bool generic = emitsGeneric(class_decl);
+    TemplateScope template_scope(*this);
+    for (size_t i = 0; i < class_decl.template_parameters.size(); ++i) {
+        const std::string& name = class_decl.template_parameters[i].name;
+        if (generic) {
+            template_scope_.emplace_back(name, name);
+        } else if (plan) {
+            template_scope_.emplace_back(name, plan->bounds[i] & TemplatePlan::Printable ? "Box<dyn std::fmt::Display>"
+                                                                                          : "Box<dyn std::any::Any>");
+        }
+    }
+    if (plan && plan->over_budget) {
+        writeLine("// " + class_decl.name + ": " + std::to_string(plan->instantiations) +
+                  " instantiations exceed the monomorphization budget of " +
+                  std::to_string(getMonomorphizationBudget()) +
+                  (plan->erased ? "; type parameters erased to trait objects" : "; kept generic for its bounds"));
+    }
+
     // Generate struct definition with generics
-    std::string struct_decl = "pub struct " + sanitizeName(class_decl.name);
+    std::string struct_name = className(class_decl);
+    std::string struct_decl = "pub struct " + struct_name;
 
     // Add generic parameters if template
-    if (class_decl.is_template && !class_decl.template_parameters.empty()) {
+    if (generic) {
         struct_decl += convertTemplateParametersToRust(class_decl.template_parameters);
     }
 
@@ -51,6 +209,18 @@ void RustCodeGenerator::generateClass(const ClassDecl& class_decl) {
         std::string field_name = sanitizeName(field.name);
         std::string field_type = convertType(field.type);
 
+        if (contains(lowering_.counter_mutexes, field.name)) {
+            continue;
+        } else if (contains(lowering_.atomic_counters, field.name)) {
+            field_type = atomicCounterType(field.type);
+        } else if (optimization_level_ >= 2 && field.type && field.type->kind == TypeKind::Class) {
+            // Spelled std mutexes map like the resolved kinds do
+            TypeKind kind = standardTypeKind(*field.type);
+            if (kind == TypeKind::StdMutex || kind == TypeKind::StdSharedMutex) {
+                field_type = convertType(std::make_shared<Type>(kind));
+            }
+        }
+
         writeLine(visibility + field_name + ": " + field_type + ",");
     }
 
@@ -62,15 +232,15 @@ void RustCodeGenerator::generateClass(const ClassDecl& class_decl) {
     if (!class_decl.methods.empty()) {
         std::string impl_decl = "impl";
 
-        // Add generic parameters
-        if (class_decl.is_template && !class_decl.template_parameters.empty()) {
-            impl_decl += convertTemplateParametersToRust(class_decl.template_parameters);
+        // Add generic parameters, bounded by what the methods do with them
+        if (generic) {
+            impl_decl += convertTemplateParametersToRust(class_decl.template_parameters, plan ? &plan->bounds : nullptr);
         }
 
-        impl_decl += " " + sanitizeName(class_decl.name);
+        impl_decl += " " + struct_name;
 
         // Add generic type arguments
-        if (class_decl.is_template && !class_decl.template_parameters.empty()) {
+        if (generic) {
             impl_decl += convertTemplateArgsToRust(class_decl.template_parameters);
         }
 
@@ -78,10 +248,15 @@ void RustCodeGenerator::generateClass(const ClassDecl& class_decl) {
         writeLine(impl_decl);
         indent();
 
-        for (const auto& method : class_decl.methods) {
-            generateFunction(method);
-            writeLine("");
-        }
+        const auto& methods = class_decl.methods;
+        emitEach(methods.size(), [&](CodeGenerator& gen, size_t i) {
+            // Destructors map to Drop, not to an inherent method
+            if (methods[i].is_destructor) return;
+
+            auto& self = static_cast<RustCodeGenerator&>(gen);
+            self.generateFunction(methods[i]);
+            self.writeLine("");
+        });
 
         dedent();
         writeLine("}");
@@ -92,15 +267,105 @@ void RustCodeGenerator::generateClass(const ClassDecl& class_decl) {
         writeLine("");
         generateTraitImplementations(class_decl);
     }
+
+    lowering_ = ClassLowering();
+}
+
+std::string RustCodeGenerator::atomicCounterType(const std::shared_ptr<Type>& type) {
+    static constexpr std::string_view kAtomics[][2] = {
+        {"i8", "AtomicI8"}, {"i16", "AtomicI16"}, {"i32", "AtomicI32"}, {"i64", "AtomicI64"},
+        {"isize", "AtomicIsize"}, {"u8", "AtomicU8"}, {"u16", "AtomicU16"}, {"u32", "AtomicU32"},
+        {"u64", "AtomicU64"}, {"usize", "AtomicUsize"}
+    };
+    std::string spelling = convertType(type);
+    for (const auto& atomic : kAtomics) {
+        if (spelling == atomic[0]) {
+            return "std::sync::atomic::" + std::string(atomic[1]);
+        }
+    }
+    return "";
+}
+
+void RustCodeGenerator::generateLockFreeUpdate(const GuardedUpdate& update) {
+    std::string counter = "self." + sanitizeName(update.var_name);
+    writeLine("// Lock-free: the C++ mutex guarded only this counter");
+    switch (update.operation) {
+        case GuardedUpdate::Read:
+            writeLine(counter + ".load(std::sync::atomic::Ordering::Relaxed)");
+            break;
+        case GuardedUpdate::Add:
+            writeLine(counter + ".fetch_add(" + update.operand + ", std::sync::atomic::Ordering::Relaxed);");
+            break;
+        case GuardedUpdate::Subtract:
+            writeLine(counter + ".fetch_sub(" + update.operand + ", std::sync::atomic::Ordering::Relaxed);");
+            break;
+    }
+}
+
+std::string RustCodeGenerator::convertParameterType(const Function& func, const Parameter& param) {
+    const std::shared_ptr<Type>& type = param.type;
+    if (optimization_level_ < 2 || !type) {
+        return convertType(type);
+    }
+
+    // Read-only by-value parameters and const references become slices or shared borrows
+    std::shared_ptr<Type> borrowed;
+    if (type->kind == TypeKind::Reference && type->is_const && type->element_type &&
+        isCostlyToCopy(*type->element_type)) {
+        borrowed = type->element_type;
+    } else if (isCostlyToCopy(*type) && contains(func.borrowed_params, param.name)) {
+        borrowed = type;
+    }
+    if (!borrowed) {
+        return convertType(type);
+    }
+    if (standardTypeKind(*borrowed) == TypeKind::StdString) {
+        return "&str";
+    }
+    if (borrowed->kind == TypeKind::StdVector && !borrowed->template_args.empty()) {
+        return "&[" + convertType(borrowed->template_args[0]) + "]";
+    }
+    return "&" + convertType(borrowed);
+}
+
+void RustCodeGenerator::generateCapacityHints(const Function& func) {
+    if (optimization_level_ < 2 || func.capacity_hints.empty()) return;
+
+    writeLine("// Capacity reserved in the C++ source");
+    for (const auto& hint : func.capacity_hints) {
+        std::string constructor;
+        switch (hint.container) {
+            case TypeKind::StdString: constructor = "String"; break;
+            case TypeKind::StdDeque: constructor = "std::collections::VecDeque"; break;
+            case TypeKind::StdUnorderedMap: constructor = "std::collections::HashMap"; break;
+            case TypeKind::StdUnorderedSet: constructor = "std::collections::HashSet"; break;
+            default: constructor = "Vec"; break;
+        }
+        writeLine("let mut " + sanitizeName(hint.var_name) + " = " + constructor +
+                  "::with_capacity(" + hint.capacity + ");");
+    }
 }
 
 void RustCodeGenerator::generateFunction(const Function& func) {
+    ResourceBudget::checkpoint("codegen");
+
     // If function is async or coroutine, use async generation
     if (func.is_async || func.coroutine_info.is_coroutine) {
         generateAsyncFunction(func);
         return;
     }
 
+    TemplateScope template_scope(*this);
+    for (const auto& param : func.template_parameters) {
+        template_scope_.emplace_back(param.name, param.name);
+    }
+
+    const GuardedUpdate* lock_free = lockFreeUpdate(func);
+    if (optimization_level_ >= 3 && !func.is_virtual && !func.body.empty() &&
+        func.body.view().size() <= kInlineBodyBytes) {
+        writeLine("#[inline]");
+    }
+
     std::stringstream sig;
 
     // Constructor becomes 'new' in Rust
@@ -117,9 +382,9 @@ void RustCodeGenerator::generateFunction(const Function& func) {
 
     sig << "(";
 
-    // Add self parameter for methods
+    // Add self parameter for methods (atomics update through a shared borrow)
     if (!func.is_static && !func.is_constructor) {
-        if (func.is_const) {
+        if (func.is_const || lock_free) {
             sig << "&self";
         } else {
             sig << "&mut self";
@@ -133,7 +398,7 @@ void RustCodeGenerator::generateFunction(const Function& func) {
     // Add parameters
     for (size_t i = 0; i < func.parameters.size(); ++i) {
         const auto& param = func.parameters[i];
-        sig << sanitizeName(param.name) << ": " << convertType(param.type);
+        sig << sanitizeName(param.name) << ": " << convertParameterType(func, param);
 
         if (i < func.parameters.size() - 1) {
             sig << ", ";
@@ -147,13 +412,13 @@ void RustCodeGenerator::generateFunction(const Function& func) {
         sig << " -> Self";
     } else if (func.may_throw) {
         // Function may throw - convert to Result type
-        if (func.return_type->kind != TypeKind::Void) {
+        if (returnsValue(func)) {
             sig << " -> Result<" << convertType(func.return_type)
                 << ", Box<dyn std::error::Error>>";
         } else {
             sig << " -> Result<(), Box<dyn std::error::Error>>";
         }
-    } else if (func.return_type->kind != TypeKind::Void) {
+    } else if (returnsValue(func)) {
         sig << " -> " << convertType(func.return_type);
     }
 
@@ -161,7 +426,9 @@ void RustCodeGenerator::generateFunction(const Function& func) {
     indent();
 
     // Function body with threading conversion
-    if (func.uses_threading) {
+    if (lock_free) {
+        generateLockFreeUpdate(*lock_free);
+    } else if (func.uses_threading) {
         generateThreadingCode(func);
     }
     // Function body with exception handling conversion
@@ -173,10 +440,11 @@ void RustCodeGenerator::generateFunction(const Function& func) {
         if (func.may_throw) {
             writeLine("// Function may throw - wrap result in Ok()");
         }
+        generateCapacityHints(func);
         writeLine("// TODO: Implement function body");
         writeLine(func.body);
 
-        if (func.may_throw && func.return_type->kind != TypeKind::Void) {
+        if (func.may_throw && returnsValue(func)) {
             writeLine("// Ok(result)");
         } else if (func.may_throw) {
             writeLine("Ok(())");
@@ -209,7 +477,7 @@ void RustCodeGenerator::generateTryCatchAsResult(const Function& func) {
         }
 
         // If try succeeds, return Ok
-        if (func.return_type->kind != TypeKind::Void) {
+        if (returnsValue(func)) {
             writeLine("Ok(result)  // TODO: actual return value");
         } else {
             writeLine("Ok(())");
@@ -237,7 +505,7 @@ void RustCodeGenerator::generateTryCatchAsResult(const Function& func) {
                 }
             }
 
-            if (func.return_type->kind != TypeKind::Void) {
+            if (returnsValue(func)) {
                 writeLine("Ok(default_value)  // TODO: error recovery value");
             } else {
                 writeLine("Ok(())");
@@ -269,6 +537,15 @@ void RustCodeGenerator::generateVariable(const Variable& var) {
 
 std::string RustCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
     if (!type) return "()";
+    if (spellsTemplates()) return convertTypeUncached(type);
+
+    if (const std::string* cached = type_spellings_.find(type.get())) {
+        return *cached;
+    }
+    return type_spellings_.insert(type, convertTypeUncached(type));
+}
+
+std::string RustCodeGenerator::convertTypeUncached(const std::shared_ptr<Type>& type) {
 
     switch (type->kind) {
         case TypeKind::Void:
@@ -278,22 +555,13 @@ std::string RustCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
             return "bool";
 
         case TypeKind::Integer:
-            // Map C++ integer types to Rust
-            if (type->name == "int" || type->name == "int32_t") return "i32";
-            if (type->name == "long" || type->name == "int64_t") return "i64";
-            if (type->name == "short" || type->name == "int16_t") return "i16";
-            if (type->name == "char" || type->name == "int8_t") return "i8";
-            if (type->name == "unsigned int" || type->name == "uint32_t") return "u32";
-            if (type->name == "unsigned long" || type->name == "uint64_t") return "u64";
-            if (type->name == "unsigned short" || type->name == "uint16_t") return "u16";
-            if (type->name == "unsigned char" || type->name == "uint8_t") return "u8";
-            if (type->name == "size_t") return "usize";
-            return "i32"; // default
-
-        case TypeKind::Float:
-            if (type->name == "float") return "f32";
-            if (type->name == "double") return "f64";
-            return "f64"; // default
+        case TypeKind::Float: {
+            const BuiltinTypeName* builtin = findBuiltinType(type->name);
+            if (builtin && builtin->kind == type->kind) {
+                return std::string(builtin->rust);
+            }
+            return type->kind == TypeKind::Integer ? "i32" : "f64"; // default
+        }
 
         case TypeKind::Pointer:
             return convertSmartPointer(type);
@@ -305,9 +573,24 @@ std::string RustCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
                 return "&mut " + convertType(type->element_type);
             }
 
-        case TypeKind::Array:
-            return "[" + convertType(type->element_type) + "; " +
-                   std::to_string(type->size_bytes / type->element_type->size_bytes) + "]";
+        case TypeKind::Array: {
+            if (type->element_type && type->element_type->size_bytes > 0) {
+                return "[" + convertType(type->element_type) + "; " +
+                       std::to_string(type->size_bytes / type->element_type->size_bytes) + "]";
+            }
+
+            // Size unknown: take the extent from the spelling (T[N]), T[] becomes Vec<T>
+            size_t open = type->name.rfind('[');
+            size_t close = type->name.rfind(']');
+            std::string extent;
+            if (open != std::string::npos && close != std::string::npos && close > open) {
+                extent = type->name.substr(open + 1, close - open - 1);
+            }
+            if (extent.empty()) {
+                return "Vec<" + convertType(type->element_type) + ">";
+            }
+            return "[" + convertType(type->element_type) + "; " + extent + "]";
+        }
 
         // STL Container types
         case TypeKind::StdVector:
@@ -447,13 +730,81 @@ std::string RustCodeGenerator::convertType(const std::shared_ptr<Type>& type) {
 
         case TypeKind::Struct:
         case TypeKind::Class:
-            return sanitizeName(type->name);
+            return spellsTemplates() ? convertClassSpelling(type->name) : sanitizeName(type->name);
 
         default:
             return "/* Unknown type: " + type->name + " */";
     }
 }
 
+std::string RustCodeGenerator::className(const ClassDecl& class_decl) {
+    std::string name = sanitizeName(class_decl.name);
+
+    // Explicit specializations are separate structs: box_i32 for Box<int>
+    if (const std::string* arguments = specializationArguments(class_decl)) {
+        for (const auto& argument : resolveClassSpelling(class_decl.name + "<" + *arguments + ">").arguments) {
+            name += "_" + mangleArgument(argument);
+        }
+    }
+    return name;
+}
+
+std::string RustCodeGenerator::convertClassSpelling(const std::string& spelling) {
+    if (const std::string* parameter = templateParameterSpelling(spelling)) {
+        return *parameter;
+    }
+    ClassSpelling resolved = resolveClassSpelling(spelling);
+    if (!resolved.plan || resolved.arguments.empty()) {
+        return sanitizeName(spelling);
+    }
+    if (resolved.specialization) {
+        return className(*resolved.specialization);
+    }
+    if (resolved.plan->erased) {
+        return sanitizeName(resolved.name);
+    }
+
+    std::string result = sanitizeName(resolved.name) + "<";
+    for (size_t i = 0; i < resolved.arguments.size(); ++i) {
+        result += (i > 0 ? ", " : "") + convertTemplateArgument(resolved.arguments[i]);
+    }
+    return result + ">";
+}
+
+std::string RustCodeGenerator::convertTemplateArgument(const std::string& argument) {
+    if (const std::string* parameter = templateParameterSpelling(argument)) {
+        return *parameter;
+    }
+    if (const BuiltinTypeName* builtin = findBuiltinType(argument)) {
+        return std::string(builtin->rust);
+    }
+    if (argument == "std::string" || argument == "string") {
+        return "String";
+    }
+    if (!argument.empty() && (std::isdigit(static_cast<unsigned char>(argument[0])) || argument[0] == '-')) {
+        return argument;
+    }
+    return convertClassSpelling(argument);
+}
+
+std::string RustCodeGenerator::mangleArgument(const std::string& argument) {
+    if (const BuiltinTypeName* builtin = findBuiltinType(argument)) {
+        return std::string(builtin->rust);
+    }
+    std::string result;
+    for (char c : sanitizeName(argument)) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            result += c;
+        } else if (c == '*' || c == '&') {
+            result += c == '*' ? "_ptr" : "_ref";
+        } else if (!result.empty() && result.back() != '_') {
+            result += '_';
+        }
+    }
+    while (!result.empty() && result.back() == '_') result.pop_back();
+    return result;
+}
+
 std::string RustCodeGenerator::convertSmartPointer(const std::shared_ptr<Type>& type) {
     // Check if this is a smart pointer pattern
     if (type->name.find("unique_ptr") != std::string::npos) {
@@ -508,7 +859,8 @@ std::string RustCodeGenerator::sanitizeName(const std::string& name) {
     return result;
 }
 
-std::string RustCodeGenerator::convertTemplateParametersToRust(const std::vector<TemplateParameter>& params) {
+std::string RustCodeGenerator::convertTemplateParametersToRust(const std::vector<TemplateParameter>& params,
+                                                                const std::vector<unsigned>* bounds) {
     if (params.empty()) {
         return "";
     }
@@ -517,19 +869,39 @@ std::string RustCodeGenerator::convertTemplateParametersToRust(const std::vector
     ss << "<";
 
     bool first = true;
-    for (const auto& param : params) {
+    for (size_t p = 0; p < params.size(); ++p) {
+        const auto& param = params[p];
         if (!first) ss << ", ";
         first = false;
 
         if (param.kind == TemplateParameter::Type) {
             ss << param.name;
 
-            // Add trait bounds if constraints exist
-            if (!param.constraints.empty()) {
+            // Add trait bounds from constraints and from the operators the methods apply
+            std::vector<std::string> traits = param.constraints;
+            unsigned inferred = bounds && p < bounds->size() ? (*bounds)[p] : 0;
+            if (inferred & TemplatePlan::Ordered) {
+                traits.push_back("PartialOrd");
+            } else if (inferred & TemplatePlan::Equatable) {
+                traits.push_back("PartialEq");
+            }
+            static constexpr std::pair<unsigned, const char*> kOperators[] = {
+                {TemplatePlan::Addable, "std::ops::Add"}, {TemplatePlan::Subtractable, "std::ops::Sub"},
+                {TemplatePlan::Multipliable, "std::ops::Mul"}, {TemplatePlan::Divisible, "std::ops::Div"}
+            };
+            for (const auto& [bound, trait] : kOperators) {
+                if (inferred & bound) {
+                    traits.push_back(std::string(trait) + "<Output = " + param.name + ">");
+                }
+            }
+            if (inferred & TemplatePlan::Printable) {
+                traits.push_back("std::fmt::Display");
+            }
+            if (!traits.empty()) {
                 ss << ": ";
-                for (size_t i = 0; i < param.constraints.size(); ++i) {
+                for (size_t i = 0; i < traits.size(); ++i) {
                     if (i > 0) ss << " + ";
-                    ss << param.constraints[i];
+                    ss << traits[i];
                 }
             }
         } else if (param.kind == TemplateParameter::NonType) {
@@ -575,9 +947,19 @@ void RustCodeGenerator::generateThreadingCode(const Function& func) {
     writeLine("// Threading code converted from C++");
     writeLine("");
 
+    // Threads joined before returning can borrow the caller's data instead of sharing it through Arc
+    bool scoped = optimization_level_ >= 2 && !func.threads_created.empty() &&
+                  std::all_of(func.threads_created.begin(), func.threads_created.end(),
+                              [](const ThreadInfo& thread) { return thread.joinable && !thread.detached; });
+    if (scoped) {
+        writeLine("// Scoped threads: all joined here, so they borrow instead of needing Arc");
+        writeLine("std::thread::scope(|scope| {");
+        indent();
+    }
+
     // Generate thread creation
     for (const auto& thread : func.threads_created) {
-        generateThreadCreation(thread);
+        generateThreadCreation(thread, scoped);
         writeLine("");
     }
 
@@ -599,6 +981,8 @@ void RustCodeGenerator::generateThreadingCode(const Function& func) {
         writeLine("");
     }
 
+    generateCapacityHints(func);
+
     // Generate original function body
     if (!func.body.empty()) {
         writeLine("// Original function body:");
@@ -613,16 +997,21 @@ void RustCodeGenerator::generateThreadingCode(const Function& func) {
             writeLine(thread.thread_var_name + ".join().unwrap();");
         }
     }
+
+    if (scoped) {
+        dedent();
+        writeLine("});");
+    }
 }
 
-void RustCodeGenerator::generateThreadCreation(const ThreadInfo& thread) {
+void RustCodeGenerator::generateThreadCreation(const ThreadInfo& thread, bool scoped) {
     std::stringstream ss;
 
     writeLine("// Thread: " + thread.thread_var_name);
 
     // Generate thread spawn
     ss << "let " << sanitizeName(thread.thread_var_name)
-       << " = std::thread::spawn(move || {";
+       << (scoped ? " = scope.spawn(|| {" : " = std::thread::spawn(move || {");
 
     writeLine(ss.str());
     indent();
@@ -653,18 +1042,23 @@ void RustCodeGenerator::generateThreadCreation(const ThreadInfo& thread) {
 void RustCodeGenerator::generateLockScope(const LockInfo& lock) {
     std::stringstream ss;
 
+    // A std::shared_mutex is an RwLock, exclusively locked with write(). A
+    // std::mutex stays exclusive even in const methods: they may update
+    // mutable state under it.
+    std::string exclusive = contains(lowering_.shared_mutexes, lock.mutex_name) ? ".write()" : ".lock()";
+
     switch (lock.type) {
         case LockInfo::LockGuard:
             writeLine("// Lock guard (RAII lock)");
             ss << "let _" << sanitizeName(lock.lock_var_name)
-               << " = " << sanitizeName(lock.mutex_name) << ".lock().unwrap();";
+               << " = " << sanitizeName(lock.mutex_name) << exclusive << ".unwrap();";
             writeLine(ss.str());
             break;
 
         case LockInfo::UniqueLock:
             writeLine("// Unique lock (RAII lock)");
             ss << "let mut " << sanitizeName(lock.lock_var_name)
-               << " = " << sanitizeName(lock.mutex_name) << ".lock().unwrap();";
+               << " = " << sanitizeName(lock.mutex_name) << exclusive << ".unwrap();";
             writeLine(ss.str());
             break;
 
@@ -789,6 +1183,11 @@ void RustCodeGenerator::generateConditionVariable(const ConditionVariableInfo& c
 }
 
 void RustCodeGenerator::generateAsyncFunction(const Function& func) {
+    TemplateScope template_scope(*this);
+    for (const auto& param : func.template_parameters) {
+        template_scope_.emplace_back(param.name, param.name);
+    }
+
     std::stringstream sig;
 
     // Generate async function signature
@@ -817,7 +1216,7 @@ void RustCodeGenerator::generateAsyncFunction(const Function& func) {
     // Add parameters
     for (size_t i = 0; i < func.parameters.size(); ++i) {
         const auto& param = func.parameters[i];
-        sig << sanitizeName(param.name) << ": " << convertType(param.type);
+        sig << sanitizeName(param.name) << ": " << convertParameterType(func, param);
 
         if (i < func.parameters.size() - 1) {
             sig << ", ";
@@ -827,7 +1226,7 @@ void RustCodeGenerator::generateAsyncFunction(const Function& func) {
     sig << ")";
 
     // Return type
-    if (func.return_type->kind != TypeKind::Void) {
+    if (returnsValue(func)) {
         sig << " -> " << convertType(func.return_type);
     }
 
@@ -1017,7 +1416,7 @@ void RustCodeGenerator::generateTraitForBaseClass(const std::string& base_class_
     // Extract public virtual methods to define trait interface
     bool has_virtual_methods = false;
     for (const auto& method : derived_class.methods) {
-        if (method.is_virtual && !method.is_constructor && !method.is_destructor) {
+        if (isVirtualMethod(method, derived_class) && !method.is_constructor && !method.is_destructor) {
             has_virtual_methods = true;
 
             // Generate trait method signature
@@ -1034,13 +1433,13 @@ void RustCodeGenerator::generateTraitForBaseClass(const std::string& base_class_
             // Add other parameters
             for (size_t i = 0; i < method.parameters.size(); ++i) {
                 const auto& param = method.parameters[i];
-                sig << ", " << sanitizeName(param.name) << ": " << convertType(param.type);
+                sig << ", " << sanitizeName(param.name) << ": " << convertParameterType(method, param);
             }
 
             sig << ")";
 
             // Return type
-            if (method.return_type && method.return_type->kind != TypeKind::Void) {
+            if (returnsValue(method)) {
                 sig << " -> " << convertType(method.return_type);
             }
 
@@ -1060,13 +1459,19 @@ void RustCodeGenerator::generateTraitForBaseClass(const std::string& base_class_
     writeLine("");
 
     // Generate trait implementation for the derived class
-    std::string struct_name = sanitizeName(derived_class.name);
-    writeLine("impl " + trait_name + " for " + struct_name + " {");
+    std::string struct_name = className(derived_class);
+    std::string impl_decl = "impl";
+    if (emitsGeneric(derived_class)) {
+        const TemplatePlan::Template* plan = templatePlan(derived_class);
+        impl_decl += convertTemplateParametersToRust(derived_class.template_parameters, plan ? &plan->bounds : nullptr);
+        struct_name += convertTemplateArgsToRust(derived_class.template_parameters);
+    }
+    writeLine(impl_decl + " " + trait_name + " for " + struct_name + " {");
     indent();
 
     // Implement virtual methods
     for (const auto& method : derived_class.methods) {
-        if (method.is_virtual && !method.is_constructor && !method.is_destructor) {
+        if (isVirtualMethod(method, derived_class) && !method.is_constructor && !method.is_destructor) {
             std::stringstream sig;
             sig << "fn " << sanitizeName(method.name) << "(";
 
@@ -1080,13 +1485,13 @@ void RustCodeGenerator::generateTraitForBaseClass(const std::string& base_class_
             // Add other parameters
             for (size_t i = 0; i < method.parameters.size(); ++i) {
                 const auto& param = method.parameters[i];
-                sig << ", " << sanitizeName(param.name) << ": " << convertType(param.type);
+                sig << ", " << sanitizeName(param.name) << ": " << convertParameterType(method, param);
             }
 
             sig << ")";
 
             // Return type
-            if (method.return_type && method.return_type->kind != TypeKind::Void) {
+            if (returnsValue(method)) {
                 sig << " -> " << convertType(method.return_type);
             }
 
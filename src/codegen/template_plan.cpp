@@ -0,0 +1,449 @@
+#include "codegen.h"
+#include "analysis_pass.h"
+#include "lexer.h"
+#include "profiler.h"
+#include "type_names.h"
+#include <algorithm>
+#include <set>
+
+namespace hybrid {
+
+namespace {
+
+bool isIntegerWord(std::string_view word) {
+    return word == "signed" || word == "unsigned" || word == "short" || word == "long" || word == "int" ||
+           word == "char";
+}
+
+/** "unsigned long int" -> "unsigned long"; every spelling of a builtin to its first table entry */
+std::string canonicalBuiltin(const std::vector<std::string_view>& words) {
+    std::string joined;
+    bool is_unsigned = false;
+    for (std::string_view word : words) {
+        if (word == "unsigned") is_unsigned = true;
+        if (word == "signed" || word == "unsigned" || (word == "int" && words.size() > 1)) continue;
+        joined += (joined.empty() ? "" : " ") + std::string(word);
+    }
+    if (joined.empty()) joined = "int";
+    if (is_unsigned) joined = "unsigned " + joined;
+    const BuiltinTypeName* builtin = findBuiltinType(joined);
+    if (!builtin) return joined;
+    for (const auto& entry : kBuiltinTypeNames) {
+        if (entry.kind == builtin->kind && entry.rust == builtin->rust) {
+            return std::string(entry.name);
+        }
+    }
+    return joined;
+}
+
+/** Arguments of the first <...> in tokens[open] .. its matching '>', split at top-level commas */
+size_t splitArguments(const std::vector<Token>& tokens, size_t open, std::vector<std::string>& arguments,
+                      std::string_view text) {
+    int depth = 0;
+    size_t start = open + 1;
+    for (size_t i = open; i < tokens.size(); ++i) {
+        const Token& t = tokens[i];
+        if (t.isPunct("<") || t.isPunct("(") || t.isPunct("[")) {
+            depth++;
+        } else if (t.isPunct(">") || t.isPunct(")") || t.isPunct("]")) {
+            if (--depth == 0) {
+                if (i > start) {
+                    arguments.push_back(CodeGenerator::canonicalSpelling(
+                        text.substr(tokens[start].offset, tokens[i - 1].end() - tokens[start].offset)));
+                }
+                return i;
+            }
+        } else if (t.isPunct(",") && depth == 1) {
+            if (i > start) {
+                arguments.push_back(CodeGenerator::canonicalSpelling(
+                    text.substr(tokens[start].offset, tokens[i - 1].end() - tokens[start].offset)));
+            }
+            start = i + 1;
+        }
+    }
+    return tokens.size();
+}
+
+std::string joinArguments(const std::vector<std::string>& arguments) {
+    std::string joined;
+    for (const auto& argument : arguments) {
+        joined += (joined.empty() ? "" : ",") + argument;
+    }
+    return joined;
+}
+
+std::string spellingOf(const std::shared_ptr<Type>& type) {
+    if (!type) return "";
+    return (type->is_const ? "const " : "") + type->name;
+}
+
+/** Name of the type parameter a value of this type holds ("T", "const T&"), else empty */
+std::string parameterHeld(const std::shared_ptr<Type>& type) {
+    if (!type) return "";
+    const Type* held = type.get();
+    if (held->kind == TypeKind::Reference && held->element_type) {
+        held = held->element_type.get();
+    }
+    return held->kind == TypeKind::Class ? held->name : "";
+}
+
+/**
+ * Everything that makes two classes generate the same code, with the
+ * identifiers in substitutions replaced
+ */
+std::string fingerprint(const ClassDecl& class_decl, const std::unordered_map<std::string, std::string>& substitutions) {
+    std::string out;
+    auto spell = [&](const std::shared_ptr<Type>& type) {
+        out += CodeGenerator::canonicalSpelling(spellingOf(type), &substitutions);
+        out += '\x1f';
+    };
+    auto text = [&](const SourceText& source) {
+        out += CodeGenerator::canonicalSpelling(source.view(), &substitutions);
+        out += '\x1f';
+    };
+    for (const auto& base : class_decl.base_classes) {
+        out += base + '\x1f';
+    }
+    out += '\x1e';
+    for (const auto& field : class_decl.fields) {
+        out += field.name + '\x1f';
+        spell(field.type);
+        text(field.initializer);
+        out += field.is_static ? 's' : '-';
+        out += field.is_const ? 'c' : '-';
+    }
+    out += '\x1e';
+    for (const auto& method : class_decl.methods) {
+        out += method.name + '\x1f';
+        spell(method.return_type);
+        for (const auto& param : method.parameters) {
+            out += param.name + '\x1f';
+            spell(param.type);
+        }
+        out += method.is_const ? 'c' : '-';
+        out += method.is_static ? 's' : '-';
+        out += method.is_virtual ? 'v' : '-';
+        out += method.is_pure_virtual ? 'p' : '-';
+        out += method.is_constructor ? 'n' : '-';
+        out += method.is_destructor ? 'd' : '-';
+        text(method.body);
+        out += '\x1e';
+    }
+    return out;
+}
+
+} // namespace
+
+std::string CodeGenerator::canonicalSpelling(std::string_view spelling,
+                                             const std::unordered_map<std::string, std::string>* substitutions) {
+    std::vector<Token> tokens = Lexer(spelling).tokenize(false);
+    std::string out;
+    bool word_before = false;
+    auto append = [&](std::string_view text, bool word) {
+        if (word && word_before) out += ' ';
+        out += text;
+        word_before = word;
+    };
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const Token& t = tokens[i];
+        if (t.kind == TokenKind::EndOfFile) break;
+        if (t.kind == TokenKind::Preprocessor) continue;
+        if (t.kind != TokenKind::Identifier) {
+            append(t.text, t.kind == TokenKind::Number);
+            continue;
+        }
+
+        // std::size_t, std::int32_t -> size_t, int32_t
+        if (t.text == "std" && i + 2 < tokens.size() && tokens[i + 1].isPunct("::") &&
+            findBuiltinType(tokens[i + 2].text)) {
+            i++;
+            continue;
+        }
+        if (isIntegerWord(t.text)) {
+            std::vector<std::string_view> words;
+            while (i < tokens.size() && tokens[i].kind == TokenKind::Identifier && isIntegerWord(tokens[i].text)) {
+                words.push_back(tokens[i].text);
+                i++;
+            }
+            i--;
+            append(canonicalBuiltin(words), true);
+            continue;
+        }
+
+        std::string word(t.text);
+        if (substitutions) {
+            auto it = substitutions->find(word);
+            if (it != substitutions->end()) {
+                append(it->second, true);
+                continue;
+            }
+        }
+        if (const BuiltinTypeName* builtin = findBuiltinType(word)) {
+            append(canonicalBuiltin({builtin->name}), true);
+            continue;
+        }
+        append(word, true);
+    }
+    return out;
+}
+
+void CodeGenerator::planTemplates(const IR& ir) {
+    templates_ = nullptr;
+    const auto& classes = ir.getClasses();
+    bool any = std::any_of(classes.begin(), classes.end(), [](const ClassDecl& c) {
+        return c.is_template || !c.specialization.specialized_args.empty();
+    });
+    if (!any) return;
+
+    ProfileScope scope("codegen", "templates");
+    auto plan = std::make_shared<TemplatePlan>();
+
+    // Primaries first, so specializations declared before them still find them
+    for (const auto& class_decl : classes) {
+        if (!class_decl.is_template || !class_decl.specialization.specialized_args.empty()) continue;
+        TemplatePlan::Template& entry = plan->templates[class_decl.name];
+        if (entry.primary) continue;
+        entry.primary = &class_decl;
+        entry.bounds.assign(class_decl.template_parameters.size(), 0);
+    }
+    for (const auto& class_decl : classes) {
+        if (!class_decl.specialization.specialized_args.empty()) {
+            plan->templates.try_emplace(class_decl.name);
+        }
+    }
+
+    // Explicit specializations: the first of each argument list, unless the primary says the same
+    for (const auto& class_decl : classes) {
+        const auto& spelled = class_decl.specialization.specialized_args;
+        if (spelled.empty()) continue;
+        std::vector<std::string> arguments;
+        for (const auto& argument : spelled) {
+            arguments.push_back(canonicalSpelling(argument));
+        }
+        std::string joined = joinArguments(arguments);
+        std::string key = class_decl.name + "<" + joined + ">";
+        if (plan->specialized.count(key)) {
+            plan->duplicates.insert(&class_decl);
+            continue;
+        }
+
+        const ClassDecl* primary = plan->templates[class_decl.name].primary;
+        if (primary && !class_decl.specialization.is_partial &&
+            primary->template_parameters.size() == arguments.size()) {
+            std::unordered_map<std::string, std::string> substitutions;
+            for (size_t i = 0; i < arguments.size(); ++i) {
+                substitutions.emplace(primary->template_parameters[i].name, arguments[i]);
+            }
+            if (fingerprint(*primary, substitutions) == fingerprint(class_decl, {})) {
+                plan->duplicates.insert(&class_decl);
+                continue;
+            }
+        }
+        plan->specializations.emplace(&class_decl, joined);
+        plan->specialized.emplace(std::move(key), &class_decl);
+    }
+
+    // Distinct argument lists of every use: signatures, fields and bodies
+    std::unordered_map<std::string, std::set<std::string>> uses;
+    auto scanSpelling = [&](std::string_view text) {
+        if (text.find('<') == std::string_view::npos) return;
+        std::vector<Token> tokens = Lexer(text).tokenize(false);
+        for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+            if (tokens[i].kind != TokenKind::Identifier || !tokens[i + 1].isPunct("<")) continue;
+            auto it = plan->templates.find(std::string(tokens[i].text));
+            if (it == plan->templates.end()) continue;
+            std::vector<std::string> arguments;
+            splitArguments(tokens, i + 1, arguments, text);
+            if (!arguments.empty()) {
+                uses[it->first].insert(joinArguments(arguments));
+            }
+        }
+    };
+    auto scanType = [&](const std::shared_ptr<Type>& type) {
+        for (const Type* t = type.get(); t; t = t->element_type.get()) {
+            scanSpelling(t->name);
+        }
+    };
+    auto scanFunction = [&](const Function& func) {
+        scanType(func.return_type);
+        for (const auto& param : func.parameters) {
+            scanType(param.type);
+        }
+        scanSpelling(func.body.view());
+    };
+    for (const auto& class_decl : classes) {
+        for (const auto& field : class_decl.fields) {
+            scanType(field.type);
+        }
+        for (const auto& method : class_decl.methods) {
+            scanFunction(method);
+        }
+    }
+    for (const auto& func : ir.getFunctions()) {
+        scanFunction(func);
+    }
+    for (const auto& var : ir.getGlobalVariables()) {
+        scanType(var.type);
+    }
+    for (const auto& [key, specialization] : plan->specialized) {
+        uses[specialization->name].insert(plan->specializations.at(specialization));
+    }
+
+    for (auto& [name, entry] : plan->templates) {
+        std::set<std::string>& lists = uses[name];
+        if (entry.primary) {
+            // A template naming itself (Box<T> inside Box) is not an instantiation
+            std::vector<std::string> own;
+            for (const auto& param : entry.primary->template_parameters) {
+                own.push_back(param.name);
+            }
+            lists.erase(joinArguments(own));
+        }
+        entry.instantiations = lists.size();
+        entry.over_budget = monomorphization_budget_ > 0 && entry.instantiations > monomorphization_budget_;
+    }
+
+    // Bounds: operators applied to fields and parameters holding a type parameter
+    for (auto& [name, entry] : plan->templates) {
+        if (!entry.primary) continue;
+        const ClassDecl& primary = *entry.primary;
+        for (size_t p = 0; p < primary.template_parameters.size(); ++p) {
+            const TemplateParameter& param = primary.template_parameters[p];
+            if (param.kind != TemplateParameter::Type) continue;
+
+            std::unordered_set<std::string> fields;
+            for (const auto& field : primary.fields) {
+                if (parameterHeld(field.type) == param.name) fields.insert(field.name);
+            }
+            unsigned bounds = 0;
+            for (const auto& method : primary.methods) {
+                if (method.body.empty()) continue;
+                std::unordered_set<std::string> values = fields;
+                for (const auto& method_param : method.parameters) {
+                    if (parameterHeld(method_param.type) == param.name) values.insert(method_param.name);
+                }
+                if (values.empty()) continue;
+
+                BodyScan scan(method.body);
+                for (size_t i = 0; i < scan.size(); ++i) {
+                    const Token& t = scan.at(i);
+                    if (t.kind != TokenKind::Identifier || !values.count(std::string(t.text))) continue;
+                    if (scan.at(i + 1).isPunct("(")) continue;
+
+                    // The operator after the value, and a binary one before it
+                    std::string_view after = scan.punctuator(i + 1);
+                    std::string_view before;
+                    if (i >= 2 && scan.punctuator(i - 2).size() == 2) {
+                        before = scan.punctuator(i - 2);
+                    } else if (i >= 1 && scan.punctuator(i - 1).size() == 1) {
+                        before = scan.punctuator(i - 1);
+                    }
+                    const Token& operand = scan.at(i - before.size() - 1);
+                    bool binary_before = !before.empty() && i > before.size() &&
+                                         (operand.kind == TokenKind::Number || operand.isPunct(")") ||
+                                          operand.isPunct("]") ||
+                                          (operand.kind == TokenKind::Identifier && !operand.isIdentifier("return")));
+
+                    for (std::string_view op : {after, binary_before ? before : std::string_view()}) {
+                        if (op == "<" || op == ">" || op == "<=" || op == ">=") {
+                            bounds |= TemplatePlan::Ordered;
+                        } else if (op == "==" || op == "!=") {
+                            bounds |= TemplatePlan::Equatable;
+                        } else if (op == "+" || op == "+=") {
+                            bounds |= TemplatePlan::Addable;
+                        } else if (op == "*" || op == "*=") {
+                            bounds |= TemplatePlan::Multipliable;
+                        } else if (op == "/" || op == "/=") {
+                            bounds |= TemplatePlan::Divisible;
+                        } else if (op == "-" || op == "-=") {
+                            bounds |= TemplatePlan::Subtractable;
+                        }
+                    }
+                    if (before == "<<" || (i >= 2 && scan.at(i - 1).isPunct("(") &&
+                                           scan.at(i - 2).isIdentifier("to_string"))) {
+                        bounds |= TemplatePlan::Printable;
+                    }
+                }
+            }
+            entry.bounds[p] = bounds;
+        }
+
+        // Erased only if every parameter is a type whose bounds survive erasure
+        bool erasable = !primary.specialization.is_partial;
+        for (size_t p = 0; p < primary.template_parameters.size(); ++p) {
+            erasable &= primary.template_parameters[p].kind == TemplateParameter::Type &&
+                        (entry.bounds[p] & ~erasableBounds()) == 0;
+        }
+        entry.erased = entry.over_budget && erasable;
+    }
+
+    templates_ = std::move(plan);
+}
+
+const std::string* CodeGenerator::templateParameterSpelling(std::string_view name) const {
+    for (auto it = template_scope_.rbegin(); it != template_scope_.rend(); ++it) {
+        if (it->first == name) return &it->second;
+    }
+    return nullptr;
+}
+
+const CodeGenerator::TemplatePlan::Template* CodeGenerator::templatePlan(const ClassDecl& class_decl) const {
+    if (!templates_ || !class_decl.is_template || !class_decl.specialization.specialized_args.empty()) {
+        return nullptr;
+    }
+    auto it = templates_->templates.find(class_decl.name);
+    return it != templates_->templates.end() && it->second.primary == &class_decl ? &it->second : nullptr;
+}
+
+bool CodeGenerator::isEmitted(const ClassDecl& class_decl) const {
+    return !templates_ || !templates_->duplicates.count(&class_decl);
+}
+
+bool CodeGenerator::emitsGeneric(const ClassDecl& class_decl) const {
+    if (!class_decl.is_template || class_decl.template_parameters.empty()) return false;
+    const TemplatePlan::Template* plan = templatePlan(class_decl);
+    return !plan || !plan->erased;
+}
+
+const std::string* CodeGenerator::specializationArguments(const ClassDecl& class_decl) const {
+    if (!templates_) return nullptr;
+    auto it = templates_->specializations.find(&class_decl);
+    return it != templates_->specializations.end() ? &it->second : nullptr;
+}
+
+CodeGenerator::ClassSpelling CodeGenerator::resolveClassSpelling(const std::string& spelling) const {
+    ClassSpelling result;
+    size_t open = spelling.find('<');
+    result.name = open == std::string::npos ? spelling : spelling.substr(0, open);
+    while (!result.name.empty() && result.name.back() == ' ') result.name.pop_back();
+    if (open == std::string::npos || spelling.back() != '>') {
+        result.name = spelling;
+        return result;
+    }
+
+    std::vector<Token> tokens = Lexer(spelling).tokenize(false);
+    size_t angle = 0;
+    while (angle < tokens.size() && !tokens[angle].isPunct("<")) angle++;
+    if (splitArguments(tokens, angle, result.arguments, spelling) + 2 != tokens.size()) {
+        result.name = spelling;     // Not one Name<...> (e.g. Outer<int>::Inner)
+        result.arguments.clear();
+        return result;
+    }
+
+    if (templates_) {
+        std::string unqualified = result.name.substr(result.name.rfind(':') == std::string::npos ? 0
+                                                                                   : result.name.rfind(':') + 1);
+        auto it = templates_->templates.find(unqualified);
+        if (it != templates_->templates.end()) {
+            result.plan = &it->second;
+            auto specialized = templates_->specialized.find(unqualified + "<" + joinArguments(result.arguments) + ">");
+            if (specialized != templates_->specialized.end()) {
+                result.specialization = specialized->second;
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace hybrid
@@ -0,0 +1,256 @@
+/**
+ * @file c_wrapper_gen.cpp
+ * @brief extern "C" wrappers and their C header
+ */
+
+#include "ffi.h"
+#include <algorithm>
+#include <cctype>
+
+namespace hybrid_transpiler {
+namespace ffi {
+
+namespace {
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+/** C declaration of one parameter; views are a (pointer, length) pair */
+std::string cParameter(const FFIParameter& param) {
+    std::string constness = param.is_const ? "const " : "";
+    switch (param.passing) {
+        case FFIPassing::StringView:
+            return "const char* " + param.name + ", size_t " + param.name + "_len";
+        case FFIPassing::SliceView:
+            return constness + param.c_type + "* " + param.name + ", size_t " + param.name + "_len";
+        case FFIPassing::Handle:
+            // A class taken by value is copied from the handle, which stays untouched
+            if (!param.is_pointer && !param.is_reference) constness = "const ";
+            return constness + param.c_type + "* " + param.name;
+        default:
+            return param.c_type + " " + param.name;
+    }
+}
+
+/** The C++ argument a wrapper passes for a parameter */
+std::string cppArgument(const FFIParameter& param) {
+    const std::string& name = param.name;
+    switch (param.passing) {
+        case FFIPassing::StringView:
+            return param.view_type + "(" + name + ", " + name + "_len)";
+        case FFIPassing::SliceView:
+            // A std::vector parameter needs its own copy; a span borrows
+            if (startsWith(param.view_type, "std::vector")) {
+                return param.view_type + "(" + name + ", " + name + " + " + name + "_len)";
+            }
+            return param.view_type + "(" + name + ", " + name + "_len)";
+        case FFIPassing::Handle:
+            return param.is_pointer ? name : "*" + name;
+        case FFIPassing::Pointer:
+            return param.is_reference ? "*" + name : name;
+        default:
+            return name;
+    }
+}
+
+std::string cReturnType(const FFIFunction& func) {
+    if (func.is_constructor) return func.class_name + "*";
+    if (func.result.passing == FFIPassing::Handle) return func.result.c_type + "*";
+    return func.result.c_type;
+}
+
+/** Receiver parameter of a member function, or empty */
+std::string selfParameter(const FFIFunction& func) {
+    if (!func.is_method || func.is_static || func.is_constructor) return "";
+    return (func.is_const ? "const " : "") + func.class_name + "* self";
+}
+
+std::string cSignature(const FFIFunction& func) {
+    std::string params = selfParameter(func);
+    for (const auto& param : func.parameters) {
+        params += (params.empty() ? "" : ", ") + cParameter(param);
+    }
+    return cReturnType(func) + " " + func.c_name + "(" + (params.empty() ? "void" : params) + ")";
+}
+
+/** <c_name>_batch: one array per parameter, one for the results, and the count */
+std::string cBatchSignature(const FFIFunction& func) {
+    std::string params = selfParameter(func);
+    for (const auto& param : func.parameters) {
+        params += (params.empty() ? "const " : ", const ") + param.c_type + "* " + param.name;
+    }
+    if (func.result.c_type != "void") {
+        params += ", " + func.result.c_type + "* results";
+    }
+    return "void " + func.c_name + "_batch(" + params + ", size_t count)";
+}
+
+std::string cppCall(const FFIFunction& func, const std::vector<std::string>& args) {
+    std::string list;
+    for (const auto& arg : args) {
+        list += (list.empty() ? "" : ", ") + arg;
+    }
+    if (func.is_constructor) return "new " + func.class_name + "(" + list + ")";
+    if (func.is_static && func.is_method) return func.class_name + "::" + func.name + "(" + list + ")";
+    if (func.is_method) return "self->" + func.name + "(" + list + ")";
+    return func.name + "(" + list + ")";
+}
+
+std::string guardName(const std::string& library_name) {
+    std::string guard;
+    for (char c : library_name) {
+        guard += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+    }
+    return guard + "_FFI_H";
+}
+
+/** Every function of the bindings, classes first */
+std::vector<const FFIFunction*> allFunctions(const std::vector<FFIFunction>& functions,
+                                             const std::vector<FFIClass>& classes) {
+    std::vector<const FFIFunction*> all;
+    for (const auto& cls : classes) {
+        for (const auto* group : {&cls.constructors, &cls.methods, &cls.static_methods}) {
+            for (const auto& func : *group) all.push_back(&func);
+        }
+    }
+    for (const auto& func : functions) all.push_back(&func);
+    return all;
+}
+
+} // namespace
+
+std::string CWrapperGenerator::generateFunctionWrapper(const FFIFunction& func) {
+    if (!func.can_use_ffi) {
+        return "// " + func.name + " not exported: " + func.reason + "\n";
+    }
+
+    std::vector<std::string> args;
+    for (const auto& param : func.parameters) {
+        args.push_back(cppArgument(param));
+    }
+    std::string call = cppCall(func, args);
+
+    std::string out = "extern \"C\" " + cSignature(func) + " {\n";
+    if (func.result.passing == FFIPassing::Handle && !func.is_constructor) {
+        out += "    return new " + func.result.c_type + "(" + call + ");\n";
+    } else if (func.is_constructor || func.result.c_type != "void") {
+        out += "    return " + call + ";\n";
+    } else {
+        out += "    " + call + ";\n";
+    }
+    out += "}\n";
+
+    // The loop runs on this side, so a whole array costs one crossing
+    if (options_.batched && FFIAnalyzer::isBatchable(func)) {
+        std::vector<std::string> elements;
+        for (const auto& param : func.parameters) {
+            elements.push_back(param.name + "[i]");
+        }
+        out += "\nextern \"C\" " + cBatchSignature(func) + " {\n";
+        out += "    for (size_t i = 0; i < count; ++i) {\n";
+        out += "        " + std::string(func.result.c_type != "void" ? "results[i] = " : "") +
+               cppCall(func, elements) + ";\n";
+        out += "    }\n";
+        out += "}\n";
+    }
+    return out;
+}
+
+std::string CWrapperGenerator::generateClassWrapper(const FFIClass& cls) {
+    std::string out = "// " + cls.name + " behind an opaque handle\n";
+    if (cls.constructors.empty() && !cls.is_abstract) {
+        out += "extern \"C\" " + cls.name + "* " + cls.c_name + "_new(void) {\n";
+        out += "    return new " + cls.name + "();\n";
+        out += "}\n\n";
+    }
+    out += "extern \"C\" void " + cls.c_name + "_delete(" + cls.name + "* self) {\n";
+    out += "    delete self;\n";
+    out += "}\n";
+    for (const auto* group : {&cls.constructors, &cls.methods, &cls.static_methods}) {
+        for (const auto& func : *group) {
+            out += "\n" + generateFunctionWrapper(func);
+        }
+    }
+    return out;
+}
+
+std::string CWrapperGenerator::generateHeader(
+    const std::vector<FFIFunction>& functions,
+    const std::vector<FFIClass>& classes,
+    const std::string& library_name
+) {
+    std::string guard = guardName(library_name);
+    std::string out;
+    out += "/* Auto-generated C interface for " + library_name + " */\n";
+    out += "/* Generated by Hybrid Transpiler */\n\n";
+    out += "#ifndef " + guard + "\n#define " + guard + "\n\n";
+    out += "#include <stdbool.h>\n#include <stddef.h>\n#include <stdint.h>\n\n";
+    out += "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n";
+
+    for (const auto& cls : classes) {
+        out += "typedef struct " + cls.name + " " + cls.name + ";\n";
+    }
+    if (!classes.empty()) {
+        out += "\n";
+    }
+    for (const auto& cls : classes) {
+        if (cls.constructors.empty() && !cls.is_abstract) {
+            out += cls.name + "* " + cls.c_name + "_new(void);\n";
+        }
+        out += "void " + cls.c_name + "_delete(" + cls.name + "* self);\n";
+    }
+
+    for (const FFIFunction* func : allFunctions(functions, classes)) {
+        if (!func->can_use_ffi) continue;
+        out += cSignature(*func) + ";\n";
+        if (options_.batched && FFIAnalyzer::isBatchable(*func)) {
+            out += cBatchSignature(*func) + ";\n";
+        }
+    }
+
+    out += "\n#ifdef __cplusplus\n}\n#endif\n\n";
+    out += "#endif /* " + guard + " */\n";
+    return out;
+}
+
+std::string CWrapperGenerator::generateImplementation(
+    const std::vector<FFIFunction>& functions,
+    const std::vector<FFIClass>& classes,
+    const std::string& library_name
+) {
+    // Headers for the types the wrappers rebuild from views
+    bool span = false;
+    bool string = false;
+    bool string_view = false;
+    bool vector = false;
+    for (const FFIFunction* func : allFunctions(functions, classes)) {
+        for (const auto& param : func->parameters) {
+            span |= startsWith(param.view_type, "std::span");
+            string |= param.view_type == "std::string";
+            string_view |= param.view_type == "std::string_view";
+            vector |= startsWith(param.view_type, "std::vector");
+        }
+    }
+
+    std::string out;
+    out += "// Auto-generated C wrappers for " + library_name + "\n";
+    out += "// Generated by Hybrid Transpiler\n\n";
+    out += "#include \"" + library_name + ".h\"\n";
+    out += "#include \"" + library_name + "_ffi.h\"\n";
+    if (span) out += "#include <span>\n";
+    if (string) out += "#include <string>\n";
+    if (string_view) out += "#include <string_view>\n";
+    if (vector) out += "#include <vector>\n";
+
+    for (const auto& cls : classes) {
+        out += "\n" + generateClassWrapper(cls);
+    }
+    for (const auto& func : functions) {
+        out += "\n" + generateFunctionWrapper(func);
+    }
+    return out;
+}
+
+} // namespace ffi
+} // namespace hybrid_transpiler
@@ -4,17 +4,126 @@
  */
 
 #include "ffi.h"
+#include "parser.h"
 #include <algorithm>
-#include <regex>
+#include <cctype>
 
 namespace hybrid_transpiler {
 namespace ffi {
 
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+/** One space between words, none around punctuation: "const  int &" -> "const int&" */
+std::string normalizeType(const std::string& type) {
+    std::string result;
+    bool space = false;
+    for (char c : trim(type)) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = true;
+            continue;
+        }
+        bool word = std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        if (space && word && !result.empty() &&
+            (std::isalnum(static_cast<unsigned char>(result.back())) || result.back() == '_')) {
+            result += ' ';
+        }
+        result += c;
+        space = false;
+    }
+    return result;
+}
+
+/** The argument of a one-argument template spelled "prefix<T>", or empty */
+std::string templateArgument(const std::string& type, const std::string& prefix) {
+    if (!startsWith(type, prefix + "<") || type.back() != '>') return "";
+    return trim(type.substr(prefix.size() + 1, type.size() - prefix.size() - 2));
+}
+
+/** Split on commas outside (), <> and {} */
+std::vector<std::string> splitTopLevel(const std::string& text) {
+    std::vector<std::string> parts;
+    int depth = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '(' || c == '<' || c == '{' || c == '[') {
+            ++depth;
+        } else if (c == ')' || c == '>' || c == '}' || c == ']') {
+            --depth;
+        } else if (c == ',' && depth == 0) {
+            parts.push_back(trim(text.substr(start, i - start)));
+            start = i + 1;
+        }
+    }
+    std::string last = trim(text.substr(start));
+    if (!last.empty() || !parts.empty()) {
+        parts.push_back(last);
+    }
+    return parts;
+}
+
+/** Remove a leading keyword (and the space after it); returns whether it was there */
+bool takeKeyword(std::string& text, const std::string& keyword) {
+    if (!startsWith(text, keyword) ||
+        (text.size() > keyword.size() && (std::isalnum(static_cast<unsigned char>(text[keyword.size()])) ||
+                                          text[keyword.size()] == '_'))) {
+        return false;
+    }
+    text = trim(text.substr(keyword.size()));
+    return true;
+}
+
+/** Start of the identifier that ends text (text.size() if there is none) */
+size_t trailingIdentifier(const std::string& text) {
+    size_t start = text.size();
+    while (start > 0 && (std::isalnum(static_cast<unsigned char>(text[start - 1])) || text[start - 1] == '_')) {
+        --start;
+    }
+    return start;
+}
+
+/** getValue -> get_value, HTTPServer -> httpserver */
+std::string snakeCase(const std::string& name) {
+    std::string result;
+    for (size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        if (std::isupper(static_cast<unsigned char>(c)) && i > 0 &&
+            std::islower(static_cast<unsigned char>(name[i - 1]))) {
+            result += '_';
+        }
+        result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+/** Spelling of an IR type as it was written (the parser keeps const as a flag) */
+std::string spelling(const std::shared_ptr<hybrid::Type>& type) {
+    if (!type) return "void";
+    return (type->is_const ? "const " : "") + (type->name.empty() ? "void" : type->name);
+}
+
+} // namespace
+
+FFIAnalyzer::FFIAnalyzer() {
+    initializeTypeMappings();
+}
+
 void FFIAnalyzer::initializeTypeMappings() {
     // C++ to C type mappings
     cpp_to_c_types_ = {
         {"void", "void"},
-        {"bool", "_Bool"},
+        {"bool", "bool"},
         {"char", "char"},
         {"unsigned char", "unsigned char"},
         {"short", "short"},
@@ -101,29 +210,104 @@ void FFIAnalyzer::initializeTypeMappings() {
 
 FFIFunction FFIAnalyzer::analyzeFunction(const std::string& function_decl) {
     FFIFunction func;
-    func.can_use_ffi = true;
 
-    // Simple parsing - in real implementation would use Clang AST
-    // This is a placeholder that demonstrates the concept
+    // Declaration up to the end of the parameter list, and what follows it
+    size_t open = function_decl.find('(');
+    size_t close = std::string::npos;
+    int depth = 0;
+    for (size_t i = open; open != std::string::npos && i < function_decl.size(); ++i) {
+        if (function_decl[i] == '(') ++depth;
+        if (function_decl[i] == ')' && --depth == 0) {
+            close = i;
+            break;
+        }
+    }
+    if (close == std::string::npos) {
+        func.reason = "Not a function declaration";
+        return func;
+    }
+    std::string head = normalizeType(function_decl.substr(0, open));
+    std::string tail = function_decl.substr(close + 1);
+    tail = tail.substr(0, std::min({tail.find('{'), tail.find(';'), tail.find(':'), tail.size()}));
+
+    // The name, without a class qualifier (Counter::hit), ends the head
+    size_t name_start = trailingIdentifier(head);
+    func.name = head.substr(name_start);
+    std::string prefix = head.substr(0, name_start);
+    while (prefix.size() >= 2 && prefix.compare(prefix.size() - 2, 2, "::") == 0) {
+        prefix = prefix.substr(0, trailingIdentifier(prefix.substr(0, prefix.size() - 2)));
+    }
+    prefix = trim(prefix);
+
+    bool is_template = false;
+    for (bool found = true; found;) {
+        found = takeKeyword(prefix, "extern \"C\"") || takeKeyword(prefix, "inline") ||
+                takeKeyword(prefix, "constexpr") || takeKeyword(prefix, "explicit") ||
+                takeKeyword(prefix, "[[nodiscard]]");
+        if (takeKeyword(prefix, "static")) {
+            func.is_static = found = true;
+        }
+        if (takeKeyword(prefix, "virtual")) {
+            func.is_virtual = found = true;
+        }
+        if (startsWith(prefix, "template")) {
+            is_template = true;
+            size_t end = prefix.find('>');
+            prefix = end == std::string::npos ? "" : trim(prefix.substr(end + 1));
+            found = true;
+        }
+    }
+    func.return_type = prefix.empty() ? "void" : prefix;
+    func.is_constructor = prefix.empty();
+    func.is_const = tail.find("const") != std::string::npos;
+
+    for (const auto& part : splitTopLevel(function_decl.substr(open + 1, close - open - 1))) {
+        if (part == "void" && func.parameters.empty()) continue;
+        std::string param = part.substr(0, part.find('='));
+        param = normalizeType(param);
 
-    // Check for exceptions
+        // The trailing identifier is the name unless it is part of the type ("unsigned int")
+        static const char* const kTypeWords[] = {"int", "char", "short", "long", "float", "double", "bool"};
+        size_t split = trailingIdentifier(param);
+        std::string name = param.substr(split);
+        std::string type = trim(param.substr(0, split));
+        if (name.empty() || type.empty() || type == "const" || type == "unsigned" || type == "signed" ||
+            std::find(std::begin(kTypeWords), std::end(kTypeWords), name) != std::end(kTypeWords)) {
+            name.clear();
+            type = param;
+        }
+        if (name.empty()) {
+            name = "arg" + std::to_string(func.parameters.size());
+        }
+        func.parameters.push_back(analyzeParameter(type, name));
+    }
+    func.result = analyzeParameter(func.return_type, "");
+    func.c_name = symbol_prefix_ + func.name;
+
+    // Exceptions cannot unwind through the C ABI
+    func.can_use_ffi = true;
     if (function_decl.find("throw") != std::string::npos) {
         func.can_use_ffi = false;
         func.reason = "Function may throw exceptions (not compatible with C ABI)";
-    }
-
-    // Check for templates
-    if (function_decl.find("template") != std::string::npos) {
+    } else if (is_template) {
         func.can_use_ffi = false;
         func.reason = "Template functions require monomorphization";
-    }
-
-    // Check for non-POD types in signature
-    if (function_decl.find("std::") != std::string::npos) {
+    } else if (func.result.c_type.empty() ||
+               (func.result.passing != FFIPassing::Value && func.result.passing != FFIPassing::Pointer &&
+                (func.result.passing != FFIPassing::Handle || func.result.is_pointer || func.result.is_reference))) {
         func.can_use_ffi = false;
-        func.reason = "Uses C++ standard library types (not C ABI compatible)";
+        func.reason = "Return type " + func.return_type +
+                      " cannot cross the C ABI (return scalars, pointers or classes by value)";
+    } else {
+        for (const auto& param : func.parameters) {
+            if (param.c_type.empty()) {
+                func.can_use_ffi = false;
+                func.reason = "Parameter '" + param.name + "' of type " + param.cpp_type +
+                              " cannot cross the C ABI";
+                break;
+            }
+        }
     }
-
     return func;
 }
 
@@ -135,9 +319,161 @@ FFIClass FFIAnalyzer::analyzeClass(const std::string& class_decl) {
     cls.is_polymorphic = cls.has_virtual_functions;
     cls.is_abstract = (class_decl.find("= 0") != std::string::npos);
 
+    hybrid::IR ir = hybrid::Parser::parseString(class_decl);
+    if (ir.getClasses().empty()) {
+        return cls;
+    }
+    const hybrid::ClassDecl& decl = ir.getClasses()[0];
+    cls.name = decl.name;
+    cls.c_name = symbol_prefix_ + snakeCase(decl.name);
+    if (std::find(classes_.begin(), classes_.end(), cls.name) == classes_.end()) {
+        classes_.push_back(cls.name);
+    }
+
+    auto isPublic = [&](const std::string& name) {
+        for (const auto& section : decl.access_sections) {
+            if (std::find(section.members.begin(), section.members.end(), name) != section.members.end()) {
+                return section.level == hybrid::ClassDecl::AccessSection::Public;
+            }
+        }
+        return decl.is_struct;
+    };
+
+    std::vector<std::string> symbols;
+    for (const auto& method : decl.methods) {
+        if (method.is_destructor || !isPublic(method.name) || startsWith(method.name, "operator")) continue;
+
+        std::string signature = (method.is_static ? "static " : "") +
+                                (method.is_constructor ? "" : spelling(method.return_type) + " ") + method.name + "(";
+        for (size_t i = 0; i < method.parameters.size(); ++i) {
+            signature += (i ? ", " : "") + spelling(method.parameters[i].type) + " " + method.parameters[i].name;
+        }
+        signature += method.is_const ? ") const" : ")";
+        signature += " {" + std::string(method.body.view()) + "}";     // Checked for throw
+        if (method.is_template) {
+            signature = "template<> " + signature;
+        }
+
+        FFIFunction func = analyzeFunction(signature);
+        func.is_method = true;
+        func.is_constructor = method.is_constructor;
+        func.is_virtual = method.is_virtual;
+        func.class_name = decl.name;
+
+        // Overloads get numbered symbols
+        std::string symbol = cls.c_name + "_" + (method.is_constructor ? "new" : snakeCase(method.name));
+        symbols.push_back(symbol);
+        size_t overload = std::count(symbols.begin(), symbols.end(), symbol);
+        func.c_name = overload > 1 ? symbol + "_" + std::to_string(overload) : symbol;
+
+        if (method.is_constructor) {
+            cls.constructors.push_back(std::move(func));
+        } else if (method.is_static) {
+            cls.static_methods.push_back(std::move(func));
+        } else {
+            cls.methods.push_back(std::move(func));
+        }
+    }
     return cls;
 }
 
+FFIParameter FFIAnalyzer::analyzeParameter(const std::string& cpp_type, const std::string& name) {
+    FFIParameter param;
+    param.name = name;
+    param.cpp_type = normalizeType(cpp_type);
+
+    std::string type = param.cpp_type;
+    param.is_const = takeKeyword(type, "const");
+    if (!type.empty() && type.back() == '&') {
+        param.is_reference = true;
+        type = trim(type.substr(0, type.size() - 1));
+        if (!type.empty() && type.back() == '&') {
+            return param;   // Rvalue references cannot cross
+        }
+    }
+    param.is_pointer = !type.empty() && type.back() == '*';
+    std::string base = param.is_pointer ? trim(type.substr(0, type.size() - 1)) : type;
+
+    // Strings and contiguous containers: borrowed views into the caller's memory
+    bool read_only = param.is_const || !param.is_reference;
+    if (!param.is_pointer && read_only && (type == "std::string_view" || type == "std::string")) {
+        param.passing = FFIPassing::StringView;
+        param.is_const = true;
+        param.c_type = "char";
+        param.rust_type = "u8";
+        param.go_type = "string";
+        param.view_type = type;
+        return param;
+    }
+    std::string span = templateArgument(type, "std::span");
+    std::string vector = templateArgument(type, "std::vector");
+    if (!param.is_pointer && (!span.empty() || (!vector.empty() && read_only))) {
+        std::string element = span.empty() ? vector : span;
+        bool mutable_view = !span.empty() && !takeKeyword(element, "const");
+        auto c_type = cpp_to_c_types_.find(element);
+        if (c_type == cpp_to_c_types_.end() || element == "void" || element.back() == '*') {
+            return param;
+        }
+        param.passing = FFIPassing::SliceView;
+        param.is_const = !mutable_view;
+        param.c_type = c_type->second;
+        param.rust_type = cpp_to_rust_types_[element];
+        param.go_type = cpp_to_go_types_[element];
+        param.view_type = span.empty() ? "std::vector<" + element + ">"
+                                       : "std::span<" + std::string(mutable_view ? "" : "const ") + element + ">";
+        return param;
+    }
+
+    // Objects of analyzed classes stay on the C++ side behind an opaque pointer
+    if (std::find(classes_.begin(), classes_.end(), base) != classes_.end()) {
+        param.passing = FFIPassing::Handle;
+        param.c_type = base;
+        param.rust_type = base;
+        param.go_type = base;
+        return param;
+    }
+
+    // Scalars by value; pointers and references to them as pointers
+    if (!param.is_pointer && !param.is_reference) {
+        auto c_type = cpp_to_c_types_.find(type);
+        if (c_type != cpp_to_c_types_.end()) {
+            param.is_const = false;     // A by-value const is the callee's business
+            param.c_type = c_type->second;
+            param.rust_type = cpp_to_rust_types_[type];
+            param.go_type = cpp_to_go_types_[type];
+        }
+        return param;
+    }
+    std::string qualified = (param.is_const ? "const " : "") + base + "*";
+    if (cpp_to_c_types_.count(qualified)) {
+        param.passing = FFIPassing::Pointer;
+        param.c_type = cpp_to_c_types_[qualified];
+        param.rust_type = cpp_to_rust_types_[qualified];
+        param.go_type = cpp_to_go_types_[qualified];
+    } else if (cpp_to_c_types_.count(base) && base != "void") {
+        param.passing = FFIPassing::Pointer;
+        param.c_type = (param.is_const ? "const " : "") + cpp_to_c_types_[base] + "*";
+        param.rust_type = (param.is_const ? "*const " : "*mut ") + cpp_to_rust_types_[base];
+        param.go_type = "*" + cpp_to_go_types_[base];
+    } else if (base == "void") {
+        param.passing = FFIPassing::Pointer;
+        param.c_type = param.is_const ? "const void*" : "void*";
+        param.rust_type = param.is_const ? "*const std::ffi::c_void" : "*mut std::ffi::c_void";
+        param.go_type = "unsafe.Pointer";
+    }
+    return param;
+}
+
+bool FFIAnalyzer::isBatchable(const FFIFunction& func) {
+    if (!func.can_use_ffi || func.is_constructor || func.parameters.empty() ||
+        func.result.passing != FFIPassing::Value) {
+        return false;
+    }
+    return std::all_of(func.parameters.begin(), func.parameters.end(), [](const FFIParameter& param) {
+        return param.passing == FFIPassing::Value;
+    });
+}
+
 bool FFIAnalyzer::isFFICompatible(const std::string& cpp_type) {
     // Remove const, volatile, etc.
     std::string clean_type = cpp_type;
@@ -0,0 +1,263 @@
+/**
+ * @file go_ffi_gen.cpp
+ * @brief Go bindings over the C wrappers (cgo)
+ */
+
+#include "ffi.h"
+#include <algorithm>
+#include <cctype>
+
+namespace hybrid_transpiler {
+namespace ffi {
+
+namespace {
+
+/** get_value, getValue -> GetValue */
+std::string exportedName(const std::string& name) {
+    std::string result;
+    bool upper = true;
+    for (char c : name) {
+        if (c == '_') {
+            upper = true;
+            continue;
+        }
+        result += upper ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+        upper = false;
+    }
+    return result;
+}
+
+std::string localName(const std::string& name) {
+    static const char* const kKeywords[] = {
+        "break", "case", "chan", "const", "continue", "default", "defer", "else", "fallthrough", "for",
+        "func", "go", "goto", "if", "import", "interface", "map", "package", "range", "return", "select",
+        "struct", "switch", "type", "var"
+    };
+    bool keyword = std::find(std::begin(kKeywords), std::end(kKeywords), name) != std::end(kKeywords);
+    return keyword ? name + "_" : name;
+}
+
+/** cgo spelling of a C scalar type */
+std::string cgoType(std::string c_type) {
+    if (c_type.compare(0, 6, "const ") == 0) c_type = c_type.substr(6);
+    static const char* const kNames[][2] = {
+        {"signed char", "C.schar"}, {"unsigned char", "C.uchar"}, {"unsigned short", "C.ushort"},
+        {"unsigned int", "C.uint"}, {"unsigned long", "C.ulong"}, {"long long", "C.longlong"},
+        {"unsigned long long", "C.ulonglong"}, {"void", "unsafe.Pointer"}
+    };
+    for (const auto& name : kNames) {
+        if (c_type == name[0]) return name[1];
+    }
+    return "C." + c_type;
+}
+
+/** Go pointer to memory the caller owns, reinterpreted for C */
+std::string cPointer(const std::string& c_element, const std::string& pointer) {
+    return "(*" + cgoType(c_element) + ")(unsafe.Pointer(" + pointer + "))";
+}
+
+std::string snakeCase(const std::string& name) {
+    std::string result;
+    for (size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        if (std::isupper(static_cast<unsigned char>(c)) && i > 0 &&
+            std::islower(static_cast<unsigned char>(name[i - 1]))) {
+            result += '_';
+        }
+        result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+/** Overload number carried by a member's symbol ("_2" -> "2"), or empty */
+std::string overloadSuffix(const FFIFunction& func) {
+    std::string symbol = "_" + (func.is_constructor ? std::string("new") : snakeCase(func.name));
+    size_t pos = func.c_name.rfind(symbol);
+    return pos == std::string::npos ? "" : exportedName(func.c_name.substr(pos + symbol.size()));
+}
+
+std::string receiverName(const FFIFunction& func) {
+    std::string name(1, static_cast<char>(std::tolower(static_cast<unsigned char>(func.class_name[0]))));
+    for (const auto& param : func.parameters) {
+        if (param.name == name) return "this";
+    }
+    return name;
+}
+
+bool returnsValue(const FFIFunction& func) {
+    return !func.result.go_type.empty() && func.result.c_type != "void";
+}
+
+} // namespace
+
+std::string GoFFIGenerator::generateFunctionBinding(const FFIFunction& func) {
+    if (!func.can_use_ffi) {
+        return "// " + func.name + " not exported: " + func.reason + "\n";
+    }
+
+    std::string receiver = func.is_method && !func.is_static && !func.is_constructor ? receiverName(func) : "";
+    std::string params;
+    std::string args = receiver.empty() ? "" : receiver + ".ptr";
+    auto param = [&](const std::string& text) { params += (params.empty() ? "" : ", ") + text; };
+    auto arg = [&](const std::string& text) { args += (args.empty() ? "" : ", ") + text; };
+    for (const auto& p : func.parameters) {
+        std::string name = localName(p.name);
+        switch (p.passing) {
+            case FFIPassing::StringView:
+                // Borrowed for the call: C must not keep or modify it
+                param(name + " string");
+                arg(cPointer("char", "unsafe.StringData(" + name + ")") + ", C.size_t(len(" + name + "))");
+                break;
+            case FFIPassing::SliceView:
+                param(name + " []" + p.go_type);
+                arg(cPointer(p.c_type, "unsafe.SliceData(" + name + ")") + ", C.size_t(len(" + name + "))");
+                break;
+            case FFIPassing::Handle:
+                param(name + " *" + p.c_type);
+                arg(name + ".ptr");
+                break;
+            case FFIPassing::Pointer: {
+                param(name + " " + p.go_type);
+                bool cgo = p.go_type.compare(0, 3, "*C.") == 0 || p.go_type == "unsafe.Pointer";
+                arg(cgo ? name : cPointer(p.c_type.substr(0, p.c_type.size() - 1), name));
+                break;
+            }
+            default:
+                param(name + " " + p.go_type);
+                arg(p.go_type == cgoType(p.c_type) ? name : cgoType(p.c_type) + "(" + name + ")");
+                break;
+        }
+    }
+
+    std::string call = "C." + func.c_name + "(" + args + ")";
+    std::string result;
+    std::string body;
+    if (func.is_constructor) {
+        result = " *" + func.class_name;
+        body = "return &" + func.class_name + "{ptr: " + call + "}";
+    } else if (func.result.passing == FFIPassing::Handle) {
+        result = " *" + func.result.c_type;
+        body = "return &" + func.result.c_type + "{ptr: " + call + "}";
+    } else if (func.result.passing == FFIPassing::Pointer) {
+        result = " " + func.result.go_type;
+        bool cgo = func.result.go_type.compare(0, 3, "*C.") == 0 || func.result.go_type == "unsafe.Pointer";
+        body = "return " + (cgo ? call : "(" + func.result.go_type + ")(unsafe.Pointer(" + call + "))");
+    } else if (returnsValue(func)) {
+        result = " " + func.result.go_type;
+        body = "return " + (func.result.go_type == cgoType(func.result.c_type) ? call : func.result.go_type + "(" + call + ")");
+    } else {
+        body = call;
+    }
+
+    std::string name;
+    std::string head = "func ";
+    if (func.is_constructor) {
+        name = "New" + func.class_name + overloadSuffix(func);
+    } else if (func.is_method && !func.is_static) {
+        name = exportedName(func.name) + overloadSuffix(func);
+        head += "(" + receiver + " *" + func.class_name + ") ";
+    } else {
+        name = (func.is_method ? func.class_name : "") + exportedName(func.name) + (func.is_method ? overloadSuffix(func) : "");
+    }
+
+    std::string out = "// " + name + " calls " + (func.is_method ? func.class_name + "::" : "") + func.name + "\n";
+    out += head + name + "(" + params + ")" + result + " {\n\t" + body + "\n}\n";
+
+    // Slices in, one cgo crossing for all of them
+    if (options_.batched && FFIAnalyzer::isBatchable(func)) {
+        std::string batch_params;
+        std::string batch_args = receiver.empty() ? "" : receiver + ".ptr";
+        std::string count = returnsValue(func) ? "results" : localName(func.parameters[0].name);
+        std::string check;
+        for (const auto& p : func.parameters) {
+            std::string pname = localName(p.name);
+            batch_params += (batch_params.empty() ? "" : ", ") + pname + " []" + p.go_type;
+            batch_args += (batch_args.empty() ? "" : ", ") + cPointer(p.c_type, "unsafe.SliceData(" + pname + ")");
+            if (pname != count) {
+                check += (check.empty() ? "" : " || ") + std::string("len(") + pname + ") != len(" + count + ")";
+            }
+        }
+        if (returnsValue(func)) {
+            batch_params += ", results []" + func.result.go_type;
+            batch_args += ", " + cPointer(func.result.c_type, "unsafe.SliceData(results)");
+        }
+        out += "\n// " + name + "Batch calls " + name + " once per element in a single cgo call\n";
+        out += head + name + "Batch(" + batch_params + ") {\n";
+        if (!check.empty()) {
+            out += "\tif " + check + " {\n\t\tpanic(\"" + name + "Batch: argument lengths differ\")\n\t}\n";
+        }
+        out += "\tC." + func.c_name + "_batch(" + batch_args + ", C.size_t(len(" + count + ")))\n";
+        out += "}\n";
+    }
+    return out;
+}
+
+std::string GoFFIGenerator::generateWrapper(const FFIFunction& func) {
+    return generateFunctionBinding(func);
+}
+
+std::string GoFFIGenerator::generateClassBinding(const FFIClass& cls) {
+    std::string receiver(1, static_cast<char>(std::tolower(static_cast<unsigned char>(cls.name[0]))));
+    std::string out;
+    out += "// " + cls.name + " wraps a C++ " + cls.name + " behind its handle\n";
+    out += "type " + cls.name + " struct {\n\tptr *C." + cls.name + "\n}\n";
+    if (cls.constructors.empty() && !cls.is_abstract) {
+        out += "\n// New" + cls.name + " default-constructs a " + cls.name + "\n";
+        out += "func New" + cls.name + "() *" + cls.name + " {\n";
+        out += "\treturn &" + cls.name + "{ptr: C." + cls.c_name + "_new()}\n";
+        out += "}\n";
+    }
+    out += "\n// Delete frees the C++ object (call it explicitly or with defer)\n";
+    out += "func (" + receiver + " *" + cls.name + ") Delete() {\n";
+    out += "\tif " + receiver + ".ptr != nil {\n";
+    out += "\t\tC." + cls.c_name + "_delete(" + receiver + ".ptr)\n";
+    out += "\t\t" + receiver + ".ptr = nil\n";
+    out += "\t}\n";
+    out += "}\n";
+    for (const auto* group : {&cls.constructors, &cls.methods, &cls.static_methods}) {
+        for (const auto& func : *group) {
+            if (func.can_use_ffi) {
+                out += "\n" + generateFunctionBinding(func);
+            }
+        }
+    }
+    return out;
+}
+
+std::string GoFFIGenerator::generatePackage(
+    const std::vector<FFIFunction>& functions,
+    const std::vector<FFIClass>& classes,
+    const std::string& library_name
+) {
+    std::string package;
+    for (char c : library_name) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            package += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+
+    std::string out;
+    out += "// Auto-generated Go bindings for " + library_name + " (cgo)\n";
+    out += "// Generated by Hybrid Transpiler\n\n";
+    out += "package " + package + "\n\n";
+    out += "/*\n";
+    out += "#cgo LDFLAGS: -l" + library_name + " -lstdc++\n";
+    out += "#include \"" + library_name + "_ffi.h\"\n";
+    out += "*/\n";
+    out += "import \"C\"\n\n";
+
+    std::string body;
+    for (const auto& cls : classes) {
+        body += "\n" + generateClassBinding(cls);
+    }
+    for (const auto& func : functions) {
+        body += "\n" + generateFunctionBinding(func);
+    }
+    if (body.find("unsafe.") != std::string::npos) {
+        out += "import \"unsafe\"\n";
+    }
+    return out + body;
+}
+
+} // namespace ffi
+} // namespace hybrid_transpiler
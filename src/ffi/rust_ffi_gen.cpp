@@ -0,0 +1,287 @@
+/**
+ * @file rust_ffi_gen.cpp
+ * @brief Rust bindings: extern "C" declarations in a sys module, safe wrappers outside it
+ */
+
+#include "ffi.h"
+#include <cctype>
+
+namespace hybrid_transpiler {
+namespace ffi {
+
+namespace {
+
+std::string snakeCase(const std::string& name) {
+    std::string result;
+    for (size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        if (std::isupper(static_cast<unsigned char>(c)) && i > 0 &&
+            std::islower(static_cast<unsigned char>(name[i - 1]))) {
+            result += '_';
+        }
+        result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+std::string indentLines(const std::string& text, const std::string& indent) {
+    std::string out;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        end = end == std::string::npos ? text.size() : end + 1;
+        if (end - start > 1) out += indent;
+        out.append(text, start, end - start);
+        start = end;
+    }
+    return out;
+}
+
+/** Name of the safe wrapper, numbered like the symbol for overloads */
+std::string wrapperName(const FFIFunction& func) {
+    std::string base = func.is_constructor ? "new" : snakeCase(func.name);
+    size_t pos = func.is_method ? func.c_name.rfind("_" + base) : std::string::npos;
+    return pos == std::string::npos ? base : func.c_name.substr(pos + 1);
+}
+
+std::string rawHandle(const std::string& class_name, bool is_const) {
+    return std::string(is_const ? "*const " : "*mut ") + "sys::" + class_name + "Raw";
+}
+
+bool handleIsConst(const FFIParameter& param) {
+    return param.is_const || (!param.is_pointer && !param.is_reference);
+}
+
+/** extern parameter list, with sys:: stripped inside the sys module */
+std::string externParameters(const FFIFunction& func) {
+    std::string params;
+    auto add = [&](const std::string& param) { params += (params.empty() ? "" : ", ") + param; };
+    if (func.is_method && !func.is_static && !func.is_constructor) {
+        add("this: " + rawHandle(func.class_name, func.is_const));
+    }
+    for (const auto& param : func.parameters) {
+        std::string name = snakeCase(param.name);
+        switch (param.passing) {
+            case FFIPassing::StringView:
+                add(name + ": *const u8, " + name + "_len: usize");
+                break;
+            case FFIPassing::SliceView:
+                add(name + ": " + (param.is_const ? "*const " : "*mut ") + param.rust_type + ", " + name + "_len: usize");
+                break;
+            case FFIPassing::Handle:
+                add(name + ": " + rawHandle(param.c_type, handleIsConst(param)));
+                break;
+            default:
+                add(name + ": " + param.rust_type);
+                break;
+        }
+    }
+    return params;
+}
+
+std::string externReturn(const FFIFunction& func) {
+    if (func.is_constructor) return " -> " + rawHandle(func.class_name, false);
+    if (func.result.passing == FFIPassing::Handle) return " -> " + rawHandle(func.result.c_type, false);
+    if (func.result.rust_type.empty() || func.result.rust_type == "()") return "";
+    return " -> " + func.result.rust_type;
+}
+
+std::string stripSys(std::string text) {
+    for (size_t pos; (pos = text.find("sys::")) != std::string::npos;) {
+        text.erase(pos, 5);
+    }
+    return text;
+}
+
+bool returnsValue(const FFIFunction& func) {
+    return !func.result.rust_type.empty() && func.result.rust_type != "()";
+}
+
+} // namespace
+
+std::string RustFFIGenerator::generateFunctionBinding(const FFIFunction& func) {
+    if (!func.can_use_ffi) {
+        return "// " + func.name + " not exported: " + func.reason + "\n";
+    }
+    std::string out = stripSys("pub fn " + func.c_name + "(" + externParameters(func) + ")" + externReturn(func) + ";\n");
+    if (options_.batched && FFIAnalyzer::isBatchable(func)) {
+        std::string params = func.is_method && !func.is_static ? "this: " + rawHandle(func.class_name, func.is_const) : "";
+        for (const auto& param : func.parameters) {
+            params += (params.empty() ? "" : ", ") + snakeCase(param.name) + ": *const " + param.rust_type;
+        }
+        if (returnsValue(func)) {
+            params += ", results: *mut " + func.result.rust_type;
+        }
+        out += stripSys("pub fn " + func.c_name + "_batch(" + params + ", count: usize);\n");
+    }
+    return out;
+}
+
+std::string RustFFIGenerator::generateSafeWrapper(const FFIFunction& func) {
+    if (!func.can_use_ffi) return "";
+
+    // Raw pointers in the signature leave their validity to the caller
+    bool is_unsafe = func.result.passing == FFIPassing::Pointer;
+    std::string params;
+    std::string args;
+    auto param = [&](const std::string& text) { params += (params.empty() ? "" : ", ") + text; };
+    auto arg = [&](const std::string& text) { args += (args.empty() ? "" : ", ") + text; };
+    if (func.is_method && !func.is_static && !func.is_constructor) {
+        param(func.is_const ? "&self" : "&mut self");
+        arg("self.ptr");
+    }
+    for (const auto& p : func.parameters) {
+        std::string name = snakeCase(p.name);
+        switch (p.passing) {
+            case FFIPassing::StringView:
+                param(name + ": &str");
+                arg(name + ".as_ptr(), " + name + ".len()");
+                break;
+            case FFIPassing::SliceView:
+                param(name + ": " + (p.is_const ? "&[" : "&mut [") + p.rust_type + "]");
+                arg(name + (p.is_const ? ".as_ptr(), " : ".as_mut_ptr(), ") + name + ".len()");
+                break;
+            case FFIPassing::Handle:
+                param(name + ": " + (handleIsConst(p) ? "&" : "&mut ") + p.c_type);
+                arg(name + ".ptr");
+                break;
+            case FFIPassing::Pointer:
+                is_unsafe = true;
+                param(name + ": " + p.rust_type);
+                arg(name);
+                break;
+            default:
+                param(name + ": " + p.rust_type);
+                arg(name);
+                break;
+        }
+    }
+
+    std::string call = "sys::" + func.c_name + "(" + args + ")";
+    std::string result;
+    std::string body;
+    if (func.is_constructor) {
+        result = " -> Self";
+        body = func.class_name + " { ptr: unsafe { " + call + " } }";
+    } else if (func.result.passing == FFIPassing::Handle) {
+        result = " -> " + func.result.c_type;
+        body = func.result.c_type + " { ptr: unsafe { " + call + " } }";
+    } else {
+        result = returnsValue(func) ? " -> " + func.result.rust_type : "";
+        body = "unsafe { " + call + " }";
+    }
+
+    std::string name = wrapperName(func);
+    std::string out = std::string("pub ") + (is_unsafe ? "unsafe " : "") + "fn " + name + "(" + params + ")" +
+                      result + " {\n    " + body + "\n}\n";
+
+    // Slices in, one crossing for all of them
+    if (options_.batched && FFIAnalyzer::isBatchable(func)) {
+        std::string batch_params = func.is_method && !func.is_static ? (func.is_const ? "&self" : "&mut self") : "";
+        std::string batch_args = func.is_method && !func.is_static ? "self.ptr" : "";
+        std::string count = returnsValue(func) ? "results.len()" : snakeCase(func.parameters[0].name) + ".len()";
+        std::string check;
+        for (const auto& p : func.parameters) {
+            std::string pname = snakeCase(p.name);
+            batch_params += (batch_params.empty() ? "" : ", ") + pname + ": &[" + p.rust_type + "]";
+            batch_args += (batch_args.empty() ? "" : ", ") + pname + ".as_ptr()";
+            if (pname + ".len()" != count) {
+                check += (check.empty() ? "" : " && ") + pname + ".len() == " + count;
+            }
+        }
+        if (returnsValue(func)) {
+            batch_params += ", results: &mut [" + func.result.rust_type + "]";
+            batch_args += ", results.as_mut_ptr()";
+        }
+        out += "\npub fn " + name + "_batch(" + batch_params + ") {\n";
+        if (!check.empty()) {
+            out += "    assert!(" + check + ", \"" + name + "_batch: argument lengths differ\");\n";
+        }
+        out += "    unsafe { sys::" + func.c_name + "_batch(" + batch_args + ", " + count + ") }\n";
+        out += "}\n";
+    }
+    return out;
+}
+
+std::string RustFFIGenerator::generateClassBinding(const FFIClass& cls) {
+    std::string out;
+    out += "/// Owns a C++ " + cls.name + " through its handle\n";
+    out += "pub struct " + cls.name + " {\n";
+    out += "    ptr: *mut sys::" + cls.name + "Raw,\n";
+    out += "}\n\n";
+
+    out += "impl " + cls.name + " {\n";
+    std::string methods;
+    if (cls.constructors.empty() && !cls.is_abstract) {
+        methods += "pub fn new() -> Self {\n    " + cls.name + " { ptr: unsafe { sys::" + cls.c_name + "_new() } }\n}\n";
+    }
+    for (const auto* group : {&cls.constructors, &cls.methods, &cls.static_methods}) {
+        for (const auto& func : *group) {
+            std::string wrapper = generateSafeWrapper(func);
+            if (wrapper.empty()) continue;
+            methods += (methods.empty() ? "" : "\n") + wrapper;
+        }
+    }
+    out += indentLines(methods, "    ");
+    out += "}\n\n";
+
+    out += "impl Drop for " + cls.name + " {\n";
+    out += "    fn drop(&mut self) {\n";
+    out += "        unsafe { sys::" + cls.c_name + "_delete(self.ptr) }\n";
+    out += "    }\n";
+    out += "}\n";
+    return out;
+}
+
+std::string RustFFIGenerator::generateModule(
+    const std::vector<FFIFunction>& functions,
+    const std::vector<FFIClass>& classes,
+    const std::string& library_name
+) {
+    std::string out;
+    out += "// Auto-generated Rust FFI bindings for " + library_name + "\n";
+    out += "// Generated by Hybrid Transpiler\n\n";
+
+    // Raw declarations live in sys; everything outside it is safe to call
+    out += "mod sys {\n";
+    for (const auto& cls : classes) {
+        out += "    #[repr(C)]\n";
+        out += "    pub struct " + cls.name + "Raw {\n";
+        out += "        _private: [u8; 0],\n";
+        out += "    }\n\n";
+    }
+    out += "    #[link(name = \"" + library_name + "\")]\n";
+    out += "    extern \"C\" {\n";
+    std::string externs;
+    for (const auto& cls : classes) {
+        if (cls.constructors.empty() && !cls.is_abstract) {
+            externs += "pub fn " + cls.c_name + "_new() -> *mut " + cls.name + "Raw;\n";
+        }
+        externs += "pub fn " + cls.c_name + "_delete(this: *mut " + cls.name + "Raw);\n";
+        for (const auto* group : {&cls.constructors, &cls.methods, &cls.static_methods}) {
+            for (const auto& func : *group) {
+                externs += generateFunctionBinding(func);
+            }
+        }
+    }
+    for (const auto& func : functions) {
+        externs += generateFunctionBinding(func);
+    }
+    out += indentLines(externs, "        ");
+    out += "    }\n";
+    out += "}\n";
+
+    for (const auto& cls : classes) {
+        out += "\n" + generateClassBinding(cls);
+    }
+    for (const auto& func : functions) {
+        std::string wrapper = generateSafeWrapper(func);
+        if (!wrapper.empty()) {
+            out += "\n" + wrapper;
+        }
+    }
+    return out;
+}
+
+} // namespace ffi
+} // namespace hybrid_transpiler
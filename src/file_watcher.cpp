@@ -0,0 +1,198 @@
+#include "file_watcher.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace hybrid {
+
+namespace fs = std::filesystem;
+
+FileWatcher::FileWatcher() {
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool FileWatcher::isNative() const {
+    return fd_ >= 0;
+}
+
+bool FileWatcher::watchDirectory(const std::string& dir, bool recursive, std::string& error) {
+    std::error_code ec;
+    fs::path normal = fs::weakly_canonical(dir, ec);
+    if (ec) {
+        normal = fs::path(dir).lexically_normal();
+    }
+    std::string path = normal.string();
+
+    if (!fs::is_directory(normal, ec)) {
+        error = "Not a directory: " + dir;
+        return false;
+    }
+
+    auto existing = watched_.find(path);
+    if (existing != watched_.end()) {
+        Directory& known = directories_[existing->second];
+        if (!recursive || known.recursive) {
+            return true;
+        }
+        known.recursive = true;     // Now also wanted recursively: add its subdirectories
+    } else {
+        int key = next_key_++;
+#ifdef __linux__
+        if (fd_ >= 0) {
+            key = inotify_add_watch(fd_, path.c_str(),
+                                    IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE |
+                                    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR);
+            if (key < 0) {
+                error = "Cannot watch " + path + ": " + std::strerror(errno);
+                return false;
+            }
+        }
+#endif
+        Directory& added = directories_[key];
+        added.path = path;
+        added.recursive = recursive;
+        if (fd_ < 0) {
+            snapshot(added, nullptr);
+        }
+        watched_[path] = key;
+    }
+
+    if (recursive) {
+        for (fs::directory_iterator it(normal, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec) && !it->is_symlink(ec) &&
+                !watchDirectory(it->path().string(), true, error)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<FileEvent> FileWatcher::wait(int timeout_ms) {
+    return fd_ >= 0 ? readNative(timeout_ms) : pollTimes(timeout_ms);
+}
+
+std::vector<FileEvent> FileWatcher::readNative(int timeout_ms) {
+    std::vector<FileEvent> events;
+#ifdef __linux__
+    pollfd pfd{fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, timeout_ms) <= 0) {
+        return events;      // Timeout, or interrupted by a signal
+    }
+
+    alignas(inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(fd_, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;          // EAGAIN: queue drained
+        }
+
+        for (char* p = buffer; p < buffer + n;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                events.push_back(FileEvent{std::string(), true});
+                continue;
+            }
+
+            auto it = directories_.find(event->wd);
+            if (it == directories_.end()) {
+                continue;
+            }
+            std::string dir = it->second.path;
+            bool recursive = it->second.recursive;
+
+            if (event->mask & IN_IGNORED) {
+                watched_.erase(dir);
+                directories_.erase(it);
+                continue;
+            }
+            if (event->mask & IN_DELETE_SELF) {
+                events.push_back(FileEvent{dir, true});
+                continue;
+            }
+
+            FileEvent change;
+            change.path = event->len ? dir + "/" + event->name : dir;
+            change.structural = (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) != 0;
+
+            // New subdirectories of a recursive watch are watched as they appear
+            if (recursive && (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                std::string ignored;
+                watchDirectory(change.path, true, ignored);
+            }
+            events.push_back(std::move(change));
+        }
+    }
+#else
+    (void)timeout_ms;
+#endif
+    return events;
+}
+
+std::vector<FileEvent> FileWatcher::pollTimes(int timeout_ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+
+    std::vector<FileEvent> events;
+    for (auto& entry : directories_) {
+        snapshot(entry.second, &events);
+    }
+
+    std::error_code ec;
+    for (const auto& event : events) {
+        auto parent = watched_.find(fs::path(event.path).parent_path().string());
+        if (event.structural && parent != watched_.end() && directories_[parent->second].recursive &&
+            fs::is_directory(event.path, ec)) {
+            std::string ignored;
+            watchDirectory(event.path, true, ignored);
+        }
+    }
+    return events;
+}
+
+void FileWatcher::snapshot(Directory& dir, std::vector<FileEvent>* changes) {
+    std::map<std::string, fs::file_time_type> entries;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir.path, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code time_ec;
+        entries[it->path().filename().string()] = it->last_write_time(time_ec);
+    }
+
+    if (changes) {
+        for (const auto& entry : entries) {
+            auto old = dir.entries.find(entry.first);
+            if (old == dir.entries.end()) {
+                changes->push_back(FileEvent{dir.path + "/" + entry.first, true});
+            } else if (old->second != entry.second) {
+                changes->push_back(FileEvent{dir.path + "/" + entry.first, false});
+            }
+        }
+        for (const auto& entry : dir.entries) {
+            if (!entries.count(entry.first)) {
+                changes->push_back(FileEvent{dir.path + "/" + entry.first, true});
+            }
+        }
+    }
+    dir.entries = std::move(entries);
+}
+
+} // namespace hybrid
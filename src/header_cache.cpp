@@ -0,0 +1,164 @@
+#include "header_cache.h"
+#include "analysis_pass.h"
+#include "build_cache.h"
+#include "ir.h"
+#include "parser.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include "source_buffer.h"
+#include <filesystem>
+#include <unordered_set>
+
+namespace hybrid {
+
+namespace fs = std::filesystem;
+
+HeaderCache::HeaderCache(std::vector<std::string> include_dirs)
+    : include_dirs_(std::move(include_dirs)) {
+}
+
+std::vector<std::string> HeaderCache::quotedIncludes(std::string_view text) {
+    std::vector<std::string> names;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        std::string_view line = text.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+        pos = end == std::string_view::npos ? text.size() : end + 1;
+
+        // # include "name"  (spaces allowed around the '#')
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string_view::npos || line[i] != '#') continue;
+        i = line.find_first_not_of(" \t", i + 1);
+        if (i == std::string_view::npos || line.compare(i, 7, "include") != 0) continue;
+        i = line.find_first_not_of(" \t", i + 7);
+        if (i == std::string_view::npos || line[i] != '"') continue;
+        size_t close = line.find('"', i + 1);
+        if (close != std::string_view::npos && close > i + 1) {
+            names.emplace_back(line.substr(i + 1, close - i - 1));
+        }
+    }
+    return names;
+}
+
+std::string HeaderCache::findHeader(const std::string& includer, const std::string& name) const {
+    std::error_code ec;
+    fs::path local = fs::path(includer).parent_path() / name;
+    if (fs::is_regular_file(local, ec)) {
+        return fs::weakly_canonical(local, ec).string();
+    }
+    for (const auto& dir : include_dirs_) {
+        fs::path candidate = fs::path(dir) / name;
+        if (fs::is_regular_file(candidate, ec)) {
+            return fs::weakly_canonical(candidate, ec).string();
+        }
+    }
+    return "";
+}
+
+std::vector<std::shared_ptr<const IR>> HeaderCache::resolve(const SourceBuffer& source, bool analyze) {
+    return walk(source, [&](const std::shared_ptr<const SourceBuffer>& header) {
+        return declarations(header, analyze);
+    });
+}
+
+std::string HeaderCache::dependencyHash(const SourceBuffer& source) const {
+    std::string hashes;
+    walk(source, [&](const std::shared_ptr<const SourceBuffer>& header) {
+        hashes += BuildCache::contentHash(header->text());
+        return std::shared_ptr<const IR>();
+    });
+    return hashes.empty() ? hashes : BuildCache::contentHash(hashes);
+}
+
+std::vector<std::shared_ptr<const IR>> HeaderCache::walk(const SourceBuffer& source, const Visit& visit) const {
+    std::vector<std::shared_ptr<const IR>> headers;
+    std::unordered_set<std::string> seen;      // Canonical paths; also stops include cycles
+
+    // Depth first, so each header comes after the ones it includes
+    struct Pending {
+        std::string includer;
+        std::vector<std::string> names;
+        size_t next = 0;
+        std::shared_ptr<const IR> ir;
+    };
+    std::vector<Pending> stack;
+    stack.push_back({source.getPath(), quotedIncludes(source.text()), 0, nullptr});
+    while (!stack.empty()) {
+        Pending& top = stack.back();
+        if (top.next == top.names.size()) {
+            if (top.ir) {
+                headers.push_back(std::move(top.ir));
+            }
+            stack.pop_back();
+            continue;
+        }
+        std::string path = findHeader(top.includer, top.names[top.next++]);
+        if (path.empty() || !seen.insert(path).second) {
+            continue;
+        }
+
+        std::shared_ptr<const SourceBuffer> buffer;
+        try {
+            buffer = SourceBuffer::fromFile(path, false);     // Headers may be edited while watched
+        }
+        catch (const std::exception&) {
+            continue;
+        }
+        std::shared_ptr<const IR> ir = visit(buffer);
+        stack.push_back({path, quotedIncludes(buffer->text()), 0, std::move(ir)});
+    }
+    return headers;
+}
+
+std::shared_ptr<const IR> HeaderCache::declarations(const std::shared_ptr<const SourceBuffer>& header, bool analyze) {
+    std::string key = BuildCache::contentHash(header->text()) + (analyze ? 'a' : 'p');
+
+    std::promise<std::shared_ptr<const IR>> promise;
+    std::shared_future<std::shared_ptr<const IR>> ready;
+    bool parse = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            ready = it->second;
+            reused_++;
+        } else {
+            ready = promise.get_future().share();
+            entries_.emplace(key, ready);
+            parsed_++;
+            parse = true;
+        }
+    }
+
+    // Includers of the same header wait for the first one to finish it
+    if (parse) {
+        ProfileScope scope("parse", "header", header->getPath(), header->size());
+
+        // Shared by every includer, so no single file's budget applies
+        BudgetScope unlimited(nullptr);
+        std::shared_ptr<IR> ir = std::make_shared<IR>();
+        try {
+            Parser::parseBuffer(header, *ir);
+            if (analyze) {
+                AnalysisPassManager::createDefault().run(*ir);
+            }
+        }
+        catch (const std::exception&) {
+            ir = nullptr;
+        }
+        promise.set_value(std::move(ir));
+    }
+    return ready.get();
+}
+
+size_t HeaderCache::getParseCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return parsed_;
+}
+
+size_t HeaderCache::getReuseCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reused_;
+}
+
+} // namespace hybrid
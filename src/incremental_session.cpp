@@ -0,0 +1,261 @@
+#include "incremental_session.h"
+#include "analysis_pass.h"
+#include "build_cache.h"
+#include "codegen.h"
+#include "declaration_index.h"
+#include "parser.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace hybrid {
+
+namespace {
+
+constexpr size_t npos = static_cast<size_t>(-1);
+constexpr uint64_t kHashSeed = 0xcbf29ce484222325ULL;
+
+uint64_t mixHash(uint64_t seed, uint64_t value) {
+    return BuildCache::hashBytes(
+        std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)), seed);
+}
+
+size_t shifted(size_t offset, std::ptrdiff_t delta) {
+    return static_cast<size_t>(static_cast<std::ptrdiff_t>(offset) + delta);
+}
+
+void rebaseFunction(Function& func, const std::shared_ptr<const SourceBuffer>& buffer,
+                    std::ptrdiff_t delta, int line_delta) {
+    // Analyzer line numbers are absolute only for bodies that are views
+    if (func.body.isView()) {
+        for (auto& op : func.coroutine_info.async_operations) {
+            op.line_number += line_delta;
+        }
+    }
+
+    func.body.rebase(buffer, delta);
+    func.location.offset = shifted(func.location.offset, delta);
+    for (auto& param : func.parameters) {
+        param.default_value.rebase(buffer, delta);
+    }
+    for (auto& block : func.try_catch_blocks) {
+        block.try_body.rebase(buffer, delta);
+        for (auto& clause : block.catch_clauses) {
+            clause.handler_body.rebase(buffer, delta);
+        }
+    }
+}
+
+/**
+ * Move a carried-over class from its old position to its new one
+ */
+void rebaseClass(ClassDecl& class_decl, const std::shared_ptr<const SourceBuffer>& buffer,
+                 std::ptrdiff_t delta, int line_delta) {
+    class_decl.location.offset = shifted(class_decl.location.offset, delta);
+    for (auto& field : class_decl.fields) {
+        field.initializer.rebase(buffer, delta);
+    }
+    for (auto& method : class_decl.methods) {
+        rebaseFunction(method, buffer, delta, line_delta);
+    }
+}
+
+} // namespace
+
+IncrementalSession::IncrementalSession(TargetLanguage target, int optimization_level,
+                                       size_t monomorphization_budget)
+    : codegen_(Transpiler::createCodeGenerator(target, optimization_level)) {
+    codegen_->setMonomorphizationBudget(monomorphization_budget);
+}
+
+IncrementalSession::~IncrementalSession() = default;
+
+bool IncrementalSession::update(std::shared_ptr<const SourceBuffer> source) {
+    ProfileScope scope("incremental", "update", source->getPath(), source->size());
+    IncrementalStats stats;
+    std::vector<IncrementalDeclaration> declarations;
+    std::vector<size_t> carried;    // Per new definition: index of the old one it reuses, or npos
+
+    // Reparse everything new into a staging IR first, so a parse error
+    // leaves the current version untouched
+    IR staged;
+    staged.getTypeArena() = ir_.getTypeArena();
+    try {
+        DeclarationIndex index(source);
+        std::string_view old_text = ir_.getSource() ? ir_.getSource()->text() : std::string_view();
+
+        std::unordered_multimap<uint64_t, size_t> previous;
+        for (size_t i = 0; i < declarations_.size(); ++i) {
+            previous.emplace(declarations_[i].text_hash, i);
+        }
+        std::vector<bool> claimed(declarations_.size(), false);
+
+        for (const auto& entry : index.getEntries()) {
+            IncrementalDeclaration declaration;
+            declaration.name = entry.name;
+            declaration.span = entry.span;
+            declaration.line = entry.line;
+
+            std::string_view text = source->slice(entry.span);
+            declaration.text_hash = BuildCache::hashBytes(text, kHashSeed);
+
+            // Identical text parses to the same class; each old one is reused once
+            size_t match = npos;
+            auto range = previous.equal_range(declaration.text_hash);
+            for (auto it = range.first; it != range.second && match == npos; ++it) {
+                const SourceSpan& old_span = declarations_[it->second].span;
+                if (!claimed[it->second] && old_text.substr(old_span.offset, old_span.length) == text) {
+                    match = it->second;
+                }
+            }
+
+            if (match != npos) {
+                claimed[match] = true;
+            } else {
+                declaration.first_class = staged.getClasses().size();
+                Parser::parseSpans(source, {entry.span}, staged);
+                declaration.class_count = staged.getClasses().size() - declaration.first_class;
+                ++stats.reparsed;
+            }
+            carried.push_back(match);
+            declarations.push_back(std::move(declaration));
+        }
+
+        for (bool used : claimed) {
+            stats.discarded += used ? 0 : 1;
+        }
+    }
+    catch (const std::exception& e) {
+        last_error_ = std::string("Failed to parse source: ") + e.what();
+        return false;
+    }
+
+    // Assemble the new IR in source order. The old IR is replaced below,
+    // so carried-over classes are moved out of it.
+    IR next;
+    next.getTypeArena() = std::move(staged.getTypeArena());
+    for (size_t i = 0; i < declarations.size(); ++i) {
+        IncrementalDeclaration& declaration = declarations[i];
+        size_t first = next.getClasses().size();
+
+        if (carried[i] != npos) {
+            const IncrementalDeclaration& old = declarations_[carried[i]];
+            std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(declaration.span.offset) -
+                                   static_cast<std::ptrdiff_t>(old.span.offset);
+            int line_delta = static_cast<int>(declaration.line) - static_cast<int>(old.line);
+            for (size_t k = 0; k < old.class_count; ++k) {
+                ClassDecl& class_decl = ir_.getClass(old.first_class + k);
+                rebaseClass(class_decl, source, delta, line_delta);
+                next.addClass(std::move(class_decl));
+            }
+            declaration.class_count = old.class_count;
+        } else {
+            for (size_t k = 0; k < declaration.class_count; ++k) {
+                next.addClass(std::move(staged.getClass(declaration.first_class + k)));
+                if (analysis_) {
+                    analysis_->runOnClass(next.getClass(first + k));
+                }
+            }
+        }
+        declaration.first_class = first;
+    }
+    next.setSource(source);
+
+    // Generation of a class also reads its bases (inherited virtual
+    // methods), so a fragment is keyed by the text of its whole base chain
+    std::vector<uint64_t> class_hashes(next.getClasses().size());
+    for (const auto& declaration : declarations) {
+        for (size_t k = 0; k < declaration.class_count; ++k) {
+            class_hashes[declaration.first_class + k] = declaration.text_hash;
+        }
+    }
+
+    // How a template is emitted depends on every use of it (duplicate
+    // specializations, the monomorphization budget), so with templates
+    // in the file every fragment is keyed by every declaration
+    uint64_t template_key = 0;
+    const auto& all_classes = next.getClasses();
+    if (std::any_of(all_classes.begin(), all_classes.end(), [](const ClassDecl& c) {
+            return c.is_template || !c.specialization.specialized_args.empty();
+        })) {
+        template_key = 1;
+        for (const auto& declaration : declarations) {
+            template_key = mixHash(template_key, declaration.text_hash);
+        }
+    }
+
+    const ClassDecl* classes = next.getClasses().data();
+    for (auto& declaration : declarations) {
+        uint64_t key = template_key ? mixHash(declaration.text_hash, template_key) : declaration.text_hash;
+        std::unordered_set<const ClassDecl*> visited;
+        std::vector<const ClassDecl*> pending;
+        for (size_t k = 0; k < declaration.class_count; ++k) {
+            pending.push_back(&classes[declaration.first_class + k]);
+        }
+        while (!pending.empty()) {
+            const ClassDecl* class_decl = pending.back();
+            pending.pop_back();
+            for (const auto& base_name : class_decl->base_classes) {
+                key = BuildCache::hashBytes(base_name, key);
+                const ClassDecl* base = next.findClass(base_name);
+                if (base && visited.insert(base).second) {
+                    key = mixHash(key, class_hashes[static_cast<size_t>(base - classes)]);
+                    pending.push_back(base);
+                }
+            }
+        }
+        declaration.fragment_key = key;
+    }
+
+    // The prologue depends on every class (Go imports), but is cheap; it
+    // also plans the templates the declarations below are generated with
+    StringSink prologue;
+    codegen_->generatePrologue(next, prologue);
+
+    for (size_t i = 0; i < declarations.size(); ++i) {
+        IncrementalDeclaration& declaration = declarations[i];
+        if (carried[i] != npos && declarations_[carried[i]].fragment_key == declaration.fragment_key) {
+            declaration.fragment = std::move(declarations_[carried[i]].fragment);
+            continue;
+        }
+
+        StringSink sink;
+        for (size_t k = 0; k < declaration.class_count; ++k) {
+            codegen_->generateDeclaration(next, classes[declaration.first_class + k], sink);
+        }
+        declaration.fragment = sink.take();
+        ++stats.regenerated;
+    }
+
+    StringSink epilogue;
+    codegen_->generateEpilogue(next, epilogue);
+
+    stats.declarations = declarations.size();
+    ir_ = std::move(next);
+    declarations_ = std::move(declarations);
+    prologue_ = prologue.take();
+    epilogue_ = epilogue.take();
+    stats_ = stats;
+    last_error_.clear();
+    return true;
+}
+
+bool IncrementalSession::write(OutputSink& sink) const {
+    sink.write(prologue_);
+    for (const auto& declaration : declarations_) {
+        sink.write(declaration.fragment);
+    }
+    sink.write(epilogue_);
+    return sink.flush();
+}
+
+std::string IncrementalSession::getOutput() const {
+    StringSink sink;
+    write(sink);
+    return sink.take();
+}
+
+} // namespace hybrid
@@ -0,0 +1,312 @@
+#include "input_collector.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
+namespace hybrid {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int kMaxResponseDepth = 16;
+
+std::string trimLine(const std::string& line) {
+    size_t start = 0;
+    while (start < line.size() && std::isspace(static_cast<unsigned char>(line[start]))) start++;
+    size_t end = line.size();
+    while (end > start && std::isspace(static_cast<unsigned char>(line[end - 1]))) end--;
+    return line.substr(start, end - start);
+}
+
+std::vector<std::string> splitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    std::string current;
+    for (char c : path) {
+        if (c == '/') {
+            if (!current.empty()) parts.push_back(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!current.empty()) parts.push_back(current);
+    return parts;
+}
+
+std::vector<fs::directory_entry> sortedEntries(const fs::path& dir) {
+    std::vector<fs::directory_entry> entries;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        entries.push_back(*it);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const fs::directory_entry& a, const fs::directory_entry& b) {
+                  return a.path().filename() < b.path().filename();
+              });
+    return entries;
+}
+
+} // namespace
+
+bool InputCollector::addSpec(const std::string& spec, std::string& error) {
+    if (spec.empty()) {
+        error = "Empty input path";
+        return false;
+    }
+
+    if (spec[0] == '@') {
+        return addResponseFile(spec.substr(1), error);
+    }
+
+    if (hasWildcard(spec)) {
+        return addGlob(spec, error);
+    }
+
+    std::error_code ec;
+    if (fs::is_directory(spec, ec)) {
+        return addDirectory(spec, error);
+    }
+
+    if (!fs::is_regular_file(spec, ec)) {
+        error = "Input file not found: " + spec;
+        return false;
+    }
+
+    std::string parent = fs::path(spec).parent_path().string();
+    addFile(spec, parent.empty() ? "." : parent);
+    return true;
+}
+
+bool InputCollector::addResponseFile(const std::string& path, std::string& error) {
+    if (response_depth_ >= kMaxResponseDepth) {
+        error = "Response files nested too deeply: " + path;
+        return false;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Cannot open response file: " + path;
+        return false;
+    }
+
+    // One spec per line; blank lines and '#' comments are ignored
+    response_depth_++;
+    std::string line;
+    bool ok = true;
+    while (ok && std::getline(file, line)) {
+        std::string spec = trimLine(line);
+        if (spec.empty() || spec[0] == '#') {
+            continue;
+        }
+        ok = addSpec(spec, error);
+    }
+    response_depth_--;
+
+    return ok;
+}
+
+bool InputCollector::addDirectory(const std::string& dir, std::string& error) {
+    std::vector<std::string> found;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && isSourceFile(it->path().string())) {
+            found.push_back(it->path().string());
+        }
+    }
+
+    if (ec) {
+        error = "Cannot read directory " + dir + ": " + ec.message();
+        return false;
+    }
+    if (found.empty()) {
+        error = "No C++ source files found in directory: " + dir;
+        return false;
+    }
+
+    std::sort(found.begin(), found.end());
+    for (const auto& path : found) {
+        addFile(path, dir);
+    }
+    return true;
+}
+
+bool InputCollector::addGlob(const std::string& pattern, std::string& error) {
+    std::vector<std::string> parts = splitPath(pattern);
+
+    // Leading components without wildcards form the search root
+    size_t first_wild = 0;
+    while (first_wild < parts.size() && !hasWildcard(parts[first_wild])) first_wild++;
+
+    fs::path root = (!pattern.empty() && pattern[0] == '/') ? fs::path("/") : fs::path();
+    for (size_t i = 0; i < first_wild; ++i) {
+        root /= parts[i];
+    }
+    std::string base_dir = root.empty() ? "." : root.string();
+
+    std::vector<std::string> found;
+
+    // Depth-first match of the remaining components
+    std::function<void(const fs::path&, size_t)> match = [&](const fs::path& dir, size_t index) {
+        const std::string& component = parts[index];
+        bool last = index + 1 == parts.size();
+        fs::path search_dir = dir.empty() ? fs::path(".") : dir;
+
+        if (component == "**") {
+            if (last) {
+                // Trailing '**' matches every source file below
+                std::error_code ec;
+                for (fs::recursive_directory_iterator it(search_dir, ec), end; !ec && it != end; it.increment(ec)) {
+                    if (it->is_regular_file(ec) && isSourceFile(it->path().string())) {
+                        found.push_back(dir.empty() ? it->path().lexically_relative(".").string()
+                                                    : it->path().string());
+                    }
+                }
+                return;
+            }
+            match(dir, index + 1);
+            for (const auto& entry : sortedEntries(search_dir)) {
+                std::error_code ec;
+                if (entry.is_directory(ec)) {
+                    match(dir / entry.path().filename(), index);
+                }
+            }
+            return;
+        }
+
+        for (const auto& entry : sortedEntries(search_dir)) {
+            std::string name = entry.path().filename().string();
+            if (!matchComponent(component.c_str(), name.c_str())) {
+                continue;
+            }
+            std::error_code ec;
+            fs::path next = dir / name;
+            if (last) {
+                if (entry.is_regular_file(ec)) {
+                    found.push_back(next.string());
+                }
+            } else if (entry.is_directory(ec)) {
+                match(next, index + 1);
+            }
+        }
+    };
+
+    if (first_wild < parts.size()) {
+        match(root, first_wild);
+    }
+
+    if (found.empty()) {
+        error = "No files match pattern: " + pattern;
+        return false;
+    }
+
+    std::sort(found.begin(), found.end());
+    for (const auto& path : found) {
+        addFile(path, base_dir);
+    }
+    return true;
+}
+
+void InputCollector::addFile(const std::string& path, const std::string& base_dir) {
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    std::string key = ec ? fs::path(path).lexically_normal().string() : canonical.string();
+
+    if (seen_.insert(key).second) {
+        files_.push_back(InputFile{path, base_dir});
+    }
+}
+
+std::string InputCollector::mirrorOutputPath(const InputFile& input, const std::string& output_dir,
+                                             const std::string& extension) {
+    fs::path relative = fs::path(input.path).lexically_normal()
+                            .lexically_relative(fs::path(input.base_dir).lexically_normal());
+
+    // Inputs outside their base (e.g. "../x.cpp") keep only the file name
+    if (relative.empty() || *relative.begin() == "..") {
+        relative = fs::path(input.path).filename();
+    }
+
+    relative.replace_extension(extension);
+    return (fs::path(output_dir) / relative).string();
+}
+
+bool InputCollector::disambiguateOutputs(const std::vector<InputFile>& inputs, std::vector<std::string>& outputs,
+                                         std::string& error) {
+    auto key = [](const std::string& path) { return fs::path(path).lexically_normal().string(); };
+    auto isHeader = [](const std::string& path) {
+        std::string ext = fs::path(path).extension().string();
+        return ext == ".h" || ext == ".hh" || ext == ".hpp" || ext == ".hxx";
+    };
+
+    std::unordered_map<std::string, std::vector<size_t>> claims;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        claims[key(outputs[i])].push_back(i);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const auto& group = claims[key(outputs[i])];
+        bool has_source = std::any_of(group.begin(), group.end(),
+                                      [&](size_t j) { return !isHeader(inputs[j].path); });
+        if (group.size() > 1 && (isHeader(inputs[i].path) || !has_source)) {
+            fs::path output(outputs[i]);
+            std::string suffix = fs::path(inputs[i].path).extension().string();
+            suffix = suffix.empty() ? "" : "_" + suffix.substr(1);
+            outputs[i] = output.replace_filename(output.stem().string() + suffix +
+                                                 output.extension().string()).string();
+        }
+    }
+
+    std::unordered_map<std::string, size_t> owner;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        auto inserted = owner.emplace(key(outputs[i]), i);
+        if (!inserted.second) {
+            error = inputs[inserted.first->second].path + " and " + inputs[i].path +
+                    " would both be written to " + outputs[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InputCollector::isSourceFile(const std::string& path) {
+    static const std::vector<std::string> extensions = {
+        ".cpp", ".cc", ".cxx", ".c++", ".hpp", ".hh", ".hxx", ".h"
+    };
+
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find(extensions.begin(), extensions.end(), ext) != extensions.end();
+}
+
+bool InputCollector::hasWildcard(const std::string& text) {
+    return text.find_first_of("*?") != std::string::npos;
+}
+
+bool InputCollector::matchComponent(const char* pattern, const char* name) {
+    // Iterative '*' / '?' matcher with single backtrack point
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*name) {
+        if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (star) {
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') pattern++;
+    return *pattern == '\0';
+}
+
+} // namespace hybrid
@@ -1,24 +1,126 @@
 #include "ir.h"
+#include <functional>
 
 namespace hybrid {
 
+std::shared_ptr<Type> TypeArena::intern(const std::shared_ptr<Type>& type) {
+    if (!type) {
+        return nullptr;
+    }
+
+    // Children first, so node identity below only needs pointer comparison
+    if (type->element_type) {
+        type->element_type = intern(type->element_type);
+    }
+    for (auto& arg : type->template_args) {
+        arg = intern(arg);
+    }
+
+    auto& bucket = buckets_[hashNode(*type)];
+    for (const auto& existing : bucket) {
+        if (existing == type || sameNode(*existing, *type)) {
+            return existing;
+        }
+    }
+
+    bucket.push_back(type);
+    count_++;
+    return type;
+}
+
+std::shared_ptr<Type> TypeArena::get(TypeKind kind, const std::string& name, bool is_const) {
+    auto type = std::make_shared<Type>(kind);
+    type->name = name;
+    type->is_const = is_const;
+    return intern(type);
+}
+
+size_t TypeArena::hashNode(const Type& type) {
+    size_t hash = std::hash<std::string>{}(type.name);
+    auto mix = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+
+    mix(static_cast<size_t>(type.kind));
+    mix((type.is_const ? 1u : 0u) | (type.is_mutable ? 2u : 0u));
+    mix(type.size_bytes);
+    mix(type.alignment);
+    mix(std::hash<const Type*>{}(type.element_type.get()));
+    for (const auto& arg : type.template_args) {
+        mix(std::hash<const Type*>{}(arg.get()));
+    }
+    return hash;
+}
+
+bool TypeArena::sameNode(const Type& a, const Type& b) {
+    // Children are canonical, so comparing their addresses is exact
+    return a.kind == b.kind &&
+           a.name == b.name &&
+           a.is_const == b.is_const &&
+           a.is_mutable == b.is_mutable &&
+           a.size_bytes == b.size_bytes &&
+           a.alignment == b.alignment &&
+           a.element_type == b.element_type &&
+           a.template_args == b.template_args;
+}
+
 void IR::addClass(const ClassDecl& class_decl) {
-    classes_.push_back(class_decl);
+    addClass(ClassDecl(class_decl));
+}
+
+void IR::addClass(ClassDecl&& class_decl) {
+    // First declaration wins, matching a linear scan over getClasses()
+    class_index_.emplace(class_decl.name, classes_.size());
 
     // Register the class as a type
-    auto type = std::make_shared<Type>(TypeKind::Class);
-    type->name = class_decl.name;
-    registerType(class_decl.name, type);
+    registerType(class_decl.name, type_arena_.get(TypeKind::Class, class_decl.name));
+
+    classes_.push_back(std::move(class_decl));
 }
 
 void IR::addFunction(const Function& func) {
-    functions_.push_back(func);
+    addFunction(Function(func));
+}
+
+void IR::addFunction(Function&& func) {
+    function_index_[func.name].push_back(functions_.size());
+    functions_.push_back(std::move(func));
 }
 
 void IR::addGlobalVariable(const Variable& var) {
     global_vars_.push_back(var);
 }
 
+void IR::addGlobalVariable(Variable&& var) {
+    global_vars_.push_back(std::move(var));
+}
+
+const ClassDecl* IR::findClass(const std::string& name) const {
+    auto it = class_index_.find(name);
+    if (it != class_index_.end()) {
+        return &classes_[it->second];
+    }
+    // Only the included IRs' own classes: inclusion is flattened by whoever
+    // attaches them, and IRs may include each other
+    for (const auto& header : included_) {
+        auto found = header->class_index_.find(name);
+        if (found != header->class_index_.end()) {
+            return &header->classes_[found->second];
+        }
+    }
+    return nullptr;
+}
+
+const Function* IR::findFunction(const std::string& name) const {
+    auto it = function_index_.find(name);
+    return it != function_index_.end() ? &functions_[it->second.front()] : nullptr;
+}
+
+const std::vector<size_t>* IR::findFunctionOverloads(const std::string& name) const {
+    auto it = function_index_.find(name);
+    return it != function_index_.end() ? &it->second : nullptr;
+}
+
 std::shared_ptr<Type> IR::findType(const std::string& name) const {
     auto it = type_registry_.find(name);
     if (it != type_registry_.end()) {
@@ -0,0 +1,549 @@
+#include "ir_serializer.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace hybrid {
+
+namespace {
+
+constexpr char kMagic[4] = {'\x89', 'H', 'I', 'R'};
+
+// How a SourceText is stored
+enum TextEncoding : uint8_t {
+    kTextOwned = 0,     // Inline bytes
+    kTextLocated = 1,   // Inline bytes plus the span they came from
+    kTextView = 2       // Span of the embedded source
+};
+
+struct DecodeError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+void putUint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// Field lists shared by the encoder and the decoder, so the two cannot
+// disagree on order. Archives take each field with operator(),
+// enumerations with enumeration(value, last enumerator) and runs of
+// booleans packed into one bitmask with flags().
+
+template <class A> void describe(A& a, Variable& v) {
+    a(v.name); a(v.type); a(v.is_static); a(v.is_const); a(v.initializer);
+}
+
+template <class A> void describe(A& a, Parameter& p) {
+    a(p.name); a(p.type); a(p.has_default); a(p.default_value);
+}
+
+template <class A> void describe(A& a, ExceptionSpec& spec) {
+    a(spec.can_throw); a(spec.throw_types); a(spec.is_noexcept);
+}
+
+template <class A> void describe(A& a, TryCatchBlock::CatchClause& clause) {
+    a(clause.exception_type); a(clause.exception_var); a(clause.handler_body);
+}
+
+template <class A> void describe(A& a, TryCatchBlock& block) {
+    a(block.try_body); a(block.catch_clauses);
+}
+
+template <class A> void describe(A& a, TemplateParameter& param) {
+    a.enumeration(param.kind, TemplateParameter::Template);
+    a(param.name); a(param.default_value); a(param.param_type); a(param.constraints);
+}
+
+template <class A> void describe(A& a, TemplateSpecialization& spec) {
+    a(spec.is_partial); a(spec.specialized_args);
+}
+
+template <class A> void describe(A& a, ThreadInfo& info) {
+    a(info.thread_var_name); a(info.function_name); a(info.arguments); a(info.detached); a(info.joinable);
+}
+
+template <class A> void describe(A& a, MutexInfo& info) {
+    a.enumeration(info.type, MutexInfo::TimedMutex);
+    a(info.mutex_var_name); a(info.protected_type);
+}
+
+template <class A> void describe(A& a, LockInfo& info) {
+    a.enumeration(info.type, LockInfo::ScopedLock);
+    a(info.lock_var_name); a(info.mutex_name); a(info.scope_body);
+}
+
+template <class A> void describe(A& a, AtomicInfo& info) {
+    a(info.atomic_var_name); a(info.value_type); a(info.operations);
+}
+
+template <class A> void describe(A& a, ConditionVariableInfo& info) {
+    a(info.cv_var_name); a(info.associated_mutex); a(info.wait_conditions);
+}
+
+template <class A> void describe(A& a, GuardedUpdate& update) {
+    a.enumeration(update.operation, GuardedUpdate::Subtract);
+    a(update.mutex_name); a(update.var_name); a(update.operand);
+}
+
+template <class A> void describe(A& a, CapacityHint& hint) {
+    a(hint.var_name); a.enumeration(hint.container, TypeKind::Task); a(hint.capacity);
+    a(hint.type_args); a(hint.escapes);
+}
+
+template <class A> void describe(A& a, AsyncOperation& op) {
+    a.enumeration(op.op_type, AsyncOpType::CoYield);
+    a(op.expression); a(op.awaited_type); a(op.line_number);
+}
+
+template <class A> void describe(A& a, CoroutineInfo& info) {
+    a(info.is_coroutine); a(info.promise_type); a(info.return_type); a(info.async_operations);
+    a(info.uses_co_await); a(info.uses_co_return); a(info.uses_co_yield); a(info.is_generator);
+}
+
+template <class A> void describe(A& a, FutureInfo& info) {
+    a(info.future_var_name); a(info.value_type); a(info.promise_var_name); a(info.is_shared_future);
+}
+
+template <class A> void describe(A& a, AsyncTaskInfo& info) {
+    a(info.task_var_name); a(info.async_function_name); a(info.arguments); a(info.result_type);
+    a(info.detached); a(info.follows_wait);
+}
+
+template <class A> void describe(A& a, Function& f) {
+    a(f.name); a(f.return_type); a(f.parameters); a(f.body); a(f.location);
+    a.flags({&f.is_const, &f.is_static, &f.is_virtual, &f.is_pure_virtual, &f.is_constructor,
+             &f.is_destructor, &f.may_throw, &f.is_template, &f.uses_threading, &f.is_async});
+    a(f.moved_params); a(f.borrowed_params);
+    a(f.exception_spec); a(f.try_catch_blocks);
+    a(f.template_parameters); a(f.specialization);
+    a(f.threads_created); a(f.lock_scopes); a(f.atomic_operations); a(f.condition_variables);
+    a(f.guarded_updates); a(f.capacity_hints);
+    a(f.coroutine_info); a(f.futures); a(f.async_tasks);
+}
+
+template <class A> void describe(A& a, ClassDecl::AccessSection& section) {
+    a.enumeration(section.level, ClassDecl::AccessSection::Private);
+    a(section.members);
+}
+
+template <class A> void describe(A& a, ClassDecl& c) {
+    a(c.name); a(c.is_struct); a(c.location);
+    a(c.fields); a(c.methods); a(c.base_classes);
+    a(c.is_template); a(c.template_parameters); a(c.specialization);
+    a(c.access_sections);
+    a(c.mutexes); a(c.atomic_fields); a(c.thread_safe);
+}
+
+class Encoder {
+public:
+    explicit Encoder(const std::shared_ptr<const SourceBuffer>& source) : source_(source) {}
+
+    void operator()(bool value) { putUint(body_, value ? 1 : 0); }
+    void operator()(int value) {
+        // Zigzag, so small negative numbers stay small
+        int64_t wide = value;
+        putUint(body_, (static_cast<uint64_t>(wide) << 1) ^ static_cast<uint64_t>(wide >> 63));
+    }
+    void operator()(const std::string& value) { putUint(body_, intern(value)); }
+    void operator()(const SourceSpan& span) {
+        putUint(body_, span.offset);
+        putUint(body_, span.length);
+    }
+    void operator()(const std::shared_ptr<Type>& type) { putUint(body_, typeRef(type)); }
+
+    void operator()(const SourceText& text) {
+        bool from_source = source_ && text.getBuffer() == source_.get();
+        if (from_source && text.isView()) {
+            putUint(body_, kTextView);
+            (*this)(text.span());
+            return;
+        }
+
+        bool located = from_source && !text.span().empty();
+        std::string_view view = text.view();
+        putUint(body_, located ? kTextLocated : kTextOwned);
+        putUint(body_, view.size());
+        body_.append(view);
+        if (located) {
+            (*this)(text.span());
+        }
+    }
+
+    template <class T> void operator()(const std::vector<T>& items) {
+        putUint(body_, items.size());
+        for (const auto& item : items) {
+            (*this)(item);
+        }
+    }
+
+    // The field lists take mutable references for the decoder's sake; nothing is written through them here
+    template <class T> void operator()(const T& value) { describe(*this, const_cast<T&>(value)); }
+
+    template <class E> void enumeration(const E& value, E) { putUint(body_, static_cast<uint64_t>(value)); }
+
+    void flags(std::initializer_list<bool*> values) {
+        uint64_t bits = 0;
+        unsigned bit = 0;
+        for (bool* value : values) {
+            bits |= static_cast<uint64_t>(*value) << bit++;
+        }
+        putUint(body_, bits);
+    }
+
+    void count(size_t n) { putUint(body_, n); }
+
+    /**
+     * Header, string pool, type table and source, followed by the encoded fields
+     */
+    std::string finish() {
+        uint64_t path = source_ ? intern(source_->getPath()) : 0;
+
+        std::string out(kMagic, sizeof(kMagic));
+        putUint(out, IRSerializer::kFormatVersion);
+        putUint(out, strings_.size());
+        for (const std::string* text : strings_) {
+            putUint(out, text->size());
+            out.append(*text);
+        }
+        putUint(out, type_count_);
+        out.append(types_);
+
+        putUint(out, source_ ? 1 : 0);
+        if (source_) {
+            putUint(out, path);
+            putUint(out, source_->size());
+            out.append(source_->text());
+        }
+        out.append(body_);
+        return out;
+    }
+
+private:
+    std::shared_ptr<const SourceBuffer> source_;
+    std::string body_;
+    std::string types_;
+    std::unordered_map<std::string, uint64_t> string_ids_;
+    std::vector<const std::string*> strings_;       // Pool order; keys of string_ids_
+    std::unordered_map<const Type*, uint64_t> type_ids_;
+    uint64_t type_count_ = 0;
+
+    uint64_t intern(const std::string& text) {
+        auto inserted = string_ids_.emplace(text, strings_.size());
+        if (inserted.second) {
+            strings_.push_back(&inserted.first->first);
+        }
+        return inserted.first->second;
+    }
+
+    // 0 is null; type n is the n-th entry of the table, written after its children
+    uint64_t typeRef(const std::shared_ptr<Type>& type) {
+        if (!type) {
+            return 0;
+        }
+        auto known = type_ids_.find(type.get());
+        if (known != type_ids_.end()) {
+            return known->second;
+        }
+
+        uint64_t element = typeRef(type->element_type);
+        std::vector<uint64_t> args;
+        args.reserve(type->template_args.size());
+        for (const auto& arg : type->template_args) {
+            args.push_back(typeRef(arg));
+        }
+
+        putUint(types_, static_cast<uint64_t>(type->kind));
+        putUint(types_, intern(type->name));
+        putUint(types_, (type->is_const ? 1u : 0u) | (type->is_mutable ? 2u : 0u));
+        putUint(types_, type->size_bytes);
+        putUint(types_, type->alignment);
+        putUint(types_, element);
+        putUint(types_, args.size());
+        for (uint64_t arg : args) {
+            putUint(types_, arg);
+        }
+
+        type_ids_[type.get()] = ++type_count_;
+        return type_count_;
+    }
+};
+
+class Decoder {
+public:
+    Decoder(const std::shared_ptr<const SourceBuffer>& data, IR& ir)
+        : data_(data), text_(data->text()), ir_(ir) {}
+
+    void operator()(bool& value) { value = readUint() != 0; }
+    void operator()(int& value) {
+        uint64_t raw = readUint();
+        int64_t wide = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        if (wide < INT32_MIN || wide > INT32_MAX) {
+            throw DecodeError("integer out of range");
+        }
+        value = static_cast<int>(wide);
+    }
+    void operator()(std::string& value) { value = std::string(readString()); }
+    void operator()(SourceSpan& span) {
+        span.offset = readSize();
+        span.length = readSize();
+    }
+    void operator()(std::shared_ptr<Type>& type) { type = typeAt(readUint()); }
+
+    void operator()(SourceText& text) {
+        uint64_t encoding = readUint();
+        if (encoding == kTextView) {
+            SourceSpan span;
+            (*this)(span);
+            if (!source_ || span.offset > source_->size() || span.length > source_->size() - span.offset) {
+                throw DecodeError("text span outside the source");
+            }
+            text = SourceText(source_, span);
+            return;
+        }
+        if (encoding != kTextOwned && encoding != kTextLocated) {
+            throw DecodeError("unknown text encoding");
+        }
+
+        std::string owned(readBytes(readSize()));
+        if (encoding == kTextLocated) {
+            SourceSpan span;
+            (*this)(span);
+            text = SourceText(std::move(owned), source_, span);
+        } else {
+            text = std::move(owned);
+        }
+    }
+
+    template <class T> void operator()(std::vector<T>& items) {
+        size_t n = count();
+        items.clear();
+        items.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            items.emplace_back();
+            (*this)(items.back());
+        }
+    }
+
+    template <class T> void operator()(T& value) { describe(*this, value); }
+
+    template <class E> void enumeration(E& value, E last) {
+        uint64_t raw = readUint();
+        if (raw > static_cast<uint64_t>(last)) {
+            throw DecodeError("enumeration value out of range");
+        }
+        value = static_cast<E>(raw);
+    }
+
+    void flags(std::initializer_list<bool*> values) {
+        uint64_t bits = readUint();
+        for (bool* value : values) {
+            *value = (bits & 1) != 0;
+            bits >>= 1;
+        }
+    }
+
+    /**
+     * Element count; every element takes at least one byte, which bounds
+     * what a corrupt count can make us allocate
+     */
+    size_t count() {
+        size_t n = readSize();
+        if (n > text_.size() - pos_) {
+            throw DecodeError("truncated data");
+        }
+        return n;
+    }
+
+    void readHeader() {
+        if (!IRSerializer::isSerialized(text_)) {
+            throw DecodeError("not serialized IR");
+        }
+        pos_ = sizeof(kMagic);
+        uint64_t version = readUint();
+        if (version != IRSerializer::kFormatVersion) {
+            throw DecodeError("unsupported format version " + std::to_string(version) +
+                              " (expected " + std::to_string(IRSerializer::kFormatVersion) + ")");
+        }
+
+        size_t strings = count();
+        strings_.reserve(strings);
+        for (size_t i = 0; i < strings; ++i) {
+            strings_.push_back(readBytes(readSize()));
+        }
+
+        size_t types = count();
+        types_.reserve(types);
+        for (size_t i = 0; i < types; ++i) {
+            readType();
+        }
+
+        if (readUint() != 0) {
+            std::string path(readString());
+            size_t length = readSize();
+            size_t offset = pos_;
+            readBytes(length);
+            source_ = SourceBuffer::fromRange(data_, SourceSpan{offset, length}, std::move(path));
+            ir_.setSource(source_);
+        }
+    }
+
+    void readEnd() const {
+        if (pos_ != text_.size()) {
+            throw DecodeError("trailing bytes after the IR");
+        }
+    }
+
+private:
+    std::shared_ptr<const SourceBuffer> data_;
+    std::string_view text_;
+    size_t pos_ = 0;
+    IR& ir_;
+    std::vector<std::string_view> strings_;         // Views into data_
+    std::vector<std::shared_ptr<Type>> types_;      // Interned in ir_'s arena
+    std::shared_ptr<const SourceBuffer> source_;
+
+    uint64_t readUint() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos_ >= text_.size()) {
+                throw DecodeError("truncated data");
+            }
+            uint8_t byte = static_cast<uint8_t>(text_[pos_++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw DecodeError("malformed integer");
+    }
+
+    size_t readSize() {
+        uint64_t value = readUint();
+        if (value > SIZE_MAX) {
+            throw DecodeError("size out of range");
+        }
+        return static_cast<size_t>(value);
+    }
+
+    std::string_view readBytes(size_t length) {
+        if (length > text_.size() - pos_) {
+            throw DecodeError("truncated data");
+        }
+        std::string_view bytes = text_.substr(pos_, length);
+        pos_ += length;
+        return bytes;
+    }
+
+    std::string_view readString() {
+        uint64_t id = readUint();
+        if (id >= strings_.size()) {
+            throw DecodeError("string index out of range");
+        }
+        return strings_[id];
+    }
+
+    std::shared_ptr<Type> typeAt(uint64_t ref) const {
+        if (ref > types_.size()) {
+            throw DecodeError("type index out of range");
+        }
+        return ref ? types_[ref - 1] : nullptr;
+    }
+
+    void readType() {
+        TypeKind kind;
+        enumeration(kind, TypeKind::Task);
+        auto type = std::make_shared<Type>(kind);
+        type->name = std::string(readString());
+        uint64_t flags = readUint();
+        type->is_const = (flags & 1) != 0;
+        type->is_mutable = (flags & 2) != 0;
+        type->size_bytes = readSize();
+        type->alignment = readSize();
+
+        // Children come earlier in the table, so they are already canonical
+        type->element_type = typeAt(readUint());
+        size_t args = count();
+        for (size_t i = 0; i < args; ++i) {
+            type->template_args.push_back(typeAt(readUint()));
+        }
+        types_.push_back(ir_.getTypeArena().intern(type));
+    }
+};
+
+} // namespace
+
+std::string IRSerializer::serialize(const IR& ir) {
+    Encoder encoder(ir.getSource());
+    encoder(ir.getClasses());
+    encoder(ir.getFunctions());
+    encoder(ir.getGlobalVariables());
+
+    // Sorted, so equal IRs serialize to equal bytes
+    std::vector<const std::pair<const std::string, std::shared_ptr<Type>>*> registry;
+    for (const auto& entry : ir.getTypeRegistry()) {
+        registry.push_back(&entry);
+    }
+    std::sort(registry.begin(), registry.end(),
+              [](const auto* a, const auto* b) { return a->first < b->first; });
+    encoder.count(registry.size());
+    for (const auto* entry : registry) {
+        encoder(entry->first);
+        encoder(entry->second);
+    }
+    return encoder.finish();
+}
+
+bool IRSerializer::isSerialized(std::string_view data) {
+    return data.size() >= sizeof(kMagic) && std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+bool IRSerializer::deserialize(const std::shared_ptr<const SourceBuffer>& data, IR& ir, std::string& error) {
+    IR loaded;
+    try {
+        Decoder decoder(data, loaded);
+        decoder.readHeader();
+
+        size_t classes = decoder.count();
+        for (size_t i = 0; i < classes; ++i) {
+            ClassDecl class_decl;
+            decoder(class_decl);
+            loaded.addClass(std::move(class_decl));
+        }
+        size_t functions = decoder.count();
+        for (size_t i = 0; i < functions; ++i) {
+            Function func;
+            decoder(func);
+            loaded.addFunction(std::move(func));
+        }
+        size_t globals = decoder.count();
+        for (size_t i = 0; i < globals; ++i) {
+            Variable var;
+            decoder(var);
+            loaded.addGlobalVariable(std::move(var));
+        }
+        size_t registered = decoder.count();
+        for (size_t i = 0; i < registered; ++i) {
+            std::string name;
+            std::shared_ptr<Type> type;
+            decoder(name);
+            decoder(type);
+            loaded.registerType(name, std::move(type));
+        }
+        decoder.readEnd();
+    }
+    catch (const DecodeError& e) {
+        error = "Invalid serialized IR: " + std::string(e.what());
+        return false;
+    }
+
+    ir = std::move(loaded);
+    return true;
+}
+
+} // namespace hybrid
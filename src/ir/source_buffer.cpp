@@ -0,0 +1,118 @@
+#include "source_buffer.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HYBRID_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hybrid {
+
+SourceBuffer::SourceBuffer(std::string content, std::string path)
+    : storage_(std::move(content)), text_(storage_), path_(std::move(path)) {
+}
+
+SourceBuffer::SourceBuffer(void* mapping, size_t size, std::string path)
+    : text_(static_cast<const char*>(mapping), size), path_(std::move(path)),
+      mapping_(mapping), mapping_size_(size) {
+}
+
+SourceBuffer::~SourceBuffer() {
+#ifdef HYBRID_HAVE_MMAP
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+#endif
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromString(std::string content, std::string path) {
+    return std::make_shared<SourceBuffer>(std::move(content), std::move(path));
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromRange(std::shared_ptr<const SourceBuffer> parent,
+                                                          SourceSpan span, std::string path) {
+    auto buffer = std::make_shared<SourceBuffer>(std::string(), std::move(path));
+    buffer->text_ = parent->slice(span);
+    buffer->parent_ = std::move(parent);
+    return buffer;
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromFile(const std::string& path, bool allow_map) {
+#ifdef HYBRID_HAVE_MMAP
+    if (allow_map) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+
+        struct stat info;
+        void* mapping = MAP_FAILED;
+        size_t size = 0;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+            static_cast<size_t>(info.st_size) >= kMapThreshold) {
+            size = static_cast<size_t>(info.st_size);
+            mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);    // The mapping keeps the file referenced
+
+        if (mapping != MAP_FAILED) {
+            // The lexer makes one forward pass
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            return std::shared_ptr<const SourceBuffer>(new SourceBuffer(mapping, size, path));
+        }
+    }
+#else
+    (void)allow_map;
+#endif
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+
+    // Size the string once instead of growing it while streaming
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    std::string content;
+    if (size > 0) {
+        content.resize(static_cast<size_t>(size));
+        file.read(&content[0], size);
+        content.resize(static_cast<size_t>(file.gcount()));
+    } else {
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        content = stream.str();
+    }
+
+    return fromString(std::move(content), path);
+}
+
+SourceLocation SourceBuffer::locate(size_t offset) const {
+    std::call_once(lines_once_, [this]() {
+        line_starts_.push_back(0);
+        for (size_t i = 0; i < text_.size(); ++i) {
+            if (text_[i] == '\n') {
+                line_starts_.push_back(i + 1);
+            }
+        }
+    });
+
+    offset = std::min(offset, text_.size());
+    auto it = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+    size_t line_index = static_cast<size_t>(it - line_starts_.begin()) - 1;
+
+    SourceLocation location;
+    location.line = static_cast<uint32_t>(line_index + 1);
+    location.column = static_cast<uint32_t>(offset - line_starts_[line_index] + 1);
+    return location;
+}
+
+} // namespace hybrid
@@ -0,0 +1,363 @@
+#include "json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace hybrid {
+
+namespace {
+
+const std::string kEmptyString;
+const JsonValue kNullValue;
+
+// Nesting limit keeps hostile input from exhausting the stack
+constexpr int kMaxDepth = 256;
+
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : text_(text) {}
+
+    bool readDocument(JsonValue& value, std::string& error) {
+        skipWhitespace();
+        if (!readValue(value, 0)) {
+            error = error_ + " at offset " + std::to_string(pos_);
+            return false;
+        }
+        skipWhitespace();
+        if (pos_ != text_.size()) {
+            error = "Unexpected trailing characters at offset " + std::to_string(pos_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::string error_;
+
+    bool fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool consume(std::string_view literal) {
+        if (text_.substr(pos_, literal.size()) == literal) {
+            pos_ += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool readValue(JsonValue& value, int depth) {
+        if (depth > kMaxDepth) {
+            return fail("Nesting too deep");
+        }
+        if (pos_ >= text_.size()) {
+            return fail("Unexpected end of input");
+        }
+
+        char c = text_[pos_];
+        if (c == '{') return readObject(value, depth);
+        if (c == '[') return readArray(value, depth);
+        if (c == '"') {
+            std::string text;
+            if (!readString(text)) return false;
+            value = JsonValue(std::move(text));
+            return true;
+        }
+        if (consume("true")) { value = JsonValue(true); return true; }
+        if (consume("false")) { value = JsonValue(false); return true; }
+        if (consume("null")) { value = JsonValue(); return true; }
+        if (c == '-' || (c >= '0' && c <= '9')) return readNumber(value);
+        return fail("Unexpected character");
+    }
+
+    bool readObject(JsonValue& value, int depth) {
+        value = JsonValue::object();
+        ++pos_;
+        skipWhitespace();
+        if (consume("}")) return true;
+
+        for (;;) {
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') {
+                return fail("Expected member name");
+            }
+            std::string key;
+            if (!readString(key)) return false;
+
+            skipWhitespace();
+            if (!consume(":")) return fail("Expected ':'");
+            skipWhitespace();
+
+            JsonValue member;
+            if (!readValue(member, depth + 1)) return false;
+            value.set(key, std::move(member));
+
+            skipWhitespace();
+            if (consume("}")) return true;
+            if (!consume(",")) return fail("Expected ',' or '}'");
+        }
+    }
+
+    bool readArray(JsonValue& value, int depth) {
+        value = JsonValue::array();
+        ++pos_;
+        skipWhitespace();
+        if (consume("]")) return true;
+
+        for (;;) {
+            skipWhitespace();
+            JsonValue item;
+            if (!readValue(item, depth + 1)) return false;
+            value.push(std::move(item));
+
+            skipWhitespace();
+            if (consume("]")) return true;
+            if (!consume(",")) return fail("Expected ',' or ']'");
+        }
+    }
+
+    bool readNumber(JsonValue& value) {
+        size_t start = pos_;
+        if (text_[pos_] == '-') ++pos_;
+        while (pos_ < text_.size() &&
+               ((text_[pos_] >= '0' && text_[pos_] <= '9') || text_[pos_] == '.' ||
+                text_[pos_] == 'e' || text_[pos_] == 'E' || text_[pos_] == '+' || text_[pos_] == '-')) {
+            ++pos_;
+        }
+
+        std::string number(text_.substr(start, pos_ - start));
+        char* end = nullptr;
+        double parsed = std::strtod(number.c_str(), &end);
+        if (end != number.c_str() + number.size() || !std::isfinite(parsed)) {
+            pos_ = start;
+            return fail("Invalid number");
+        }
+        value = JsonValue(parsed);
+        return true;
+    }
+
+    bool readHex4(uint32_t& code) {
+        if (pos_ + 4 > text_.size()) return fail("Truncated \\u escape");
+        code = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            char h = text_[pos_++];
+            code <<= 4;
+            if (h >= '0' && h <= '9') code |= static_cast<uint32_t>(h - '0');
+            else if (h >= 'a' && h <= 'f') code |= static_cast<uint32_t>(h - 'a' + 10);
+            else if (h >= 'A' && h <= 'F') code |= static_cast<uint32_t>(h - 'A' + 10);
+            else return fail("Invalid \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool readString(std::string& out) {
+        ++pos_;     // Opening quote
+
+        for (;;) {
+            // Copy unescaped runs in one go; sources are mostly plain text
+            size_t run = pos_;
+            while (run < text_.size() && text_[run] != '"' && text_[run] != '\\' &&
+                   static_cast<unsigned char>(text_[run]) >= 0x20) {
+                ++run;
+            }
+            out.append(text_.data() + pos_, run - pos_);
+            pos_ = run;
+
+            if (pos_ >= text_.size()) return fail("Unterminated string");
+
+            char c = text_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') return fail("Control character in string");
+            if (pos_ >= text_.size()) return fail("Unterminated string");
+
+            char escape = text_[pos_++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t code = 0;
+                    if (!readHex4(code)) return false;
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        uint32_t low = 0;
+                        if (!consume("\\u") || !readHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                            return fail("Invalid surrogate pair");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("Invalid escape");
+            }
+        }
+    }
+};
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    // Integral values print without a fraction so ids round-trip exactly
+    if (std::nearbyint(value) == value && std::fabs(value) < 9007199254740992.0) {
+        std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    out += buffer;
+}
+
+} // namespace
+
+JsonValue JsonValue::array() {
+    JsonValue value;
+    value.kind_ = Kind::Array;
+    return value;
+}
+
+JsonValue JsonValue::object() {
+    JsonValue value;
+    value.kind_ = Kind::Object;
+    return value;
+}
+
+const std::string& JsonValue::asString() const {
+    return isString() ? string_ : kEmptyString;
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const {
+    for (const auto& member : members_) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+    return kNullValue;
+}
+
+bool JsonValue::has(std::string_view key) const {
+    for (const auto& member : members_) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+JsonValue& JsonValue::set(std::string_view key, JsonValue value) {
+    kind_ = Kind::Object;
+    for (auto& member : members_) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return *this;
+        }
+    }
+    members_.emplace_back(std::string(key), std::move(value));
+    return *this;
+}
+
+JsonValue& JsonValue::push(JsonValue value) {
+    kind_ = Kind::Array;
+    items_.push_back(std::move(value));
+    return *this;
+}
+
+std::string JsonValue::dump() const {
+    std::string out;
+    dump(out);
+    return out;
+}
+
+void JsonValue::dump(std::string& out) const {
+    switch (kind_) {
+        case Kind::Null: out += "null"; break;
+        case Kind::Bool: out += bool_ ? "true" : "false"; break;
+        case Kind::Number: appendNumber(out, number_); break;
+        case Kind::String: appendJsonString(out, string_); break;
+        case Kind::Array:
+            out += '[';
+            for (size_t i = 0; i < items_.size(); ++i) {
+                if (i > 0) out += ',';
+                items_[i].dump(out);
+            }
+            out += ']';
+            break;
+        case Kind::Object:
+            out += '{';
+            for (size_t i = 0; i < members_.size(); ++i) {
+                if (i > 0) out += ',';
+                appendJsonString(out, members_[i].first);
+                out += ':';
+                members_[i].second.dump(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+bool JsonValue::parse(std::string_view text, JsonValue& value, std::string& error) {
+    JsonReader reader(text);
+    return reader.readDocument(value, error);
+}
+
+void appendJsonString(std::string& out, std::string_view text) {
+    out += '"';
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        const char* escaped = nullptr;
+        char control[8];
+        switch (c) {
+            case '"': escaped = "\\\""; break;
+            case '\\': escaped = "\\\\"; break;
+            case '\n': escaped = "\\n"; break;
+            case '\t': escaped = "\\t"; break;
+            case '\r': escaped = "\\r"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    std::snprintf(control, sizeof(control), "\\u%04x", static_cast<unsigned>(c));
+                    escaped = control;
+                }
+        }
+        if (escaped) {
+            out.append(text.data() + run, i - run);
+            out += escaped;
+            run = i + 1;
+        }
+    }
+    out.append(text.data() + run, text.size() - run);
+    out += '"';
+}
+
+} // namespace hybrid
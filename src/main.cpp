@@ -1,8 +1,17 @@
 #include "transpiler.h"
+#include "clang_frontend.h"
+#include "header_cache.h"
+#include "input_collector.h"
+#include "profiler.h"
+#include "server.h"
+#include "shard_manifest.h"
+#include "watch_mode.h"
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
-#include <fstream>
 
 void printUsage(const char* program_name) {
     std::cout << "Hybrid Transpiler - Convert C++ code to modern, safe languages (Rust/Go)\n\n";
@@ -15,18 +24,56 @@ void printUsage(const char* program_name) {
     std::cout << "  • Threading → Safe concurrency\n";
     std::cout << "  • Async/Coroutines → async/await\n\n";
 
-    std::cout << "Usage: " << program_name << " [options]\n\n";
+    std::cout << "Usage: " << program_name << " [options]\n";
+    std::cout << "       " << program_name << " merge [-o <merged.json>] <shard.json>...\n\n";
 
     std::cout << "Options:\n";
-    std::cout << "  -i, --input <file>      Input C++ source file (required)\n";
+    std::cout << "  -i, --input <path>      Input file, directory or glob (repeatable, required)\n";
+    std::cout << "  @<file>                 Read input paths from a response file\n";
     std::cout << "  -o, --output <file>     Output file path (auto-generated if omitted)\n";
+    std::cout << "  --output-dir <dir>      Write outputs under <dir>, mirroring the input tree\n";
     std::cout << "  -t, --target <lang>     Target language: rust, go [default: rust]\n";
+    std::cout << "                          rust,go generates both from one parse\n";
     std::cout << "  -O, --opt-level <N>     Optimization level 0-3 [default: 0]\n";
     std::cout << "                          0 = readable, 1 = balanced,\n";
     std::cout << "                          2 = optimized, 3 = aggressive\n";
+    std::cout << "  --mono-budget <N>       Emit a class template used with more than N distinct\n";
+    std::cout << "                          argument lists once, type-erased, where its operations\n";
+    std::cout << "                          allow [default: 0 = always generic]\n";
     std::cout << "  --no-safety-checks      Disable safety checks\n";
     std::cout << "  --no-comments           Don't preserve comments\n";
     std::cout << "  --gen-tests             Generate test cases\n";
+    std::cout << "  --gen-benchmarks        Also write benchmark harnesses: foo_bench.rs (Criterion),\n";
+    std::cout << "                          foo_test.go (testing.B) and foo_bench.cpp (Google\n";
+    std::cout << "                          Benchmark) with one benchmark per public method\n";
+    std::cout << "  -j, --jobs <N>          Parallel jobs: per file in batches, per declaration\n";
+    std::cout << "                          for a single file [default: 1]\n";
+    std::cout << "                          0 = one per hardware thread\n";
+    std::cout << "  --cache-dir <dir>       Reuse outputs of unchanged inputs from <dir>\n";
+    std::cout << "  --time-budget <ms>      Per-file wall-time limit; a file over it gets\n";
+    std::cout << "                          signatures only and a warning [default: none]\n";
+    std::cout << "  --memory-budget <MiB>   Per-file limit on tokens, IR and copies, as above\n";
+    std::cout << "  --frontend <name>       C++ front end: simple, clang [default: simple]\n";
+    std::cout << "  --resolve-includes      Simple: read the classes of quoted #includes (bases\n";
+    std::cout << "                          in shared headers), each header parsed once per run\n";
+    std::cout << "  -I, --include-dir <dir> Simple: also search <dir> for them (repeatable;\n";
+    std::cout << "                          implies --resolve-includes)\n";
+    std::cout << "  -p, --compile-commands <dir>\n";
+    std::cout << "                          Clang: directory of compile_commands.json\n";
+    std::cout << "                          [default: searched upwards from each input]\n";
+    std::cout << "  --extra-arg <arg>       Clang: append <arg> to every compile command (repeatable)\n";
+    std::cout << "  --emit-ir               Parse and analyze only; write binary IR (.hir) that\n";
+    std::cout << "                          later runs accept as input in place of the source\n";
+    std::cout << "  --shard <i/N>           Transpile only shard i of N of the inputs (balanced by\n";
+    std::cout << "                          size, the same split on every machine) and write a\n";
+    std::cout << "                          manifest; '" << program_name << " merge' then fixes up\n";
+    std::cout << "                          classes whose bases are in files of other shards\n";
+    std::cout << "  --manifest <file>       Shard manifest path [default: <output-dir or .>/shard-i-of-N.json]\n";
+    std::cout << "  --stats                 Print time, allocations and bytes per phase\n";
+    std::cout << "  --trace <file>          Write a Chrome trace-event JSON profile to <file>\n";
+    std::cout << "  --server                Serve JSON-RPC transpile requests on stdin/stdout\n";
+    std::cout << "  --socket <path>         Serve JSON-RPC requests on a Unix socket (implies --server)\n";
+    std::cout << "  --watch                 Rebuild inputs as they change, until Ctrl-C\n";
     std::cout << "  --verbose               Enable verbose output\n";
     std::cout << "  --quiet                 Minimal output (errors only)\n";
     std::cout << "  -h, --help              Show this help message\n";
@@ -46,6 +93,26 @@ void printUsage(const char* program_name) {
     std::cout << "  " << program_name << " -i example.cpp --quiet\n\n";
     std::cout << "  # Generate with test cases\n";
     std::cout << "  " << program_name << " -i vector.cpp --gen-tests\n\n";
+    std::cout << "  # Benchmark the Rust and Go output against the original C++\n";
+    std::cout << "  " << program_name << " -i vector.cpp -t rust,go -O 2 --gen-benchmarks\n\n";
+    std::cout << "  # Profile a run (open the trace in chrome://tracing or Perfetto)\n";
+    std::cout << "  " << program_name << " -i big.cpp --stats --trace big.trace.json\n\n";
+    std::cout << "  # Rust and Go bindings from a single parse (point.rs, point.go)\n";
+    std::cout << "  " << program_name << " -i point.cpp -t rust,go\n\n";
+    std::cout << "  # Analyze once, generate both targets from the saved IR\n";
+    std::cout << "  " << program_name << " -i big.cpp --emit-ir && " << program_name << " -i big.hir -t go\n\n";
+    std::cout << "  # Parse with Clang using the project's compilation database\n";
+    std::cout << "  " << program_name << " -i src --output-dir out --frontend clang -p build\n\n";
+    std::cout << "  # Keep a warm server for editors and build tools\n";
+    std::cout << "  " << program_name << " --socket /tmp/hybrid.sock --cache-dir .hybrid-cache\n\n";
+    std::cout << "  # Keep out/ up to date while editing src/\n";
+    std::cout << "  " << program_name << " -i src --output-dir out --watch\n\n";
+    std::cout << "  # Split a project over two machines, then merge the manifests\n";
+    std::cout << "  " << program_name << " -i src --output-dir out --shard 1/2    # machine 1\n";
+    std::cout << "  " << program_name << " -i src --output-dir out --shard 2/2    # machine 2\n";
+    std::cout << "  " << program_name << " merge out/shard-1-of-2.json out/shard-2-of-2.json\n\n";
+    std::cout << "  # Whole project, 8 jobs, mirrored into out/\n";
+    std::cout << "  " << program_name << " -i src -i 'include/**/*.h' @extra.rsp --output-dir out -j 8\n\n";
 
     std::cout << "Supported C++ Features:\n";
     std::cout << "  • Classes, methods, constructors\n";
@@ -61,7 +128,7 @@ void printUsage(const char* program_name) {
 }
 
 void printVersion() {
-    std::cout << "Hybrid Transpiler v0.1.0\n";
+    std::cout << "Hybrid Transpiler v" << HYBRID_TRANSPILER_VERSION << "\n";
     std::cout << "Built with LLVM/Clang support\n\n";
     std::cout << "Supported targets:\n";
     std::cout << "  • Rust (edition 2021)\n";
@@ -70,15 +137,234 @@ void printVersion() {
     std::cout << "License: MIT\n";
 }
 
+/**
+ * Stop the profiler and report results; stats go to stats_out
+ */
+void finishProfile(bool show_stats, const std::string& trace_path, bool quiet, std::ostream& stats_out) {
+    hybrid::Profiler& profiler = hybrid::Profiler::global();
+    if (!hybrid::Profiler::enabled()) {
+        return;
+    }
+
+    profiler.stop();
+    if (show_stats) {
+        profiler.writeStats(stats_out);
+    }
+    std::string trace_error;
+    if (!trace_path.empty() && !profiler.writeTrace(trace_path, trace_error)) {
+        std::cerr << "Warning: " << trace_error << "\n";
+    } else if (!trace_path.empty() && !quiet) {
+        stats_out << "Trace written to: " << trace_path << "\n";
+    }
+}
+
+/**
+ * --server / --socket: answer requests until shutdown
+ */
+int runServer(const hybrid::TranspilerOptions& options, const std::string& socket_path,
+              bool show_stats, const std::string& trace_path) {
+    if (show_stats || !trace_path.empty()) {
+        hybrid::Profiler::global().start();
+    }
+
+    hybrid::TranspileServer server(options);
+    bool ok = true;
+    if (socket_path.empty()) {
+        // stdout carries the protocol; everything else goes to stderr
+        std::ios::sync_with_stdio(false);
+        server.serveStream(std::cin, std::cout);
+    } else {
+        if (!options.quiet) {
+            std::cout << "Listening on " << socket_path << "\n";
+            std::cout.flush();
+        }
+        std::string error;
+        ok = server.serveSocket(socket_path, error);
+        if (!ok) {
+            std::cerr << "Error: " << error << "\n";
+        }
+    }
+
+    finishProfile(show_stats, trace_path, options.quiet, std::cerr);
+    return ok ? 0 : 1;
+}
+
+/**
+ * Expand input specs (files, directories, globs, response files) and pair
+ * each input with its output path
+ * @return false with error (and an optional hint line) set on failure
+ */
+bool resolveInputs(const std::vector<std::string>& input_specs, const hybrid::TranspilerOptions& options,
+                   const std::string& output_dir, std::vector<std::string>& input_files,
+                   std::vector<std::string>& output_files, std::string& error, std::string& hint) {
+    hybrid::InputCollector collector;
+    for (const auto& spec : input_specs) {
+        if (!collector.addSpec(spec, error)) {
+            hint = "Please check the file path and try again.\n";
+            return false;
+        }
+    }
+
+    const auto& inputs = collector.getFiles();
+    if (inputs.size() > 1 && !options.output_path.empty()) {
+        error = "--output names a single file but " + std::to_string(inputs.size()) + " inputs were given";
+        hint = "Use --output-dir <dir> for multiple inputs.\n";
+        return false;
+    }
+
+    input_files.clear();
+    output_files.clear();
+    for (const auto& input : inputs) {
+        input_files.push_back(input.path);
+        if (!output_dir.empty()) {
+            output_files.push_back(hybrid::InputCollector::mirrorOutputPath(
+                input, output_dir, hybrid::Transpiler::outputExtension(options)));
+        } else if (!options.output_path.empty()) {
+            output_files.push_back(options.output_path);
+        } else {
+            output_files.push_back(hybrid::Transpiler::defaultOutputPath(input.path, options));
+        }
+    }
+    if (!hybrid::InputCollector::disambiguateOutputs(inputs, output_files, error)) {
+        hint = "Rename one of the inputs or transpile them separately.\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * --watch: build, then rebuild changed inputs until Ctrl-C
+ */
+int runWatch(const hybrid::TranspilerOptions& options, const std::vector<std::string>& input_specs,
+             const std::string& output_dir, bool show_stats, const std::string& trace_path) {
+    if (show_stats || !trace_path.empty()) {
+        hybrid::Profiler::global().start();
+    }
+
+    hybrid::WatchMode watch(options, [&](std::vector<std::string>& inputs, std::vector<std::string>& outputs,
+                                         std::string& error) {
+        std::string hint;
+        return resolveInputs(input_specs, options, output_dir, inputs, outputs, error, hint);
+    });
+
+    // Directories and glob roots are watched as trees so new files show up
+    for (const auto& spec : input_specs) {
+        std::error_code ec;
+        if (spec[0] != '@' && std::filesystem::is_directory(spec, ec)) {
+            watch.addTree(spec, true);
+        } else if (spec.find_first_of("*?") != std::string::npos) {
+            std::string root = spec.substr(0, spec.find_first_of("*?"));
+            root = root.substr(0, root.find_last_of('/') == std::string::npos ? 0 : root.find_last_of('/'));
+            watch.addTree(root.empty() ? "." : root, spec.find("**") != std::string::npos);
+        }
+    }
+
+    int status = watch.run(std::cout);
+    finishProfile(show_stats, trace_path, options.quiet, std::cout);
+    return status;
+}
+
+/**
+ * merge: combine the manifests of every shard of a batch
+ */
+int runMerge(int argc, char* argv[]) {
+    std::vector<std::string> manifest_paths;
+    std::string merged_path;
+    bool verbose = false;
+    bool quiet = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" || arg == "--output") {
+            if (i + 1 >= argc) {
+                std::cerr << "Usage: " << argv[0] << " merge -o <merged.json> <shard.json>...\n";
+                return 1;
+            }
+            merged_path = argv[++i];
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Error: Unknown merge option '" << arg << "'\n";
+            return 1;
+        } else {
+            manifest_paths.push_back(arg);
+        }
+    }
+    if (manifest_paths.empty()) {
+        std::cerr << "Error: No shard manifests given\n";
+        std::cerr << "Usage: " << argv[0] << " merge [-o <merged.json>] <shard.json>...\n";
+        return 1;
+    }
+
+    std::vector<hybrid::ShardManifest> shards(manifest_paths.size());
+    std::string error;
+    for (size_t i = 0; i < manifest_paths.size(); ++i) {
+        if (!hybrid::ShardManifest::read(manifest_paths[i], shards[i], error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    hybrid::MergeResult result = hybrid::ShardMerger::merge(shards);
+    if (!result.success) {
+        std::cerr << "Error: " << result.error << "\n";
+        return 1;
+    }
+    if (!merged_path.empty() && !result.manifest.write(merged_path, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    size_t failed = 0;
+    for (const auto& entry : result.manifest.entries) {
+        if (!entry.success) {
+            std::cerr << entry.input_path << ": " << entry.diagnostic << "\n";
+            failed++;
+        } else if (verbose && !entry.resolved_bases.empty()) {
+            std::cout << "  " << entry.input_path << ": bases from other files:";
+            for (const auto& base : entry.resolved_bases) {
+                std::cout << " " << base;
+            }
+            std::cout << "\n";
+        }
+    }
+    for (const auto& missing : result.unresolved) {
+        if (!quiet) {
+            std::cerr << "Warning: base not defined in any shard: " << missing << "\n";
+        }
+    }
+    if (!quiet) {
+        std::cout << "Merged " << shards.size() << " shards, " << result.manifest.entries.size() << " files, "
+                  << result.regenerated << " regenerated\n";
+    }
+    if (failed) {
+        std::cerr << failed << " of " << result.manifest.entries.size() << " files failed\n";
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         printUsage(argv[0]);
         return 1;
     }
+    if (std::string(argv[1]) == "merge") {
+        return runMerge(argc, argv);
+    }
 
     hybrid::TranspilerOptions options;
-    std::string input_file;
-    std::vector<std::string> input_files;
+    std::vector<std::string> input_specs;
+    std::string output_dir;
+    bool show_stats = false;
+    std::string trace_path;
+    bool server_mode = false;
+    std::string socket_path;
+    bool watch_mode = false;
+    bool sharded = false;
+    hybrid::ShardSpec shard;
+    std::string manifest_path;
 
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -92,13 +378,23 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (arg == "-i" || arg == "--input") {
             if (i + 1 < argc) {
-                input_file = argv[++i];
+                input_specs.push_back(argv[++i]);
             } else {
                 std::cerr << "Error: --input requires a file path\n";
                 std::cerr << "Usage: " << argv[0] << " --input <file.cpp> --output <file.rs> --target rust\n";
                 std::cerr << "See '" << argv[0] << " --help' for more information.\n";
                 return 1;
             }
+        } else if (arg.size() > 1 && arg[0] == '@') {
+            input_specs.push_back(arg);
+        } else if (arg == "--output-dir") {
+            if (i + 1 < argc) {
+                output_dir = argv[++i];
+            } else {
+                std::cerr << "Error: --output-dir requires a directory path\n";
+                std::cerr << "Usage: " << argv[0] << " --output-dir <dir>\n";
+                return 1;
+            }
         } else if (arg == "-o" || arg == "--output") {
             if (i + 1 < argc) {
                 options.output_path = argv[++i];
@@ -110,11 +406,25 @@ int main(int argc, char* argv[]) {
             }
         } else if (arg == "-t" || arg == "--target") {
             if (i + 1 < argc) {
-                std::string target = argv[++i];
-                if (target == "rust") {
-                    options.target = hybrid::TargetLanguage::Rust;
-                } else if (target == "go") {
-                    options.target = hybrid::TargetLanguage::Go;
+                // A comma-separated list generates every target from one parse
+                std::istringstream names(argv[++i]);
+                std::vector<hybrid::TargetLanguage> targets;
+                std::string target;
+                bool valid = true;
+                while (valid && std::getline(names, target, ',')) {
+                    hybrid::TargetLanguage language = hybrid::TargetLanguage::Rust;
+                    if (target == "go") {
+                        language = hybrid::TargetLanguage::Go;
+                    } else if (target != "rust") {
+                        valid = false;
+                    }
+                    if (valid && std::find(targets.begin(), targets.end(), language) == targets.end()) {
+                        targets.push_back(language);
+                    }
+                }
+                if (valid && !targets.empty()) {
+                    options.target = targets[0];
+                    options.targets = targets.size() > 1 ? targets : std::vector<hybrid::TargetLanguage>();
                 } else {
                     std::cerr << "Error: Unknown target language '" << target << "'\n";
                     std::cerr << "Supported languages: rust, go\n";
@@ -158,12 +468,160 @@ int main(int argc, char* argv[]) {
                 std::cerr << "See '" << argv[0] << " --help' for more information.\n";
                 return 1;
             }
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 < argc) {
+                try {
+                    options.jobs = std::stoi(argv[++i]);
+                    if (options.jobs < 0) {
+                        std::cerr << "Error: Job count must not be negative\n";
+                        return 1;
+                    }
+                } catch (const std::exception&) {
+                    std::cerr << "Error: Invalid job count '" << argv[i] << "'\n";
+                    std::cerr << "Expected a non-negative number\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --jobs requires a number\n";
+                std::cerr << "Usage: " << argv[0] << " --jobs <N>\n";
+                return 1;
+            }
+        } else if (arg == "--time-budget" || arg == "--memory-budget") {
+            bool time = arg == "--time-budget";
+            if (i + 1 < argc) {
+                try {
+                    std::string value = argv[++i];
+                    if (value.empty() || value[0] == '-') {
+                        throw std::invalid_argument(value);
+                    }
+                    (time ? options.time_budget_ms : options.memory_budget_mb) = std::stoull(value);
+                } catch (const std::exception&) {
+                    std::cerr << "Error: Invalid budget '" << argv[i] << "'\n";
+                    std::cerr << "Expected a non-negative number of " << (time ? "milliseconds" : "MiB") << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: " << arg << " requires a number\n";
+                std::cerr << "Usage: " << argv[0] << " " << arg << (time ? " <ms>" : " <MiB>") << "\n";
+                return 1;
+            }
+        } else if (arg == "--mono-budget") {
+            if (i + 1 < argc) {
+                try {
+                    std::string value = argv[++i];
+                    if (value.empty() || value[0] == '-') {
+                        throw std::invalid_argument(value);
+                    }
+                    options.monomorphization_budget = std::stoull(value);
+                } catch (const std::exception&) {
+                    std::cerr << "Error: Invalid monomorphization budget '" << argv[i] << "'\n";
+                    std::cerr << "Expected a non-negative number of instantiations\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --mono-budget requires a number\n";
+                std::cerr << "Usage: " << argv[0] << " --mono-budget <N>\n";
+                return 1;
+            }
+        } else if (arg == "--cache-dir") {
+            if (i + 1 < argc) {
+                options.cache_dir = argv[++i];
+            } else {
+                std::cerr << "Error: --cache-dir requires a directory path\n";
+                std::cerr << "Usage: " << argv[0] << " --cache-dir <dir>\n";
+                return 1;
+            }
+        } else if (arg == "--stats") {
+            show_stats = true;
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                trace_path = argv[++i];
+            } else {
+                std::cerr << "Error: --trace requires a file path\n";
+                std::cerr << "Usage: " << argv[0] << " --trace <file>\n";
+                return 1;
+            }
+        } else if (arg == "--server") {
+            server_mode = true;
+        } else if (arg == "--socket") {
+            if (i + 1 < argc) {
+                socket_path = argv[++i];
+                server_mode = true;
+            } else {
+                std::cerr << "Error: --socket requires a path\n";
+                std::cerr << "Usage: " << argv[0] << " --socket <path>\n";
+                return 1;
+            }
+        } else if (arg == "--frontend") {
+            std::string name = i + 1 < argc ? argv[++i] : "";
+            if (name == "simple") {
+                options.frontend = hybrid::FrontEnd::Simple;
+            } else if (name == "clang") {
+                options.frontend = hybrid::FrontEnd::Clang;
+            } else {
+                std::cerr << "Error: --frontend must be 'simple' or 'clang'\n";
+                std::cerr << "Usage: " << argv[0] << " --frontend <simple|clang>\n";
+                return 1;
+            }
+        } else if (arg == "-p" || arg == "--compile-commands") {
+            if (i + 1 < argc) {
+                options.compile_commands_dir = argv[++i];
+            } else {
+                std::cerr << "Error: " << arg << " requires a directory path\n";
+                std::cerr << "Usage: " << argv[0] << " --compile-commands <dir>\n";
+                return 1;
+            }
+        } else if (arg == "--extra-arg") {
+            if (i + 1 < argc) {
+                options.clang_args.push_back(argv[++i]);
+            } else {
+                std::cerr << "Error: --extra-arg requires an argument\n";
+                std::cerr << "Usage: " << argv[0] << " --extra-arg <arg>\n";
+                return 1;
+            }
+        } else if (arg == "--resolve-includes") {
+            options.resolve_includes = true;
+        } else if (arg == "-I" || arg == "--include-dir") {
+            if (i + 1 < argc) {
+                options.include_dirs.push_back(argv[++i]);
+                options.resolve_includes = true;
+            } else {
+                std::cerr << "Error: " << arg << " requires a directory path\n";
+                std::cerr << "Usage: " << argv[0] << " --include-dir <dir>\n";
+                return 1;
+            }
+        } else if (arg == "--shard") {
+            std::string error;
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --shard requires an argument\n";
+                std::cerr << "Usage: " << argv[0] << " --shard <i/N>\n";
+                return 1;
+            }
+            if (!hybrid::ShardSpec::parse(argv[++i], shard, error)) {
+                std::cerr << "Error: " << error << "\n";
+                return 1;
+            }
+            sharded = true;
+        } else if (arg == "--manifest") {
+            if (i + 1 < argc) {
+                manifest_path = argv[++i];
+            } else {
+                std::cerr << "Error: --manifest requires an argument\n";
+                std::cerr << "Usage: " << argv[0] << " --manifest <file>\n";
+                return 1;
+            }
+        } else if (arg == "--emit-ir") {
+            options.emit_ir = true;
+        } else if (arg == "--watch") {
+            watch_mode = true;
         } else if (arg == "--no-safety-checks") {
             options.enable_safety_checks = false;
         } else if (arg == "--no-comments") {
             options.preserve_comments = false;
         } else if (arg == "--gen-tests") {
             options.generate_tests = true;
+        } else if (arg == "--gen-benchmarks") {
+            options.generate_benchmarks = true;
         } else if (arg == "--verbose") {
             options.verbose = true;
         } else if (arg == "--quiet") {
@@ -187,8 +645,50 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!options.targets.empty() && (server_mode || watch_mode)) {
+        std::cerr << "Error: " << (server_mode ? "--server" : "--watch") << " takes a single target\n";
+        return 1;
+    }
+
+    if (options.emit_ir && (server_mode || watch_mode)) {
+        std::cerr << "Error: --emit-ir cannot be combined with " << (server_mode ? "--server" : "--watch") << "\n";
+        return 1;
+    }
+
+    if (sharded && (server_mode || watch_mode)) {
+        std::cerr << "Error: --shard cannot be combined with " << (server_mode ? "--server" : "--watch") << "\n";
+        return 1;
+    }
+    if (!manifest_path.empty() && !sharded) {
+        std::cerr << "Error: --manifest needs --shard\n";
+        return 1;
+    }
+
+    if (options.frontend == hybrid::FrontEnd::Clang) {
+        if (!hybrid::ClangFrontEnd::isAvailable()) {
+            std::cerr << "Error: this build has no Clang front end; use --frontend simple\n";
+            return 1;
+        }
+        if (watch_mode) {
+            std::cerr << "Error: --watch reparses incrementally and needs --frontend simple\n";
+            return 1;
+        }
+    }
+
+    if (server_mode) {
+        if (watch_mode) {
+            std::cerr << "Error: --watch and --server cannot be combined\n";
+            return 1;
+        }
+        if (!input_specs.empty() || !options.output_path.empty() || !output_dir.empty()) {
+            std::cerr << "Error: --server takes inputs from requests, not the command line\n";
+            return 1;
+        }
+        return runServer(options, socket_path, show_stats, trace_path);
+    }
+
     // Validate inputs
-    if (input_file.empty()) {
+    if (input_specs.empty()) {
         std::cerr << "Error: No input file specified\n";
         std::cerr << "You must provide an input file with -i or --input\n";
         std::cerr << "Example: " << argv[0] << " -i example.cpp\n";
@@ -196,59 +696,180 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Check if input file exists
-    std::ifstream test_file(input_file);
-    if (!test_file.good()) {
-        std::cerr << "Error: Input file not found: " << input_file << "\n";
-        std::cerr << "Please check the file path and try again.\n";
+    std::vector<std::string> input_files;
+    std::vector<std::string> output_files;
+    std::string error;
+    std::string hint;
+    if (!resolveInputs(input_specs, options, output_dir, input_files, output_files, error, hint)) {
+        std::cerr << "Error: " << error << "\n" << hint;
         return 1;
     }
-    test_file.close();
 
-    // Auto-generate output filename if not specified
-    if (options.output_path.empty()) {
-        std::string extension = (options.target == hybrid::TargetLanguage::Rust) ? ".rs" : ".go";
-        size_t dot_pos = input_file.find_last_of('.');
-        if (dot_pos != std::string::npos) {
-            options.output_path = input_file.substr(0, dot_pos) + extension;
-        } else {
-            options.output_path = input_file + extension;
+    if (watch_mode) {
+        return runWatch(options, input_specs, output_dir, show_stats, trace_path);
+    }
+
+    // This machine's share; the merge needs every file's IR to fix up bases
+    if (sharded) {
+        std::vector<size_t> assigned = hybrid::ShardSpec::assign(input_files, shard.count);
+        std::vector<std::string> shard_inputs;
+        std::vector<std::string> shard_outputs;
+        for (size_t i = 0; i < input_files.size(); ++i) {
+            if (assigned[i] == shard.index) {
+                shard_inputs.push_back(input_files[i]);
+                shard_outputs.push_back(output_files[i]);
+            }
         }
+        input_files = std::move(shard_inputs);
+        output_files = std::move(shard_outputs);
+        options.keep_ir = true;
+        if (manifest_path.empty()) {
+            manifest_path = (output_dir.empty() ? std::string(".") : output_dir) + "/shard-" +
+                            std::to_string(shard.index + 1) + "-of-" + std::to_string(shard.count) + ".json";
+        }
+    }
+
+    // Auto-generate output filename if not specified
+    if (options.output_path.empty() && input_files.size() == 1) {
+        options.output_path = output_files[0];
 
         if (options.verbose) {
             std::cout << "Auto-generated output path: " << options.output_path << "\n";
         }
     }
 
+    std::string target_name;
+    for (hybrid::TargetLanguage target : hybrid::Transpiler::getTargets(options)) {
+        target_name += target_name.empty() ? "" : " and ";
+        target_name += (target == hybrid::TargetLanguage::Rust) ? "Rust" : "Go";
+    }
+    if (options.emit_ir) {
+        target_name = "IR";
+    }
+
     // Display verbose information
     if (options.verbose) {
         std::cout << "Configuration:\n";
-        std::cout << "  Input:  " << input_file << "\n";
-        std::cout << "  Output: " << options.output_path << "\n";
-        std::cout << "  Target: " << (options.target == hybrid::TargetLanguage::Rust ? "Rust" : "Go") << "\n";
+        if (input_files.size() == 1) {
+            std::cout << "  Input:  " << input_files[0] << "\n";
+            std::cout << "  Output: " << options.output_path << "\n";
+        } else {
+            std::cout << "  Inputs: " << input_files.size() << " files\n";
+            std::cout << "  Output: " << (output_dir.empty() ? "next to inputs" : output_dir) << "\n";
+        }
+        std::cout << "  Target: " << target_name << "\n";
+        std::cout << "  Front end: " << (options.frontend == hybrid::FrontEnd::Clang ? "clang" : "simple") << "\n";
+        if (options.resolve_includes && options.frontend == hybrid::FrontEnd::Simple) {
+            std::cout << "  Includes: resolved";
+            for (const auto& dir : options.include_dirs) {
+                std::cout << " -I " << dir;
+            }
+            std::cout << "\n";
+        }
         std::cout << "  Optimization level: " << options.optimization_level << "\n";
+        if (options.monomorphization_budget) {
+            std::cout << "  Monomorphization budget: " << options.monomorphization_budget << " instantiations\n";
+        }
         std::cout << "  Safety checks: " << (options.enable_safety_checks ? "enabled" : "disabled") << "\n";
         std::cout << "  Preserve comments: " << (options.preserve_comments ? "yes" : "no") << "\n";
         std::cout << "  Generate tests: " << (options.generate_tests ? "yes" : "no") << "\n";
+        std::cout << "  Generate benchmarks: " << (options.generate_benchmarks ? "yes" : "no") << "\n";
+        std::cout << "  Cache: " << (options.cache_dir.empty() ? "disabled" : options.cache_dir) << "\n";
+        std::cout << "  Jobs: " << options.jobs << "\n";
+        if (sharded) {
+            std::cout << "  Shard: " << shard.toString() << ", manifest " << manifest_path << "\n";
+        }
+        if (options.time_budget_ms || options.memory_budget_mb) {
+            std::cout << "  Budget per file: "
+                      << (options.time_budget_ms ? std::to_string(options.time_budget_ms) + " ms" : "no time limit")
+                      << ", "
+                      << (options.memory_budget_mb ? std::to_string(options.memory_budget_mb) + " MiB" : "no memory limit")
+                      << "\n";
+        }
     }
 
     // Create transpiler and run
     if (!options.quiet) {
-        std::cout << "Transpiling " << input_file << " to "
-                  << (options.target == hybrid::TargetLanguage::Rust ? "Rust" : "Go")
-                  << "...\n";
+        if (input_files.size() == 1) {
+            std::cout << "Transpiling " << input_files[0] << " to " << target_name << "...\n";
+        } else {
+            std::cout << "Transpiling " << input_files.size() << " files to " << target_name << "...\n";
+        }
+    }
+
+    hybrid::Profiler& profiler = hybrid::Profiler::global();
+    if (show_stats || !trace_path.empty()) {
+        profiler.start();
     }
 
     hybrid::Transpiler transpiler(options);
 
-    if (!transpiler.transpile(input_file)) {
+    bool ok = transpiler.transpileBatch(input_files, output_files);
+
+    finishProfile(show_stats, trace_path, options.quiet, std::cout);
+
+    // Written even if files failed, so the merge can report them
+    if (sharded) {
+        hybrid::ShardManifest manifest = hybrid::ShardManifest::fromBatch(shard, options, transpiler.getBatchResults());
+        if (!manifest.write(manifest_path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    // Over-budget files still count as done; their outputs are stubs
+    for (const auto& result : transpiler.getBatchResults()) {
+        if (result.success && result.over_budget) {
+            std::cerr << "Warning: " << result.input_path << ": " << result.error
+                      << "; wrote signatures only\n";
+        }
+    }
+
+    if (options.verbose) {
+        for (const auto& result : transpiler.getBatchResults()) {
+            if (result.success) {
+                std::cout << "  " << result.input_path << " -> ";
+                for (size_t i = 0; i < result.output_paths.size(); ++i) {
+                    std::cout << (i ? ", " : "") << result.output_paths[i];
+                }
+                for (const auto& path : result.benchmark_paths) {
+                    std::cout << ", " << path;
+                }
+                std::cout << (result.cache_hit ? " (cached)" : "") << "\n";
+            }
+        }
+        if (const hybrid::HeaderCache* headers = transpiler.getHeaderCache()) {
+            std::cout << "  Headers: " << headers->getParseCount() << " parsed, "
+                      << headers->getReuseCount() << " reused\n";
+        }
+    }
+
+    if (!ok) {
         std::cerr << "Error: Transpilation failed\n";
-        std::cerr << transpiler.getLastError() << "\n";
+        size_t failed = 0;
+        for (const auto& result : transpiler.getBatchResults()) {
+            if (!result.success) {
+                std::cerr << result.input_path << ": " << result.error << "\n";
+                failed++;
+            }
+        }
+        if (input_files.size() > 1) {
+            std::cerr << failed << " of " << input_files.size() << " files failed\n";
+        }
         return 1;
     }
 
     if (!options.quiet) {
-        std::cout << "Successfully transpiled to: " << options.output_path << "\n";
+        if (input_files.size() == 1) {
+            const auto& written = transpiler.getBatchResults()[0].output_paths;
+            std::cout << "Successfully transpiled to: ";
+            for (size_t i = 0; i < written.size(); ++i) {
+                std::cout << (i ? ", " : "") << written[i];
+            }
+            std::cout << "\n";
+        } else {
+            std::cout << "Successfully transpiled " << input_files.size() << " files\n";
+        }
     }
 
     return 0;
@@ -0,0 +1,307 @@
+#include "analysis_pass.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include <algorithm>
+#include <chrono>
+
+namespace hybrid {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t elapsedNanoseconds(Clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+} // namespace
+
+BodyScan::BodyScan(const SourceText& body)
+    : body_(body), text_(body.view()) {
+    Lexer lexer(text_);
+    std::vector<Token> all = lexer.tokenize(false);
+
+    tokens_.reserve(all.size());
+    for (const auto& token : all) {
+        if (token.kind != TokenKind::Preprocessor) {
+            tokens_.push_back(token);
+        }
+    }
+
+    // Same matching rules as the parser: unbalanced openers are dropped
+    match_.assign(tokens_.size(), npos);
+    std::vector<size_t> open;
+    for (size_t i = 0; i < tokens_.size(); ++i) {
+        const Token& t = tokens_[i];
+        if (t.kind != TokenKind::Punct || t.length != 1) continue;
+
+        char c = t.text[0];
+        if (c == '(' || c == '[' || c == '{') {
+            open.push_back(i);
+        } else if (c == ')' || c == ']' || c == '}') {
+            char expected = (c == ')') ? '(' : (c == ']') ? '[' : '{';
+            while (!open.empty() && tokens_[open.back()].text[0] != expected) {
+                open.pop_back();
+            }
+            if (!open.empty()) {
+                match_[open.back()] = i;
+                match_[i] = open.back();
+                open.pop_back();
+            }
+        }
+    }
+}
+
+size_t BodyScan::matchingAngle(size_t index) const {
+    int depth = 0;
+    for (size_t i = index; i < size(); ++i) {
+        const Token& t = tokens_[i];
+        if (t.kind != TokenKind::Punct) continue;
+
+        if (t.text == "<") {
+            ++depth;
+        } else if (t.text == ">") {
+            if (--depth == 0) return i;
+        } else if (t.text == "(" || t.text == "[") {
+            if (match_[i] == npos) return npos;
+            i = match_[i];
+        } else if (t.text == ";" || t.text == "{" || t.text == "}" ||
+                   t.text == ")" || t.text == "]") {
+            return npos;
+        }
+    }
+    return npos;
+}
+
+std::string_view BodyScan::punctuator(size_t index) const {
+    static constexpr std::string_view kOperators[] = {
+        "<<=", ">>=", "++", "--", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+        "==", "!=", "<=", ">=", "&&", "||", "<<", ">>"
+    };
+    const Token& first = at(index);
+    if (first.kind != TokenKind::Punct || first.length != 1) {
+        return first.kind == TokenKind::Punct ? first.text : std::string_view();
+    }
+
+    size_t count = 1;
+    while (count < 3 && at(index + count).kind == TokenKind::Punct && at(index + count).length == 1 &&
+           at(index + count).offset == at(index + count - 1).end()) {
+        ++count;
+    }
+    std::string_view spelled = text_.substr(first.offset, count);
+    for (std::string_view op : kOperators) {
+        if (spelled.compare(0, op.size(), op) == 0) {
+            return op;
+        }
+    }
+    return first.text;
+}
+
+std::string_view BodyScan::text(size_t first, size_t last) const {
+    if (last < first || last >= size()) {
+        return std::string_view();
+    }
+    size_t begin = tokens_[first].offset;
+    return text_.substr(begin, tokens_[last].end() - begin);
+}
+
+std::string_view BodyScan::between(size_t open, size_t close) const {
+    if (close <= open || close >= tokens_.size()) {
+        return std::string_view();
+    }
+    size_t begin = tokens_[open].end();
+    return text_.substr(begin, tokens_[close].offset - begin);
+}
+
+SourceText BodyScan::sliceBetween(size_t open, size_t close) const {
+    if (close <= open || close >= tokens_.size()) {
+        return SourceText();
+    }
+    size_t begin = tokens_[open].end();
+    return body_.substr(begin, tokens_[close].offset - begin);
+}
+
+std::vector<std::string> BodyScan::splitArguments(size_t open, size_t close) const {
+    std::vector<std::string> arguments;
+    if (close <= open || close > size()) {
+        return arguments;
+    }
+
+    size_t start = open + 1;
+    for (size_t i = open + 1; i <= close; ++i) {
+        const Token& t = tokens_[i];
+        if (i < close && match_[i] != npos && match_[i] > i) {
+            i = match_[i];      // Skip nested brackets wholesale
+            continue;
+        }
+        if (i == close || t.isPunct(",")) {
+            if (i > start) {
+                arguments.emplace_back(text(start, i - 1));
+            }
+            start = i + 1;
+        }
+    }
+    return arguments;
+}
+
+uint32_t BodyScan::line(size_t index) const {
+    const Token& t = at(index);
+    if (body_.isView() && body_.getBuffer()) {
+        return body_.getBuffer()->locate(body_.span().offset + t.offset).line;
+    }
+    return t.line;
+}
+
+AnalysisPassManager AnalysisPassManager::createDefault() {
+    AnalysisPassManager manager;
+    manager.addPass(createThreadAnalysisPass());
+    manager.addPass(createAsyncAnalysisPass());
+    manager.addPass(createExceptionAnalysisPass());
+    manager.addPass(createOwnershipAnalysisPass());
+    return manager;
+}
+
+void AnalysisPassManager::addPass(std::unique_ptr<AnalysisPass> pass) {
+    size_t index = passes_.size();
+    for (std::string_view identifier : pass->interests()) {
+        auto& subscribers = interests_[identifier];
+        if (std::find(subscribers.begin(), subscribers.end(), index) == subscribers.end()) {
+            subscribers.push_back(index);
+        }
+    }
+
+    PassTiming timing;
+    timing.name = pass->name();
+    timings_.push_back(timing);
+    passes_.push_back(std::move(pass));
+}
+
+void AnalysisPassManager::run(IR& ir) {
+    ProfileScope scope("analysis", "run");
+    std::vector<PassTiming> before = timings_;
+    uint64_t scan_before = scan_nanoseconds_;
+
+    for (size_t i = 0; i < ir.getClasses().size(); ++i) {
+        runOnClass(ir.getClass(i));
+    }
+    for (size_t i = 0; i < ir.getFunctions().size(); ++i) {
+        runOnFunction(ir.getFunction(i));
+    }
+
+    // Passes interleave per token, so they are reported as totals, not spans
+    if (Profiler::enabled()) {
+        Profiler& profiler = Profiler::global();
+        profiler.recordTotal("analysis", "scan", scan_nanoseconds_ - scan_before, 1);
+        for (size_t p = 0; p < passes_.size(); ++p) {
+            profiler.recordTotal("analysis", passes_[p]->name(),
+                                 timings_[p].nanoseconds - before[p].nanoseconds,
+                                 timings_[p].dispatches - before[p].dispatches);
+        }
+    }
+}
+
+void AnalysisPassManager::runOnClass(ClassDecl& class_decl) {
+    bool timed = Profiler::enabled();
+    for (size_t p = 0; p < passes_.size(); ++p) {
+        Clock::time_point start = timed ? Clock::now() : Clock::time_point();
+        passes_[p]->analyzeClass(class_decl);
+        if (timed) timings_[p].nanoseconds += elapsedNanoseconds(start);
+    }
+    for (auto& method : class_decl.methods) {
+        runOnFunction(method);
+    }
+}
+
+void AnalysisPassManager::runOnFunction(Function& func) {
+    ++functions_analyzed_;
+    ResourceBudget::checkpoint("analysis");
+
+    // The clock is read only while profiling: next to one dispatch it is not cheap
+    bool timed = Profiler::enabled();
+    function_interests_.clear();
+    std::vector<std::string_view> identifiers;
+    for (size_t p = 0; p < passes_.size(); ++p) {
+        Clock::time_point start = timed ? Clock::now() : Clock::time_point();
+        passes_[p]->beginFunction(func);
+        identifiers.clear();
+        passes_[p]->functionInterests(func, identifiers);
+        for (std::string_view identifier : identifiers) {
+            function_interests_.emplace_back(identifier, p);
+        }
+        if (timed) timings_[p].nanoseconds += elapsedNanoseconds(start);
+    }
+
+    if (!func.body.empty() && (!interests_.empty() || !function_interests_.empty())) {
+        Clock::time_point scan_start = timed ? Clock::now() : Clock::time_point();
+        BodyScan scan(func.body);
+        if (timed) scan_nanoseconds_ += elapsedNanoseconds(scan_start);
+
+        auto dispatch = [&](size_t p, size_t i) {
+            if (!timed) {
+                passes_[p]->onToken(scan, i, func);
+            } else {
+                Clock::time_point start = Clock::now();
+                passes_[p]->onToken(scan, i, func);
+                timings_[p].nanoseconds += elapsedNanoseconds(start);
+            }
+            ++timings_[p].dispatches;
+        };
+
+        for (size_t i = 0; i < scan.size(); ++i) {
+            const Token& t = scan.at(i);
+            if (t.kind != TokenKind::Identifier) continue;
+
+            auto it = interests_.find(t.text);
+            if (it != interests_.end()) {
+                for (size_t p : it->second) {
+                    dispatch(p, i);
+                }
+            }
+            // A handful of names (parameters), so a linear scan beats hashing
+            for (const auto& [identifier, p] : function_interests_) {
+                bool dispatched = it != interests_.end() &&
+                                  std::find(it->second.begin(), it->second.end(), p) != it->second.end();
+                if (identifier == t.text && !dispatched) {
+                    dispatch(p, i);
+                }
+            }
+        }
+    }
+
+    for (size_t p = 0; p < passes_.size(); ++p) {
+        Clock::time_point start = timed ? Clock::now() : Clock::time_point();
+        passes_[p]->endFunction(func);
+        if (timed) timings_[p].nanoseconds += elapsedNanoseconds(start);
+    }
+}
+
+void AnalysisPassManager::runPass(AnalysisPass& pass, Function& func) {
+    pass.beginFunction(func);
+
+    if (!func.body.empty()) {
+        std::vector<std::string_view> interests = pass.interests();
+        pass.functionInterests(func, interests);
+        BodyScan scan(func.body);
+        for (size_t i = 0; i < scan.size(); ++i) {
+            const Token& t = scan.at(i);
+            if (t.kind == TokenKind::Identifier &&
+                std::find(interests.begin(), interests.end(), t.text) != interests.end()) {
+                pass.onToken(scan, i, func);
+            }
+        }
+    }
+
+    pass.endFunction(func);
+}
+
+void AnalysisPassManager::resetTimings() {
+    for (auto& timing : timings_) {
+        timing.nanoseconds = 0;
+        timing.dispatches = 0;
+    }
+    scan_nanoseconds_ = 0;
+    functions_analyzed_ = 0;
+}
+
+} // namespace hybrid
@@ -3,10 +3,8 @@
  * Analyzes C++20 coroutines and async patterns for conversion to Rust async/await and Go goroutines
  */
 
-#include "ir.h"
-#include <regex>
+#include "analysis_pass.h"
 #include <algorithm>
-#include <set>
 
 namespace hybrid {
 
@@ -14,20 +12,66 @@ namespace hybrid {
  * Async/Coroutine Analyzer
  * Detects co_await, co_return, co_yield, std::future, std::async, etc.
  */
-class AsyncAnalyzer {
+class AsyncAnalyzer : public AnalysisPass {
 public:
     /**
      * Analyze function for coroutine patterns
      */
     void analyzeFunction(Function& func) {
-        // Detect coroutine keywords
-        detectCoroutineKeywords(func);
+        AnalysisPassManager::runPass(*this, func);
+    }
+
+    const char* name() const override { return "async"; }
+
+    std::vector<std::string_view> interests() const override {
+        return {"co_await", "co_return", "co_yield", "future", "promise", "async", "get", "wait"};
+    }
+
+    void beginFunction(Function& func) override {
+        (void)func;
+        promise_vars_.clear();
+        waited_ = false;
+    }
+
+    void onToken(const BodyScan& scan, size_t index, Function& func) override {
+        std::string_view word = scan.at(index).text;
+
+        if (word == "co_await") {
+            addCoroutineOperation(scan, index, AsyncOpType::CoAwait, func);
+        } else if (word == "co_return") {
+            addCoroutineOperation(scan, index, AsyncOpType::CoReturn, func);
+        } else if (word == "co_yield") {
+            addCoroutineOperation(scan, index, AsyncOpType::CoYield, func);
+        } else if (word == "get" || word == "wait") {
+            detectTaskWait(scan, index, func);
+        } else if (!scan.isQualified(index, "std")) {
+            return;
+        } else if (word == "future") {
+            detectFuture(scan, index, func);
+        } else if (word == "promise") {
+            detectPromise(scan, index);
+        } else if (word == "async") {
+            detectAsyncCall(scan, index, func);
+        }
+    }
 
-        // Detect std::future and std::promise usage
-        detectFuturePromise(func);
+    void endFunction(Function& func) override {
+        // Associate each promise with the first future lacking one
+        for (const auto& promise_var : promise_vars_) {
+            for (auto& future : func.futures) {
+                if (future.promise_var_name.empty()) {
+                    future.promise_var_name = promise_var;
+                    break;
+                }
+            }
+        }
+        promise_vars_.clear();
 
-        // Detect std::async calls
-        detectAsyncCalls(func);
+        // Mark as coroutine if any coroutine keyword is used
+        CoroutineInfo& coro_info = func.coroutine_info;
+        if (coro_info.uses_co_await || coro_info.uses_co_return || coro_info.uses_co_yield) {
+            coro_info.is_coroutine = true;
+        }
 
         // Determine if function is async
         func.is_async = func.coroutine_info.is_coroutine ||
@@ -36,218 +80,132 @@ public:
     }
 
 private:
+    std::vector<std::string> promise_vars_;
+    bool waited_ = false;   // A task was awaited earlier in the body
+
     /**
-     * Detect C++20 coroutine keywords: co_await, co_return, co_yield
+     * Record co_await / co_return / co_yield and the expression up to ';'
      */
-    void detectCoroutineKeywords(Function& func) {
-        std::string body = func.body;
-        CoroutineInfo& coro_info = func.coroutine_info;
-
-        // Pattern 1: co_await expression
-        std::regex await_pattern(R"(co_await\s+([^;]+))");
-
-        // Pattern 2: co_return expression
-        std::regex return_pattern(R"(co_return\s+([^;]+))");
-
-        // Pattern 3: co_yield expression
-        std::regex yield_pattern(R"(co_yield\s+([^;]+))");
+    void addCoroutineOperation(const BodyScan& scan, size_t index, AsyncOpType type, Function& func) {
+        size_t end = index + 1;
+        while (end < scan.size() && !scan.at(end).isPunct(";")) {
+            size_t match = scan.matching(end);
+            if (match != BodyScan::npos && match > end) {
+                end = match;    // Lambdas and calls inside the expression
+            } else if (match != BodyScan::npos) {
+                break;          // Closing bracket of the enclosing scope
+            }
+            ++end;
+        }
 
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
+        AsyncOperation op;
+        op.op_type = type;
+        op.expression = std::string(scan.text(index + 1, end - 1));
+        op.line_number = static_cast<int>(scan.line(index));
 
-        // Search for co_await
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, await_pattern)) {
-            AsyncOperation op;
-            op.op_type = AsyncOpType::CoAwait;
-            op.expression = trim(match[1].str());
+        CoroutineInfo& coro_info = func.coroutine_info;
+        coro_info.async_operations.push_back(std::move(op));
 
-            coro_info.async_operations.push_back(op);
+        if (type == AsyncOpType::CoAwait) {
             coro_info.uses_co_await = true;
-            search_start = match.suffix().first;
-        }
-
-        // Search for co_return
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, return_pattern)) {
-            AsyncOperation op;
-            op.op_type = AsyncOpType::CoReturn;
-            op.expression = trim(match[1].str());
-
-            coro_info.async_operations.push_back(op);
+        } else if (type == AsyncOpType::CoReturn) {
             coro_info.uses_co_return = true;
-            search_start = match.suffix().first;
-        }
-
-        // Search for co_yield
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, yield_pattern)) {
-            AsyncOperation op;
-            op.op_type = AsyncOpType::CoYield;
-            op.expression = trim(match[1].str());
-
-            coro_info.async_operations.push_back(op);
+        } else {
             coro_info.uses_co_yield = true;
             coro_info.is_generator = true;  // co_yield makes it a generator
-            search_start = match.suffix().first;
-        }
-
-        // Mark as coroutine if any coroutine keyword is used
-        if (coro_info.uses_co_await || coro_info.uses_co_return || coro_info.uses_co_yield) {
-            coro_info.is_coroutine = true;
         }
     }
 
     /**
-     * Detect std::future and std::promise usage
+     * Detect future declarations: std::future<T> var = ... / std::future<T> var;
      */
-    void detectFuturePromise(Function& func) {
-        std::string body = func.body;
-
-        // Pattern 1: std::future<T> var = ...
-        std::regex future_pattern(
-            R"(std::future<([^>]+)>\s+(\w+)\s*(?:=|;))"
-        );
-
-        // Pattern 2: std::promise<T> var
-        std::regex promise_pattern(
-            R"(std::promise<([^>]+)>\s+(\w+))"
-        );
-
-        // Pattern 3: future.get()
-        std::regex get_pattern(R"((\w+)\.get\(\))");
-
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
-
-        // Search for future declarations
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, future_pattern)) {
-            FutureInfo future_info;
-            future_info.future_var_name = match[2].str();
-
-            // Create type for future value
-            auto value_type = std::make_shared<Type>(TypeKind::Void);
-            value_type->name = match[1].str();
-            future_info.value_type = value_type;
-
-            func.futures.push_back(future_info);
-            search_start = match.suffix().first;
+    void detectFuture(const BodyScan& scan, size_t index, Function& func) {
+        size_t close = templateClose(scan, index);
+        if (close == BodyScan::npos) return;
+
+        const Token& var = scan.at(close + 1);
+        const Token& after = scan.at(close + 2);
+        if (var.kind != TokenKind::Identifier || !(after.isPunct("=") || after.isPunct(";"))) {
+            return;
         }
 
-        // Search for promise declarations
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, promise_pattern)) {
-            std::string promise_var = match[2].str();
-            std::string value_type_name = match[1].str();
+        FutureInfo future_info;
+        future_info.future_var_name = std::string(var.text);
 
-            // Associate promise with future if exists
-            for (auto& future : func.futures) {
-                if (future.promise_var_name.empty()) {
-                    future.promise_var_name = promise_var;
-                    break;
-                }
-            }
+        // Create type for future value
+        auto value_type = std::make_shared<Type>(TypeKind::Void);
+        value_type->name = std::string(scan.text(index + 2, close - 1));
+        future_info.value_type = value_type;
 
-            search_start = match.suffix().first;
-        }
+        func.futures.push_back(std::move(future_info));
     }
 
     /**
-     * Detect std::async calls
+     * Detect promise declarations: std::promise<T> var
      */
-    void detectAsyncCalls(Function& func) {
-        std::string body = func.body;
-
-        // Pattern 1: auto result = std::async(func, args...)
-        std::regex async_pattern1(
-            R"((?:auto|std::future<[^>]+>)\s+(\w+)\s*=\s*std::async\s*\(\s*([^,)]+)(?:,\s*([^)]*))?\))"
-        );
-
-        // Pattern 2: std::async(std::launch::*, func, args...)
-        std::regex async_pattern2(
-            R"(std::async\s*\(\s*std::launch::\w+\s*,\s*([^,)]+)(?:,\s*([^)]*))?\))"
-        );
-
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
-
-        // Search for async pattern 1
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, async_pattern1)) {
-            AsyncTaskInfo task_info;
-            task_info.task_var_name = match[1].str();
-            task_info.async_function_name = trim(match[2].str());
-
-            // Parse arguments
-            if (match.size() > 3 && match[3].matched) {
-                parseArguments(match[3].str(), task_info.arguments);
-            }
-
-            func.async_tasks.push_back(task_info);
-            search_start = match.suffix().first;
-        }
-
-        // Search for async pattern 2
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, async_pattern2)) {
-            AsyncTaskInfo task_info;
-            task_info.async_function_name = trim(match[1].str());
-
-            // Parse arguments
-            if (match.size() > 2 && match[2].matched) {
-                parseArguments(match[2].str(), task_info.arguments);
-            }
-
-            task_info.detached = true;  // No variable assignment means detached
-            func.async_tasks.push_back(task_info);
-            search_start = match.suffix().first;
+    void detectPromise(const BodyScan& scan, size_t index) {
+        size_t close = templateClose(scan, index);
+        if (close != BodyScan::npos && scan.at(close + 1).kind == TokenKind::Identifier) {
+            promise_vars_.emplace_back(scan.at(close + 1).text);
         }
     }
 
     /**
-     * Parse comma-separated arguments
+     * Detect std::async calls:
+     *   auto result = std::async(func, args...)
+     *   std::async(std::launch::*, func, args...)
      */
-    void parseArguments(const std::string& args_str, std::vector<std::string>& arguments) {
-        if (args_str.empty()) return;
-
-        std::string current_arg;
-        int paren_depth = 0;
-        int angle_depth = 0;
-
-        for (char c : args_str) {
-            if (c == '(' || c == '[' || c == '{') {
-                paren_depth++;
-            } else if (c == ')' || c == ']' || c == '}') {
-                paren_depth--;
-            } else if (c == '<') {
-                angle_depth++;
-            } else if (c == '>') {
-                angle_depth--;
-            }
-
-            if (c == ',' && paren_depth == 0 && angle_depth == 0) {
-                arguments.push_back(trim(current_arg));
-                current_arg.clear();
-            } else {
-                current_arg += c;
-            }
+    void detectAsyncCall(const BodyScan& scan, size_t index, Function& func) {
+        size_t open = index + 1;
+        size_t close = scan.matching(open);
+        if (!scan.at(open).isPunct("(") || close == BodyScan::npos) return;
+
+        std::vector<std::string> arguments = scan.splitArguments(open, close);
+        auto first = arguments.begin();
+        if (first != arguments.end() && first->rfind("std::launch::", 0) == 0) {
+            ++first;    // Launch policy
         }
-
-        if (!current_arg.empty()) {
-            arguments.push_back(trim(current_arg));
+        if (first == arguments.end()) return;
+
+        AsyncTaskInfo task_info;
+        task_info.async_function_name = std::move(*first);
+        task_info.arguments.assign(std::make_move_iterator(first + 1),
+                                   std::make_move_iterator(arguments.end()));
+
+        // "name = std::async(...)"; no variable assignment means detached
+        if (index >= 4 && scan.at(index - 3).isPunct("=") &&
+            scan.at(index - 4).kind == TokenKind::Identifier) {
+            task_info.task_var_name = std::string(scan.at(index - 4).text);
+        } else {
+            task_info.detached = true;
         }
+        task_info.follows_wait = waited_;
+
+        func.async_tasks.push_back(std::move(task_info));
+    }
+
+    /**
+     * Detect waits on a task launched earlier: task.get() / task.wait()
+     */
+    void detectTaskWait(const BodyScan& scan, size_t index, const Function& func) {
+        if (index < 2 || !scan.at(index - 1).isPunct(".") || !scan.at(index + 1).isPunct("(")) return;
+        std::string_view var = scan.at(index - 2).text;
+        waited_ = waited_ || std::any_of(func.async_tasks.begin(), func.async_tasks.end(),
+                                         [&](const AsyncTaskInfo& task) { return !task.detached && task.task_var_name == var; });
     }
 
     /**
-     * Trim whitespace from string
+     * Index of the '>' closing "name<...>" at index, npos if absent or empty
      */
-    std::string trim(const std::string& str) {
-        size_t first = str.find_first_not_of(" \t\n\r");
-        if (first == std::string::npos) return "";
-        size_t last = str.find_last_not_of(" \t\n\r");
-        return str.substr(first, last - first + 1);
+    static size_t templateClose(const BodyScan& scan, size_t index) {
+        if (!scan.at(index + 1).isPunct("<")) return BodyScan::npos;
+        size_t close = scan.matchingAngle(index + 1);
+        return close == index + 2 ? BodyScan::npos : close;
     }
 };
 
+std::unique_ptr<AnalysisPass> createAsyncAnalysisPass() {
+    return std::make_unique<AsyncAnalyzer>();
+}
+
 } // namespace hybrid
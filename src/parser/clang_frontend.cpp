@@ -0,0 +1,891 @@
+/**
+ * Clang AST front end
+ *
+ * Compiles each input with Clang and walks the declarations of its main
+ * file into the same IR SimpleCppParser builds. Texts the IR keeps
+ * (bodies, initializers, default arguments) are spans into the input's
+ * SourceBuffer, which is handed to Clang as the file's contents.
+ */
+
+#include "clang_frontend.h"
+#include "ir.h"
+#include "profiler.h"
+#include "source_buffer.h"
+
+#ifdef HYBRID_HAVE_CLANG
+#include "type_names.h"
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Basic/Version.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Lex/Lexer.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#endif
+
+namespace hybrid {
+
+#ifdef HYBRID_HAVE_CLANG
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * Keeps the first error, formatted as file:line:column: message
+ */
+class FirstErrorConsumer : public clang::DiagnosticConsumer {
+public:
+    void HandleDiagnostic(clang::DiagnosticsEngine::Level level, const clang::Diagnostic& info) override {
+        clang::DiagnosticConsumer::HandleDiagnostic(level, info);
+        if (level < clang::DiagnosticsEngine::Error || !first_error_.empty()) {
+            return;
+        }
+
+        if (info.hasSourceManager() && info.getLocation().isValid()) {
+            clang::PresumedLoc where = info.getSourceManager().getPresumedLoc(info.getLocation());
+            if (where.isValid()) {
+                first_error_ = std::string(where.getFilename()) + ":" + std::to_string(where.getLine()) + ":" +
+                               std::to_string(where.getColumn()) + ": ";
+            }
+        }
+        llvm::SmallString<128> message;
+        info.FormatDiagnostic(message);
+        first_error_ += std::string(message.str());
+    }
+
+    const std::string& getFirstError() const { return first_error_; }
+
+private:
+    std::string first_error_;
+};
+
+/**
+ * Driver command line for one input, and the directory it runs in
+ */
+struct CompileCommand {
+    std::vector<std::string> args;
+    std::string directory;
+};
+
+std::unique_ptr<clang::CompilerInvocation> makeInvocation(const CompileCommand& command,
+                                                          clang::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diagnostics) {
+    std::vector<const char*> argv;
+    argv.reserve(command.args.size());
+    for (const auto& arg : command.args) {
+        argv.push_back(arg.c_str());
+    }
+
+#if CLANG_VERSION_MAJOR >= 15
+    clang::CreateInvocationOptions options;
+    options.Diags = std::move(diagnostics);
+    std::unique_ptr<clang::CompilerInvocation> invocation = clang::createInvocation(argv, std::move(options));
+#else
+    std::unique_ptr<clang::CompilerInvocation> invocation =
+        clang::createInvocationFromCommandLine(argv, std::move(diagnostics));
+#endif
+    if (invocation) {
+        invocation->getFileSystemOpts().WorkingDir = command.directory;
+    }
+    return invocation;
+}
+
+/**
+ * Converts the declarations of the main file into IR
+ *
+ * Bodies are not traversed: the IR keeps them as text.
+ */
+class IRBuilder : public clang::RecursiveASTVisitor<IRBuilder> {
+public:
+    IRBuilder(clang::ASTContext& context, const std::shared_ptr<const SourceBuffer>& source, IR& ir)
+        : context_(context), sm_(context.getSourceManager()), policy_(context.getLangOpts()),
+          source_(source), ir_(ir) {
+        policy_.SuppressTagKeyword = true;
+        policy_.SuppressUnwrittenScope = true;
+        policy_.Bool = true;
+    }
+
+    bool TraverseStmt(clang::Stmt*, DataRecursionQueue* = nullptr) { return true; }
+
+    bool VisitCXXRecordDecl(clang::CXXRecordDecl* record) {
+        if (!record->isThisDeclarationADefinition() || record->isImplicit() || record->isLambda() ||
+            record->isUnion() || record->getName().empty() || record->isInvalidDecl() ||
+            !record->getDeclContext()->isFileContext() || !inMainFile(record)) {
+            return true;
+        }
+
+        ClassDecl class_decl;
+        class_decl.name = record->getNameAsString();
+        class_decl.is_struct = record->isStruct();
+        if (auto span = spanOf(outerRange(record))) {
+            class_decl.location = *span;
+        }
+
+        for (const clang::CXXBaseSpecifier& base : record->bases()) {
+            class_decl.base_classes.push_back(spell(base.getType()));
+        }
+
+        if (clang::ClassTemplateDecl* described = record->getDescribedClassTemplate()) {
+            class_decl.is_template = true;
+            class_decl.template_parameters = templateParameters(described->getTemplateParameters());
+        }
+        if (const auto* specialization = llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(record)) {
+            class_decl.specialization.is_partial =
+                llvm::isa<clang::ClassTemplatePartialSpecializationDecl>(specialization);
+            for (const clang::TemplateArgument& arg : specialization->getTemplateArgs().asArray()) {
+                class_decl.specialization.specialized_args.push_back(spellArgument(arg));
+            }
+        }
+
+        for (clang::Decl* member : record->decls()) {
+            if (member->isImplicit() || member->isInvalidDecl()) {
+                continue;
+            }
+
+            if (auto* field = llvm::dyn_cast<clang::FieldDecl>(member)) {
+                if (field->getName().empty()) continue;
+                Variable var;
+                var.name = field->getNameAsString();
+                var.type = convertType(field->getType());
+                var.is_const = field->getType().isConstQualified();
+                if (clang::Expr* init = field->getInClassInitializer()) {
+                    var.initializer = textOf(init->getSourceRange());
+                }
+                recordMember(member->getAccess(), var.name, class_decl);
+                class_decl.fields.push_back(std::move(var));
+            } else if (auto* var_decl = llvm::dyn_cast<clang::VarDecl>(member)) {
+                Variable var = convertVariable(var_decl);
+                var.is_static = true;
+                recordMember(member->getAccess(), var.name, class_decl);
+                class_decl.fields.push_back(std::move(var));
+            } else if (auto* method = llvm::dyn_cast<clang::CXXMethodDecl>(member)) {
+                recordMember(member->getAccess(), method->getNameAsString(), class_decl);
+                class_decl.methods.push_back(convertFunction(method));
+            } else if (auto* templ = llvm::dyn_cast<clang::FunctionTemplateDecl>(member)) {
+                if (auto* templated = llvm::dyn_cast<clang::CXXMethodDecl>(templ->getTemplatedDecl())) {
+                    recordMember(member->getAccess(), templated->getNameAsString(), class_decl);
+                    class_decl.methods.push_back(convertFunction(templated));
+                }
+            }
+        }
+
+        ir_.addClass(std::move(class_decl));
+        return true;
+    }
+
+    bool VisitFunctionDecl(clang::FunctionDecl* func) {
+        if (llvm::isa<clang::CXXMethodDecl>(func) || func->isImplicit() || func->isInvalidDecl() ||
+            !func->getDeclContext()->isFileContext() || !inMainFile(func)) {
+            return true;
+        }
+        // One entry per function: its definition, or its first declaration if it has none
+        if (func->isDefined() ? !func->isThisDeclarationADefinition() : !func->isFirstDecl()) {
+            return true;
+        }
+
+        ir_.addFunction(convertFunction(func));
+        return true;
+    }
+
+    bool VisitVarDecl(clang::VarDecl* var) {
+        if (llvm::isa<clang::ParmVarDecl>(var) || var->isImplicit() || var->isInvalidDecl() ||
+            !var->getDeclContext()->isFileContext() || !var->hasGlobalStorage() || !inMainFile(var) ||
+            var->isThisDeclarationADefinition() == clang::VarDecl::DeclarationOnly) {
+            return true;
+        }
+
+        ir_.addGlobalVariable(convertVariable(var));
+        return true;
+    }
+
+private:
+    clang::ASTContext& context_;
+    clang::SourceManager& sm_;
+    clang::PrintingPolicy policy_;
+    std::shared_ptr<const SourceBuffer> source_;
+    IR& ir_;
+
+    bool inMainFile(const clang::Decl* decl) const {
+        return sm_.isInMainFile(sm_.getExpansionLoc(decl->getLocation()));
+    }
+
+    /**
+     * Byte span of a token range in the main file
+     */
+    std::optional<SourceSpan> spanOf(clang::SourceRange range) const {
+        if (range.isInvalid()) {
+            return std::nullopt;
+        }
+        clang::SourceLocation begin = sm_.getExpansionLoc(range.getBegin());
+        clang::SourceLocation end = clang::Lexer::getLocForEndOfToken(sm_.getExpansionLoc(range.getEnd()), 0, sm_,
+                                                                      context_.getLangOpts());
+        if (begin.isInvalid() || end.isInvalid() || !sm_.isInMainFile(begin) || !sm_.isInMainFile(end)) {
+            return std::nullopt;
+        }
+
+        size_t offset = sm_.getFileOffset(begin);
+        size_t stop = sm_.getFileOffset(end);
+        if (stop < offset || stop > source_->size()) {
+            return std::nullopt;
+        }
+        return SourceSpan{offset, stop - offset};
+    }
+
+    SourceText textOf(clang::SourceRange range) const {
+        std::optional<SourceSpan> span = spanOf(range);
+        return span ? SourceText(source_, *span) : SourceText();
+    }
+
+    /**
+     * Range of a declaration including its template header
+     */
+    static clang::SourceRange outerRange(const clang::Decl* decl) {
+        if (const auto* record = llvm::dyn_cast<clang::CXXRecordDecl>(decl)) {
+            if (const clang::ClassTemplateDecl* described = record->getDescribedClassTemplate()) {
+                return described->getSourceRange();
+            }
+        }
+        if (const auto* func = llvm::dyn_cast<clang::FunctionDecl>(decl)) {
+            if (const clang::FunctionTemplateDecl* described = func->getDescribedFunctionTemplate()) {
+                return described->getSourceRange();
+            }
+        }
+        return decl->getSourceRange();
+    }
+
+    /**
+     * Text between the braces of a function's definition, if it is in the main file
+     */
+    SourceText bodyOf(const clang::FunctionDecl* func) const {
+        const clang::FunctionDecl* definition = nullptr;
+        const clang::Stmt* body = func->getBody(definition);
+        if (!body || !definition || !inMainFile(definition)) {
+            return SourceText();
+        }
+
+        const auto* compound = llvm::dyn_cast<clang::CompoundStmt>(body);
+        if (!compound) {
+            return textOf(body->getSourceRange());  // Function-try-block
+        }
+        clang::SourceLocation open = sm_.getExpansionLoc(compound->getLBracLoc());
+        clang::SourceLocation close = sm_.getExpansionLoc(compound->getRBracLoc());
+        if (!sm_.isInMainFile(open) || !sm_.isInMainFile(close)) {
+            return SourceText();
+        }
+        size_t begin = sm_.getFileOffset(open) + 1;
+        size_t end = sm_.getFileOffset(close);
+        if (end < begin || end > source_->size()) {
+            return SourceText();
+        }
+        return SourceText(source_, SourceSpan{begin, end - begin});
+    }
+
+    void recordMember(clang::AccessSpecifier access, const std::string& name, ClassDecl& class_decl) const {
+        ClassDecl::AccessSection::Level level = ClassDecl::AccessSection::Private;
+        if (access == clang::AS_public) {
+            level = ClassDecl::AccessSection::Public;
+        } else if (access == clang::AS_protected) {
+            level = ClassDecl::AccessSection::Protected;
+        }
+
+        auto& sections = class_decl.access_sections;
+        if (sections.empty() || sections.back().level != level) {
+            ClassDecl::AccessSection section;
+            section.level = level;
+            sections.push_back(std::move(section));
+        }
+        sections.back().members.push_back(name);
+    }
+
+    Function convertFunction(clang::FunctionDecl* func) {
+        Function function;
+        function.name = func->getNameAsString();
+        function.is_constructor = llvm::isa<clang::CXXConstructorDecl>(func);
+        function.is_destructor = llvm::isa<clang::CXXDestructorDecl>(func);
+        if (!function.is_constructor && !function.is_destructor) {
+            function.return_type = convertType(func->getReturnType());
+        }
+
+        for (clang::ParmVarDecl* param : func->parameters()) {
+            Parameter parameter;
+            parameter.name = param->getNameAsString();
+            parameter.type = convertType(param->getType());
+            if (param->hasDefaultArg()) {
+                parameter.has_default = true;
+                parameter.default_value = textOf(param->getDefaultArgRange());
+            }
+            function.parameters.push_back(std::move(parameter));
+        }
+
+        const auto* method = llvm::dyn_cast<clang::CXXMethodDecl>(func);
+        function.is_const = method && method->isConst();
+        function.is_static = method ? method->isStatic() : func->getStorageClass() == clang::SC_Static;
+        function.is_virtual = method && method->isVirtual();
+#if CLANG_VERSION_MAJOR >= 18
+        function.is_pure_virtual = func->isPureVirtual();
+#else
+        function.is_pure_virtual = func->isPure();
+#endif
+        if (const auto* proto = func->getType()->getAs<clang::FunctionProtoType>()) {
+            function.exception_spec.is_noexcept = proto->isNothrow();
+        }
+
+        if (clang::FunctionTemplateDecl* described = func->getDescribedFunctionTemplate()) {
+            function.is_template = true;
+            function.template_parameters = templateParameters(described->getTemplateParameters());
+        }
+
+        function.body = bodyOf(func);
+        if (auto span = spanOf(outerRange(func))) {
+            function.location = *span;
+        }
+        return function;
+    }
+
+    Variable convertVariable(const clang::VarDecl* var) {
+        Variable variable;
+        variable.name = var->getNameAsString();
+        variable.type = convertType(var->getType());
+        variable.is_static = var->getStorageClass() == clang::SC_Static;
+        variable.is_const = var->getType().isConstQualified();
+        if (const clang::Expr* init = var->getInit()) {
+            variable.initializer = textOf(init->getSourceRange());
+        }
+        return variable;
+    }
+
+    std::vector<TemplateParameter> templateParameters(const clang::TemplateParameterList* list) {
+        std::vector<TemplateParameter> params;
+        for (const clang::NamedDecl* decl : *list) {
+            TemplateParameter param;
+            param.name = decl->getNameAsString();
+            if (llvm::isa<clang::TemplateTypeParmDecl>(decl)) {
+                param.kind = TemplateParameter::Type;
+            } else if (const auto* non_type = llvm::dyn_cast<clang::NonTypeTemplateParmDecl>(decl)) {
+                param.kind = TemplateParameter::NonType;
+                param.param_type = convertType(non_type->getType());
+            } else {
+                param.kind = TemplateParameter::Template;
+            }
+
+            // The default is whatever follows '=' in the parameter's own text
+            std::string text(textOf(decl->getSourceRange()).view());
+            size_t equals = text.find('=');
+            if (equals != std::string::npos) {
+                size_t first = text.find_first_not_of(" \t\r\n", equals + 1);
+                param.default_value = first == std::string::npos ? std::string() : text.substr(first);
+            }
+            params.push_back(std::move(param));
+        }
+        return params;
+    }
+
+    std::string spell(clang::QualType type) const {
+        return type.getAsString(policy_);
+    }
+
+    std::string spellArgument(const clang::TemplateArgument& arg) const {
+        switch (arg.getKind()) {
+            case clang::TemplateArgument::Type:
+                return spell(arg.getAsType());
+            case clang::TemplateArgument::Integral: {
+                llvm::SmallString<16> digits;
+                arg.getAsIntegral().toString(digits);
+                return std::string(digits.str());
+            }
+            default: {
+                std::string text;
+                llvm::raw_string_ostream out(text);
+#if CLANG_VERSION_MAJOR >= 13
+                arg.print(policy_, out, /*IncludeType=*/false);
+#else
+                arg.print(policy_, out);
+#endif
+                return out.str();
+            }
+        }
+    }
+
+    std::shared_ptr<Type> convertType(clang::QualType type) {
+        if (type.isNull()) {
+            return nullptr;
+        }
+        return ir_.getTypeArena().intern(buildType(type));
+    }
+
+    std::shared_ptr<Type> makeType(TypeKind kind, std::string name, bool is_const) const {
+        auto type = std::make_shared<Type>(kind);
+        type->name = std::move(name);
+        type->is_const = is_const;
+        return type;
+    }
+
+    /**
+     * Same shapes as SimpleCppParser::buildType: const on the node itself,
+     * references and pointers carry the pointee's const, smart pointers
+     * are Pointer nodes named after the template, and standard library
+     * classes get their own kinds.
+     */
+    std::shared_ptr<Type> buildType(clang::QualType type) {
+        bool is_const = type.isConstQualified();
+
+        if (const auto* deduced = type->getAs<clang::AutoType>()) {
+            if (!deduced->getDeducedType().isNull()) {
+                return buildType(deduced->getDeducedType());
+            }
+        }
+
+        if (const auto* ref = type->getAs<clang::ReferenceType>()) {
+            clang::QualType pointee = ref->getPointeeType();
+            auto node = makeType(TypeKind::Reference,
+                                 spell(pointee.getUnqualifiedType()) + (ref->isRValueReferenceType() ? "&&" : "&"),
+                                 pointee.isConstQualified());
+            node->element_type = convertType(pointee.getUnqualifiedType());
+            return node;
+        }
+        if (const auto* ptr = type->getAs<clang::PointerType>()) {
+            clang::QualType pointee = ptr->getPointeeType();
+            auto node = makeType(TypeKind::Pointer, spell(pointee.getUnqualifiedType()) + "*",
+                                 pointee.isConstQualified());
+            node->element_type = convertType(pointee.getUnqualifiedType());
+            return node;
+        }
+        if (const clang::ArrayType* array = context_.getAsArrayType(type)) {
+            std::string extent;
+            if (const auto* constant = llvm::dyn_cast<clang::ConstantArrayType>(array)) {
+                extent = std::to_string(constant->getSize().getZExtValue());
+            }
+            clang::QualType element = array->getElementType();
+            auto node = makeType(TypeKind::Array, spell(element) + "[" + extent + "]", is_const);
+            node->element_type = convertType(element);
+            return node;
+        }
+
+        // Builtins by their written name first, so size_t and int32_t survive
+        std::string spelling = spell(type.getUnqualifiedType());
+        std::string_view unqualified = spelling;
+        if (unqualified.substr(0, 5) == "std::") {
+            unqualified.remove_prefix(5);
+        }
+        if (const BuiltinTypeName* builtin = findBuiltinType(unqualified)) {
+            return makeType(builtin->kind, std::string(unqualified), is_const);
+        }
+        if (type->isBuiltinType()) {
+            std::string canonical = spell(type.getCanonicalType().getUnqualifiedType());
+            if (const BuiltinTypeName* builtin = findBuiltinType(canonical)) {
+                return makeType(builtin->kind, canonical, is_const);
+            }
+            TypeKind kind = type->isVoidType() ? TypeKind::Void
+                          : type->isBooleanType() ? TypeKind::Bool
+                          : type->isFloatingType() ? TypeKind::Float
+                          : TypeKind::Integer;
+            return makeType(kind, canonical, is_const);
+        }
+
+        if (auto node = buildStdType(type, is_const)) {
+            return node;
+        }
+
+        if (type->isEnumeralType()) {
+            return makeType(TypeKind::Enum, spelling, is_const);
+        }
+        return makeType(TypeKind::Class, spelling, is_const);
+    }
+
+    /**
+     * Standard library classes and templates (std::vector<T>, std::mutex,
+     * std::unique_ptr<T>), written or reached through a typedef
+     */
+    std::shared_ptr<Type> buildStdType(clang::QualType type, bool is_const) {
+        std::string name;
+        llvm::ArrayRef<clang::TemplateArgument> args;
+        if (const auto* specialization = type->getAs<clang::TemplateSpecializationType>()) {
+            const clang::TemplateDecl* templ = specialization->getTemplateName().getAsTemplateDecl();
+            if (templ && templ->isInStdNamespace()) {
+                name = templ->getNameAsString();
+                args = specialization->template_arguments();
+            }
+        }
+        if (name.empty()) {
+            const clang::CXXRecordDecl* record = type->getAsCXXRecordDecl();
+            if (!record || !record->isInStdNamespace()) {
+                return nullptr;
+            }
+            name = record->getNameAsString();
+            if (const auto* instance = llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(record)) {
+                args = instance->getTemplateArgs().asArray();
+            }
+        }
+
+        std::vector<clang::QualType> type_args;
+        for (const clang::TemplateArgument& arg : args) {
+            if (arg.getKind() == clang::TemplateArgument::Type) {
+                type_args.push_back(arg.getAsType());
+            }
+        }
+
+        if (name == "unique_ptr" || name == "shared_ptr" || name == "weak_ptr") {
+            if (type_args.empty()) {
+                return nullptr;
+            }
+            auto node = makeType(TypeKind::Pointer, "std::" + name + "<" + spell(type_args[0]) + ">", is_const);
+            node->element_type = convertType(type_args[0]);
+            return node;
+        }
+
+        TypeKind kind = findSTLTypeKind(name == "basic_string" ? "string" : name);
+        if (kind == TypeKind::Template) {
+            return nullptr;
+        }
+        auto node = makeType(kind, "std::" + (name == "basic_string" ? std::string("string") : name), is_const);
+        for (size_t i = 0; i < type_args.size() && i < stdTemplateArity(kind); ++i) {
+            node->template_args.push_back(convertType(type_args[i]));
+        }
+        return node;
+    }
+};
+
+/**
+ * Collects the main file's top-level declarations while parsing and
+ * converts them once the translation unit is complete
+ */
+class IRConsumer : public clang::ASTConsumer {
+public:
+    IRConsumer(const std::shared_ptr<const SourceBuffer>& source, IR& ir) : source_(source), ir_(ir) {}
+
+    void Initialize(clang::ASTContext& context) override { context_ = &context; }
+
+    bool HandleTopLevelDecl(clang::DeclGroupRef group) override {
+        for (clang::Decl* decl : group) {
+            if (inMainFile(decl)) {
+                decls_.push_back(decl);
+            }
+        }
+        return true;
+    }
+
+    // Only the main file's bodies reach the IR; headers just need signatures
+    bool shouldSkipFunctionBody(clang::Decl* decl) override {
+        return !inMainFile(decl);
+    }
+
+    void HandleTranslationUnit(clang::ASTContext& context) override {
+        if (context.getDiagnostics().hasErrorOccurred()) {
+            return;
+        }
+        IRBuilder builder(context, source_, ir_);
+        for (clang::Decl* decl : decls_) {
+            builder.TraverseDecl(decl);
+        }
+    }
+
+private:
+    std::shared_ptr<const SourceBuffer> source_;
+    IR& ir_;
+    clang::ASTContext* context_ = nullptr;
+    std::vector<clang::Decl*> decls_;
+
+    bool inMainFile(const clang::Decl* decl) const {
+        const clang::SourceManager& sm = context_->getSourceManager();
+        return sm.isInMainFile(sm.getExpansionLoc(decl->getLocation()));
+    }
+};
+
+class IRAction : public clang::ASTFrontendAction {
+public:
+    IRAction(const std::shared_ptr<const SourceBuffer>& source, IR& ir) : source_(source), ir_(ir) {}
+
+protected:
+    std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance&, llvm::StringRef) override {
+        return std::make_unique<IRConsumer>(source_, ir_);
+    }
+
+private:
+    std::shared_ptr<const SourceBuffer> source_;
+    IR& ir_;
+};
+
+} // namespace
+
+/**
+ * A precompiled #include block and the virtual header it was built from
+ */
+struct Preamble {
+    std::string pch_path;       // Empty if precompiling failed
+    std::string header_path;
+    std::string text;
+    unsigned size = 0;                  // Bytes of the main file the PCH stands for
+    bool ends_at_start_of_line = false;
+};
+
+struct ClangFrontEnd::State {
+    std::mutex mutex;
+    bool fixed_loaded = false;
+    std::unique_ptr<clang::tooling::CompilationDatabase> fixed_database;   // From compile_commands_dir
+    std::unordered_map<std::string, std::unique_ptr<clang::tooling::CompilationDatabase>> databases;  // Per input directory
+    std::unordered_map<std::string, std::shared_future<Preamble>> preambles;  // Command + block -> PCH
+    fs::path pch_dir;
+    size_t built = 0;
+
+    ~State() {
+        if (!pch_dir.empty()) {
+            std::error_code ec;
+            fs::remove_all(pch_dir, ec);
+        }
+    }
+
+    CompileCommand commandFor(const std::string& path, const ClangFrontEndOptions& options);
+    Preamble preambleFor(const CompileCommand& command, const std::string& path, std::string_view text);
+    Preamble buildPreamble(const CompileCommand& command, Preamble preamble);
+};
+
+CompileCommand ClangFrontEnd::State::commandFor(const std::string& path, const ClangFrontEndOptions& options) {
+    CompileCommand command;
+    {
+        // Databases are loaded once and shared; lookups may read files, so they are serialized too
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string error;
+        clang::tooling::CompilationDatabase* database = nullptr;
+        if (!options.compile_commands_dir.empty()) {
+            if (!fixed_loaded) {
+                fixed_database = clang::tooling::CompilationDatabase::loadFromDirectory(options.compile_commands_dir, error);
+                fixed_loaded = true;
+            }
+            database = fixed_database.get();
+        } else {
+            std::string dir = fs::path(path).parent_path().string();
+            auto it = databases.find(dir);
+            if (it == databases.end()) {
+                it = databases.emplace(dir, clang::tooling::CompilationDatabase::autoDetectFromDirectory(dir, error)).first;
+            }
+            database = it->second.get();
+        }
+
+        if (database) {
+            std::vector<clang::tooling::CompileCommand> found = database->getCompileCommands(path);
+            if (!found.empty()) {
+                command.args = found.front().CommandLine;
+                command.directory = found.front().Directory;
+            }
+        }
+    }
+
+    if (command.args.empty()) {
+        command.args = {"clang++", "-std=c++17", path};
+        command.directory = fs::current_path().string();
+    }
+
+    clang::tooling::ArgumentsAdjuster adjust = clang::tooling::combineAdjusters(
+        clang::tooling::getClangStripOutputAdjuster(), clang::tooling::getClangStripDependencyFileAdjuster());
+    adjust = clang::tooling::combineAdjusters(adjust, clang::tooling::getClangSyntaxOnlyAdjuster());
+    adjust = clang::tooling::combineAdjusters(
+        adjust, clang::tooling::getInsertArgumentAdjuster(options.extra_args, clang::tooling::ArgumentInsertPosition::END));
+    command.args = adjust(command.args, path);
+    return command;
+}
+
+Preamble ClangFrontEnd::State::preambleFor(const CompileCommand& command, const std::string& path,
+                                           std::string_view text) {
+    clang::LangOptions lang;
+    lang.CPlusPlus = 1;
+    lang.CPlusPlus11 = 1;
+    lang.CPlusPlus14 = 1;
+    lang.CPlusPlus17 = 1;
+    clang::PreambleBounds bounds = clang::Lexer::ComputePreamble(llvm::StringRef(text.data(), text.size()), lang);
+
+    Preamble preamble;
+    preamble.text = std::string(text.substr(0, bounds.Size));
+    preamble.size = bounds.Size;
+    preamble.ends_at_start_of_line = bounds.PreambleEndsAtStartOfLine;
+    if (preamble.text.find("#include") == std::string::npos) {
+        return Preamble();
+    }
+
+    // Quoted includes resolve next to the including file, so the block is
+    // compiled as a (virtual) header in the input's directory
+    std::string dir = fs::path(path).parent_path().string();
+    std::string key = dir;
+    key += '\0';
+    key += command.directory;
+    for (const auto& arg : command.args) {
+        if (arg != path) {
+            key += '\0';
+            key += arg;
+        }
+    }
+    key += '\0';
+    key += preamble.text;
+
+    std::promise<Preamble> promise;
+    std::shared_future<Preamble> ready;
+    bool build = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = preambles.find(key);
+        if (it != preambles.end()) {
+            ready = it->second;
+        } else {
+            if (pch_dir.empty()) {
+                std::random_device random;
+                pch_dir = fs::temp_directory_path() / ("hybrid-pch-" + std::to_string(random()));
+            }
+            std::string id = std::to_string(built++);
+            preamble.header_path = (fs::path(dir) / (".hybrid-preamble-" + id + ".h")).string();
+            preamble.pch_path = (pch_dir / ("preamble-" + id + ".pch")).string();
+            ready = promise.get_future().share();
+            preambles.emplace(std::move(key), ready);
+            build = true;
+        }
+    }
+
+    // Inputs with the same block wait for the first one to finish it
+    if (build) {
+        promise.set_value(buildPreamble(command, std::move(preamble)));
+    }
+    return ready.get();
+}
+
+Preamble ClangFrontEnd::State::buildPreamble(const CompileCommand& command, Preamble preamble) {
+    ProfileScope scope("parse", "clang_preamble", preamble.header_path, preamble.text.size());
+    std::error_code ec;
+    fs::create_directories(fs::path(preamble.pch_path).parent_path(), ec);
+
+    FirstErrorConsumer errors;
+    auto diagnostics = clang::CompilerInstance::createDiagnostics(new clang::DiagnosticOptions(), &errors, false);
+    std::shared_ptr<clang::CompilerInvocation> invocation = makeInvocation(command, diagnostics);
+    if (!invocation) {
+        preamble.pch_path.clear();
+        return preamble;
+    }
+
+    clang::FrontendOptions& frontend = invocation->getFrontendOpts();
+    frontend.Inputs.clear();
+    frontend.Inputs.emplace_back(preamble.header_path, clang::InputKind(clang::Language::CXX).getHeader());
+    frontend.OutputFile = preamble.pch_path;
+    frontend.ProgramAction = clang::frontend::GeneratePCH;
+    frontend.SkipFunctionBodies = true;     // Headers only contribute signatures
+    invocation->getPreprocessorOpts().addRemappedFile(
+        preamble.header_path, llvm::MemoryBuffer::getMemBufferCopy(preamble.text, preamble.header_path).release());
+
+    clang::CompilerInstance compiler;
+    compiler.setInvocation(std::move(invocation));
+    compiler.createDiagnostics(&errors, false);
+    clang::GeneratePCHAction action;
+    if (!compiler.ExecuteAction(action) || compiler.getDiagnostics().hasErrorOccurred()) {
+        // Inputs of this block fall back to parsing their headers themselves
+        fs::remove(preamble.pch_path, ec);
+        preamble.pch_path.clear();
+    }
+    return preamble;
+}
+
+ClangFrontEnd::ClangFrontEnd(ClangFrontEndOptions options)
+    : options_(std::move(options)), state_(std::make_unique<State>()) {
+}
+
+ClangFrontEnd::~ClangFrontEnd() = default;
+
+bool ClangFrontEnd::isAvailable() {
+    return true;
+}
+
+bool ClangFrontEnd::parse(const std::shared_ptr<const SourceBuffer>& source, IR& ir, std::string& error) {
+    std::error_code ec;
+    std::string path = source->getPath().empty() ? "input.cpp" : source->getPath();
+    path = fs::absolute(path, ec).lexically_normal().string();
+    ProfileScope scope("parse", "clang", path, source->size());
+
+    CompileCommand command = state_->commandFor(path, options_);
+    Preamble preamble;
+    if (options_.share_preambles) {
+        preamble = state_->preambleFor(command, path, source->text());
+    }
+
+    FirstErrorConsumer errors;
+    auto diagnostics = clang::CompilerInstance::createDiagnostics(new clang::DiagnosticOptions(), &errors, false);
+    std::shared_ptr<clang::CompilerInvocation> invocation = makeInvocation(command, diagnostics);
+    if (!invocation) {
+        error = errors.getFirstError().empty() ? "Cannot build a compile command for " + path : errors.getFirstError();
+        return false;
+    }
+
+    // Clang reads the buffer the IR's spans point into, not the file on disk
+    std::string_view text = source->text();
+    clang::PreprocessorOptions& preprocessor = invocation->getPreprocessorOpts();
+    preprocessor.addRemappedFile(
+        path, llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(text.data(), text.size()), path, false).release());
+    if (!preamble.pch_path.empty()) {
+        preprocessor.ImplicitPCHInclude = preamble.pch_path;
+        // The main file's block is in the PCH; reading it again would include each header twice
+        preprocessor.PrecompiledPreambleBytes = {preamble.size, preamble.ends_at_start_of_line};
+        preprocessor.addRemappedFile(preamble.header_path,
+                                     llvm::MemoryBuffer::getMemBufferCopy(preamble.text, preamble.header_path).release());
+        // The preamble's header exists only in memory; it cannot change during a batch
+#if CLANG_VERSION_MAJOR >= 13
+        preprocessor.DisablePCHOrModuleValidation = clang::DisableValidationForModuleKind::PCH;
+#else
+        preprocessor.DisablePCHValidation = true;
+#endif
+    }
+    invocation->getFrontendOpts().SkipFunctionBodies = true;   // IRConsumer keeps the main file's
+
+    clang::CompilerInstance compiler;
+    compiler.setInvocation(std::move(invocation));
+    compiler.createDiagnostics(&errors, false);
+
+    IR parsed;
+    IRAction action(source, parsed);
+    if (!compiler.ExecuteAction(action) || compiler.getDiagnostics().hasErrorOccurred()) {
+        error = errors.getFirstError().empty() ? "Clang could not compile " + path : errors.getFirstError();
+        return false;
+    }
+
+    parsed.setSource(source);
+    ir = std::move(parsed);
+    return true;
+}
+
+size_t ClangFrontEnd::getPreambleCount() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->built;
+}
+
+#else
+
+struct ClangFrontEnd::State {};
+
+ClangFrontEnd::ClangFrontEnd(ClangFrontEndOptions options) : options_(std::move(options)) {
+}
+
+ClangFrontEnd::~ClangFrontEnd() = default;
+
+bool ClangFrontEnd::isAvailable() {
+    return false;
+}
+
+bool ClangFrontEnd::parse(const std::shared_ptr<const SourceBuffer>&, IR&, std::string& error) {
+    error = "This build has no Clang front end (rebuild with Clang development files)";
+    return false;
+}
+
+size_t ClangFrontEnd::getPreambleCount() const {
+    return 0;
+}
+
+#endif
+
+} // namespace hybrid
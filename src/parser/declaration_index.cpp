@@ -0,0 +1,238 @@
+#include "declaration_index.h"
+#include "lexer.h"
+#include "parser.h"
+#include "profiler.h"
+#include <stdexcept>
+#include <unordered_set>
+
+namespace hybrid {
+
+namespace {
+
+/**
+ * Significant-token cursor over a streaming lexer; copying it saves a
+ * position to backtrack to
+ */
+class Cursor {
+public:
+    explicit Cursor(std::string_view source) : lexer_(source) { advance(); }
+
+    const Token& token() const { return token_; }
+    bool done() const { return token_.kind == TokenKind::EndOfFile; }
+
+    void advance() {
+        // Preprocessor lines are invisible to the parser as well
+        do {
+            if (!lexer_.next(token_, false)) {
+                token_ = Token();
+                return;
+            }
+        } while (token_.kind == TokenKind::Preprocessor);
+    }
+
+private:
+    Lexer lexer_;
+    Token token_;
+};
+
+/**
+ * Advance from an opening ( [ { to its matching closer, pairing brackets
+ * the way the parser does (unbalanced openers are dropped)
+ * @return false if the opener has no match
+ */
+bool skipGroup(Cursor& cursor) {
+    std::vector<char> open{cursor.token().text[0]};
+    for (;;) {
+        cursor.advance();
+        if (cursor.done()) return false;
+
+        const Token& t = cursor.token();
+        if (t.kind != TokenKind::Punct || t.length != 1) continue;
+
+        char c = t.text[0];
+        if (c == '(' || c == '[' || c == '{') {
+            open.push_back(c);
+        } else if (c == ')' || c == ']' || c == '}') {
+            char expected = (c == ')') ? '(' : (c == ']') ? '[' : '{';
+            while (!open.empty() && open.back() != expected) {
+                open.pop_back();
+            }
+            if (open.empty()) return false;
+            open.pop_back();
+            if (open.empty()) return true;
+        }
+    }
+}
+
+/**
+ * Skip a balanced <...> group starting at '<'; on success the cursor is
+ * after the '>'. Mirrors the parser's skipAngles().
+ */
+bool skipAngles(Cursor& cursor) {
+    int depth = 0;
+    while (!cursor.done()) {
+        const Token& t = cursor.token();
+        if (t.isPunct("<")) {
+            depth++;
+        } else if (t.isPunct(">")) {
+            if (--depth == 0) {
+                cursor.advance();
+                return true;
+            }
+        } else if (t.isPunct("(") || t.isPunct("[")) {
+            Cursor saved = cursor;
+            if (!skipGroup(cursor)) {
+                cursor = saved;     // Unmatched: step over the opener only
+            }
+        } else if (t.isPunct(";") || t.isPunct("{")) {
+            return false;
+        }
+        cursor.advance();
+    }
+    return false;
+}
+
+bool isBaseSpecifier(const Token& t) {
+    return t.isIdentifier("public") || t.isIdentifier("protected") ||
+           t.isIdentifier("private") || t.isIdentifier("virtual");
+}
+
+} // namespace
+
+DeclarationIndex::DeclarationIndex(std::shared_ptr<const SourceBuffer> buffer)
+    : buffer_(std::move(buffer)) {
+    ProfileScope scope("index", "scan", buffer_->getPath(), buffer_->size());
+    scan();
+}
+
+void DeclarationIndex::scan() {
+    std::string_view source = buffer_->text();
+    Cursor cursor(source);
+    bool after_enum = false;
+    size_t template_begin = 0;      // Offset of the template header of...
+    size_t template_class = static_cast<size_t>(-1);   // ...the 'class' keyword at this offset
+
+    // Same acceptance rules as SimpleCppParser::parseClass: a failed
+    // candidate resumes right after its 'class' keyword
+    while (!cursor.done()) {
+        const Token& keyword = cursor.token();
+        if (keyword.isIdentifier("template")) {
+            Cursor header = cursor;
+            header.advance();
+            if (header.token().isPunct("<") && skipAngles(header) && header.token().isIdentifier("class")) {
+                template_begin = keyword.offset;
+                template_class = header.token().offset;
+            }
+        }
+        if (!keyword.isIdentifier("class") || after_enum) {
+            after_enum = keyword.isIdentifier("enum");
+            cursor.advance();
+            continue;
+        }
+
+        Cursor attempt = cursor;
+        DeclarationEntry entry;
+        size_t begin = keyword.offset == template_class ? template_begin : keyword.offset;
+        entry.line = keyword.line;
+        bool accepted = false;
+
+        attempt.advance();
+        if (attempt.token().kind == TokenKind::Identifier) {
+            entry.name = std::string(attempt.token().text);
+            attempt.advance();
+
+            bool ok = true;
+            if (attempt.token().isPunct("<")) {
+                ok = skipAngles(attempt);
+            }
+            if (ok && attempt.token().isIdentifier("final")) {
+                attempt.advance();
+            }
+
+            if (ok && attempt.token().isPunct(":")) {
+                attempt.advance();
+                size_t first = 0;
+                size_t last_end = 0;
+                bool in_name = false;
+                bool name_closed = false;
+                auto finishBase = [&]() {
+                    if (in_name && last_end > first) {
+                        entry.bases.emplace_back(source.substr(first, last_end - first));
+                    }
+                    in_name = false;
+                    name_closed = false;
+                };
+
+                while (!attempt.done() && !attempt.token().isPunct("{") && !attempt.token().isPunct(";")) {
+                    const Token& t = attempt.token();
+                    if (t.isPunct("<")) {
+                        name_closed = true;
+                        Cursor saved = attempt;
+                        if (!skipAngles(attempt)) {
+                            attempt = saved;
+                            attempt.advance();
+                        }
+                        continue;
+                    }
+                    if (t.isPunct(",")) {
+                        finishBase();
+                    } else if (!name_closed && !(isBaseSpecifier(t) && !in_name)) {
+                        if (!in_name) {
+                            first = t.offset;
+                            in_name = true;
+                        }
+                        last_end = t.end();
+                    }
+                    attempt.advance();
+                }
+                finishBase();
+            }
+
+            if (ok && attempt.token().isPunct("{") && skipGroup(attempt)) {
+                entry.span = SourceSpan{begin, attempt.token().end() - begin};
+                accepted = true;
+            }
+        }
+
+        if (accepted) {
+            by_name_.emplace(entry.name, entries_.size());
+            entries_.push_back(std::move(entry));
+            cursor = attempt;
+            after_enum = false;
+        } else {
+            after_enum = false;     // 'class' itself is the previous token now
+        }
+        cursor.advance();
+    }
+}
+
+const DeclarationEntry* DeclarationIndex::find(const std::string& name) const {
+    auto it = by_name_.find(name);
+    return it != by_name_.end() ? &entries_[it->second] : nullptr;
+}
+
+IR DeclarationIndex::parseDeclaration(const std::string& name) const {
+    const DeclarationEntry* entry = find(name);
+    if (!entry) {
+        throw std::runtime_error("No class named '" + name + "' in " +
+                                 (buffer_->getPath().empty() ? std::string("source") : buffer_->getPath()));
+    }
+
+    // The class first, then every base reachable through the index
+    std::vector<SourceSpan> spans;
+    std::unordered_set<const DeclarationEntry*> visited{entry};
+    std::vector<const DeclarationEntry*> pending{entry};
+    for (size_t i = 0; i < pending.size(); ++i) {
+        spans.push_back(pending[i]->span);
+        for (const auto& base_name : pending[i]->bases) {
+            const DeclarationEntry* base = find(base_name);
+            if (base && visited.insert(base).second) {
+                pending.push_back(base);
+            }
+        }
+    }
+
+    return Parser::parseSpans(buffer_, spans);
+}
+
+} // namespace hybrid
@@ -3,9 +3,9 @@
  * Analyzes C++ exception handling and prepares for conversion to Result/error
  */
 
-#include "ir.h"
-#include <regex>
+#include "analysis_pass.h"
 #include <algorithm>
+#include <map>
 
 namespace hybrid {
 
@@ -13,17 +13,39 @@ namespace hybrid {
  * Exception Analyzer
  * Detects and analyzes try-catch blocks, throw statements, and exception specifications
  */
-class ExceptionAnalyzer {
+class ExceptionAnalyzer : public AnalysisPass {
 public:
     /**
      * Analyze function body for exception handling patterns
      */
     void analyzeFunction(Function& func) {
-        // Detect try-catch blocks
-        detectTryCatchBlocks(func);
+        AnalysisPassManager::runPass(*this, func);
+    }
+
+    const char* name() const override { return "exception"; }
+
+    std::vector<std::string_view> interests() const override {
+        return {"try", "throw"};
+    }
+
+    void beginFunction(Function& func) override {
+        (void)func;
+        saw_throw_ = false;
+    }
+
+    void onToken(const BodyScan& scan, size_t index, Function& func) override {
+        if (scan.at(index).text == "try") {
+            detectTryCatchBlock(scan, index, func);
+        } else {
+            saw_throw_ = true;
+        }
+    }
 
-        // Detect throw statements
-        detectThrowStatements(func);
+    void endFunction(Function& func) override {
+        // Throw statements
+        if (saw_throw_) {
+            func.exception_spec.can_throw = true;
+        }
 
         // Analyze exception specification
         analyzeExceptionSpec(func);
@@ -31,95 +53,84 @@ public:
         // Determine if function may throw
         func.may_throw = func.exception_spec.can_throw ||
                          !func.try_catch_blocks.empty() ||
-                         containsThrowStatement(func.body);
+                         saw_throw_;
     }
 
 private:
+    bool saw_throw_ = false;
+
     /**
-     * Detect try-catch blocks in function body
+     * Detect a try block and its catch clauses: try { ... } catch (...) { ... } ...
      */
-    void detectTryCatchBlocks(Function& func) {
-        std::string body = func.body;
-
-        // Simple pattern matching for try-catch blocks
-        // In real implementation, would use Clang AST
-        std::regex try_catch_pattern(
-            R"(try\s*\{([^}]*)\}\s*catch\s*\(([^)]+)\)\s*\{([^}]*)\})"
-        );
+    void detectTryCatchBlock(const BodyScan& scan, size_t index, Function& func) {
+        size_t try_close = scan.matching(index + 1);
+        if (!scan.at(index + 1).isPunct("{") || try_close == BodyScan::npos) return;
 
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
+        TryCatchBlock block;
+        block.try_body = scan.sliceBetween(index + 1, try_close);
 
-        while (std::regex_search(search_start, body.cend(), match, try_catch_pattern)) {
-            TryCatchBlock block;
-            block.try_body = match[1].str();
+        size_t pos = try_close + 1;
+        while (scan.at(pos).isIdentifier("catch") && scan.at(pos + 1).isPunct("(")) {
+            size_t param_close = scan.matching(pos + 1);
+            if (param_close == BodyScan::npos || !scan.at(param_close + 1).isPunct("{")) break;
+            size_t handler_close = scan.matching(param_close + 1);
+            if (handler_close == BodyScan::npos) break;
 
-            // Parse catch clause
             TryCatchBlock::CatchClause clause;
-            std::string catch_param = match[2].str();
-            clause.handler_body = match[3].str();
+            parseCatchParameter(scan, pos + 1, param_close, clause.exception_type, clause.exception_var);
+            clause.handler_body = scan.sliceBetween(param_close + 1, handler_close);
+            block.catch_clauses.push_back(std::move(clause));
 
-            // Parse exception type and variable
-            // Format: "const Type& var" or "Type var" or "..."
-            parseCatchParameter(catch_param, clause.exception_type, clause.exception_var);
-
-            block.catch_clauses.push_back(clause);
-            func.try_catch_blocks.push_back(block);
+            pos = handler_close + 1;
+        }
 
-            search_start = match.suffix().first;
+        if (!block.catch_clauses.empty()) {
+            func.try_catch_blocks.push_back(std::move(block));
         }
     }
 
     /**
      * Parse catch parameter to extract type and variable name
+     * Format: "const Type& var" or "Type var" or "..."
      */
-    void parseCatchParameter(const std::string& param,
-                            std::string& type,
-                            std::string& var) {
-        if (param == "...") {
+    void parseCatchParameter(const BodyScan& scan, size_t open, size_t close,
+                             std::string& type, std::string& var) {
+        if (close == open + 2 && scan.at(open + 1).isPunct("...")) {
             type = "...";  // catch-all
             var = "";
             return;
         }
 
         // Remove const, &, etc.
-        std::string cleaned = param;
-        cleaned = std::regex_replace(cleaned, std::regex(R"(\s*const\s*)"), " ");
-        cleaned = std::regex_replace(cleaned, std::regex(R"(\s*&\s*)"), " ");
-        cleaned = std::regex_replace(cleaned, std::regex(R"(\s+)"), " ");
-
-        // Split into type and variable
-        size_t last_space = cleaned.find_last_of(' ');
-        if (last_space != std::string::npos) {
-            type = cleaned.substr(0, last_space);
-            var = cleaned.substr(last_space + 1);
-        } else {
-            type = cleaned;
-            var = "e";  // default variable name
+        std::vector<const Token*> parts;
+        for (size_t i = open + 1; i < close; ++i) {
+            const Token& t = scan.at(i);
+            if (!t.isIdentifier("const") && !t.isPunct("&")) {
+                parts.push_back(&t);
+            }
         }
 
-        // Trim whitespace
-        type.erase(0, type.find_first_not_of(" \t\n"));
-        type.erase(type.find_last_not_of(" \t\n") + 1);
-        var.erase(0, var.find_first_not_of(" \t\n"));
-        var.erase(var.find_last_not_of(" \t\n") + 1);
-    }
+        // A trailing identifier after another name is the variable
+        var = "e";  // default variable name
+        if (parts.size() >= 2 && parts.back()->kind == TokenKind::Identifier &&
+            !parts[parts.size() - 2]->isPunct("::")) {
+            var = std::string(parts.back()->text);
+            parts.pop_back();
+        }
 
-    /**
-     * Detect throw statements in function body
-     */
-    void detectThrowStatements(Function& func) {
-        std::regex throw_pattern(R"(throw\s+)");
-        if (std::regex_search(func.body, throw_pattern)) {
-            func.exception_spec.can_throw = true;
+        type.clear();
+        const Token* previous = nullptr;
+        for (const Token* part : parts) {
+            if (previous && isWord(*previous) && isWord(*part)) {
+                type += ' ';
+            }
+            type.append(part->text);
+            previous = part;
         }
     }
 
-    /**
-     * Check if body contains throw statement
-     */
-    bool containsThrowStatement(const std::string& body) {
-        return body.find("throw ") != std::string::npos;
+    static bool isWord(const Token& token) {
+        return token.kind == TokenKind::Identifier || token.kind == TokenKind::Number;
     }
 
     /**
@@ -187,7 +198,7 @@ public:
     /**
      * Get Go error type for C++ exception
      */
-    static std::string getGoErrorType(const std::string& exception_type) {
+    static std::string getGoErrorType(const std::string& /*exception_type*/) {
         // Go uses 'error' interface for all errors
         return "error";
     }
@@ -238,4 +249,8 @@ public:
     }
 };
 
+std::unique_ptr<AnalysisPass> createExceptionAnalysisPass() {
+    return std::make_unique<ExceptionAnalyzer>();
+}
+
 } // namespace hybrid
@@ -0,0 +1,354 @@
+/**
+ * C++ Lexer
+ * Single-pass tokenizer feeding SimpleCppParser
+ */
+
+#include "lexer.h"
+#include <cctype>
+
+// Comment, literal and directive bodies are skipped 16 bytes at a time.
+// SSE2 is part of x86-64 and NEON of AArch64, so neither needs a runtime check.
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HYBRID_LEXER_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HYBRID_LEXER_NEON 1
+#endif
+
+namespace hybrid {
+
+namespace {
+
+constexpr size_t kBlock = 16;
+
+#if defined(HYBRID_LEXER_SSE2)
+
+// Bit i set when byte i of the block equals a, b or c
+inline uint32_t blockMatches(const char* p, char a, char b, char c) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(a)),
+                                             _mm_cmpeq_epi8(block, _mm_set1_epi8(b))),
+                                _mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(hits));
+}
+
+inline size_t firstMatch(uint32_t mask) { return static_cast<size_t>(__builtin_ctz(mask)); }
+inline uint32_t matchCount(uint32_t mask) { return static_cast<uint32_t>(__builtin_popcount(mask)); }
+
+#elif defined(HYBRID_LEXER_NEON)
+
+// Four mask bits per byte (NEON has no movemask)
+inline uint64_t blockMatches(const char* p, char a, char b, char c) {
+    uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(block, vdupq_n_u8(static_cast<uint8_t>(a))),
+                                        vceqq_u8(block, vdupq_n_u8(static_cast<uint8_t>(b)))),
+                               vceqq_u8(block, vdupq_n_u8(static_cast<uint8_t>(c))));
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+}
+
+inline size_t firstMatch(uint64_t mask) { return static_cast<size_t>(__builtin_ctzll(mask)) / 4; }
+inline uint32_t matchCount(uint64_t mask) { return static_cast<uint32_t>(__builtin_popcountll(mask)) / 4; }
+
+#endif
+
+/**
+ * Offset of the first byte in [pos, end) equal to a, b or c; end if none
+ */
+size_t findAny(const char* data, size_t pos, size_t end, char a, char b, char c) {
+#if defined(HYBRID_LEXER_SSE2) || defined(HYBRID_LEXER_NEON)
+    for (; pos + kBlock <= end; pos += kBlock) {
+        auto mask = blockMatches(data + pos, a, b, c);
+        if (mask) {
+            return pos + firstMatch(mask);
+        }
+    }
+#endif
+    for (; pos < end; ++pos) {
+        char ch = data[pos];
+        if (ch == a || ch == b || ch == c) {
+            return pos;
+        }
+    }
+    return end;
+}
+
+/**
+ * Number of newlines in data[0, length)
+ */
+uint32_t countNewlines(const char* data, size_t length) {
+    uint32_t count = 0;
+    size_t i = 0;
+#if defined(HYBRID_LEXER_SSE2) || defined(HYBRID_LEXER_NEON)
+    for (; i + kBlock <= length; i += kBlock) {
+        count += matchCount(blockMatches(data + i, '\n', '\n', '\n'));
+    }
+#endif
+    for (; i < length; ++i) {
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+bool isIdentStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+bool isIdentChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+} // namespace
+
+std::vector<Token> Lexer::tokenize(bool keep_comments) {
+    std::vector<Token> tokens;
+    // Rough estimate to avoid repeated reallocation on large inputs
+    tokens.reserve((end_ - begin_) / 4 + 1);
+
+    pos_ = begin_;
+    line_ = first_line_;
+    at_line_start_ = true;
+
+    Token token;
+    while (next(token, keep_comments)) {
+        tokens.push_back(token);
+    }
+
+    Token eof;
+    eof.kind = TokenKind::EndOfFile;
+    eof.offset = end_;
+    eof.line = line_;
+    tokens.push_back(eof);
+
+    return tokens;
+}
+
+bool Lexer::next(Token& token, bool keep_comments) {
+    while (pos_ < end_) {
+        char c = peek();
+
+        // Whitespace
+        if (c == '\n') {
+            advance();
+            at_line_start_ = true;
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            advance();
+            continue;
+        }
+
+        size_t start = pos_;
+        uint32_t line = line_;
+
+        // Comments
+        if (c == '/' && peek(1) == '/') {
+            skipLineComment();
+            if (!keep_comments) continue;
+            token = makeToken(TokenKind::Comment, start, line);
+            return true;
+        }
+        if (c == '/' && peek(1) == '*') {
+            skipBlockComment();
+            if (!keep_comments) continue;
+            token = makeToken(TokenKind::Comment, start, line);
+            return true;
+        }
+
+        // Preprocessor directives only start a line
+        if (c == '#' && at_line_start_) {
+            skipPreprocessorLine();
+            token = makeToken(TokenKind::Preprocessor, start, line);
+            return true;
+        }
+
+        at_line_start_ = false;
+
+        if (isIdentStart(c)) {
+            skipIdentifier();
+            std::string_view ident = source_.substr(start, pos_ - start);
+
+            // Encoding prefixes and raw strings: u8"...", L'x', R"(...)"
+            if (peek() == '"' && isStringPrefix(ident)) {
+                if (ident.back() == 'R') {
+                    skipRawString();
+                } else {
+                    skipQuoted('"');
+                }
+                token = makeToken(TokenKind::String, start, line);
+            } else if (peek() == '\'' && isStringPrefix(ident) && ident.back() != 'R') {
+                skipQuoted('\'');
+                token = makeToken(TokenKind::Char, start, line);
+            } else {
+                token = makeToken(TokenKind::Identifier, start, line);
+            }
+            return true;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) ||
+            (c == '.' && std::isdigit(static_cast<unsigned char>(peek(1))))) {
+            skipNumber();
+            token = makeToken(TokenKind::Number, start, line);
+            return true;
+        }
+
+        if (c == '"') {
+            skipQuoted('"');
+            token = makeToken(TokenKind::String, start, line);
+            return true;
+        }
+
+        if (c == '\'') {
+            skipQuoted('\'');
+            token = makeToken(TokenKind::Char, start, line);
+            return true;
+        }
+
+        // Punctuation
+        if ((c == ':' && peek(1) == ':') || (c == '-' && peek(1) == '>')) {
+            advance(2);
+        } else if (c == '.' && peek(1) == '.' && peek(2) == '.') {
+            advance(3);
+        } else {
+            advance();
+        }
+        token = makeToken(TokenKind::Punct, start, line);
+        return true;
+    }
+    return false;
+}
+
+void Lexer::advance(size_t count) {
+    if (count == 1 && pos_ < end_) {
+        line_ += source_[pos_++] == '\n';
+        return;
+    }
+    advanceTo(count < end_ - pos_ ? pos_ + count : end_);
+}
+
+void Lexer::advanceTo(size_t target) {
+    line_ += countNewlines(source_.data() + pos_, target - pos_);
+    pos_ = target;
+}
+
+Token Lexer::makeToken(TokenKind kind, size_t start, uint32_t line) const {
+    Token token;
+    token.kind = kind;
+    token.offset = start;
+    token.length = pos_ - start;
+    token.line = line;
+    token.text = source_.substr(start, pos_ - start);
+    return token;
+}
+
+void Lexer::skipLineComment() {
+    // Stops before the newline; a trailing backslash continues the comment
+    for (;;) {
+        pos_ = findAny(source_.data(), pos_, end_, '\n', '\\', '\\');
+        if (pos_ >= end_ || peek() == '\n') {
+            return;
+        }
+        advance(peek(1) == '\n' ? 2 : 1);
+    }
+}
+
+void Lexer::skipBlockComment() {
+    advance(2);
+    for (;;) {
+        advanceTo(findAny(source_.data(), pos_, end_, '*', '*', '*'));
+        if (pos_ >= end_) {
+            return;
+        }
+        if (peek(1) == '/') {
+            advance(2);
+            return;
+        }
+        advance();
+    }
+}
+
+void Lexer::skipPreprocessorLine() {
+    for (;;) {
+        pos_ = findAny(source_.data(), pos_, end_, '\n', '\\', '/');
+        if (pos_ >= end_ || peek() == '\n') {
+            return;
+        }
+        if (peek() == '\\' && peek(1) == '\n') {
+            advance(2);
+        } else if (peek() == '/' && peek(1) == '*') {
+            skipBlockComment();
+        } else if (peek() == '/' && peek(1) == '/') {
+            skipLineComment();
+        } else {
+            advance();
+        }
+    }
+}
+
+void Lexer::skipQuoted(char quote) {
+    advance();  // opening quote
+    for (;;) {
+        // No newline can be passed over here, so the line count is unchanged
+        pos_ = findAny(source_.data(), pos_, end_, quote, '\\', '\n');
+        if (pos_ >= end_) {
+            return;
+        }
+        char c = peek();
+        if (c == '\\') {
+            advance(2);
+        } else if (c == quote) {
+            advance();
+            return;
+        } else {
+            return;  // Unterminated literal; stop at end of line
+        }
+    }
+}
+
+void Lexer::skipRawString() {
+    // R"delim( ... )delim"
+    advance();  // opening quote
+    size_t delim_start = pos_;
+    while (pos_ < end_ && peek() != '(' && peek() != '\n') {
+        advance();
+    }
+    std::string terminator = ")";
+    terminator.append(source_.substr(delim_start, pos_ - delim_start));
+    terminator += '"';
+
+    size_t close = source_.find(terminator, pos_);
+    if (close == std::string_view::npos || close + terminator.size() > end_) {
+        advanceTo(end_);
+    } else {
+        advanceTo(close + terminator.size());
+    }
+}
+
+void Lexer::skipNumber() {
+    while (pos_ < end_) {
+        char c = peek();
+        if ((c == 'e' || c == 'E' || c == 'p' || c == 'P') &&
+            (peek(1) == '+' || peek(1) == '-')) {
+            advance(2);
+        } else if (isIdentChar(c) || c == '.' ||
+                   (c == '\'' && isIdentChar(peek(1)))) {
+            advance();
+        } else {
+            break;
+        }
+    }
+}
+
+void Lexer::skipIdentifier() {
+    while (pos_ < end_ && isIdentChar(peek())) {
+        advance();
+    }
+}
+
+bool Lexer::isStringPrefix(std::string_view ident) const {
+    return ident == "L" || ident == "u" || ident == "U" || ident == "u8" ||
+           ident == "R" || ident == "LR" || ident == "uR" || ident == "UR" ||
+           ident == "u8R";
+}
+
+} // namespace hybrid
@@ -0,0 +1,314 @@
+/**
+ * Ownership Analyzer
+ * Works out which parameters a function consumes and which it only reads
+ */
+
+#include "analysis_pass.h"
+#include "type_names.h"
+#include <algorithm>
+
+namespace hybrid {
+
+namespace {
+
+/** Assignment, compound assignment, ++ or -- starting at index */
+bool isAssignment(const BodyScan& scan, size_t index) {
+    static constexpr std::string_view kOperators[] = {
+        "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>=", "++", "--"
+    };
+    std::string_view op = scan.punctuator(index);
+    return std::find(std::begin(kOperators), std::end(kOperators), op) != std::end(kOperators);
+}
+
+bool isComparison(std::string_view op) {
+    return op == "==" || op == "!=" || op == "<=" || op == ">=";
+}
+
+/** Members of the standard containers and std::string that modify them */
+bool isMutatingMember(std::string_view name) {
+    static constexpr std::string_view kMembers[] = {
+        "push_back", "emplace_back", "pop_back", "push_front", "emplace_front", "pop_front",
+        "insert", "emplace", "erase", "clear", "resize", "reserve", "shrink_to_fit",
+        "append", "assign", "replace", "swap", "splice", "merge", "sort", "unique", "remove"
+    };
+    return std::find(std::begin(kMembers), std::end(kMembers), name) != std::end(kMembers);
+}
+
+bool isStandardContainer(TypeKind kind) {
+    switch (kind) {
+        case TypeKind::StdVector:
+        case TypeKind::StdList:
+        case TypeKind::StdDeque:
+        case TypeKind::StdMap:
+        case TypeKind::StdUnorderedMap:
+        case TypeKind::StdSet:
+        case TypeKind::StdUnorderedSet:
+        case TypeKind::StdString:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Container kinds whose reserve() has a with_capacity counterpart */
+TypeKind reservableContainer(std::string_view name) {
+    if (name == "vector") return TypeKind::StdVector;
+    if (name == "deque") return TypeKind::StdDeque;
+    if (name == "string") return TypeKind::StdString;
+    if (name == "unordered_map") return TypeKind::StdUnorderedMap;
+    if (name == "unordered_set") return TypeKind::StdUnorderedSet;
+    return TypeKind::Void;
+}
+
+} // namespace
+
+/**
+ * Ownership Analyzer
+ *
+ * For each by-value parameter, records in moved_params those the body
+ * hands on (std::move, std::forward, return) and in borrowed_params those
+ * it only reads, so generators may take a reference instead of a copy.
+ * A parameter that is assigned, modified through a member, passed to
+ * another function, copied or has its address taken is neither.
+ *
+ * Also records capacity reserved for local containers whose size is known
+ * at function entry (from parameters or literals), for with_capacity-style
+ * construction.
+ */
+class OwnershipAnalyzer : public AnalysisPass {
+public:
+    const char* name() const override { return "ownership"; }
+
+    std::vector<std::string_view> interests() const override {
+        return {"reserve"};
+    }
+
+    void functionInterests(const Function& func, std::vector<std::string_view>& interests) const override {
+        for (const auto& param : params_) {
+            interests.push_back(func.parameters[param.index].name);
+        }
+    }
+
+    void beginFunction(Function& func) override {
+        params_.clear();
+        func.capacity_hints.clear();
+        for (size_t i = 0; i < func.parameters.size(); ++i) {
+            const Parameter& param = func.parameters[i];
+            if (param.name.empty() || !param.type ||
+                param.type->kind == TypeKind::Pointer || param.type->kind == TypeKind::Reference) {
+                continue;
+            }
+            params_.push_back({i});
+        }
+    }
+
+    void onToken(const BodyScan& scan, size_t index, Function& func) override {
+        std::string_view word = scan.at(index).text;
+        if (word == "reserve" && index >= 2 && scan.at(index - 1).isPunct(".")) {
+            detectReserve(scan, index, func);
+        }
+        for (auto& param : params_) {
+            if (func.parameters[param.index].name == word) {
+                classifyUse(scan, index, standardTypeKind(*func.parameters[param.index].type), param);
+            }
+        }
+    }
+
+    void endFunction(Function& func) override {
+        func.moved_params.clear();
+        func.borrowed_params.clear();
+        for (const auto& param : params_) {
+            const std::string& name = func.parameters[param.index].name;
+            if (param.moved) {
+                func.moved_params.push_back(name);
+            } else if (!param.modified && !param.escapes) {
+                func.borrowed_params.push_back(name);
+            }
+        }
+        params_.clear();
+    }
+
+private:
+    struct ParamUse {
+        size_t index;               // Into func.parameters
+        bool moved = false;
+        bool modified = false;
+        bool escapes = false;       // Copied, passed on or address taken
+    };
+
+    std::vector<ParamUse> params_;
+
+    /**
+     * Fold one use of a variable of the given kind at index into its flags
+     */
+    static void classifyUse(const BodyScan& scan, size_t index, TypeKind kind, ParamUse& use) {
+        const Token& next = scan.at(index + 1);
+        if (index == 0) {
+            use.modified |= isAssignment(scan, index + 1);
+            return;
+        }
+        const Token& prev = scan.at(index - 1);
+        if (prev.isPunct(".") || prev.isPunct("->") || prev.isPunct("::")) {
+            return;     // A member of something else with the same name
+        }
+
+        // std::move(p), std::forward<T>(p), return p;
+        if (prev.isPunct("(") && next.isPunct(")") && index >= 2) {
+            size_t callee = index - 2;
+            if (scan.at(callee).isPunct(">")) {
+                while (callee > 0 && !scan.at(callee).isPunct("<")) --callee;
+                callee = callee > 0 ? callee - 1 : callee;
+            }
+            if (scan.at(callee).isIdentifier("move") || scan.at(callee).isIdentifier("forward")) {
+                use.moved = true;
+                return;
+            }
+        }
+        if (prev.isIdentifier("return") && next.isPunct(";")) {
+            use.moved = true;
+            return;
+        }
+
+        std::string_view before = index >= 2 ? scan.punctuator(index - 2) : std::string_view();
+        if (isAssignment(scan, index + 1) || before == "++" || before == "--") {
+            use.modified = true;
+            return;
+        }
+        if (next.isPunct("[")) {
+            size_t close = scan.matching(index + 1);
+            use.modified |= close == BodyScan::npos || isAssignment(scan, close + 1);
+            return;
+        }
+        if (next.isPunct(".")) {
+            const Token& member = scan.at(index + 2);
+            if (scan.at(index + 3).isPunct("(")) {
+                // Only the standard types' members are known not to modify
+                use.modified |= !isStandardContainer(kind) || isMutatingMember(member.text);
+            } else {
+                use.modified |= isAssignment(scan, index + 3);
+            }
+            return;
+        }
+
+        // Unary &, call and initializer arguments, copies
+        bool address = prev.isPunct("&") &&
+                       (index < 2 || (scan.at(index - 2).kind == TokenKind::Punct && before != "&&" &&
+                                      !scan.at(index - 2).isPunct(")") && !scan.at(index - 2).isPunct("]")));
+        bool argument = prev.isPunct(",") || prev.isPunct("{") ||
+                        (prev.isPunct("(") && index >= 2 && scan.at(index - 2).kind == TokenKind::Identifier &&
+                         !isControlKeyword(scan.at(index - 2).text));
+        bool copied = prev.isPunct("=") && !isComparison(before);
+        if (address || argument || copied) {
+            use.escapes = true;
+        }
+    }
+
+    static bool isControlKeyword(std::string_view word) {
+        return word == "if" || word == "while" || word == "switch" || word == "for" ||
+               word == "return" || word == "sizeof";
+    }
+
+    /**
+     * v.reserve(n) on a default-constructed local std::vector<T> v (or
+     * deque, string, unordered_map, unordered_set)
+     */
+    void detectReserve(const BodyScan& scan, size_t index, Function& func) {
+        const Token& var = scan.at(index - 2);
+        size_t open = index + 1;
+        size_t close = scan.matching(open);
+        if (var.kind != TokenKind::Identifier || !scan.at(open).isPunct("(") ||
+            close == BodyScan::npos || close == open + 1) {
+            return;
+        }
+        for (const auto& hint : func.capacity_hints) {
+            if (hint.var_name == var.text) return;
+        }
+
+        // Hoisted to the declaration, the amount may only use parameters (and their members) and literals
+        for (size_t i = open + 1; i < close; ++i) {
+            const Token& t = scan.at(i);
+            if (t.kind != TokenKind::Identifier || scan.at(i - 1).isPunct(".") || scan.at(i - 1).isPunct("::") ||
+                scan.at(i + 1).isPunct("::")) {
+                continue;
+            }
+            bool is_param = std::any_of(func.parameters.begin(), func.parameters.end(),
+                                        [&](const Parameter& param) { return param.name == t.text; });
+            if (!is_param) return;
+        }
+
+        size_t type_first = 0;
+        size_t type_last = 0;
+        TypeKind container = declaredContainer(scan, index - 2, var.text, type_first, type_last);
+        if (container == TypeKind::Void) return;
+
+        CapacityHint hint;
+        hint.var_name = std::string(var.text);
+        hint.container = container;
+        hint.capacity = std::string(scan.between(open, close));
+        if (type_last > type_first) {
+            hint.type_args = templateArguments(scan, type_first + 1, type_last);
+        }
+
+        // Whether the container outlives the call, which rules out recycling it
+        ParamUse use{0};
+        for (size_t i = type_last + 2; i < scan.size() && !use.moved && !use.escapes; ++i) {
+            if (scan.at(i).isIdentifier(var.text)) {
+                classifyUse(scan, i, container, use);
+            }
+        }
+        hint.escapes = use.moved || use.escapes;
+        func.capacity_hints.push_back(std::move(hint));
+    }
+
+    /**
+     * Kind of the container declared as "std::vector<T> name;" before end;
+     * first and last are set to its name and the '>' closing its arguments
+     */
+    static TypeKind declaredContainer(const BodyScan& scan, size_t end, std::string_view name,
+                                      size_t& first, size_t& last) {
+        for (size_t i = 0; i < end; ++i) {
+            TypeKind kind = reservableContainer(scan.at(i).text);
+            if (kind == TypeKind::Void || scan.at(i).kind != TokenKind::Identifier) continue;
+
+            last = i;
+            if (scan.at(i + 1).isPunct("<")) {
+                last = scan.matchingAngle(i + 1);
+                if (last == BodyScan::npos) continue;
+            } else if (kind != TypeKind::StdString) {
+                continue;
+            }
+            if (scan.at(last + 1).isIdentifier(name) && scan.at(last + 2).isPunct(";")) {
+                first = i;
+                return kind;
+            }
+        }
+        return TypeKind::Void;
+    }
+
+    /**
+     * Text of the top-level arguments of the template argument list opened at open
+     */
+    static std::vector<std::string> templateArguments(const BodyScan& scan, size_t open, size_t close) {
+        std::vector<std::string> args;
+        size_t start = open + 1;
+        int depth = 0;
+        for (size_t i = start; i <= close; ++i) {
+            const Token& t = scan.at(i);
+            if (t.isPunct("<") || t.isPunct("(")) {
+                ++depth;
+            } else if ((t.isPunct(">") || t.isPunct(")")) && i != close) {
+                --depth;
+            } else if ((i == close || (depth == 0 && t.isPunct(","))) && i > start) {
+                args.emplace_back(scan.text(start, i - 1));
+                start = i + 1;
+            }
+        }
+        return args;
+    }
+};
+
+std::unique_ptr<AnalysisPass> createOwnershipAnalysisPass() {
+    return std::make_unique<OwnershipAnalyzer>();
+}
+
+} // namespace hybrid
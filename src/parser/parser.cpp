@@ -11,4 +11,21 @@ IR Parser::parseString(const std::string& source) {
     return SimpleCppParser::parseString(source);
 }
 
+IR Parser::parseBuffer(std::shared_ptr<const SourceBuffer> buffer) {
+    return SimpleCppParser::parseBuffer(std::move(buffer));
+}
+
+void Parser::parseBuffer(std::shared_ptr<const SourceBuffer> buffer, IR& ir) {
+    SimpleCppParser::parseBuffer(std::move(buffer), ir);
+}
+
+IR Parser::parseSpans(std::shared_ptr<const SourceBuffer> buffer, const std::vector<SourceSpan>& spans) {
+    return SimpleCppParser::parseSpans(std::move(buffer), spans);
+}
+
+void Parser::parseSpans(const std::shared_ptr<const SourceBuffer>& buffer,
+                        const std::vector<SourceSpan>& spans, IR& ir) {
+    SimpleCppParser::parseSpans(buffer, spans, ir);
+}
+
 } // namespace hybrid
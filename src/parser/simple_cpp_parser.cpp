@@ -1,16 +1,24 @@
 /**
  * Simple C++ Parser
  *
- * A lightweight regex-based parser for basic C++ class structures.
+ * A lightweight token-based parser for basic C++ class structures.
+ * The source is tokenized once by the Lexer and every stage below walks
+ * the same token stream, so parsing is linear in the size of the input.
  * This is a simplified parser for demonstration purposes.
  * For production use, integrate with Clang LibTooling.
  */
 
 #include "ir.h"
-#include <regex>
+#include "lexer.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include "source_buffer.h"
+#include "type_names.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 namespace hybrid {
 
@@ -20,303 +28,853 @@ public:
      * Parse C++ source file and build IR
      */
     static IR parseFile(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot open file: " + filename);
-        }
-
-        std::string content((std::istreambuf_iterator<char>(file)),
-                           std::istreambuf_iterator<char>());
-        file.close();
-
-        return parseString(content);
+        return parseBuffer(SourceBuffer::fromFile(filename));
     }
 
     /**
      * Parse C++ source string and build IR
      */
     static IR parseString(const std::string& source) {
+        return parseBuffer(SourceBuffer::fromString(source));
+    }
+
+    /**
+     * Parse a shared source buffer; the IR keeps the buffer alive and its
+     * bodies, initializers and default values are spans into it
+     */
+    static IR parseBuffer(std::shared_ptr<const SourceBuffer> buffer) {
         IR ir;
-        SimpleCppParser parser(source);
+        parseBuffer(std::move(buffer), ir);
+        return ir;
+    }
+
+    /**
+     * Same, into an existing (empty) IR. If parsing throws (BudgetExceeded),
+     * the IR keeps the classes parsed up to that point.
+     */
+    static void parseBuffer(std::shared_ptr<const SourceBuffer> buffer, IR& ir) {
+        ProfileScope scope("parse", "parse", buffer->getPath(), buffer->text().size());
+        ir.setSource(buffer);
+        SimpleCppParser parser(buffer);
 
         // Parse all classes in the source
+        ProfileScope classes_scope("parse", "classes");
         parser.parseClasses(ir);
+    }
 
+    /**
+     * Parse only the classes inside the given spans of a buffer, in span
+     * order. Each span is lexed on its own, so the cost follows the spans'
+     * size rather than the file's.
+     */
+    static IR parseSpans(std::shared_ptr<const SourceBuffer> buffer, const std::vector<SourceSpan>& spans) {
+        IR ir;
+        parseSpans(buffer, spans, ir);
+        ir.setSource(std::move(buffer));
         return ir;
     }
 
+    /**
+     * Append the classes inside the spans to an existing IR
+     */
+    static void parseSpans(const std::shared_ptr<const SourceBuffer>& buffer,
+                           const std::vector<SourceSpan>& spans, IR& ir) {
+        ProfileScope scope("parse", "parse_spans", buffer->getPath());
+        for (const auto& span : spans) {
+            SimpleCppParser parser(buffer, span);
+            scope.addBytes(span.length);
+            parser.parseClasses(ir);
+        }
+    }
+
 private:
-    std::string source_;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    std::shared_ptr<const SourceBuffer> buffer_;
+    std::string_view source_;
+    std::vector<Token> tokens_;     // Significant tokens, EndOfFile-terminated
+    std::vector<Token> comments_;   // Comment tokens, used to strip comments from slices
+    std::vector<size_t> match_;     // Matching bracket index for ( [ { and ) ] }
+    TypeArena* types_ = nullptr;    // Arena of the IR being built
+    std::unordered_map<std::string, std::shared_ptr<Type>> type_cache_;  // Spelling -> canonical type
+
+    explicit SimpleCppParser(const std::shared_ptr<const SourceBuffer>& buffer)
+        : buffer_(buffer), source_(buffer->text()) {
+        tokenize(Lexer(source_), source_.size());
+    }
 
-    explicit SimpleCppParser(const std::string& source) : source_(source) {}
+    SimpleCppParser(const std::shared_ptr<const SourceBuffer>& buffer, const SourceSpan& span)
+        : buffer_(buffer), source_(buffer->text()) {
+        tokenize(Lexer(source_, span.offset, span.offset + span.length,
+                       buffer->locate(span.offset).line), span.length);
+    }
 
     /**
-     * Remove C++ comments from source
+     * Tokenize the source and pair up brackets in one pass
      */
-    std::string removeComments(const std::string& code) const {
-        std::string result = code;
+    void tokenize(Lexer lexer, size_t bytes) {
+        std::vector<Token> all;
+        {
+            ProfileScope lex_scope("parse", "lex", std::string_view(), bytes);
+            all = lexer.tokenize(true);
+        }
+
+        tokens_.reserve(all.size());
+        for (const auto& token : all) {
+            if (token.kind == TokenKind::Comment) {
+                comments_.push_back(token);
+            } else if (token.kind != TokenKind::Preprocessor) {
+                tokens_.push_back(token);
+            }
+        }
 
-        // Remove single-line comments
-        result = std::regex_replace(result, std::regex("//[^\n]*"), "");
+        // The token arrays are the bulk of a parse's memory
+        ResourceBudget::chargeCurrent((all.size() + tokens_.size() + comments_.size()) * sizeof(Token) +
+                                      tokens_.size() * sizeof(size_t), "parse");
+
+        ProfileScope match_scope("parse", "match_brackets");
+        match_.assign(tokens_.size(), npos);
+        std::vector<size_t> open;
+        for (size_t i = 0; i < tokens_.size(); ++i) {
+            const Token& t = tokens_[i];
+            if (t.kind != TokenKind::Punct || t.length != 1) continue;
+
+            char c = t.text[0];
+            if (c == '(' || c == '[' || c == '{') {
+                open.push_back(i);
+            } else if (c == ')' || c == ']' || c == '}') {
+                char expected = (c == ')') ? '(' : (c == ']') ? '[' : '{';
+                // Drop unbalanced openers so one stray bracket can't derail the rest
+                while (!open.empty() && tokens_[open.back()].text[0] != expected) {
+                    open.pop_back();
+                }
+                if (!open.empty()) {
+                    match_[open.back()] = i;
+                    match_[i] = open.back();
+                    open.pop_back();
+                }
+            }
+        }
+    }
 
-        // Remove multi-line comments
-        result = std::regex_replace(result, std::regex("/\\*.*?\\*/", std::regex::ECMAScript), "");
+    const Token& tok(size_t i) const {
+        return i < tokens_.size() ? tokens_[i] : tokens_.back();
+    }
 
+    /**
+     * Source text in [begin, end) with comments removed
+     */
+    std::string sliceText(size_t begin, size_t end) const {
+        std::string result;
+        if (begin >= end) return result;
+
+        auto it = std::lower_bound(comments_.begin(), comments_.end(), begin,
+            [](const Token& comment, size_t offset) { return comment.end() <= offset; });
+
+        size_t pos = begin;
+        for (; it != comments_.end() && it->offset < end; ++it) {
+            if (it->offset > pos) {
+                result.append(source_.substr(pos, it->offset - pos));
+            }
+            pos = std::max(pos, it->end());
+        }
+        if (pos < end) {
+            result.append(source_.substr(pos, end - pos));
+        }
         return result;
     }
 
+    /**
+     * Source text covered by tokens [first, last)
+     */
+    std::string tokenText(size_t first, size_t last) const {
+        if (first >= last) return "";
+        return trim(sliceText(tok(first).offset, tok(last - 1).end()));
+    }
+
+    /**
+     * IR text for [begin, end): a span into the buffer, or an owned
+     * comment-stripped copy when a comment falls inside the range
+     */
+    SourceText spanText(size_t begin, size_t end, bool trimmed = false) const {
+        SourceSpan span{begin, end > begin ? end - begin : 0};
+
+        auto it = std::lower_bound(comments_.begin(), comments_.end(), begin,
+            [](const Token& comment, size_t offset) { return comment.end() <= offset; });
+        if (it != comments_.end() && it->offset < end) {
+            ProfileScope scope("parse", "strip_comments", std::string_view(), span.length);
+            ResourceBudget::chargeCurrent(span.length, "parse");
+            std::string text = sliceText(begin, end);
+            return SourceText(trimmed ? trim(text) : std::move(text), buffer_, span);
+        }
+
+        return SourceText(buffer_, span);
+    }
+
+    /**
+     * IR text covered by tokens [first, last)
+     */
+    SourceText tokenSpanText(size_t first, size_t last) const {
+        if (first >= last) return SourceText();
+        return spanText(tok(first).offset, tok(last - 1).end(), true);
+    }
+
+    /**
+     * Skip a balanced <...> group starting at 'pos'; returns index after '>'
+     */
+    size_t skipAngles(size_t pos, size_t end) const {
+        int depth = 0;
+        for (size_t i = pos; i < end; ++i) {
+            const Token& t = tok(i);
+            if (t.isPunct("<")) {
+                depth++;
+            } else if (t.isPunct(">")) {
+                if (--depth == 0) return i + 1;
+            } else if ((t.isPunct("(") || t.isPunct("[")) && match_[i] != npos) {
+                i = match_[i];
+            } else if (t.isPunct(";") || t.isPunct("{")) {
+                break;
+            }
+        }
+        return pos + 1;
+    }
+
+    /**
+     * Split token range [begin, end) on top-level commas
+     */
+    std::vector<std::pair<size_t, size_t>> splitOnCommas(size_t begin, size_t end) const {
+        std::vector<std::pair<size_t, size_t>> parts;
+        int angle_depth = 0;
+        size_t start = begin;
+
+        for (size_t i = begin; i < end; ++i) {
+            const Token& t = tok(i);
+            if ((t.isPunct("(") || t.isPunct("[") || t.isPunct("{")) && match_[i] != npos) {
+                i = match_[i];
+            } else if (t.isPunct("<")) {
+                angle_depth++;
+            } else if (t.isPunct(">") && angle_depth > 0) {
+                angle_depth--;
+            } else if (t.isPunct(",") && angle_depth == 0) {
+                parts.emplace_back(start, i);
+                start = i + 1;
+            }
+        }
+        parts.emplace_back(start, end);
+        return parts;
+    }
+
     /**
      * Parse all class declarations
      */
     void parseClasses(IR& ir) {
-        std::string cleaned = removeComments(source_);
+        types_ = &ir.getTypeArena();
+        type_cache_.clear();
+
+        for (size_t i = 0; i < tokens_.size(); ++i) {
+            // Class templates: the header belongs to the class after it
+            if (tok(i).isIdentifier("template") && tok(i + 1).isPunct("<")) {
+                size_t header_end = skipAngles(i + 1, tokens_.size());
+                if (tok(header_end).isIdentifier("class")) {
+                    size_t next = parseClass(header_end, ir, i);
+                    i = next != npos ? next - 1 : header_end;
+                }
+                continue;
+            }
 
-        // Regex to match class declarations
-        // Matches: class ClassName { ... };
-        std::regex class_pattern(
-            R"(class\s+(\w+)\s*(?::\s*public\s+(\w+(?:\s*,\s*\w+)*))?\s*\{([^}]*(?:\{[^}]*\}[^}]*)*)\};)",
-            std::regex::ECMAScript
-        );
+            if (!tok(i).isIdentifier("class")) continue;
 
-        auto classes_begin = std::sregex_iterator(cleaned.begin(), cleaned.end(), class_pattern);
-        auto classes_end = std::sregex_iterator();
+            // enum class is not a class
+            if (i > 0 && tok(i - 1).isIdentifier("enum")) continue;
 
-        for (std::sregex_iterator i = classes_begin; i != classes_end; ++i) {
-            std::smatch match = *i;
+            size_t next = parseClass(i, ir);
+            if (next != npos) {
+                i = next - 1;
+            }
+        }
+    }
 
-            ClassDecl class_decl;
-            class_decl.name = match[1].str();
-            class_decl.is_struct = false;
+    /**
+     * Parse one class definition starting at the 'class' keyword
+     * @param header Index of the 'template' keyword of its template header, if any
+     * @return Index after the closing brace, or npos if this is not a definition
+     */
+    size_t parseClass(size_t pos, IR& ir, size_t header = npos) {
+        size_t i = pos + 1;
+        if (tok(i).kind != TokenKind::Identifier) return npos;
+
+        ClassDecl class_decl;
+        class_decl.name = std::string(tok(i).text);
+        class_decl.is_struct = false;
+        i++;
+
+        if (header != npos) {
+            class_decl.template_parameters = parseTemplateParameters(header + 1, pos);
+            class_decl.is_template = !class_decl.template_parameters.empty();
+        }
 
-            // Parse base classes if present
-            if (match[2].matched) {
-                parseBaseClasses(match[2].str(), class_decl);
+        // Explicit specialization: class Name<Args> (partial if it has parameters left)
+        if (tok(i).isPunct("<")) {
+            size_t close = skipAngles(i, tokens_.size());
+            if (close == i + 1) return npos;
+            for (const auto& arg : splitOnCommas(i + 1, close - 1)) {
+                class_decl.specialization.specialized_args.emplace_back(tokenText(arg.first, arg.second));
             }
+            class_decl.specialization.is_partial = class_decl.is_template;
+            i = close;
+        }
 
-            // Parse class body
-            std::string body = match[3].str();
-            parseClassBody(body, class_decl);
+        if (tok(i).isIdentifier("final")) i++;
 
-            ir.addClass(class_decl);
+        // Parse base classes if present
+        if (tok(i).isPunct(":")) {
+            size_t bases_begin = ++i;
+            while (i < tokens_.size() && !tok(i).isPunct("{") && !tok(i).isPunct(";")) {
+                if (tok(i).isPunct("<")) {
+                    i = skipAngles(i, tokens_.size());
+                } else {
+                    i++;
+                }
+            }
+            parseBaseClasses(bases_begin, i, class_decl);
         }
+
+        if (!tok(i).isPunct("{") || match_[i] == npos) return npos;
+
+        size_t close = match_[i];
+        parseClassBody(i + 1, close, class_decl);
+
+        size_t first = header != npos ? header : pos;
+        class_decl.location = SourceSpan{tok(first).offset, tok(close).end() - tok(first).offset};
+        ResourceBudget::chargeCurrent(sizeof(ClassDecl) + class_decl.methods.size() * sizeof(Function) +
+                                      class_decl.fields.size() * sizeof(Variable), "parse");
+        ir.addClass(std::move(class_decl));
+        return close + 1;
     }
 
     /**
-     * Parse base class list
+     * Parameters of a template header from its '<' to the token after its '>'
+     * typename T, class T = int, size_t N, typename... Args, template <class> class C
      */
-    void parseBaseClasses(const std::string& bases_str, ClassDecl& class_decl) {
-        std::regex base_pattern(R"(\w+)");
-        auto bases_begin = std::sregex_iterator(bases_str.begin(), bases_str.end(), base_pattern);
-        auto bases_end = std::sregex_iterator();
+    std::vector<TemplateParameter> parseTemplateParameters(size_t open, size_t close) {
+        std::vector<TemplateParameter> params;
+        if (close < open + 2) return params;
+        for (const auto& part : splitOnCommas(open + 1, close - 1)) {
+            size_t first = part.first;
+            size_t last = part.second;
+            if (first >= last) continue;
+
+            TemplateParameter param;
+            size_t value = first;       // Default argument after '='
+            int angle_depth = 0;
+            while (value < last && !(angle_depth == 0 && tok(value).isPunct("="))) {
+                if (tok(value).isPunct("<")) angle_depth++;
+                if (tok(value).isPunct(">") && angle_depth > 0) angle_depth--;
+                value++;
+            }
+            if (value < last) {
+                param.default_value = tokenText(value + 1, last);
+            }
 
-        for (std::sregex_iterator i = bases_begin; i != bases_end; ++i) {
-            class_decl.base_classes.push_back((*i).str());
+            size_t name = value;
+            while (name > first && tok(name - 1).kind != TokenKind::Identifier) name--;
+            if (name == first) continue;
+            name--;
+            if (tok(name).isIdentifier("typename") || tok(name).isIdentifier("class")) continue;   // Unnamed
+            param.name = std::string(tok(name).text);
+
+            if (tok(first).isIdentifier("template")) {
+                param.kind = TemplateParameter::Template;
+            } else if ((tok(first).isIdentifier("typename") || tok(first).isIdentifier("class")) &&
+                       (name == first + 1 || tok(first + 1).kind != TokenKind::Identifier)) {
+                param.kind = TemplateParameter::Type;
+            } else {
+                param.kind = TemplateParameter::NonType;
+                param.param_type = parseType(tokenText(first, name));
+            }
+            params.push_back(std::move(param));
         }
+        return params;
     }
 
     /**
-     * Parse class body (fields and methods)
+     * Parse base class list
      */
-    void parseClassBody(const std::string& body, ClassDecl& class_decl) {
-        // Split by access specifiers
-        std::vector<std::string> sections;
-        std::vector<std::string> access_levels;
+    void parseBaseClasses(size_t begin, size_t end, ClassDecl& class_decl) {
+        for (const auto& base : splitOnCommas(begin, end)) {
+            // Skip access specifiers and 'virtual', keep the (qualified) name
+            size_t first = base.first;
+            while (first < base.second &&
+                   (tok(first).isIdentifier("public") || tok(first).isIdentifier("protected") ||
+                    tok(first).isIdentifier("private") || tok(first).isIdentifier("virtual"))) {
+                first++;
+            }
 
-        std::regex access_pattern(R"((private|protected|public)\s*:)");
+            // Drop template arguments: Base<Derived> -> Base
+            size_t last = first;
+            while (last < base.second && !tok(last).isPunct("<")) {
+                last++;
+            }
 
-        auto it = std::sregex_iterator(body.begin(), body.end(), access_pattern);
-        auto end = std::sregex_iterator();
+            std::string name = tokenText(first, last);
+            if (!name.empty()) {
+                class_decl.base_classes.push_back(std::move(name));
+            }
+        }
+    }
 
-        size_t last_pos = 0;
+    /**
+     * Parse class body (fields and methods)
+     */
+    void parseClassBody(size_t begin, size_t end, ClassDecl& class_decl) {
         std::string current_access = "private"; // Default for class
 
-        for (; it != end; ++it) {
-            std::string section_content = body.substr(last_pos, it->position() - last_pos);
-            if (!section_content.empty()) {
-                sections.push_back(section_content);
-                access_levels.push_back(current_access);
+        size_t i = begin;
+        while (i < end) {
+            const Token& t = tok(i);
+
+            if (t.isPunct(";")) {
+                i++;
+                continue;
+            }
+
+            // Access specifiers switch the current section
+            if ((t.isIdentifier("public") || t.isIdentifier("protected") ||
+                 t.isIdentifier("private")) && tok(i + 1).isPunct(":")) {
+                current_access = std::string(t.text);
+                i += 2;
+                continue;
             }
 
-            current_access = (*it)[1].str();
-            last_pos = it->position() + it->length();
+            ResourceBudget::checkpoint("parse");
+            size_t next = parseMember(i, end, current_access, class_decl);
+            i = std::max(next, i + 1);
         }
+    }
 
-        // Add remaining section
-        if (last_pos < body.length()) {
-            sections.push_back(body.substr(last_pos));
-            access_levels.push_back(current_access);
+    /**
+     * Parse one member declaration (field or method)
+     * @return Index of the first token after the member
+     */
+    size_t parseMember(size_t begin, size_t end, const std::string& access, ClassDecl& class_decl) {
+        size_t i = begin;
+
+        // Member templates: parse the templated declaration itself
+        if (tok(i).isIdentifier("template") && tok(i + 1).isPunct("<")) {
+            size_t header_end = skipAngles(i + 1, end);
+            size_t methods = class_decl.methods.size();
+            size_t next = parseMember(header_end, end, access, class_decl);
+            if (class_decl.methods.size() > methods) {
+                Function& method = class_decl.methods.back();
+                method.template_parameters = parseTemplateParameters(i + 1, header_end);
+                method.is_template = !method.template_parameters.empty();
+            }
+            return next;
         }
 
-        // If no access specifier found, treat entire body as private
-        if (sections.empty()) {
-            sections.push_back(body);
-            access_levels.push_back("private");
+        // Attributes: [[nodiscard]], [[deprecated("...")]]
+        while (tok(i).isPunct("[") && tok(i + 1).isPunct("[") && match_[i] != npos) {
+            i = match_[i] + 1;
         }
 
-        // Parse each section
-        for (size_t i = 0; i < sections.size(); ++i) {
-            parseSection(sections[i], access_levels[i], class_decl);
+        // Nested types, aliases and friends are not data members or methods
+        const Token& lead = tok(i);
+        if (lead.isIdentifier("class") || lead.isIdentifier("struct") ||
+            lead.isIdentifier("union") || lead.isIdentifier("enum") ||
+            lead.isIdentifier("using") || lead.isIdentifier("typedef") ||
+            lead.isIdentifier("friend") || lead.isIdentifier("static_assert")) {
+            return skipDeclaration(i, end);
         }
+
+        // Find the first top-level '(' (method) or declaration terminator (field)
+        int angle_depth = 0;
+        for (size_t j = i; j < end; ++j) {
+            const Token& t = tok(j);
+
+            if (t.isIdentifier("operator")) {
+                return parseMethod(i, j, end, access, class_decl);
+            }
+            if (t.isPunct("<") && j > i) {
+                angle_depth++;
+            } else if (t.isPunct(">") && angle_depth > 0) {
+                angle_depth--;
+            } else if (angle_depth > 0) {
+                if ((t.isPunct("(") || t.isPunct("[")) && match_[j] != npos) j = match_[j];
+            } else if (t.isPunct("(")) {
+                return parseMethod(i, j, end, access, class_decl);
+            } else if (t.isPunct("=") || t.isPunct(";") || t.isPunct("{") ||
+                       t.isPunct("[") || t.isPunct(":") || t.isPunct(",")) {
+                return parseFields(i, end, access, class_decl);
+            }
+        }
+
+        return end;
     }
 
     /**
-     * Parse a section (fields and methods within an access level)
+     * Skip to the end of a declaration we don't model
      */
-    void parseSection(const std::string& section, const std::string& access, ClassDecl& class_decl) {
-        // Parse field declarations
-        parseFields(section, access, class_decl);
-
-        // Parse method declarations/definitions
-        parseMethods(section, access, class_decl);
+    size_t skipDeclaration(size_t begin, size_t end) const {
+        for (size_t i = begin; i < end; ++i) {
+            const Token& t = tok(i);
+            if (t.isPunct(";")) return i + 1;
+            if ((t.isPunct("(") || t.isPunct("[")) && match_[i] != npos) {
+                i = match_[i];
+            } else if (t.isPunct("{") && match_[i] != npos) {
+                // friend function defined inline: no trailing ';'
+                bool function_body = i > begin && tok(i - 1).isPunct(")");
+                i = match_[i];
+                if (function_body) return i + 1;
+            }
+        }
+        return end;
     }
 
     /**
      * Parse field declarations
+     * Handles: [static] [const] type name [= init]; and type name1, name2;
      */
-    void parseFields(const std::string& section, const std::string& access, ClassDecl& class_decl) {
-        // Match: type name; or type name1, name2;
-        std::regex field_pattern(
-            R"((?:const\s+)?(?:static\s+)?([a-zA-Z_][\w:<>,\[\]\s*&]*?)\s+([a-zA-Z_]\w*(?:\s*,\s*[a-zA-Z_]\w*)*)\s*;)",
-            std::regex::ECMAScript
-        );
-
-        auto fields_begin = std::sregex_iterator(section.begin(), section.end(), field_pattern);
-        auto fields_end = std::sregex_iterator();
-
-        for (std::sregex_iterator it = fields_begin; it != fields_end; ++it) {
-            std::smatch match = *it;
-
-            // Skip if this looks like a method (has parentheses before semicolon)
-            std::string before_semicolon = match.str();
-            if (before_semicolon.find('(') != std::string::npos) {
-                continue;
+    size_t parseFields(size_t begin, size_t end, const std::string& access, ClassDecl& class_decl) {
+        // Find the terminating ';'
+        size_t semicolon = begin;
+        while (semicolon < end && !tok(semicolon).isPunct(";")) {
+            if ((tok(semicolon).isPunct("(") || tok(semicolon).isPunct("[") ||
+                 tok(semicolon).isPunct("{")) && match_[semicolon] != npos) {
+                semicolon = match_[semicolon];
+            }
+            semicolon++;
+        }
+
+        // Leading specifiers
+        bool is_static = false;
+        bool is_const = false;
+        size_t i = begin;
+        for (; i < semicolon; ++i) {
+            const Token& t = tok(i);
+            if (t.isIdentifier("static")) {
+                is_static = true;
+            } else if (t.isIdentifier("const") || t.isIdentifier("constexpr")) {
+                is_const = true;
+            } else if (!t.isIdentifier("mutable") && !t.isIdentifier("inline") &&
+                       !t.isIdentifier("volatile") && !t.isIdentifier("thread_local")) {
+                break;
+            }
+        }
+
+        auto declarators = splitOnCommas(i, semicolon);
+        std::string type_str;
+
+        for (size_t d = 0; d < declarators.size(); ++d) {
+            size_t first = declarators[d].first;
+            size_t last = declarators[d].second;
+
+            // Declarator ends at initializer, array extent or bit-field width
+            size_t decl_end = first;
+            int angle_depth = 0;
+            while (decl_end < last) {
+                const Token& t = tok(decl_end);
+                if (t.isPunct("<")) {
+                    angle_depth++;
+                } else if (t.isPunct(">") && angle_depth > 0) {
+                    angle_depth--;
+                } else if (angle_depth == 0 &&
+                           (t.isPunct("=") || t.isPunct("{") || t.isPunct("[") || t.isPunct(":"))) {
+                    break;
+                }
+                decl_end++;
             }
 
-            std::string type_str = match[1].str();
-            std::string names_str = match[2].str();
+            // Name is the last identifier of the declarator
+            if (decl_end == first || tok(decl_end - 1).kind != TokenKind::Identifier) continue;
+            size_t name_pos = decl_end - 1;
 
-            // Parse multiple variable names (e.g., int x, y;)
-            std::regex name_pattern(R"([a-zA-Z_]\w*)");
-            auto names_begin = std::sregex_iterator(names_str.begin(), names_str.end(), name_pattern);
-            auto names_end = std::sregex_iterator();
+            if (d == 0) {
+                if (name_pos == first) return semicolon + 1;  // No type: not a field
+                type_str = tokenText(first, name_pos);
+            }
 
-            for (std::sregex_iterator name_it = names_begin; name_it != names_end; ++name_it) {
-                Variable field;
-                field.name = (*name_it).str();
-                field.type = parseType(type_str);
+            Variable field;
+            field.name = std::string(tok(name_pos).text);
+            field.is_static = is_static;
+            field.is_const = is_const;
 
-                class_decl.fields.push_back(field);
+            std::string field_type = type_str;
+            size_t rest = decl_end;
+            while (rest < last && tok(rest).isPunct("[") && match_[rest] != npos) {
+                field_type += tokenText(rest, match_[rest] + 1);
+                rest = match_[rest] + 1;
             }
+
+            if (rest < last && tok(rest).isPunct("=")) {
+                field.initializer = tokenSpanText(rest + 1, last);
+            } else if (rest < last && tok(rest).isPunct("{")) {
+                field.initializer = tokenSpanText(rest, last);
+            }
+
+            field.type = parseType(field_type);
+            recordMember(access, field.name, class_decl);
+            class_decl.fields.push_back(std::move(field));
         }
+
+        return semicolon + 1;
     }
 
     /**
      * Parse method declarations/definitions
+     * Pattern: [virtual] [static] [type] name(params) [const] [= 0] [: inits] [{ body } | ;]
      */
-    void parseMethods(const std::string& section, const std::string& access, ClassDecl& class_decl) {
-        // Match method signatures (including constructors, virtual, static)
-        // Pattern: [virtual] [static] [type] name(params) [const] [= 0] [{ body } | ;]
-        std::regex method_pattern(
-            R"((virtual\s+)?(static\s+)?(?:([a-zA-Z_][\w:<>,\s*&]*?)\s+)?([a-zA-Z_]\w*)\s*\(([^)]*)\)\s*(const)?\s*(=\s*0)?\s*(?:\{([^}]*(?:\{[^}]*\}[^}]*)*)\}|;))",
-            std::regex::ECMAScript
-        );
-
-        auto methods_begin = std::sregex_iterator(section.begin(), section.end(), method_pattern);
-        auto methods_end = std::sregex_iterator();
-
-        for (std::sregex_iterator it = methods_begin; it != methods_end; ++it) {
-            std::smatch match = *it;
+    size_t parseMethod(size_t begin, size_t name_end, size_t end,
+                       const std::string& access, ClassDecl& class_decl) {
+        Function method;
+
+        // Leading specifiers
+        size_t i = begin;
+        for (; i < name_end; ++i) {
+            const Token& t = tok(i);
+            if (t.isIdentifier("virtual")) {
+                method.is_virtual = true;
+            } else if (t.isIdentifier("static")) {
+                method.is_static = true;
+            } else if (!t.isIdentifier("inline") && !t.isIdentifier("explicit") &&
+                       !t.isIdentifier("constexpr") && !t.isIdentifier("consteval")) {
+                break;
+            }
+        }
 
-            Function method;
-            method.name = match[4].str();
+        // Method name and the opening parenthesis of the parameter list
+        size_t name_begin = name_end;
+        size_t lparen = name_end;
+        if (tok(name_end).isIdentifier("operator")) {
+            lparen = name_end + 1;
+            if (tok(lparen).isPunct("(") && tok(lparen + 1).isPunct(")")) {
+                lparen += 2;  // operator()
+            }
+            while (lparen < end && !tok(lparen).isPunct("(")) {
+                lparen++;
+            }
+            std::string name;
+            for (size_t k = name_end; k < lparen; ++k) {
+                if (k > name_end && tok(k).kind == TokenKind::Identifier &&
+                    tok(k - 1).kind == TokenKind::Identifier) {
+                    name += ' ';
+                }
+                name += tok(k).text;
+            }
+            method.name = name;
+        } else {
+            if (name_end == i || tok(name_end - 1).kind != TokenKind::Identifier) {
+                return skipDeclaration(begin, end);
+            }
+            name_begin = name_end - 1;
+            method.name = std::string(tok(name_begin).text);
 
-            // Check if virtual
-            method.is_virtual = match[1].matched;
+            if (name_begin > i && tok(name_begin - 1).isPunct("~")) {
+                method.is_destructor = true;
+                method.name = "~" + method.name;
+                name_begin--;
+            }
+        }
 
-            // Check if static
-            method.is_static = match[2].matched;
+        size_t rparen = match_[lparen];
+        if (rparen == npos || rparen >= end) return end;
+
+        // Return type: everything between the specifiers and the name
+        std::string return_type = tokenText(i, name_begin);
+        if (method.is_destructor) {
+            method.return_type = parseType("void");
+        } else if (return_type.empty() && tok(name_end).isIdentifier("operator")) {
+            // Conversion operator: operator bool() returns bool
+            method.return_type = parseType(method.name.substr(std::string("operator").size()));
+        } else if (return_type.empty() || return_type == class_decl.name) {
+            // Constructor: no return type and name matches class
+            method.is_constructor = true;
+            method.return_type = nullptr;
+        } else {
+            method.return_type = parseType(return_type);
+        }
 
-            // Check if pure virtual (= 0)
-            method.is_pure_virtual = match[7].matched;
+        // Parse parameters
+        if (rparen > lparen + 1) {
+            parseParameters(lparen + 1, rparen, method);
+        }
 
-            // Check if constructor (no return type and name matches class)
-            if (match[3].str().empty() || match[3].str() == class_decl.name) {
-                method.is_constructor = true;
-                method.return_type = nullptr;
+        // Trailing qualifiers
+        size_t k = rparen + 1;
+        while (k < end) {
+            const Token& t = tok(k);
+            if (t.isIdentifier("const")) {
+                method.is_const = true;
+                k++;
+            } else if (t.isIdentifier("noexcept") || t.isIdentifier("throw")) {
+                k++;
+                if (tok(k).isPunct("(") && match_[k] != npos) k = match_[k] + 1;
+            } else if (t.isIdentifier("override") || t.isIdentifier("final") ||
+                       t.isIdentifier("volatile") || t.isPunct("&")) {
+                k++;
+            } else if (t.isPunct("->")) {
+                // Trailing return type
+                size_t type_begin = ++k;
+                while (k < end && !tok(k).isPunct("{") && !tok(k).isPunct(";") &&
+                       !tok(k).isPunct("=")) {
+                    k++;
+                }
+                if (method.return_type && method.return_type->name == "auto") {
+                    method.return_type = parseType(tokenText(type_begin, k));
+                }
             } else {
-                method.return_type = parseType(match[3].str());
+                break;
             }
+        }
 
-            // Parse parameters
-            std::string params_str = match[5].str();
-            if (!params_str.empty()) {
-                parseParameters(params_str, method);
+        // '= 0', '= default', '= delete'
+        if (tok(k).isPunct("=")) {
+            if (tok(k + 1).text == "0") {
+                method.is_pure_virtual = true;
             }
+            k += 2;
+        }
 
-            // Check if const method
-            method.is_const = match[6].matched;
-
-            // Store body if present
-            if (match[8].matched) {
-                method.body = match[8].str();
+        // Constructor initializer list: : a(x), b{y}
+        if (tok(k).isPunct(":")) {
+            k++;
+            while (k < end && !tok(k).isPunct("{") && !tok(k).isPunct(";")) {
+                if (tok(k).isPunct("(") && match_[k] != npos) {
+                    k = match_[k];
+                } else if (tok(k).isPunct("<")) {
+                    k = skipAngles(k, end) - 1;
+                }
+                k++;
+                // A '{' right after a member name is a brace initializer, not the body
+                if (tok(k).isPunct("{") && match_[k] != npos &&
+                    tok(k - 1).kind == TokenKind::Identifier) {
+                    k = match_[k] + 1;
+                }
             }
+        }
 
-            class_decl.methods.push_back(method);
+        // Store body if present
+        if (tok(k).isPunct("{") && match_[k] != npos) {
+            size_t close = match_[k];
+            method.body = spanText(tok(k).end(), tok(close).offset);
+            k = close + 1;
+        } else {
+            while (k < end && !tok(k).isPunct(";")) {
+                k++;
+            }
+            k++;
         }
+
+        method.location = SourceSpan{tok(begin).offset, tok(k - 1).end() - tok(begin).offset};
+        recordMember(access, method.name, class_decl);
+        class_decl.methods.push_back(std::move(method));
+        return k;
     }
 
     /**
-     * Parse function parameters
+     * Record a member name under its access section
      */
-    void parseParameters(const std::string& params_str, Function& func) {
-        // Split by commas (but not inside <>)
-        std::vector<std::string> param_strs;
-        int angle_depth = 0;
-        size_t start = 0;
+    void recordMember(const std::string& access, const std::string& name, ClassDecl& class_decl) {
+        ClassDecl::AccessSection::Level level = ClassDecl::AccessSection::Private;
+        if (access == "public") {
+            level = ClassDecl::AccessSection::Public;
+        } else if (access == "protected") {
+            level = ClassDecl::AccessSection::Protected;
+        }
 
-        for (size_t i = 0; i < params_str.length(); ++i) {
-            if (params_str[i] == '<') angle_depth++;
-            else if (params_str[i] == '>') angle_depth--;
-            else if (params_str[i] == ',' && angle_depth == 0) {
-                param_strs.push_back(params_str.substr(start, i - start));
-                start = i + 1;
-            }
+        auto& sections = class_decl.access_sections;
+        if (sections.empty() || sections.back().level != level) {
+            ClassDecl::AccessSection section;
+            section.level = level;
+            sections.push_back(std::move(section));
         }
-        param_strs.push_back(params_str.substr(start));
+        sections.back().members.push_back(name);
+    }
 
-        // Parse each parameter
-        for (const auto& param_str : param_strs) {
-            std::string trimmed = trim(param_str);
-            if (trimmed.empty()) continue;
+    /**
+     * Parse function parameters
+     */
+    void parseParameters(size_t begin, size_t end, Function& func) {
+        for (const auto& part : splitOnCommas(begin, end)) {
+            size_t first = part.first;
+            size_t last = part.second;
+            if (first >= last) continue;
 
             Parameter param;
 
-            // Simple parameter parsing: type name or just type
-            std::regex param_pattern(R"(([a-zA-Z_][\w:<>,\s*&]*?)\s+([a-zA-Z_]\w*)(?:\s*=\s*(.+))?)");
-            std::smatch match;
+            // Default value
+            size_t decl_end = first;
+            int angle_depth = 0;
+            while (decl_end < last) {
+                const Token& t = tok(decl_end);
+                if (t.isPunct("<")) {
+                    angle_depth++;
+                } else if (t.isPunct(">") && angle_depth > 0) {
+                    angle_depth--;
+                } else if (angle_depth == 0 && t.isPunct("=")) {
+                    break;
+                }
+                decl_end++;
+            }
+            if (decl_end < last) {
+                param.has_default = true;
+                param.default_value = tokenSpanText(decl_end + 1, last);
+            }
 
-            if (std::regex_match(trimmed, match, param_pattern)) {
-                param.type = parseType(match[1].str());
-                param.name = match[2].str();
+            // Array parameters: type name[N]
+            size_t array_begin = decl_end;
+            while (array_begin > first && tok(array_begin - 1).isPunct("]") &&
+                   match_[array_begin - 1] != npos) {
+                array_begin = match_[array_begin - 1];
+            }
 
-                if (match[3].matched) {
-                    param.has_default = true;
-                    param.default_value = match[3].str();
-                }
+            // Simple parameter parsing: type name or just type
+            size_t name_pos = array_begin - 1;
+            bool has_name = array_begin - first >= 2 &&
+                            tok(name_pos).kind == TokenKind::Identifier &&
+                            !tok(name_pos - 1).isPunct("::") &&
+                            !isTypeKeyword(tok(name_pos).text);
+
+            if (has_name) {
+                param.name = std::string(tok(name_pos).text);
+                param.type = parseType(tokenText(first, name_pos) + tokenText(array_begin, decl_end));
             } else {
                 // Just type, no name
-                param.type = parseType(trimmed);
+                param.type = parseType(tokenText(first, decl_end));
                 param.name = "";
             }
 
-            func.parameters.push_back(param);
+            func.parameters.push_back(std::move(param));
         }
     }
 
     /**
-     * Parse type string into Type object
+     * Keywords that end a type spelling rather than name a parameter
+     */
+    static bool isTypeKeyword(std::string_view word) {
+        return word == "int" || word == "char" || word == "short" || word == "long" ||
+               word == "float" || word == "double" || word == "bool" || word == "void" ||
+               word == "unsigned" || word == "signed" || word == "const" || word == "auto" ||
+               word == "volatile";
+    }
+
+    /**
+     * Parse a type spelling into a canonical (interned) Type node
      */
     std::shared_ptr<Type> parseType(const std::string& type_str) {
+        auto cached = type_cache_.find(type_str);
+        if (cached != type_cache_.end()) {
+            return cached->second;
+        }
+
+        auto type = buildType(type_str);
+        if (types_) {
+            type = types_->intern(type);
+        }
+        type_cache_.emplace(type_str, type);
+        return type;
+    }
+
+    std::shared_ptr<Type> buildType(const std::string& type_str) {
         std::string trimmed = trim(type_str);
 
         // Check for const
@@ -326,6 +884,12 @@ private:
             trimmed = trim(trimmed.substr(5));
         }
 
+        if (trimmed.empty()) {
+            auto unknown = std::make_shared<Type>(TypeKind::Class);
+            unknown->is_const = is_const;
+            return unknown;
+        }
+
         // Check for pointer
         if (trimmed.back() == '*') {
             trimmed.pop_back();
@@ -402,21 +966,9 @@ private:
      * Map C++ built-in types
      */
     std::shared_ptr<Type> mapBuiltinType(const std::string& type_name) {
-        static const std::map<std::string, TypeKind> builtin_map = {
-            {"void", TypeKind::Void},
-            {"bool", TypeKind::Bool},
-            {"char", TypeKind::Integer},
-            {"short", TypeKind::Integer},
-            {"int", TypeKind::Integer},
-            {"long", TypeKind::Integer},
-            {"float", TypeKind::Float},
-            {"double", TypeKind::Float},
-            {"size_t", TypeKind::Integer}
-        };
-
-        auto it = builtin_map.find(type_name);
-        if (it != builtin_map.end()) {
-            auto type = std::make_shared<Type>(it->second);
+        const BuiltinTypeName* builtin = findBuiltinType(type_name);
+        if (builtin) {
+            auto type = std::make_shared<Type>(builtin->kind);
             type->name = type_name;
             return type;
         }
@@ -427,14 +979,14 @@ private:
     /**
      * Trim whitespace from string
      */
-    std::string trim(const std::string& str) const {
+    static std::string trim(const std::string& str) {
         size_t start = 0;
-        while (start < str.length() && std::isspace(str[start])) {
+        while (start < str.length() && std::isspace(static_cast<unsigned char>(str[start]))) {
             start++;
         }
 
         size_t end = str.length();
-        while (end > start && std::isspace(str[end - 1])) {
+        while (end > start && std::isspace(static_cast<unsigned char>(str[end - 1]))) {
             end--;
         }
 
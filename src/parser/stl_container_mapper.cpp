@@ -64,6 +64,13 @@ public:
         return type;
     }
 
+    /**
+     * Map STL container to a canonical type owned by the given arena
+     */
+    static std::shared_ptr<Type> mapSTLContainer(const std::string& cpp_type, TypeArena& arena) {
+        return arena.intern(mapSTLContainer(cpp_type));
+    }
+
     /**
      * Get Rust equivalent for STL container
      */
@@ -3,8 +3,7 @@
  * Analyzes C++ threading code and prepares for conversion to Rust/Go concurrency
  */
 
-#include "ir.h"
-#include <regex>
+#include "analysis_pass.h"
 #include <algorithm>
 
 namespace hybrid {
@@ -13,35 +12,19 @@ namespace hybrid {
  * Thread Analyzer
  * Detects and analyzes std::thread, mutexes, atomics, and condition variables
  */
-class ThreadAnalyzer {
+class ThreadAnalyzer : public AnalysisPass {
 public:
     /**
      * Analyze function body for threading patterns
      */
     void analyzeFunction(Function& func) {
-        // Detect thread creation
-        detectThreadCreation(func);
-
-        // Detect mutex and lock usage
-        detectMutexUsage(func);
-
-        // Detect atomic operations
-        detectAtomicOperations(func);
-
-        // Detect condition variables
-        detectConditionVariables(func);
-
-        // Mark function as using threading
-        func.uses_threading = !func.threads_created.empty() ||
-                             !func.lock_scopes.empty() ||
-                             !func.atomic_operations.empty() ||
-                             !func.condition_variables.empty();
+        AnalysisPassManager::runPass(*this, func);
     }
 
     /**
      * Analyze class for thread-safe patterns
      */
-    void analyzeClass(ClassDecl& class_decl) {
+    void analyzeClass(ClassDecl& class_decl) override {
         // Detect mutex members
         detectMutexMembers(class_decl);
 
@@ -53,312 +36,300 @@ public:
                                  !class_decl.atomic_fields.empty();
     }
 
-private:
-    /**
-     * Detect std::thread creation patterns
-     */
-    void detectThreadCreation(Function& func) {
-        std::string body = func.body;
+    const char* name() const override { return "thread"; }
+
+    std::vector<std::string_view> interests() const override {
+        return {
+            // Declarations (std:: qualified)
+            "thread", "lock_guard", "unique_lock", "shared_lock", "atomic", "condition_variable",
+            // Member calls
+            "detach",
+            "load", "store", "fetch_add", "fetch_sub", "exchange",
+            "compare_exchange_weak", "compare_exchange_strong",
+            "wait", "notify_one", "notify_all", "wait_for", "wait_until"
+        };
+    }
 
-        // Pattern 1: std::thread t(func, args...)
-        std::regex thread_pattern1(
-            R"(std::thread\s+(\w+)\s*\(\s*(\w+)\s*(?:,\s*([^)]*))?\))"
-        );
+    void beginFunction(Function& func) override {
+        (void)func;
+        member_calls_.clear();
+    }
 
-        // Pattern 2: std::thread t{func, args...}
-        std::regex thread_pattern2(
-            R"(std::thread\s+(\w+)\s*\{\s*(\w+)\s*(?:,\s*([^}]*))?\})"
-        );
-
-        // Pattern 3: auto t = std::thread(...)
-        std::regex thread_pattern3(
-            R"((?:auto|std::thread)\s+(\w+)\s*=\s*std::thread\s*\(\s*(\w+)\s*(?:,\s*([^)]*))?\))"
-        );
-
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
-
-        // Search for pattern 1
-        while (std::regex_search(search_start, body.cend(), match, thread_pattern1)) {
-            ThreadInfo thread_info;
-            thread_info.thread_var_name = match[1].str();
-            thread_info.function_name = match[2].str();
-
-            // Parse arguments
-            if (match.size() > 3 && match[3].matched) {
-                parseArguments(match[3].str(), thread_info.arguments);
+    void onToken(const BodyScan& scan, size_t index, Function& func) override {
+        std::string_view word = scan.at(index).text;
+
+        if (scan.isQualified(index, "std")) {
+            if (word == "thread") {
+                detectThreadCreation(scan, index, func);
+            } else if (word == "lock_guard") {
+                detectLock(scan, index, LockInfo::LockGuard, func);
+            } else if (word == "unique_lock") {
+                detectLock(scan, index, LockInfo::UniqueLock, func);
+            } else if (word == "shared_lock") {
+                detectLock(scan, index, LockInfo::SharedLock, func);
+            } else if (word == "atomic") {
+                detectAtomicDeclaration(scan, index, func);
+            } else if (word == "condition_variable") {
+                detectConditionVariable(scan, index, func);
             }
-
-            func.threads_created.push_back(thread_info);
-            search_start = match.suffix().first;
+            return;
         }
 
-        // Search for pattern 2
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, thread_pattern2)) {
-            ThreadInfo thread_info;
-            thread_info.thread_var_name = match[1].str();
-            thread_info.function_name = match[2].str();
+        // Member calls: var.op(...)
+        if (index < 2 || !scan.at(index - 1).isPunct(".") ||
+            scan.at(index - 2).kind != TokenKind::Identifier ||
+            !scan.at(index + 1).isPunct("(")) {
+            return;
+        }
+        if (word == "detach" && !scan.at(index + 2).isPunct(")")) {
+            return;
+        }
+        member_calls_.push_back({std::string(scan.at(index - 2).text), std::string(word)});
+    }
 
-            if (match.size() > 3 && match[3].matched) {
-                parseArguments(match[3].str(), thread_info.arguments);
+    void endFunction(Function& func) override {
+        // Calls are resolved once every declaration in the body is known
+        for (const auto& call : member_calls_) {
+            if (call.operation == "detach") {
+                markDetached(func, call.var_name);
+            } else if (isConditionVariableOperation(call.operation)) {
+                addConditionVariableOperation(func, call.var_name, call.operation);
+            } else {
+                addAtomicOperation(func, call.var_name, call.operation);
             }
-
-            func.threads_created.push_back(thread_info);
-            search_start = match.suffix().first;
         }
+        member_calls_.clear();
 
-        // Search for pattern 3
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, thread_pattern3)) {
-            ThreadInfo thread_info;
-            thread_info.thread_var_name = match[1].str();
-            thread_info.function_name = match[2].str();
+        // Mark function as using threading
+        func.uses_threading = !func.threads_created.empty() ||
+                             !func.lock_scopes.empty() ||
+                             !func.atomic_operations.empty() ||
+                             !func.condition_variables.empty();
+    }
 
-            if (match.size() > 3 && match[3].matched) {
-                parseArguments(match[3].str(), thread_info.arguments);
-            }
+private:
+    struct MemberCall {
+        std::string var_name;
+        std::string operation;
+    };
+
+    std::vector<MemberCall> member_calls_;
+
+    /**
+     * Detect std::thread creation patterns
+     */
+    void detectThreadCreation(const BodyScan& scan, size_t index, Function& func) {
+        const Token& next = scan.at(index + 1);
 
-            func.threads_created.push_back(thread_info);
-            search_start = match.suffix().first;
+        // Pattern 1: std::thread t(func, args...)
+        // Pattern 2: std::thread t{func, args...}
+        if (next.kind == TokenKind::Identifier &&
+            (scan.at(index + 2).isPunct("(") || scan.at(index + 2).isPunct("{"))) {
+            addThread(scan, next.text, index + 2, func);
+            return;
         }
 
-        // Detect thread.detach()
-        std::regex detach_pattern(R"((\w+)\.detach\s*\(\))");
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, detach_pattern)) {
-            std::string thread_var = match[1].str();
-
-            // Find the thread in threads_created and mark as detached
-            for (auto& thread : func.threads_created) {
-                if (thread.thread_var_name == thread_var) {
-                    thread.detached = true;
-                    thread.joinable = false;
-                    break;
-                }
+        // Pattern 3: auto t = std::thread(...) or std::thread t = std::thread(...)
+        if (next.isPunct("(") && index >= 5 &&
+            scan.at(index - 3).isPunct("=") &&
+            scan.at(index - 4).kind == TokenKind::Identifier) {
+            size_t decl = index - 5;
+            if (scan.at(decl).isIdentifier("auto") ||
+                (scan.at(decl).isIdentifier("thread") && scan.isQualified(decl, "std"))) {
+                addThread(scan, scan.at(index - 4).text, index + 1, func);
             }
-
-            search_start = match.suffix().first;
         }
     }
 
     /**
-     * Parse function arguments
+     * Record a thread whose constructor arguments start at the bracket at open
      */
-    void parseArguments(const std::string& args_str, std::vector<std::string>& arguments) {
-        if (args_str.empty()) return;
-
-        std::string current_arg;
-        int paren_depth = 0;
-        int bracket_depth = 0;
-
-        for (char c : args_str) {
-            if (c == '(' || c == '{') {
-                paren_depth++;
-                current_arg += c;
-            } else if (c == ')' || c == '}') {
-                paren_depth--;
-                current_arg += c;
-            } else if (c == '[') {
-                bracket_depth++;
-                current_arg += c;
-            } else if (c == ']') {
-                bracket_depth--;
-                current_arg += c;
-            } else if (c == ',' && paren_depth == 0 && bracket_depth == 0) {
-                // End of current argument
-                std::string trimmed = trim(current_arg);
-                if (!trimmed.empty()) {
-                    arguments.push_back(trimmed);
-                }
-                current_arg.clear();
-            } else {
-                current_arg += c;
-            }
+    void addThread(const BodyScan& scan, std::string_view var_name, size_t open, Function& func) {
+        size_t close = scan.matching(open);
+        if (close == BodyScan::npos || scan.at(open + 1).kind != TokenKind::Identifier) {
+            return;
         }
-
-        // Add last argument
-        std::string trimmed = trim(current_arg);
-        if (!trimmed.empty()) {
-            arguments.push_back(trimmed);
+        // Only named functions are recognized as thread entry points
+        if (open + 2 != close && !scan.at(open + 2).isPunct(",")) {
+            return;
         }
+
+        ThreadInfo thread_info;
+        thread_info.thread_var_name = std::string(var_name);
+        thread_info.function_name = std::string(scan.at(open + 1).text);
+
+        std::vector<std::string> arguments = scan.splitArguments(open, close);
+        thread_info.arguments.assign(std::make_move_iterator(arguments.begin() + 1),
+                                     std::make_move_iterator(arguments.end()));
+
+        func.threads_created.push_back(std::move(thread_info));
     }
 
     /**
-     * Detect mutex usage and lock scopes
+     * Find the thread in threads_created and mark as detached
      */
-    void detectMutexUsage(Function& func) {
-        std::string body = func.body;
-
-        // Pattern: std::lock_guard<std::mutex> lock(mutex_name)
-        std::regex lock_guard_pattern(
-            R"(std::lock_guard<[^>]+>\s+(\w+)\s*\(\s*(\w+)\s*\))"
-        );
-
-        // Pattern: std::unique_lock<std::mutex> lock(mutex_name)
-        std::regex unique_lock_pattern(
-            R"(std::unique_lock<[^>]+>\s+(\w+)\s*\(\s*(\w+)\s*\))"
-        );
-
-        // Pattern: std::shared_lock<std::shared_mutex> lock(mutex_name)
-        std::regex shared_lock_pattern(
-            R"(std::shared_lock<[^>]+>\s+(\w+)\s*\(\s*(\w+)\s*\))"
-        );
-
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
-
-        // Detect lock_guard
-        while (std::regex_search(search_start, body.cend(), match, lock_guard_pattern)) {
-            LockInfo lock_info;
-            lock_info.type = LockInfo::LockGuard;
-            lock_info.lock_var_name = match[1].str();
-            lock_info.mutex_name = match[2].str();
-
-            func.lock_scopes.push_back(lock_info);
-            search_start = match.suffix().first;
+    void markDetached(Function& func, const std::string& thread_var) {
+        for (auto& thread : func.threads_created) {
+            if (thread.thread_var_name == thread_var) {
+                thread.detached = true;
+                thread.joinable = false;
+                break;
+            }
         }
+    }
 
-        // Detect unique_lock
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, unique_lock_pattern)) {
-            LockInfo lock_info;
-            lock_info.type = LockInfo::UniqueLock;
-            lock_info.lock_var_name = match[1].str();
-            lock_info.mutex_name = match[2].str();
+    /**
+     * Detect lock scopes: std::lock_guard<std::mutex> lock(mutex_name)
+     * (the template argument list may be omitted, as with C++17 deduction)
+     */
+    void detectLock(const BodyScan& scan, size_t index, LockInfo::LockType type, Function& func) {
+        size_t pos = index + 1;
+        if (scan.at(pos).isPunct("<")) {
+            pos = scan.matchingAngle(pos);
+            if (pos == BodyScan::npos) return;
+            ++pos;
+        }
 
-            func.lock_scopes.push_back(lock_info);
-            search_start = match.suffix().first;
+        const Token& var = scan.at(pos);
+        const Token& open = scan.at(pos + 1);
+        const Token& mutex = scan.at(pos + 2);
+        if (var.kind != TokenKind::Identifier ||
+            !(open.isPunct("(") || open.isPunct("{")) ||
+            mutex.kind != TokenKind::Identifier ||
+            scan.matching(pos + 1) != pos + 3) {
+            return;
         }
 
-        // Detect shared_lock
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, shared_lock_pattern)) {
-            LockInfo lock_info;
-            lock_info.type = LockInfo::SharedLock;
-            lock_info.lock_var_name = match[1].str();
-            lock_info.mutex_name = match[2].str();
+        LockInfo lock_info;
+        lock_info.type = type;
+        lock_info.lock_var_name = std::string(var.text);
+        lock_info.mutex_name = std::string(mutex.text);
 
-            func.lock_scopes.push_back(lock_info);
-            search_start = match.suffix().first;
+        if (index == 2 && scan.at(pos + 4).isPunct(";")) {
+            detectGuardedUpdate(scan, pos + 5, lock_info, func);
         }
+        func.lock_scopes.push_back(std::move(lock_info));
     }
 
     /**
-     * Detect atomic operations
+     * A body that is just the lock and one update or read of a variable,
+     * starting at first: ++v; v--; v += n; v -= n; return v;
      */
-    void detectAtomicOperations(Function& func) {
-        std::string body = func.body;
-
-        // Pattern: std::atomic<T> var_name
-        std::regex atomic_pattern(
-            R"(std::atomic<([^>]+)>\s+(\w+))"
-        );
-
-        // Pattern: var.load(), var.store(), var.fetch_add(), etc.
-        std::regex atomic_op_pattern(
-            R"((\w+)\.(load|store|fetch_add|fetch_sub|exchange|compare_exchange_weak|compare_exchange_strong)\s*\()"
-        );
-
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
-
-        // Detect atomic variable declarations
-        while (std::regex_search(search_start, body.cend(), match, atomic_pattern)) {
-            AtomicInfo atomic_info;
-            atomic_info.atomic_var_name = match[2].str();
-
-            // Create type for atomic value
-            std::string type_name = match[1].str();
-            auto value_type = std::make_shared<Type>(TypeKind::Integer); // Simplified
-            value_type->name = type_name;
-            atomic_info.value_type = value_type;
-
-            func.atomic_operations.push_back(atomic_info);
-            search_start = match.suffix().first;
+    void detectGuardedUpdate(const BodyScan& scan, size_t first, const LockInfo& lock, Function& func) {
+        size_t last = scan.size() - 1;
+        if (last <= first || !scan.at(last).isPunct(";")) return;
+
+        auto isVariable = [&](size_t i) {
+            const Token& t = scan.at(i);
+            return t.kind == TokenKind::Identifier && t.text != lock.mutex_name && t.text != lock.lock_var_name &&
+                   t.text != "return" && t.text != "this";
+        };
+        size_t var = first;
+        if (scan.at(var).isIdentifier("this") && scan.at(var + 1).isPunct("->")) {
+            var += 2;
         }
 
-        // Detect atomic operations
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, atomic_op_pattern)) {
-            std::string var_name = match[1].str();
-            std::string operation = match[2].str();
-
-            // Find or create atomic info
-            bool found = false;
-            for (auto& atomic : func.atomic_operations) {
-                if (atomic.atomic_var_name == var_name) {
-                    atomic.operations.push_back(operation);
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) {
-                // Variable might be a member, create entry anyway
-                AtomicInfo atomic_info;
-                atomic_info.atomic_var_name = var_name;
-                atomic_info.operations.push_back(operation);
-                func.atomic_operations.push_back(atomic_info);
-            }
-
-            search_start = match.suffix().first;
+        GuardedUpdate update;
+        update.mutex_name = lock.mutex_name;
+        update.operand = "1";
+        std::string_view prefix = scan.punctuator(first);
+        std::string_view postfix = scan.punctuator(var + 1);
+        if ((prefix == "++" || prefix == "--") && first + 3 == last && isVariable(first + 2)) {
+            update.operation = prefix == "++" ? GuardedUpdate::Add : GuardedUpdate::Subtract;
+            update.var_name = std::string(scan.at(first + 2).text);
+        } else if (scan.at(first).isIdentifier("return") && first + 2 == last && isVariable(first + 1)) {
+            update.operation = GuardedUpdate::Read;
+            update.var_name = std::string(scan.at(first + 1).text);
+            update.operand.clear();
+        } else if (isVariable(var) && var + 3 == last && (postfix == "++" || postfix == "--")) {
+            update.operation = postfix == "++" ? GuardedUpdate::Add : GuardedUpdate::Subtract;
+            update.var_name = std::string(scan.at(var).text);
+        } else if (isVariable(var) && var + 3 < last && (postfix == "+=" || postfix == "-=")) {
+            update.operation = postfix == "+=" ? GuardedUpdate::Add : GuardedUpdate::Subtract;
+            update.var_name = std::string(scan.at(var).text);
+            update.operand = std::string(scan.text(var + 3, last - 1));
+        } else {
+            return;
         }
+        func.guarded_updates.push_back(std::move(update));
     }
 
     /**
-     * Detect condition variables
+     * Detect atomic variable declarations: std::atomic<T> var_name
      */
-    void detectConditionVariables(Function& func) {
-        std::string body = func.body;
+    void detectAtomicDeclaration(const BodyScan& scan, size_t index, Function& func) {
+        if (!scan.at(index + 1).isPunct("<")) return;
 
-        // Pattern: std::condition_variable cv_name
-        std::regex cv_pattern(
-            R"(std::condition_variable\s+(\w+))"
-        );
+        size_t close = scan.matchingAngle(index + 1);
+        if (close == BodyScan::npos || close == index + 2 ||
+            scan.at(close + 1).kind != TokenKind::Identifier) {
+            return;
+        }
 
-        // Pattern: cv.wait(lock), cv.notify_one(), cv.notify_all()
-        std::regex cv_op_pattern(
-            R"((\w+)\.(wait|notify_one|notify_all|wait_for|wait_until)\s*\()"
-        );
+        AtomicInfo atomic_info;
+        atomic_info.atomic_var_name = std::string(scan.at(close + 1).text);
 
-        std::smatch match;
-        std::string::const_iterator search_start(body.cbegin());
+        // Create type for atomic value
+        auto value_type = std::make_shared<Type>(TypeKind::Integer); // Simplified
+        value_type->name = std::string(scan.text(index + 2, close - 1));
+        atomic_info.value_type = value_type;
 
-        // Detect condition variable declarations
-        while (std::regex_search(search_start, body.cend(), match, cv_pattern)) {
-            ConditionVariableInfo cv_info;
-            cv_info.cv_var_name = match[1].str();
+        func.atomic_operations.push_back(std::move(atomic_info));
+    }
 
-            func.condition_variables.push_back(cv_info);
-            search_start = match.suffix().first;
+    /**
+     * Record load/store/fetch_add/... on a variable
+     */
+    void addAtomicOperation(Function& func, const std::string& var_name, const std::string& operation) {
+        // Find or create atomic info
+        for (auto& atomic : func.atomic_operations) {
+            if (atomic.atomic_var_name == var_name) {
+                atomic.operations.push_back(operation);
+                return;
+            }
         }
 
-        // Detect condition variable operations
-        search_start = body.cbegin();
-        while (std::regex_search(search_start, body.cend(), match, cv_op_pattern)) {
-            std::string cv_var = match[1].str();
-            std::string operation = match[2].str();
-
-            // Find or create CV info
-            bool found = false;
-            for (auto& cv : func.condition_variables) {
-                if (cv.cv_var_name == cv_var) {
-                    cv.wait_conditions.push_back(operation);
-                    found = true;
-                    break;
-                }
-            }
+        // Variable might be a member, create entry anyway
+        AtomicInfo atomic_info;
+        atomic_info.atomic_var_name = var_name;
+        atomic_info.operations.push_back(operation);
+        func.atomic_operations.push_back(std::move(atomic_info));
+    }
 
-            if (!found) {
-                ConditionVariableInfo cv_info;
-                cv_info.cv_var_name = cv_var;
-                cv_info.wait_conditions.push_back(operation);
-                func.condition_variables.push_back(cv_info);
-            }
+    /**
+     * Detect condition variable declarations: std::condition_variable cv_name
+     */
+    void detectConditionVariable(const BodyScan& scan, size_t index, Function& func) {
+        const Token& var = scan.at(index + 1);
+        if (var.kind != TokenKind::Identifier) return;
 
-            search_start = match.suffix().first;
+        ConditionVariableInfo cv_info;
+        cv_info.cv_var_name = std::string(var.text);
+        func.condition_variables.push_back(std::move(cv_info));
+    }
+
+    static bool isConditionVariableOperation(const std::string& operation) {
+        return operation == "wait" || operation == "notify_one" || operation == "notify_all" ||
+               operation == "wait_for" || operation == "wait_until";
+    }
+
+    /**
+     * Record cv.wait(lock), cv.notify_one(), cv.notify_all(), ...
+     */
+    void addConditionVariableOperation(Function& func, const std::string& cv_var,
+                                       const std::string& operation) {
+        // Find or create CV info
+        for (auto& cv : func.condition_variables) {
+            if (cv.cv_var_name == cv_var) {
+                cv.wait_conditions.push_back(operation);
+                return;
+            }
         }
+
+        ConditionVariableInfo cv_info;
+        cv_info.cv_var_name = cv_var;
+        cv_info.wait_conditions.push_back(operation);
+        func.condition_variables.push_back(std::move(cv_info));
     }
 
     /**
@@ -398,17 +369,6 @@ private:
             }
         }
     }
-
-    /**
-     * Trim whitespace from string
-     */
-    std::string trim(const std::string& str) {
-        size_t first = str.find_first_not_of(" \t\n\r");
-        if (first == std::string::npos) return "";
-
-        size_t last = str.find_last_not_of(" \t\n\r");
-        return str.substr(first, last - first + 1);
-    }
 };
 
 /**
@@ -501,4 +461,8 @@ public:
     }
 };
 
+std::unique_ptr<AnalysisPass> createThreadAnalysisPass() {
+    return std::make_unique<ThreadAnalyzer>();
+}
+
 } // namespace hybrid
@@ -1,5 +1,5 @@
 #include "ir.h"
-#include <map>
+#include "type_names.h"
 #include <string>
 
 namespace hybrid {
@@ -10,37 +10,11 @@ namespace hybrid {
 class TypeMapper {
 public:
     static std::shared_ptr<Type> mapBuiltinType(const std::string& cpp_type) {
-        static const std::map<std::string, TypeKind> builtin_map = {
-            {"void", TypeKind::Void},
-            {"bool", TypeKind::Bool},
-            {"char", TypeKind::Integer},
-            {"short", TypeKind::Integer},
-            {"int", TypeKind::Integer},
-            {"long", TypeKind::Integer},
-            {"long long", TypeKind::Integer},
-            {"unsigned char", TypeKind::Integer},
-            {"unsigned short", TypeKind::Integer},
-            {"unsigned int", TypeKind::Integer},
-            {"unsigned long", TypeKind::Integer},
-            {"unsigned long long", TypeKind::Integer},
-            {"int8_t", TypeKind::Integer},
-            {"int16_t", TypeKind::Integer},
-            {"int32_t", TypeKind::Integer},
-            {"int64_t", TypeKind::Integer},
-            {"uint8_t", TypeKind::Integer},
-            {"uint16_t", TypeKind::Integer},
-            {"uint32_t", TypeKind::Integer},
-            {"uint64_t", TypeKind::Integer},
-            {"size_t", TypeKind::Integer},
-            {"float", TypeKind::Float},
-            {"double", TypeKind::Float}
-        };
-
-        auto it = builtin_map.find(cpp_type);
-        if (it != builtin_map.end()) {
-            auto type = std::make_shared<Type>(it->second);
+        const BuiltinTypeName* builtin = findBuiltinType(cpp_type);
+        if (builtin) {
+            auto type = std::make_shared<Type>(builtin->kind);
             type->name = cpp_type;
-            type->size_bytes = getSizeForType(cpp_type);
+            type->size_bytes = builtin->size_bytes;
             type->alignment = type->size_bytes;
             return type;
         }
@@ -48,6 +22,13 @@ public:
         return nullptr;
     }
 
+    /**
+     * Map a builtin type to its canonical node in the given arena
+     */
+    static std::shared_ptr<Type> mapBuiltinType(const std::string& cpp_type, TypeArena& arena) {
+        return arena.intern(mapBuiltinType(cpp_type));
+    }
+
     static std::shared_ptr<Type> mapPointerType(std::shared_ptr<Type> pointee) {
         auto ptr_type = std::make_shared<Type>(TypeKind::Pointer);
         ptr_type->element_type = pointee;
@@ -97,38 +78,6 @@ public:
         ptr_type->alignment = sizeof(void*);
         return ptr_type;
     }
-
-private:
-    static size_t getSizeForType(const std::string& type_name) {
-        static const std::map<std::string, size_t> size_map = {
-            {"void", 0},
-            {"bool", 1},
-            {"char", 1},
-            {"short", 2},
-            {"int", 4},
-            {"long", 8},
-            {"long long", 8},
-            {"unsigned char", 1},
-            {"unsigned short", 2},
-            {"unsigned int", 4},
-            {"unsigned long", 8},
-            {"unsigned long long", 8},
-            {"int8_t", 1},
-            {"int16_t", 2},
-            {"int32_t", 4},
-            {"int64_t", 8},
-            {"uint8_t", 1},
-            {"uint16_t", 2},
-            {"uint32_t", 4},
-            {"uint64_t", 8},
-            {"size_t", 8},
-            {"float", 4},
-            {"double", 8}
-        };
-
-        auto it = size_map.find(type_name);
-        return (it != size_map.end()) ? it->second : 0;
-    }
 };
 
 /**
@@ -0,0 +1,199 @@
+#include "profiler.h"
+#include "json.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+namespace hybrid {
+
+std::atomic<bool> Profiler::enabled_{false};
+
+Profiler& Profiler::global() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    totals_.clear();
+    epoch_ = Clock::now();
+    stop_ns_ = 0;
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stop() {
+    enabled_.store(false, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ns_ = now();
+}
+
+uint64_t Profiler::now() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count());
+}
+
+void Profiler::record(ProfileEvent event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(std::move(event));
+}
+
+void Profiler::recordTotal(const char* category, const char* name, uint64_t nanoseconds, uint64_t calls) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    totals_.push_back(Total{category, name, nanoseconds, calls});
+}
+
+std::vector<ProfileEvent> Profiler::getEvents() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+}
+
+uint32_t Profiler::threadIndex() {
+    static std::atomic<uint32_t> next_index{0};
+    thread_local uint32_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+void Profiler::writeStats(std::ostream& out) const {
+    struct Row {
+        std::string phase;
+        uint64_t calls = 0;
+        uint64_t nanoseconds = 0;
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+        uint64_t bytes = 0;
+    };
+
+    std::map<std::string, Row> rows;
+    uint32_t threads = 0;
+    uint64_t wall_ns = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& event : events_) {
+            std::string phase = std::string(event.category) + "/" + event.name;
+            Row& row = rows[phase];
+            row.phase = phase;
+            row.calls++;
+            row.nanoseconds += event.duration_ns;
+            row.allocations += event.allocations;
+            row.allocated_bytes += event.allocated_bytes;
+            row.bytes += event.bytes;
+            threads = std::max(threads, event.thread + 1);
+        }
+        for (const auto& total : totals_) {
+            std::string phase = std::string(total.category) + "/" + total.name;
+            Row& row = rows[phase];
+            row.phase = phase;
+            row.calls += total.calls;
+            row.nanoseconds += total.nanoseconds;
+        }
+        wall_ns = stop_ns_ ? stop_ns_ : now();
+    }
+
+    std::vector<Row> sorted;
+    sorted.reserve(rows.size());
+    for (auto& entry : rows) {
+        sorted.push_back(std::move(entry.second));
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Row& a, const Row& b) {
+        return a.nanoseconds != b.nanoseconds ? a.nanoseconds > b.nanoseconds : a.phase < b.phase;
+    });
+
+    std::ios_base::fmtflags flags = out.flags();
+    out << "\nPhase statistics (wall time is inclusive of nested phases):\n";
+    out << std::left << std::setw(28) << "  Phase" << std::right
+        << std::setw(9) << "Calls"
+        << std::setw(12) << "Wall ms"
+        << std::setw(11) << "Allocs"
+        << std::setw(13) << "Alloc KiB"
+        << std::setw(13) << "Bytes KiB" << "\n";
+
+    out << std::fixed;
+    for (const auto& row : sorted) {
+        out << "  " << std::left << std::setw(26) << row.phase << std::right
+            << std::setw(9) << row.calls
+            << std::setw(12) << std::setprecision(3) << row.nanoseconds / 1e6
+            << std::setw(11) << row.allocations
+            << std::setw(13) << std::setprecision(1) << row.allocated_bytes / 1024.0
+            << std::setw(13) << std::setprecision(1) << row.bytes / 1024.0 << "\n";
+    }
+    out << "  Total wall time: " << std::setprecision(3) << wall_ns / 1e6 << " ms on "
+        << threads << (threads == 1 ? " thread" : " threads") << "\n";
+    out.flags(flags);
+}
+
+namespace {
+
+void writeJsonString(std::ostream& out, std::string_view text) {
+    std::string quoted;
+    appendJsonString(quoted, text);
+    out << quoted;
+}
+
+} // namespace
+
+bool Profiler::writeTrace(const std::string& path, std::string& error) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        error = "Failed to open trace file: " + path;
+        return false;
+    }
+
+    std::vector<ProfileEvent> events = getEvents();
+    std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.start_ns < b.start_ns;
+    });
+
+    // Timestamps are microseconds; three decimals keep nanosecond resolution
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < events.size(); ++i) {
+        const ProfileEvent& event = events[i];
+        out << "{\"name\":";
+        writeJsonString(out, event.name);
+        out << ",\"cat\":";
+        writeJsonString(out, event.category);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << event.start_ns / 1e3
+            << ",\"dur\":" << event.duration_ns / 1e3
+            << ",\"args\":{";
+        if (!event.detail.empty()) {
+            out << "\"detail\":";
+            writeJsonString(out, event.detail);
+            out << ",";
+        }
+        out << "\"allocs\":" << event.allocations
+            << ",\"alloc_bytes\":" << event.allocated_bytes
+            << ",\"bytes\":" << event.bytes << "}}";
+        out << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+
+    if (!out.good()) {
+        error = "Failed to write trace file: " + path;
+        return false;
+    }
+    return true;
+}
+
+void ProfileScope::begin(const char* category, const char* name, std::string_view detail, uint64_t bytes) {
+    event_.category = category;
+    event_.name = name;
+    event_.detail.assign(detail.data(), detail.size());
+    event_.bytes = bytes;
+    event_.thread = Profiler::threadIndex();
+    allocations_start_ = Profiler::threadAllocations();
+    allocated_bytes_start_ = Profiler::threadAllocatedBytes();
+    event_.start_ns = Profiler::global().now();
+}
+
+void ProfileScope::end() {
+    Profiler& profiler = Profiler::global();
+    event_.duration_ns = profiler.now() - event_.start_ns;
+    event_.allocations = Profiler::threadAllocations() - allocations_start_;
+    event_.allocated_bytes = Profiler::threadAllocatedBytes() - allocated_bytes_start_;
+    profiler.record(std::move(event_));
+}
+
+} // namespace hybrid
@@ -0,0 +1,45 @@
+#include "resource_budget.h"
+
+namespace hybrid {
+
+ResourceBudget::ResourceBudget(uint64_t time_ms, uint64_t memory_bytes)
+    : start_(std::chrono::steady_clock::now()),
+      deadline_(start_ + std::chrono::milliseconds(time_ms)),
+      time_ms_(time_ms), memory_bytes_(memory_bytes) {
+}
+
+void ResourceBudget::check(const char* phase) {
+    if (exceeded_.load(std::memory_order_acquire)) {
+        exceed(std::string(), phase);
+    }
+    if (time_ms_ != 0 && std::chrono::steady_clock::now() > deadline_) {
+        exceed("exceeded its " + std::to_string(time_ms_) + " ms time budget during " + phase, phase);
+    }
+}
+
+void ResourceBudget::charge(uint64_t bytes, const char* phase) {
+    uint64_t charged = charged_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (memory_bytes_ != 0 && charged > memory_bytes_) {
+        exceed("exceeded its " + std::to_string(memory_bytes_ >> 20) + " MiB memory budget during " + phase +
+               " (" + std::to_string(charged >> 20) + " MiB)", phase);
+    }
+    check(phase);
+}
+
+double ResourceBudget::getElapsedMs() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_);
+    return static_cast<double>(elapsed.count()) / 1000.0;
+}
+
+void ResourceBudget::exceed(std::string message, const char* phase) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!exceeded_.load(std::memory_order_relaxed)) {
+        message_ = std::move(message);
+        phase_ = phase;
+        exceeded_.store(true, std::memory_order_release);
+    }
+    throw BudgetExceeded(message_, phase_);
+}
+
+} // namespace hybrid
@@ -0,0 +1,445 @@
+#include "server.h"
+#include "build_cache.h"
+#include "declaration_index.h"
+#include "header_cache.h"
+#include "source_buffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace hybrid {
+
+namespace {
+
+// JSON-RPC 2.0 error codes
+constexpr int kParseError = -32700;
+constexpr int kInvalidRequest = -32600;
+constexpr int kMethodNotFound = -32601;
+constexpr int kInvalidParams = -32602;
+constexpr int kTranspileFailed = -32000;
+
+// Longest request line accepted on a socket (sources travel inline)
+constexpr size_t kMaxMessageBytes = 256 * 1024 * 1024;
+
+// Listening socket woken by SIGINT/SIGTERM in socket mode
+std::atomic<int> g_signal_listen_fd{-1};
+
+extern "C" void handleStopSignal(int) {
+    int fd = g_signal_listen_fd.load();
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+std::string errorResponse(const JsonValue& id, int code, const std::string& message) {
+    JsonValue error = JsonValue::object();
+    error.set("code", code);
+    error.set("message", message);
+
+    JsonValue response = JsonValue::object();
+    response.set("jsonrpc", "2.0");
+    response.set("id", id);
+    response.set("error", std::move(error));
+    return response.dump();
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+TranspileServer::TranspileServer(const TranspilerOptions& options, size_t cache_bytes)
+    : options_(options), started_(std::chrono::steady_clock::now()), cache_limit_(cache_bytes) {
+}
+
+TranspileServer::~TranspileServer() = default;
+
+Transpiler& TranspileServer::transpilerFor(TargetLanguage target) {
+    auto& transpiler = transpilers_[static_cast<size_t>(target)];
+    if (!transpiler) {
+        TranspilerOptions options = options_;
+        options.target = target;
+        transpiler = std::make_unique<Transpiler>(options);
+    }
+    return *transpiler;
+}
+
+bool TranspileServer::cacheLookup(const std::string& key, std::string& code) {
+    auto it = cache_index_.find(key);
+    if (it == cache_index_.end()) {
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    code = it->second->code;
+    return true;
+}
+
+void TranspileServer::cacheStore(const std::string& key, const std::string& code) {
+    if (code.size() > cache_limit_ || cache_index_.count(key)) {
+        return;
+    }
+
+    lru_.push_front(CacheEntry{key, code});
+    cache_index_[key] = lru_.begin();
+    cache_bytes_ += code.size();
+
+    while (cache_bytes_ > cache_limit_ && !lru_.empty()) {
+        cache_bytes_ -= lru_.back().code.size();
+        cache_index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
+
+std::string TranspileServer::handleMessage(std::string_view message) {
+    JsonValue request;
+    std::string parse_error;
+    if (!JsonValue::parse(message, request, parse_error)) {
+        return errorResponse(JsonValue(), kParseError, "Parse error: " + parse_error);
+    }
+
+    JsonValue id = request["id"];
+    bool notification = !request.has("id");
+    if (!request.isObject() || !request["method"].isString()) {
+        return errorResponse(id, kInvalidRequest, "Invalid request: expected an object with a method");
+    }
+
+    int error_code = 0;
+    std::string error;
+    JsonValue result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++requests_;
+        result = dispatch(request["method"].asString(), request["params"], error_code, error);
+        if (error_code != 0) {
+            ++failures_;
+        }
+    }
+
+    if (notification) {
+        return std::string();
+    }
+    if (error_code != 0) {
+        return errorResponse(id, error_code, error);
+    }
+
+    JsonValue response = JsonValue::object();
+    response.set("jsonrpc", "2.0");
+    response.set("id", id);
+    response.set("result", std::move(result));
+    return response.dump();
+}
+
+JsonValue TranspileServer::dispatch(const std::string& method, const JsonValue& params,
+                                    int& error_code, std::string& error) {
+    if (!params.isNull() && !params.isObject()) {
+        error_code = kInvalidParams;
+        error = "params must be an object";
+        return JsonValue();
+    }
+
+    if (method == "transpile") {
+        return transpileRequest(params, error_code, error);
+    } else if (method == "status") {
+        return statusRequest();
+    } else if (method == "shutdown") {
+        shutdown_.store(true);     // Listener is woken once the answer is sent
+        return JsonValue();
+    }
+
+    error_code = kMethodNotFound;
+    error = "Method not found: " + method;
+    return JsonValue();
+}
+
+JsonValue TranspileServer::transpileRequest(const JsonValue& params, int& error_code, std::string& error) {
+    auto start = std::chrono::steady_clock::now();
+
+    TargetLanguage target = options_.target;
+    if (params.has("target")) {
+        const std::string& name = params["target"].asString();
+        if (name == "rust") {
+            target = TargetLanguage::Rust;
+        } else if (name == "go") {
+            target = TargetLanguage::Go;
+        } else {
+            error_code = kInvalidParams;
+            error = "Unknown target language '" + name + "' (expected rust or go)";
+            return JsonValue();
+        }
+    }
+
+    const std::string& path = params["path"].asString();
+    std::shared_ptr<const SourceBuffer> source;
+    if (params["source"].isString()) {
+        source = SourceBuffer::fromString(params["source"].asString(), path);
+    } else if (!path.empty()) {
+        try {
+            // Not mapped: an editor truncating the file mid-request must not crash the server
+            source = SourceBuffer::fromFile(path, false);
+        }
+        catch (const std::exception& e) {
+            error_code = kTranspileFailed;
+            error = "Failed to read input file: " + std::string(e.what());
+            return JsonValue();
+        }
+    } else {
+        error_code = kInvalidParams;
+        error = "transpile needs 'source' or 'path'";
+        return JsonValue();
+    }
+
+    // Outputs of identical sources under identical options are reused
+    Transpiler& transpiler = transpilerFor(target);
+    const std::string& declaration = params["declaration"].asString();
+    const HeaderCache* headers = transpiler.getHeaderCache();
+    std::string key = BuildCache::computeKey(source->text(), transpiler.getOptions(),
+                                             headers ? headers->dependencyHash(*source) : std::string());
+    if (!declaration.empty()) {
+        key += "#" + declaration;
+    }
+
+    std::string code;
+    bool cached = cacheLookup(key, code);
+    if (cached) {
+        ++cache_hits_;
+    } else {
+        // A single declaration only needs the cheap index plus its own parse
+        bool ok = declaration.empty()
+            ? transpiler.transpileSource(source, code)
+            : transpiler.transpileDeclaration(DeclarationIndex(source), declaration, code);
+        if (!ok) {
+            error_code = kTranspileFailed;
+            error = transpiler.getLastError();
+            return JsonValue();
+        }
+        ++transpiled_;
+        cacheStore(key, code);
+    }
+
+    JsonValue result = JsonValue::object();
+    const std::string& output = params["output"].asString();
+    if (!output.empty()) {
+        if (!Transpiler::writeOutputFile(output, code, error)) {
+            error_code = kTranspileFailed;
+            return JsonValue();
+        }
+        result.set("output", output);
+    } else {
+        result.set("code", std::move(code));
+    }
+    result.set("cached", cached);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    result.set("elapsed_ms", static_cast<double>(elapsed.count()) / 1000.0);
+    return result;
+}
+
+JsonValue TranspileServer::statusRequest() const {
+    auto uptime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started_);
+
+    JsonValue status = JsonValue::object();
+    status.set("version", HYBRID_TRANSPILER_VERSION);
+    status.set("uptime_ms", static_cast<int64_t>(uptime.count()));
+    status.set("requests", requests_);
+    status.set("transpiled", transpiled_);
+    status.set("cache_hits", cache_hits_);
+    status.set("failures", failures_);
+    status.set("cache_entries", static_cast<uint64_t>(lru_.size()));
+    status.set("cache_bytes", static_cast<uint64_t>(cache_bytes_));
+    return status;
+}
+
+void TranspileServer::serveStream(std::istream& in, std::ostream& out) {
+    std::string line;
+    while (!isShutdownRequested() && std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+
+        std::string response = handleMessage(line);
+        if (!response.empty()) {
+            out << response << '\n';
+            out.flush();
+        }
+    }
+}
+
+void TranspileServer::wakeListener() {
+    int fd = listen_fd_.load();
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void TranspileServer::serveConnection(int fd) {
+    std::string pending;
+    char buffer[64 * 1024];
+
+    bool connected = true;
+    while (connected && !isShutdownRequested()) {
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        size_t scanned = pending.size();
+        pending.append(buffer, static_cast<size_t>(n));
+
+        // Answer every complete line; keep the partial tail for the next read
+        size_t line_start = 0;
+        size_t newline;
+        while ((newline = pending.find('\n', scanned)) != std::string::npos) {
+            std::string_view line(pending.data() + line_start, newline - line_start);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.find_first_not_of(" \t") != std::string_view::npos) {
+                std::string response = handleMessage(line);
+                if (!response.empty() && !sendAll(fd, response + "\n")) {
+                    connected = false;      // Peer gone; the fd is dropped and closed below
+                    break;
+                }
+            }
+            line_start = newline + 1;
+            scanned = line_start;
+            if (isShutdownRequested()) {
+                wakeListener();
+                break;
+            }
+        }
+        pending.erase(0, line_start);
+
+        if (pending.size() > kMaxMessageBytes) {
+            sendAll(fd, errorResponse(JsonValue(), kInvalidRequest, "Message too large") + "\n");
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections_.erase(std::remove(connections_.begin(), connections_.end(), fd), connections_.end());
+        finished_workers_.push_back(std::this_thread::get_id());
+    }
+    ::close(fd);
+}
+
+bool TranspileServer::serveSocket(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "Invalid socket path: " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        error = "Failed to create socket: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    // A leftover socket file from a dead server is replaced; a live one is not
+    struct stat info;
+    if (::lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe >= 0 &&
+                    ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (live) {
+            ::close(listen_fd);
+            error = "Another server is already listening on " + path;
+            return false;
+        }
+        ::unlink(path.c_str());
+    }
+
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd, 16) != 0) {
+        error = "Failed to listen on " + path + ": " + std::strerror(errno);
+        ::close(listen_fd);
+        return false;
+    }
+
+    listen_fd_.store(listen_fd);
+    g_signal_listen_fd.store(listen_fd);
+    auto previous_int = std::signal(SIGINT, handleStopSignal);
+    auto previous_term = std::signal(SIGTERM, handleStopSignal);
+
+    std::vector<std::thread> workers;
+    while (!isShutdownRequested()) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;      // Listener shut down (shutdown request or signal)
+        }
+
+        // Join the connections that closed since the last accept, so a
+        // long-lived server holds threads only for open connections
+        std::vector<std::thread> finished;
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            for (auto it = workers.begin(); it != workers.end();) {
+                if (std::find(finished_workers_.begin(), finished_workers_.end(), it->get_id()) !=
+                    finished_workers_.end()) {
+                    finished.push_back(std::move(*it));
+                    it = workers.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            finished_workers_.clear();
+            connections_.push_back(fd);
+            workers.emplace_back(&TranspileServer::serveConnection, this, fd);
+        }
+        for (auto& worker : finished) {
+            worker.join();
+        }
+    }
+
+    std::signal(SIGINT, previous_int);
+    std::signal(SIGTERM, previous_term);
+    g_signal_listen_fd.store(-1);
+    listen_fd_.store(-1);
+
+    // Unblock connections still waiting for input, then wait for them
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (int fd : connections_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    finished_workers_.clear();
+
+    ::close(listen_fd);
+    ::unlink(path.c_str());
+    return true;
+}
+
+} // namespace hybrid
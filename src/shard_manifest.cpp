@@ -0,0 +1,384 @@
+#include "shard_manifest.h"
+#include "codegen.h"
+#include "ir.h"
+#include "ir_serializer.h"
+#include "json.h"
+#include "profiler.h"
+#include "source_buffer.h"
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+
+namespace hybrid {
+
+namespace fs = std::filesystem;
+
+bool ShardSpec::parse(const std::string& text, ShardSpec& spec, std::string& error) {
+    size_t slash = text.find('/');
+    unsigned long long index = 0;
+    unsigned long long count = 0;
+    bool valid = slash != std::string::npos && slash > 0 && slash + 1 < text.size() &&
+                 text.find_first_not_of("0123456789/") == std::string::npos &&
+                 text.find('/', slash + 1) == std::string::npos;
+    if (valid) {
+        try {
+            index = std::stoull(text.substr(0, slash));
+            count = std::stoull(text.substr(slash + 1));
+        }
+        catch (const std::exception&) {
+            valid = false;
+        }
+    }
+    if (!valid || index < 1 || index > count) {
+        error = "Invalid shard '" + text + "': expected i/N with 1 <= i <= N";
+        return false;
+    }
+    spec.index = static_cast<size_t>(index - 1);
+    spec.count = static_cast<size_t>(count);
+    return true;
+}
+
+std::string ShardSpec::toString() const {
+    return std::to_string(index + 1) + "/" + std::to_string(count);
+}
+
+std::vector<size_t> ShardSpec::assign(const std::vector<std::string>& inputs, size_t count) {
+    std::vector<uint64_t> sizes;
+    sizes.reserve(inputs.size());
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(input, ec);
+        sizes.push_back(ec ? 0 : static_cast<uint64_t>(size));
+    }
+    return assign(inputs, sizes, count);
+}
+
+std::vector<size_t> ShardSpec::assign(const std::vector<std::string>& inputs,
+                                      const std::vector<uint64_t>& sizes, size_t count) {
+    std::vector<size_t> order(inputs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sizes[a] != sizes[b] ? sizes[a] > sizes[b] : inputs[a] < inputs[b];
+    });
+
+    // Greedy largest-first: within one file of the best split, and cheap
+    std::vector<size_t> shards(inputs.size(), 0);
+    std::vector<uint64_t> load(std::max<size_t>(count, 1), 0);
+    for (size_t i : order) {
+        size_t lightest = std::min_element(load.begin(), load.end()) - load.begin();
+        shards[i] = lightest;
+        load[lightest] += sizes[i];
+    }
+    return shards;
+}
+
+ShardManifest ShardManifest::fromBatch(const ShardSpec& shard, const TranspilerOptions& options,
+                                       const std::vector<FileResult>& results) {
+    ShardManifest manifest;
+    manifest.shard = shard;
+    manifest.targets = Transpiler::getTargets(options);
+    manifest.optimization_level = options.optimization_level;
+    manifest.monomorphization_budget = options.monomorphization_budget;
+    manifest.enable_safety_checks = options.enable_safety_checks;
+    manifest.preserve_comments = options.preserve_comments;
+    manifest.generate_tests = options.generate_tests;
+    for (const auto& result : results) {
+        ManifestEntry entry;
+        entry.input_path = result.input_path;
+        entry.output_paths = result.output_paths;
+        entry.ir_path = result.success ? result.ir_path : "";
+        entry.source_hash = result.source_hash;
+        entry.elapsed_ms = result.elapsed_ms;
+        entry.success = result.success;
+        entry.cache_hit = result.cache_hit;
+        entry.over_budget = result.over_budget;
+        entry.diagnostic = result.error;
+        manifest.entries.push_back(std::move(entry));
+    }
+    return manifest;
+}
+
+TranspilerOptions ShardManifest::options() const {
+    TranspilerOptions options;
+    options.target = targets.empty() ? TargetLanguage::Rust : targets[0];
+    options.targets = targets.size() > 1 ? targets : std::vector<TargetLanguage>();
+    options.optimization_level = optimization_level;
+    options.monomorphization_budget = monomorphization_budget;
+    options.enable_safety_checks = enable_safety_checks;
+    options.preserve_comments = preserve_comments;
+    options.generate_tests = generate_tests;
+    return options;
+}
+
+namespace {
+
+const char* targetName(TargetLanguage target) {
+    return target == TargetLanguage::Go ? "go" : "rust";
+}
+
+JsonValue stringArray(const std::vector<std::string>& strings) {
+    JsonValue array = JsonValue::array();
+    for (const auto& text : strings) {
+        array.push(text);
+    }
+    return array;
+}
+
+std::vector<std::string> stringsOf(const JsonValue& array) {
+    std::vector<std::string> strings;
+    for (const auto& item : array.items()) {
+        strings.push_back(item.asString());
+    }
+    return strings;
+}
+
+} // namespace
+
+JsonValue ShardManifest::toJson() const {
+    JsonValue json = JsonValue::object();
+    json.set("format", kFormatVersion);
+    json.set("shard", shard.toString());
+    JsonValue target_names = JsonValue::array();
+    for (TargetLanguage target : targets) {
+        target_names.push(targetName(target));
+    }
+    json.set("targets", std::move(target_names));
+    json.set("optimization_level", optimization_level);
+    json.set("mono_budget", static_cast<uint64_t>(monomorphization_budget));
+    json.set("safety_checks", enable_safety_checks);
+    json.set("comments", preserve_comments);
+    json.set("tests", generate_tests);
+
+    JsonValue files = JsonValue::array();
+    for (const auto& entry : entries) {
+        JsonValue file = JsonValue::object();
+        file.set("input", entry.input_path);
+        file.set("outputs", stringArray(entry.output_paths));
+        file.set("ir", entry.ir_path);
+        file.set("source_hash", entry.source_hash);
+        file.set("elapsed_ms", entry.elapsed_ms);
+        file.set("success", entry.success);
+        file.set("cache_hit", entry.cache_hit);
+        file.set("over_budget", entry.over_budget);
+        file.set("diagnostic", entry.diagnostic);
+        if (!entry.resolved_bases.empty()) {
+            file.set("resolved_bases", stringArray(entry.resolved_bases));
+        }
+        files.push(std::move(file));
+    }
+    json.set("files", std::move(files));
+    return json;
+}
+
+bool ShardManifest::fromJson(const JsonValue& json, ShardManifest& manifest, std::string& error) {
+    if (!json.isObject() || json["format"].asNumber(-1) != kFormatVersion) {
+        error = "not a version " + std::to_string(kFormatVersion) + " shard manifest";
+        return false;
+    }
+    ShardManifest parsed;
+    if (!ShardSpec::parse(json["shard"].asString(), parsed.shard, error)) {
+        return false;
+    }
+    for (const auto& name : json["targets"].items()) {
+        if (name.asString() != "rust" && name.asString() != "go") {
+            error = "unknown target '" + name.asString() + "'";
+            return false;
+        }
+        parsed.targets.push_back(name.asString() == "go" ? TargetLanguage::Go : TargetLanguage::Rust);
+    }
+    if (parsed.targets.empty()) {
+        error = "manifest has no targets";
+        return false;
+    }
+    parsed.optimization_level = static_cast<int>(json["optimization_level"].asNumber());
+    parsed.monomorphization_budget = static_cast<size_t>(json["mono_budget"].asNumber());
+    parsed.enable_safety_checks = json["safety_checks"].asBool(true);
+    parsed.preserve_comments = json["comments"].asBool(true);
+    parsed.generate_tests = json["tests"].asBool();
+
+    for (const auto& file : json["files"].items()) {
+        ManifestEntry entry;
+        entry.input_path = file["input"].asString();
+        entry.output_paths = stringsOf(file["outputs"]);
+        entry.ir_path = file["ir"].asString();
+        entry.source_hash = file["source_hash"].asString();
+        entry.elapsed_ms = file["elapsed_ms"].asNumber();
+        entry.success = file["success"].asBool();
+        entry.cache_hit = file["cache_hit"].asBool();
+        entry.over_budget = file["over_budget"].asBool();
+        entry.diagnostic = file["diagnostic"].asString();
+        entry.resolved_bases = stringsOf(file["resolved_bases"]);
+        if (entry.input_path.empty() || entry.output_paths.size() != parsed.targets.size()) {
+            error = "file entry without an input or with " + std::to_string(entry.output_paths.size()) +
+                    " outputs for " + std::to_string(parsed.targets.size()) + " targets";
+            return false;
+        }
+        parsed.entries.push_back(std::move(entry));
+    }
+    manifest = std::move(parsed);
+    return true;
+}
+
+bool ShardManifest::write(const std::string& path, std::string& error) const {
+    std::string text = toJson().dump();
+    text += '\n';
+    return Transpiler::writeOutputFile(path, text, error);
+}
+
+bool ShardManifest::read(const std::string& path, ShardManifest& manifest, std::string& error) {
+    std::shared_ptr<const SourceBuffer> buffer;
+    try {
+        buffer = SourceBuffer::fromFile(path, false);
+    }
+    catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    JsonValue json;
+    if (!JsonValue::parse(buffer->text(), json, error) || !fromJson(json, manifest, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+MergeResult ShardMerger::merge(const std::vector<ShardManifest>& shards) {
+    ProfileScope scope("pipeline", "merge");
+    MergeResult result;
+    if (shards.empty()) {
+        result.error = "No manifests to merge";
+        return result;
+    }
+
+    // Every shard exactly once, all run with the same options
+    const ShardManifest& first = shards[0];
+    std::vector<const ShardManifest*> ordered(first.shard.count, nullptr);
+    for (const auto& shard : shards) {
+        if (shard.shard.count != first.shard.count || shard.targets != first.targets ||
+            shard.optimization_level != first.optimization_level ||
+            shard.monomorphization_budget != first.monomorphization_budget ||
+            shard.enable_safety_checks != first.enable_safety_checks ||
+            shard.preserve_comments != first.preserve_comments || shard.generate_tests != first.generate_tests) {
+            result.error = "Shard " + shard.shard.toString() + " was run with different options than shard " +
+                           first.shard.toString();
+            return result;
+        }
+        if (ordered[shard.shard.index]) {
+            result.error = "Shard " + shard.shard.toString() + " given twice";
+            return result;
+        }
+        ordered[shard.shard.index] = &shard;
+    }
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        if (!ordered[i]) {
+            result.error = "Shard " + ShardSpec{i, first.shard.count}.toString() + " is missing";
+            return result;
+        }
+    }
+
+    // The merged manifest describes one whole batch
+    ShardManifest& merged = result.manifest;
+    merged = first;
+    merged.shard = ShardSpec();
+    merged.entries.clear();
+    for (const ShardManifest* shard : ordered) {
+        merged.entries.insert(merged.entries.end(), shard->entries.begin(), shard->entries.end());
+    }
+
+    // Load every IR; the first file defining a class defines it for all
+    std::vector<std::shared_ptr<IR>> irs(merged.entries.size());
+    std::unordered_map<std::string, size_t> definitions;
+    for (size_t i = 0; i < merged.entries.size(); ++i) {
+        const ManifestEntry& entry = merged.entries[i];
+        if (entry.ir_path.empty()) {
+            continue;
+        }
+        auto ir = std::make_shared<IR>();
+        std::string error;
+        try {
+            if (!IRSerializer::deserialize(SourceBuffer::fromFile(entry.ir_path), *ir, error)) {
+                result.error = entry.ir_path + ": " + error;
+                return result;
+            }
+        }
+        catch (const std::exception& e) {
+            result.error = e.what();
+            return result;
+        }
+        for (const auto& class_decl : ir->getClasses()) {
+            definitions.emplace(class_decl.name, i);
+        }
+        irs[i] = std::move(ir);
+    }
+
+    TranspilerOptions options = merged.options();
+    std::vector<TargetLanguage> targets = Transpiler::getTargets(options);
+    std::set<std::string> unresolved;
+    for (size_t i = 0; i < merged.entries.size(); ++i) {
+        if (!irs[i]) {
+            continue;
+        }
+        IR& ir = *irs[i];
+
+        // Bases missing from the file, then the bases of those, and so on
+        std::vector<std::pair<std::string, std::string>> pending;  // Class, base it names
+        for (const auto& class_decl : ir.getClasses()) {
+            for (const auto& base : class_decl.base_classes) {
+                pending.emplace_back(class_decl.name, base);
+            }
+        }
+        std::set<size_t> attached;
+        std::set<std::string> resolved;
+        while (!pending.empty()) {
+            auto [derived, base] = pending.back();
+            pending.pop_back();
+            if (resolved.count(base) || ir.findClass(base)) {
+                continue;
+            }
+            auto definer = definitions.find(base);
+            if (definer == definitions.end()) {
+                unresolved.insert(derived + ": " + base);
+                continue;
+            }
+            const IR& other = *irs[definer->second];
+            if (attached.insert(definer->second).second) {
+                // Non-owning: every IR lives until the merge returns, and files
+                // that need each other's bases would otherwise never be freed
+                ir.addIncluded(std::shared_ptr<const IR>(std::shared_ptr<const IR>(), &other));
+            }
+            resolved.insert(base);
+            if (const ClassDecl* found = other.findClass(base)) {
+                for (const auto& next : found->base_classes) {
+                    pending.emplace_back(found->name, next);
+                }
+            }
+        }
+        if (attached.empty()) {
+            continue;
+        }
+
+        // Regenerated exactly as the shard generated it, with the bases now known
+        ManifestEntry& entry = merged.entries[i];
+        for (size_t t = 0; t < targets.size(); ++t) {
+            auto codegen = Transpiler::createCodeGenerator(targets[t], options);
+            std::string code = codegen->generate(ir);
+            std::string error;
+            if (!Transpiler::writeOutputFile(entry.output_paths[t], code, error)) {
+                result.error = error;
+                return result;
+            }
+        }
+        entry.resolved_bases.assign(resolved.begin(), resolved.end());
+        result.regenerated++;
+    }
+
+    result.unresolved.assign(unresolved.begin(), unresolved.end());
+    result.success = true;
+    return result;
+}
+
+} // namespace hybrid
@@ -0,0 +1,113 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <thread>
+
+namespace hybrid {
+
+WorkStealingPool::WorkStealingPool(size_t num_threads)
+    : num_threads_(resolveThreadCount(num_threads)) {
+    for (size_t i = 0; i < num_threads_; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+size_t WorkStealingPool::resolveThreadCount(size_t requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    size_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    Failure failure;
+
+    // Single worker or single task: no threads needed
+    if (num_threads_ == 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            try {
+                task(i);
+            } catch (...) {
+                failure.record(i, std::current_exception());
+            }
+        }
+        if (failure.error) {
+            std::rethrow_exception(failure.error);
+        }
+        return;
+    }
+
+    // Deal contiguous blocks so neighbouring inputs start on the same worker
+    size_t workers = std::min(num_threads_, count);
+    for (size_t w = 0; w < workers; ++w) {
+        size_t begin = count * w / workers;
+        size_t end = count * (w + 1) / workers;
+        std::lock_guard<std::mutex> lock(queues_[w]->mutex);
+        for (size_t i = begin; i < end; ++i) {
+            queues_[w]->tasks.push_back(i);
+        }
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        threads.emplace_back([this, w, &task, &failure]() { workerLoop(w, task, failure); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (failure.error) {
+        std::rethrow_exception(failure.error);
+    }
+}
+
+void WorkStealingPool::Failure::record(size_t task, std::exception_ptr exception) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error || task < index) {
+        error = std::move(exception);
+        index = task;
+    }
+}
+
+bool WorkStealingPool::popLocal(size_t worker, size_t& task) {
+    auto& queue = *queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, size_t& task) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(thief + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t worker, const std::function<void(size_t)>& task, Failure& failure) {
+    // Queues are only filled before the workers start, so an empty sweep
+    // over every queue means all work has been claimed
+    size_t index = 0;
+    while (popLocal(worker, index) || steal(worker, index)) {
+        try {
+            task(index);
+        } catch (...) {
+            failure.record(index, std::current_exception());
+        }
+    }
+}
+
+} // namespace hybrid
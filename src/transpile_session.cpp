@@ -0,0 +1,248 @@
+#include "transpile_session.h"
+#include "analysis_pass.h"
+#include "build_cache.h"
+#include "clang_frontend.h"
+#include "codegen.h"
+#include "declaration_index.h"
+#include "header_cache.h"
+#include "ir.h"
+#include "ir_serializer.h"
+#include "output_sink.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include "source_buffer.h"
+#include <chrono>
+
+namespace hybrid {
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    return static_cast<double>(elapsed.count()) / 1000.0;
+}
+
+} // namespace
+
+/**
+ * What one call needs besides the IR, kept between calls
+ */
+struct TranspileSession::Workspace {
+    std::unique_ptr<CodeGenerator> generators[2];   // Indexed by TargetLanguage, created on first use
+    StringSink output;                              // Keeps its capacity across calls
+
+    CodeGenerator& generatorFor(TargetLanguage target, const TranspilerOptions& options) {
+        auto& generator = generators[static_cast<size_t>(target)];
+        if (!generator) {
+            generator = Transpiler::createCodeGenerator(target, options);
+            generator->setJobs(1);
+        }
+        return *generator;
+    }
+};
+
+TranspileSession::TranspileSession(const TranspilerOptions& options) : options_(options) {
+    if (!options.cache_dir.empty()) {
+        cache_ = std::make_unique<BuildCache>(options.cache_dir);
+    }
+    if (options.frontend == FrontEnd::Clang) {
+        ClangFrontEndOptions clang_options;
+        clang_options.compile_commands_dir = options.compile_commands_dir;
+        clang_options.extra_args = options.clang_args;
+        clang_ = std::make_unique<ClangFrontEnd>(std::move(clang_options));
+    } else if (options.resolve_includes) {
+        headers_ = std::make_unique<HeaderCache>(options.include_dirs);
+    }
+}
+
+TranspileSession::~TranspileSession() = default;
+
+std::unique_ptr<TranspileSession::Workspace> TranspileSession::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            std::unique_ptr<Workspace> workspace = std::move(idle_.back());
+            idle_.pop_back();
+            return workspace;
+        }
+        workspaces_++;
+    }
+    return std::make_unique<Workspace>();
+}
+
+void TranspileSession::release(std::unique_ptr<Workspace> workspace) {
+    // Cached spellings pin the finished call's types; only the allocations are worth keeping
+    for (auto& generator : workspace->generators) {
+        if (generator) {
+            generator->clearTypeSpellings();
+        }
+    }
+    workspace->output.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(std::move(workspace));
+}
+
+size_t TranspileSession::getWorkspaceCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return workspaces_;
+}
+
+SessionResult TranspileSession::transpileFile(const std::string& input_path) {
+    std::shared_ptr<const SourceBuffer> source;
+    SessionResult result;
+    if (!Transpiler::readSourceFile(input_path, source, result.error)) {
+        return result;
+    }
+    return transpile(source);
+}
+
+SessionResult TranspileSession::transpile(const std::shared_ptr<const SourceBuffer>& source) {
+    SessionRequest request;
+    request.source = source;
+    return transpile(request);
+}
+
+SessionResult TranspileSession::transpile(const SessionRequest& request) {
+    SessionResult result;
+    if (!request.source) {
+        result.error = "No source given";
+        return result;
+    }
+    ProfileScope scope("pipeline", "session", request.source->getPath());
+    ResourceBudget budget(options_.time_budget_ms, options_.memory_budget_mb << 20);
+    BudgetScope budget_scope(budget.isLimited() ? &budget : nullptr);
+
+    std::vector<TargetLanguage> targets =
+        request.targets.empty() ? Transpiler::getTargets(options_) : request.targets;
+    if (options_.emit_ir) {
+        targets.resize(1);      // The IR does not depend on the target
+    }
+
+    // Each target has its own cache entry; only the targets that miss need the IR
+    std::vector<std::string> keys(targets.size());
+    std::vector<size_t> pending;
+    std::string dependencies = cache_ && headers_ ? headers_->dependencyHash(*request.source) : std::string();
+    for (size_t i = 0; i < targets.size(); ++i) {
+        SessionOutput output;
+        output.target = targets[i];
+        if (cache_) {
+            TranspilerOptions target_options = options_;
+            target_options.target = targets[i];
+            keys[i] = BuildCache::computeKey(request.source->text(), target_options, dependencies);
+            if (!request.declaration.empty()) {
+                keys[i] += "#" + request.declaration;
+            }
+            output.cache_hit = cache_->lookup(keys[i], output.code);
+        }
+        if (!output.cache_hit) {
+            pending.push_back(i);
+        }
+        result.outputs.push_back(std::move(output));
+    }
+    if (pending.empty()) {
+        result.success = true;
+        return result;
+    }
+
+    // Over budget: every output that was not cached gets what was parsed, without bodies
+    IR ir;
+    auto signaturesOnly = [&](const BudgetExceeded& e) {
+        result.over_budget = true;
+        result.error = e.what();
+        for (size_t i : pending) {
+            SessionOutput& output = result.outputs[i];
+            output.code = Transpiler::generateSignaturesOnly(ir, output.target, options_, result.error);
+        }
+        result.classes = ir.getClasses().size();
+        result.functions = ir.getFunctions().size();
+        result.success = true;
+        return result;
+    };
+
+    auto parse_start = std::chrono::steady_clock::now();
+    try {
+        if (request.declaration.empty()) {
+            if (!Transpiler::loadIR(request.source, clang_.get(), headers_.get(),
+                                    Transpiler::needsAnalysis(options_), ir, result.error)) {
+                result.outputs.clear();
+                return result;
+            }
+        } else {
+            // Only the class and its bases are parsed
+            ir = DeclarationIndex(request.source).parseDeclaration(request.declaration);
+            if (Transpiler::needsAnalysis(options_)) {
+                AnalysisPassManager::createDefault().run(ir);
+            }
+        }
+    }
+    catch (const BudgetExceeded& e) {
+        return signaturesOnly(e);
+    }
+    catch (const std::exception& e) {
+        result.error = "Failed to parse declaration: " + std::string(e.what());
+        result.outputs.clear();
+        return result;
+    }
+    result.parse_ms = elapsedMs(parse_start);
+    result.classes = ir.getClasses().size();
+    result.functions = ir.getFunctions().size();
+
+    auto generate_start = std::chrono::steady_clock::now();
+    std::unique_ptr<Workspace> workspace = acquire();
+    try {
+        generateOutputs(request, ir, pending, keys, *workspace, result);
+    }
+    catch (const BudgetExceeded& e) {
+        release(std::move(workspace));
+        return signaturesOnly(e);
+    }
+    release(std::move(workspace));
+    result.generate_ms = elapsedMs(generate_start);
+    if (!result.error.empty()) {
+        result.outputs.clear();
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+void TranspileSession::generateOutputs(const SessionRequest& request, const IR& ir,
+                                       const std::vector<size_t>& pending,
+                                       const std::vector<std::string>& keys,
+                                       Workspace& workspace, SessionResult& result) {
+    for (size_t i : pending) {
+        SessionOutput& output = result.outputs[i];
+        if (options_.emit_ir) {
+            output.code = IRSerializer::serialize(ir);
+            if (cache_) {
+                cache_->store(keys[i], output.code);
+            }
+            continue;
+        }
+
+        workspace.output.clear();
+        bool ok = true;
+        if (request.declaration.empty()) {
+            ok = workspace.generatorFor(output.target, options_).generate(ir, workspace.output);
+        } else {
+            ok = workspace.generatorFor(output.target, options_).generateDeclaration(ir, request.declaration,
+                                                                           workspace.output);
+        }
+        if (!ok) {
+            result.error = request.declaration.empty() ? "Code generation failed"
+                                                       : "Failed to generate declaration: " + request.declaration;
+            return;
+        }
+
+        // One exactly sized copy; the buffer's capacity stays with the workspace
+        output.code = workspace.output.str();
+        if (cache_) {
+            cache_->store(keys[i], output.code);
+        }
+    }
+}
+
+} // namespace hybrid
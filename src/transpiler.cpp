@@ -2,85 +2,657 @@
 #include "ir.h"
 #include "codegen.h"
 #include "parser.h"
-#include <fstream>
+#include "clang_frontend.h"
+#include "thread_pool.h"
+#include "build_cache.h"
+#include "declaration_index.h"
+#include "header_cache.h"
+#include "analysis_pass.h"
+#include "ir_serializer.h"
+#include "source_buffer.h"
+#include "output_sink.h"
+#include "profiler.h"
+#include "resource_budget.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <sstream>
+#include <unordered_map>
 
 namespace hybrid {
 
 Transpiler::Transpiler(const TranspilerOptions& options)
-    : options_(options), ir_(std::make_unique<IR>()) {
-
-    // Create appropriate code generator based on target
-    if (options.target == TargetLanguage::Rust) {
-        codegen_ = std::make_unique<RustCodeGenerator>();
-    } else if (options.target == TargetLanguage::Go) {
-        codegen_ = std::make_unique<GoCodeGenerator>();
+    : options_(options), ir_(std::make_unique<IR>()),
+      codegen_(createCodeGenerator(options.target, options)) {
+    if (!options.cache_dir.empty()) {
+        cache_ = std::make_unique<BuildCache>(options.cache_dir);
+    }
+    if (options.frontend == FrontEnd::Clang) {
+        ClangFrontEndOptions clang_options;
+        clang_options.compile_commands_dir = options.compile_commands_dir;
+        clang_options.extra_args = options.clang_args;
+        clang_ = std::make_unique<ClangFrontEnd>(std::move(clang_options));
+    } else if (options.resolve_includes) {
+        headers_ = std::make_unique<HeaderCache>(options.include_dirs);
     }
 }
 
 Transpiler::~Transpiler() = default;
 
 bool Transpiler::transpile(const std::string& input_path) {
-    // Parse the input file
-    if (!parseSourceFile(input_path)) {
+    FileResult result = transpileFile(input_path, options_.output_path,
+                                      static_cast<size_t>(std::max(options_.jobs, 0)));
+    last_error_ = result.error;
+    return result.success;
+}
+
+bool Transpiler::transpileBatch(const std::vector<std::string>& input_paths) {
+    std::vector<std::string> output_paths;
+    output_paths.reserve(input_paths.size());
+    for (const auto& input : input_paths) {
+        output_paths.push_back(batchOutputPath(input, input_paths.size()));
+    }
+    return transpileBatch(input_paths, output_paths);
+}
+
+bool Transpiler::transpileBatch(const std::vector<std::string>& input_paths,
+                                const std::vector<std::string>& output_paths) {
+    if (input_paths.size() != output_paths.size()) {
+        last_error_ = "Input and output path counts differ";
         return false;
     }
 
-    // Generate output code
-    if (!generateCode(options_.output_path)) {
+    // Two files writing one output would race and silently lose one of them
+    std::unordered_map<std::string, size_t> owners;
+    for (size_t i = 0; i < output_paths.size(); ++i) {
+        auto inserted = owners.emplace(std::filesystem::path(output_paths[i]).lexically_normal().string(), i);
+        if (!inserted.second) {
+            last_error_ = input_paths[inserted.first->second] + " and " + input_paths[i] +
+                          " would both be written to " + output_paths[i];
+            return false;
+        }
+    }
+
+    // Slots are filled by index, so result order never depends on scheduling
+    batch_results_.assign(input_paths.size(), FileResult{});
+
+    // Files are the unit of parallelism; a lone file parallelizes its codegen instead
+    size_t jobs = static_cast<size_t>(std::max(options_.jobs, 0));
+    size_t codegen_jobs = input_paths.size() == 1 ? jobs : 1;
+
+    // Inputs of a batch usually start with the same includes; compile those once
+    if (clang_) {
+        clang_->setSharePreambles(input_paths.size() > 1);
+    }
+
+    WorkStealingPool pool(jobs);
+    pool.parallelFor(input_paths.size(), [&](size_t i) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            batch_results_[i] = transpileFile(input_paths[i], output_paths[i], codegen_jobs);
+        } catch (const std::exception& e) {
+            // One file's failure must not lose the diagnostic (or the rest of the batch)
+            batch_results_[i] = FileResult();
+            batch_results_[i].input_path = input_paths[i];
+            batch_results_[i].output_path = output_paths[i];
+            batch_results_[i].error = std::string("Internal error: ") + e.what();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        batch_results_[i].elapsed_ms = elapsed.count();
+    });
+
+    size_t failed = 0;
+    for (const auto& result : batch_results_) {
+        if (!result.success) {
+            if (failed == 0) {
+                last_error_ = result.input_path + ": " + result.error;
+            }
+            failed++;
+        }
+    }
+
+    if (failed > 1) {
+        last_error_ += " (and " + std::to_string(failed - 1) + " more failed files)";
+    }
+
+    return failed == 0;
+}
+
+bool Transpiler::transpileSource(const std::shared_ptr<const SourceBuffer>& source, std::string& code) {
+    ProfileScope scope("pipeline", "source", source->getPath());
+
+    std::string cache_key;
+    if (cache_) {
+        cache_key = BuildCache::computeKey(source->text(), options_,
+                                           headers_ ? headers_->dependencyHash(*source) : std::string());
+        if (cache_->lookup(cache_key, code)) {
+            return true;
+        }
+    }
+
+    if (!parseSourceFile(source)) {
+        return false;
+    }
+    if (options_.emit_ir) {
+        code = IRSerializer::serialize(*ir_);
+        if (cache_) {
+            cache_->store(cache_key, code);
+        }
+        return true;
+    }
+    if (!codegen_) {
+        last_error_ = "Code generator not initialized";
         return false;
     }
 
+    codegen_->setJobs(static_cast<size_t>(std::max(options_.jobs, 0)));
+    {
+        ProfileScope generate_scope("codegen", "generate", source->getPath());
+        code = codegen_->generate(*ir_);
+        generate_scope.addBytes(code.size());
+    }
+
+    if (cache_) {
+        cache_->store(cache_key, code);
+    }
     return true;
 }
 
-bool Transpiler::transpileBatch(const std::vector<std::string>& input_paths) {
-    for (const auto& path : input_paths) {
-        if (!transpile(path)) {
+bool Transpiler::transpileDeclaration(const DeclarationIndex& index, const std::string& name,
+                                      std::string& code) {
+    ProfileScope scope("pipeline", "declaration", name);
+    if (!codegen_) {
+        last_error_ = "Code generator not initialized";
+        return false;
+    }
+
+    try {
+        *ir_ = index.parseDeclaration(name);
+    }
+    catch (const std::exception& e) {
+        last_error_ = "Failed to parse declaration: " + std::string(e.what());
+        return false;
+    }
+    if (needsAnalysis(options_)) {
+        AnalysisPassManager::createDefault().run(*ir_);
+    }
+
+    StringSink sink;
+    codegen_->setJobs(1);
+    if (!codegen_->generateDeclaration(*ir_, name, sink)) {
+        last_error_ = "Failed to generate declaration: " + name;
+        return false;
+    }
+    code = sink.take();
+    return true;
+}
+
+FileResult Transpiler::transpileFile(const std::string& input_path,
+                                     const std::string& output_path,
+                                     size_t codegen_jobs) const {
+    ProfileScope scope("pipeline", "file", input_path);
+    FileResult result;
+    result.input_path = input_path;
+    result.output_path = output_path;
+
+    // One file over budget stops just that file (see writeSignaturesOnly below)
+    ResourceBudget budget(options_.time_budget_ms, options_.memory_budget_mb << 20);
+    BudgetScope budget_scope(budget.isLimited() ? &budget : nullptr);
+
+    std::shared_ptr<const SourceBuffer> source;
+    if (!readSourceFile(input_path, source, result.error)) {
+        return result;
+    }
+    if (options_.keep_ir) {
+        result.source_hash = BuildCache::contentHash(source->text());
+    }
+
+    // Each target has its own cache entry; only the targets that miss need the IR
+    struct Pending {
+        TargetLanguage target;
+        std::string path;
+        std::string key;
+    };
+    std::vector<TargetLanguage> targets = getTargets(options_);
+    if (options_.emit_ir) {
+        targets.resize(1);      // The IR does not depend on the target
+    }
+    std::vector<Pending> pending;
+    std::string dependencies = cache_ && headers_ ? headers_->dependencyHash(*source) : std::string();
+    for (TargetLanguage target : targets) {
+        Pending output{target, targets.size() == 1 ? output_path : targetOutputPath(output_path, target), ""};
+        result.output_paths.push_back(output.path);
+        if (cache_) {
+            TranspilerOptions target_options = options_;
+            target_options.target = target;
+            output.key = BuildCache::computeKey(source->text(), target_options, dependencies);
+            std::string cached;
+            if (cache_->lookup(output.key, cached)) {
+                if (!writeOutputFile(output.path, cached, result.error)) {
+                    return result;
+                }
+                continue;
+            }
+        }
+        pending.push_back(std::move(output));
+    }
+    result.output_path = result.output_paths[0];
+    result.cache_hit = pending.empty();
+
+    // keep_ir: the IR is one more output. Analyzed IR is what --emit-ir
+    // writes, so it shares that cache entry; unanalyzed IR is not cached.
+    bool write_ir = options_.keep_ir && !options_.emit_ir;
+    std::string ir_key;
+    if (options_.emit_ir) {
+        result.ir_path = result.output_path;
+    } else if (write_ir) {
+        result.ir_path = irOutputPath(result.output_path);
+        if (cache_ && needsAnalysis(options_)) {
+            TranspilerOptions ir_options = options_;
+            ir_options.emit_ir = true;
+            ir_key = BuildCache::computeKey(source->text(), ir_options, dependencies);
+            std::string cached;
+            if (cache_->lookup(ir_key, cached)) {
+                if (!writeOutputFile(result.ir_path, cached, result.error)) {
+                    return result;
+                }
+                write_ir = false;
+            }
+        }
+    }
+
+    bool benchmarks = options_.generate_benchmarks && !options_.emit_ir;
+    if (pending.empty() && !benchmarks && !write_ir) {
+        result.success = true;
+        return result;
+    }
+
+    // Over budget: keep what was parsed, without bodies, and report it.
+    // Fallback outputs are not cached, so the next run tries again.
+    auto writeSignaturesOnly = [&](IR& partial, const std::vector<Pending>& targets, const std::string& diagnostic) {
+        BudgetScope unlimited(nullptr);
+        result.over_budget = true;
+        result.error = diagnostic;
+        result.success = true;
+        for (const Pending& target : targets) {
+            std::string code = generateSignaturesOnly(partial, target.target, options_, result.error);
+            std::string error;
+            if (!writeOutputFile(target.path, code, error)) {
+                result.success = false;
+                result.error = error;
+                return;
+            }
+        }
+    };
+
+    IR ir;
+    try {
+        if (!loadIR(source, clang_.get(), headers_.get(), needsAnalysis(options_), ir, result.error)) {
+            return result;
+        }
+    }
+    catch (const BudgetExceeded& e) {
+        result.ir_path.clear();     // A partial IR would mislead a merge
+        writeSignaturesOnly(ir, pending, e.what());
+        return result;
+    }
+
+    if (write_ir) {
+        std::string data = IRSerializer::serialize(ir);
+        if (!writeOutputFile(result.ir_path, data, result.error)) {
+            return result;
+        }
+        if (!ir_key.empty()) {
+            cache_->store(ir_key, data);
+        }
+    }
+
+    if (options_.emit_ir) {
+        std::string data = IRSerializer::serialize(ir);
+        result.success = writeOutputFile(pending[0].path, data, result.error);
+        if (result.success && cache_) {
+            cache_->store(pending[0].key, data);
+        }
+        return result;
+    }
+
+    // Generators only read the IR, so targets can share it across threads
+    std::vector<std::string> errors(pending.size());
+    std::vector<char> written(pending.size(), 0);
+    std::vector<char> exceeded(pending.size(), 0);      // errors[i] then holds the diagnostic
+    size_t target_jobs = codegen_jobs;
+    auto generate = [&](size_t i) {
+        BudgetScope target_scope(budget.isLimited() ? &budget : nullptr);   // Pool threads too
+        auto codegen = createCodeGenerator(pending[i].target, options_);
+        if (!codegen) {
+            errors[i] = "Code generator not initialized";
+            return;
+        }
+        codegen->setJobs(target_jobs);
+
+        std::string generated_code;
+        try {
+            written[i] = emitCode(*codegen, ir, pending[i].path,
+                                  cache_ ? &generated_code : nullptr, errors[i]);
+        }
+        catch (const BudgetExceeded& e) {
+            exceeded[i] = 1;
+            errors[i] = e.what();
+            return;
+        }
+        if (written[i] && cache_) {
+            cache_->store(pending[i].key, generated_code);
+        }
+    };
+
+    if (pending.size() > 1 && codegen_jobs != 1) {
+        size_t threads = WorkStealingPool::resolveThreadCount(codegen_jobs);
+        target_jobs = std::max<size_t>(threads / pending.size(), 1);
+        WorkStealingPool pool(std::min(threads, pending.size()));
+        pool.parallelFor(pending.size(), generate);
+    } else {
+        for (size_t i = 0; i < pending.size(); ++i) {
+            generate(i);
+        }
+    }
+
+    // Targets stopped by the budget get the fallback; the others are complete
+    std::vector<Pending> over_budget;
+    std::string diagnostic;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (exceeded[i]) {
+            over_budget.push_back(pending[i]);
+            diagnostic = diagnostic.empty() ? errors[i] : diagnostic;
+        }
+    }
+
+    result.success = true;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (!written[i] && !exceeded[i]) {
+            result.success = false;
+            result.error = errors[i];
+            return result;
+        }
+    }
+    if (!over_budget.empty()) {
+        writeSignaturesOnly(ir, over_budget, diagnostic);
+    } else if (benchmarks) {
+        BudgetScope unlimited(nullptr);
+        result.success = writeBenchmarks(ir, targets, result);
+    }
+    return result;
+}
+
+bool Transpiler::writeBenchmarks(const IR& ir, const std::vector<TargetLanguage>& targets, FileResult& result) const {
+    ProfileScope scope("pipeline", "benchmarks", result.input_path);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        auto codegen = createCodeGenerator(targets[i], options_);
+        std::string module = std::filesystem::path(result.output_paths[i]).filename().string();
+        std::string harness = codegen->generateBenchmarks(ir, module);
+        if (harness.empty()) {
+            return true;    // No class to benchmark, for any target
+        }
+
+        std::string path = benchmarkOutputPath(result.output_paths[i], targets[i]);
+        if (!writeOutputFile(path, harness, result.error)) {
             return false;
         }
+        result.benchmark_paths.push_back(std::move(path));
+    }
+
+    // The stubs include the input by its path from where they are written
+    std::string path = cppBenchmarkOutputPath(result.output_paths[0]);
+    std::error_code ec;
+    std::filesystem::path input = std::filesystem::absolute(result.input_path, ec);
+    std::filesystem::path header =
+        input.lexically_relative(std::filesystem::absolute(path, ec).parent_path());
+    std::string stubs = CodeGenerator::generateCppBenchmarks(
+        ir, (header.empty() ? input : header).generic_string());
+    if (!writeOutputFile(path, stubs, result.error)) {
+        return false;
     }
+    result.benchmark_paths.push_back(std::move(path));
     return true;
 }
 
-bool Transpiler::parseSourceFile(const std::string& input_path) {
-    try {
-        // Use the simple C++ parser to parse the source file
-        // This will be replaced with full Clang LibTooling in the future
-        *ir_ = Parser::parseFile(input_path);
+std::string Transpiler::batchOutputPath(const std::string& input_path, size_t batch_size) const {
+    // An explicit output path only makes sense for a single input
+    if (batch_size == 1 && !options_.output_path.empty()) {
+        return options_.output_path;
+    }
+    return defaultOutputPath(input_path, options_);
+}
 
-        // TODO (future): Add additional analysis passes:
-        // 1. Ownership analysis for smart pointers
-        // 2. Lifetime inference for references
-        // 3. Safety validation
-        // 4. Performance optimization hints
+std::vector<TargetLanguage> Transpiler::getTargets(const TranspilerOptions& options) {
+    return options.targets.empty() ? std::vector<TargetLanguage>{options.target} : options.targets;
+}
 
-        return true;
+std::string Transpiler::targetOutputPath(const std::string& output_path, TargetLanguage target) {
+    return std::filesystem::path(output_path).replace_extension(outputExtension(target)).string();
+}
+
+std::string Transpiler::benchmarkOutputPath(const std::string& output_path, TargetLanguage target) {
+    std::filesystem::path path(output_path);
+    std::string suffix = target == TargetLanguage::Rust ? "_bench.rs" : "_test.go";
+    return path.replace_filename(path.stem().string() + suffix).string();
+}
+
+std::string Transpiler::irOutputPath(const std::string& output_path) {
+    return std::filesystem::path(output_path).replace_extension(IRSerializer::kFileExtension).string();
+}
+
+std::string Transpiler::cppBenchmarkOutputPath(const std::string& output_path) {
+    std::filesystem::path path(output_path);
+    return path.replace_filename(path.stem().string() + "_bench.cpp").string();
+}
+
+std::string Transpiler::outputExtension(TargetLanguage target) {
+    return (target == TargetLanguage::Rust) ? ".rs" : ".go";
+}
+
+std::string Transpiler::outputExtension(const TranspilerOptions& options) {
+    return options.emit_ir ? IRSerializer::kFileExtension : outputExtension(options.target);
+}
+
+std::string Transpiler::defaultOutputPath(const std::string& input_path, TargetLanguage target) {
+    TranspilerOptions options;
+    options.target = target;
+    return defaultOutputPath(input_path, options);
+}
+
+std::string Transpiler::defaultOutputPath(const std::string& input_path, const TranspilerOptions& options) {
+    std::string extension = outputExtension(options);
+    size_t dot_pos = input_path.find_last_of('.');
+    size_t slash_pos = input_path.find_last_of('/');
+    if (dot_pos != std::string::npos &&
+        (slash_pos == std::string::npos || dot_pos > slash_pos)) {
+        return input_path.substr(0, dot_pos) + extension;
     }
-    catch (const std::exception& e) {
-        last_error_ = "Failed to parse input file: " + std::string(e.what());
+    return input_path + extension;
+}
+
+std::unique_ptr<CodeGenerator> Transpiler::createCodeGenerator(TargetLanguage target, int optimization_level) {
+    // Create appropriate code generator based on target
+    std::unique_ptr<CodeGenerator> codegen;
+    if (target == TargetLanguage::Rust) {
+        codegen = std::make_unique<RustCodeGenerator>();
+    } else if (target == TargetLanguage::Go) {
+        codegen = std::make_unique<GoCodeGenerator>();
+    }
+    if (codegen) {
+        codegen->setOptimizationLevel(optimization_level);
+    }
+    return codegen;
+}
+
+std::unique_ptr<CodeGenerator> Transpiler::createCodeGenerator(TargetLanguage target, const TranspilerOptions& options) {
+    std::unique_ptr<CodeGenerator> codegen = createCodeGenerator(target, options.optimization_level);
+    if (codegen) {
+        codegen->setMonomorphizationBudget(options.monomorphization_budget);
+    }
+    return codegen;
+}
+
+bool Transpiler::parseSourceFile(const std::shared_ptr<const SourceBuffer>& source) {
+    // TODO (future): Add additional analysis passes:
+    // 1. Ownership analysis for smart pointers
+    // 2. Lifetime inference for references
+    // 3. Safety validation
+    // 4. Performance optimization hints
+    return loadIR(source, clang_.get(), headers_.get(), needsAnalysis(options_), *ir_, last_error_);
+}
+
+bool Transpiler::loadIR(const std::shared_ptr<const SourceBuffer>& source, ClangFrontEnd* clang,
+                        HeaderCache* headers, bool analyze, IR& ir, std::string& error) {
+    // Serialized IR was analyzed when it was written
+    if (IRSerializer::isSerialized(source->text())) {
+        ProfileScope scope("io", "load-ir", source->getPath(), source->size());
+        return IRSerializer::deserialize(source, ir, error);
+    }
+
+    if (clang) {
+        if (!clang->parse(source, ir, error)) {
+            error = "Failed to parse input file: " + error;
+            return false;
+        }
+    } else {
+        try {
+            ir = IR();
+            Parser::parseBuffer(source, ir);
+        }
+        catch (const BudgetExceeded&) {
+            throw;      // The caller falls back on what was parsed
+        }
+        catch (const std::exception& e) {
+            error = "Failed to parse input file: " + std::string(e.what());
+            return false;
+        }
+
+        // Each header is parsed and analyzed once per build, whoever includes it
+        if (headers) {
+            for (auto& header : headers->resolve(*source, analyze)) {
+                ir.addIncluded(std::move(header));
+            }
+        }
+    }
+
+    if (analyze) {
+        AnalysisPassManager::createDefault().run(ir);
+    }
+    return true;
+}
+
+namespace {
+
+void keepSignature(Function& func) {
+    func.body = SourceText();
+    func.try_catch_blocks.clear();
+    func.may_throw = false;
+    func.threads_created.clear();
+    func.lock_scopes.clear();
+    func.atomic_operations.clear();
+    func.condition_variables.clear();
+    func.uses_threading = false;
+    func.futures.clear();
+    func.async_tasks.clear();
+}
+
+} // namespace
+
+std::string Transpiler::generateSignaturesOnly(IR& ir, TargetLanguage target, const TranspilerOptions& options,
+                                               const std::string& diagnostic) {
+    BudgetScope unlimited(nullptr);
+    for (size_t i = 0; i < ir.getClasses().size(); ++i) {
+        for (Function& method : ir.getClass(i).methods) {
+            keepSignature(method);
+        }
+    }
+    for (size_t i = 0; i < ir.getFunctions().size(); ++i) {
+        keepSignature(ir.getFunction(i));
+    }
+
+    if (options.emit_ir) {
+        return IRSerializer::serialize(ir);
+    }
+    auto codegen = createCodeGenerator(target, options);
+    return "// Signatures only: " + diagnostic + "\n" + codegen->generate(ir);
+}
+
+bool Transpiler::emitCode(CodeGenerator& codegen, const IR& ir, const std::string& output_path,
+                          std::string* captured, std::string& error) {
+    if (captured) {
+        {
+            ProfileScope scope("codegen", "generate", output_path);
+            *captured = codegen.generate(ir);
+            scope.addBytes(captured->size());
+        }
+        return writeOutputFile(output_path, *captured, error);
+    }
+
+    FileSink sink;
+    if (!openOutputFile(output_path, sink, error)) {
+        return false;
+    }
+
+    // Streaming: the file is written while code is generated
+    {
+        ProfileScope scope("codegen", "generate", output_path);
+        codegen.generate(ir, sink);
+        scope.addBytes(sink.bytesWritten());
+    }
+
+    ProfileScope scope("io", "write", output_path, sink.bytesWritten());
+    if (!sink.close()) {
+        error = "Failed to write output file: " + output_path;
         return false;
     }
+
+    return true;
 }
 
-bool Transpiler::generateCode(const std::string& output_path) {
-    if (!codegen_) {
-        last_error_ = "Code generator not initialized";
+bool Transpiler::openOutputFile(const std::string& output_path, FileSink& sink, std::string& error) {
+    // Mirrored output trees may need their directories created first
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(output_path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    if (!sink.open(output_path)) {
+        error = "Failed to open output file: " + output_path;
         return false;
     }
+    return true;
+}
 
-    // Generate code from IR
-    std::string generated_code = codegen_->generate(*ir_);
+bool Transpiler::readSourceFile(const std::string& input_path,
+                                std::shared_ptr<const SourceBuffer>& source, std::string& error) {
+    // The buffer is read once and shared by the cache key and the IR
+    ProfileScope scope("io", "read", input_path);
+    try {
+        source = SourceBuffer::fromFile(input_path);
+        scope.addBytes(source->text().size());
+    }
+    catch (const std::exception& e) {
+        error = "Failed to parse input file: " + std::string(e.what());
+        return false;
+    }
+    return true;
+}
 
-    // Write to output file
-    std::ofstream out_file(output_path);
-    if (!out_file.is_open()) {
-        last_error_ = "Failed to open output file: " + output_path;
+bool Transpiler::writeOutputFile(const std::string& output_path, const std::string& code,
+                                 std::string& error) {
+    ProfileScope scope("io", "write", output_path, code.size());
+    FileSink sink;
+    if (!openOutputFile(output_path, sink, error)) {
         return false;
     }
 
-    out_file << generated_code;
-    out_file.close();
+    sink.write(code);
+    if (!sink.close()) {
+        error = "Failed to write output file: " + output_path;
+        return false;
+    }
 
     return true;
 }
@@ -0,0 +1,307 @@
+#include "watch_mode.h"
+#include "analysis_pass.h"
+#include "build_cache.h"
+#include "incremental_session.h"
+#include "input_collector.h"
+#include "profiler.h"
+#include "source_buffer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <unordered_set>
+
+namespace hybrid {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// How long to wait for OS events before checking for a stop signal
+constexpr int kPollMs = 250;
+
+// Editors write in bursts (temp file, rename, chmod); rebuild once they go quiet
+constexpr int kDebounceMs = 100;
+constexpr int kMaxDebounceMs = 1000;
+
+std::atomic<bool> g_watch_stop{false};
+
+extern "C" void handleWatchSignal(int) {
+    g_watch_stop.store(true);
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+WatchMode::WatchMode(const TranspilerOptions& options, Collector collect)
+    : options_(options), collect_(std::move(collect)) {
+    // Watch builds do not read headers, so their cache entries must not
+    // pass for ones generated against them
+    options_.resolve_includes = false;
+    if (!options.cache_dir.empty()) {
+        cache_ = std::make_unique<BuildCache>(options.cache_dir);
+    }
+}
+
+WatchMode::~WatchMode() = default;
+
+void WatchMode::addTree(const std::string& dir, bool recursive) {
+    trees_.emplace_back(dir, recursive);
+}
+
+std::string WatchMode::normalize(const std::string& path) {
+    std::error_code ec;
+    fs::path normal = fs::weakly_canonical(path, ec);
+    return ec ? fs::path(path).lexically_normal().string() : normal.string();
+}
+
+bool WatchMode::refresh(std::string& error) {
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    if (!collect_(inputs, outputs, error)) {
+        return false;
+    }
+
+    // Inputs that are still there keep their session and last build key
+    std::unordered_map<std::string, std::unique_ptr<WatchedFile>> by_path;
+    std::vector<WatchedFile*> files;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        std::string key = normalize(inputs[i]);
+        if (by_path.count(key)) {
+            continue;
+        }
+
+        std::unique_ptr<WatchedFile> file;
+        auto old = by_path_.find(key);
+        if (old != by_path_.end()) {
+            file = std::move(old->second);
+        } else {
+            file = std::make_unique<WatchedFile>();
+        }
+        if (file->output != outputs[i]) {
+            file->built = false;
+        }
+        file->input = inputs[i];
+        file->output = outputs[i];
+
+        files.push_back(file.get());
+        by_path[key] = std::move(file);
+    }
+    files_ = std::move(files);
+    by_path_ = std::move(by_path);
+
+    for (const auto& tree : trees_) {
+        if (!watcher_.watchDirectory(tree.first, tree.second, error)) {
+            return false;
+        }
+    }
+    for (const auto& file : files_) {
+        fs::path parent = fs::path(file->input).parent_path();
+        if (!watcher_.watchDirectory(parent.empty() ? "." : parent.string(), false, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<WatchResult> WatchMode::rebuild(const std::vector<std::string>& paths) {
+    std::unordered_set<const WatchedFile*> selected;
+    for (const auto& path : paths) {
+        auto it = by_path_.find(normalize(path));
+        if (it != by_path_.end()) {
+            selected.insert(it->second.get());
+        }
+    }
+
+    std::vector<WatchedFile*> pending;
+    for (WatchedFile* file : files_) {
+        if (!file->built || selected.count(file)) {
+            pending.push_back(file);
+        }
+    }
+
+    // Each file has its own session, so files build independently
+    std::vector<WatchResult> results(pending.size());
+    WorkStealingPool pool(static_cast<size_t>(std::max(options_.jobs, 0)));
+    pool.parallelFor(pending.size(), [&](size_t i) {
+        results[i] = build(*pending[i]);
+    });
+    return results;
+}
+
+WatchResult WatchMode::build(WatchedFile& file) const {
+    ProfileScope scope("watch", "file", file.input);
+    WatchResult result;
+    result.file.input_path = file.input;
+    result.file.output_path = file.output;
+
+    std::shared_ptr<const SourceBuffer> source;
+    try {
+        // Copied, not mapped: the session keeps the buffer while the file is edited
+        source = SourceBuffer::fromFile(file.input, false);
+    }
+    catch (const std::exception& e) {
+        result.file.error = "Failed to read input file: " + std::string(e.what());
+        return result;
+    }
+
+    // Saves that do not change the content (touch, re-save) cost one hash
+    std::string key = BuildCache::computeKey(source->text(), options_);
+    if (file.built && key == file.key) {
+        result.unchanged = true;
+        result.file.success = true;
+        return result;
+    }
+
+    std::string code;
+    if (cache_ && cache_->lookup(key, code)) {
+        result.file.cache_hit = true;
+    } else {
+        if (!file.session) {
+            file.session = std::make_unique<IncrementalSession>(options_.target, options_.optimization_level,
+                                                                options_.monomorphization_budget);
+            if (Transpiler::needsAnalysis(options_)) {
+                file.analysis = std::make_unique<AnalysisPassManager>(AnalysisPassManager::createDefault());
+                file.session->setAnalysis(file.analysis.get());
+            }
+        }
+        if (!file.session->update(source)) {
+            result.file.error = file.session->getLastError();
+            return result;
+        }
+        result.reparsed = file.session->getLastStats().reparsed;
+        result.declarations = file.session->getLastStats().declarations;
+        code = file.session->getOutput();
+        if (cache_) {
+            cache_->store(key, code);
+        }
+    }
+
+    result.file.success = Transpiler::writeOutputFile(file.output, code, result.file.error);
+    if (result.file.success) {
+        file.key = key;
+        file.built = true;
+    }
+    return result;
+}
+
+void WatchMode::report(const std::vector<WatchResult>& results, double milliseconds,
+                       std::ostream& log) const {
+    size_t rebuilt = 0;
+    size_t unchanged = 0;
+    size_t cached = 0;
+    size_t failed = 0;
+    for (const auto& result : results) {
+        if (!result.file.success) {
+            std::cerr << result.file.input_path << ": " << result.file.error << "\n";
+            failed++;
+        } else if (result.unchanged) {
+            unchanged++;
+        } else {
+            rebuilt++;
+            cached += result.file.cache_hit ? 1 : 0;
+            if (options_.verbose) {
+                log << "  " << result.file.input_path << " -> " << result.file.output_path;
+                if (result.file.cache_hit) {
+                    log << " (cached)";
+                } else {
+                    log << " (" << result.reparsed << " of " << result.declarations << " classes parsed)";
+                }
+                log << "\n";
+            }
+        }
+    }
+
+    if (options_.quiet || (rebuilt == 0 && failed == 0)) {
+        return;
+    }
+    log << "Rebuilt " << rebuilt << (rebuilt == 1 ? " file" : " files") << " in "
+        << std::fixed << std::setprecision(1) << milliseconds << " ms";
+    log.unsetf(std::ios_base::floatfield);
+    if (cached) log << ", " << cached << " from cache";
+    if (unchanged) log << ", " << unchanged << " unchanged";
+    if (failed) log << ", " << failed << " failed";
+    log << "\n";
+    log.flush();
+}
+
+int WatchMode::run(std::ostream& log) {
+    std::string error;
+    if (!refresh(error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<WatchResult> results = rebuild({});
+    report(results, millisecondsSince(start), log);
+    if (!options_.quiet) {
+        log << "Watching " << files_.size() << (files_.size() == 1 ? " file" : " files") << " in "
+            << watcher_.getDirectoryCount() << (watcher_.getDirectoryCount() == 1 ? " directory" : " directories")
+            << (watcher_.isNative() ? "" : " (polling)") << "; press Ctrl-C to stop\n";
+        log.flush();
+    }
+
+    g_watch_stop.store(false);
+    auto previous_int = std::signal(SIGINT, handleWatchSignal);
+    auto previous_term = std::signal(SIGTERM, handleWatchSignal);
+
+    while (!g_watch_stop.load()) {
+        std::vector<FileEvent> events = watcher_.wait(kPollMs);
+        if (events.empty()) {
+            continue;
+        }
+
+        Clock::time_point burst = Clock::now();
+        for (;;) {
+            std::vector<FileEvent> more = watcher_.wait(kDebounceMs);
+            if (more.empty() || millisecondsSince(burst) > kMaxDebounceMs || g_watch_stop.load()) {
+                events.insert(events.end(), more.begin(), more.end());
+                break;
+            }
+            events.insert(events.end(), more.begin(), more.end());
+        }
+
+        // Sources or directories coming and going change the input set;
+        // generated outputs appearing next to the inputs do not
+        bool rescan = false;
+        std::vector<std::string> changed;
+        for (const auto& event : events) {
+            std::error_code ec;
+            if (event.path.empty()) {
+                rescan = true;
+            } else if (InputCollector::isSourceFile(event.path)) {
+                changed.push_back(event.path);
+                rescan |= event.structural;
+            } else if (event.structural && (fs::is_directory(event.path, ec) || !fs::exists(event.path, ec))) {
+                rescan = true;
+            }
+        }
+
+        if (rescan && !refresh(error)) {
+            std::cerr << "Warning: " << error << "\n";
+        }
+        if (changed.empty() && !rescan) {
+            continue;
+        }
+
+        start = Clock::now();
+        results = rebuild(changed);
+        report(results, millisecondsSince(start), log);
+    }
+
+    std::signal(SIGINT, previous_int);
+    std::signal(SIGTERM, previous_term);
+    return 0;
+}
+
+} // namespace hybrid
@@ -1,7 +1,31 @@
 #include "ir.h"
+#include "build_cache.h"
 #include "codegen.h"
+#include "json.h"
+#include "ffi.h"
+#include "header_cache.h"
+#include "input_collector.h"
+#include "output_sink.h"
+#include "parser.h"
+#include "shard_manifest.h"
+#include "thread_pool.h"
+#include "transpiler.h"
+#include "transpile_session.h"
+#include "source_buffer.h"
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef HYBRID_EXAMPLES_DIR
+#define HYBRID_EXAMPLES_DIR "examples"
+#endif
 
 namespace hybrid {
 namespace test {
@@ -69,10 +93,975 @@ void testGoCodeGeneration() {
     std::cout << "  ✓ Go code generation test passed\n";
 }
 
+void testStreamingOutputSinks() {
+    IR ir;
+
+    ClassDecl test_class;
+    test_class.name = "Streamed";
+
+    Variable field;
+    field.name = "value";
+    field.type = std::make_shared<Type>(TypeKind::Integer);
+    field.type->name = "int";
+    test_class.fields.push_back(field);
+
+    ir.addClass(test_class);
+
+    RustCodeGenerator rust_gen;
+    std::string expected = rust_gen.generate(ir);
+
+    // A tiny buffer forces many flushes through the file sink
+    std::string path = "test_streaming_sink.rs";
+    {
+        FileSink sink(16);
+        assert(sink.open(path));
+        assert(rust_gen.generate(ir, sink));
+        assert(sink.close());
+    }
+
+    std::ifstream in(path);
+    std::stringstream written;
+    written << in.rdbuf();
+    std::remove(path.c_str());
+
+    assert(written.str() == expected);
+    std::cout << "  ✓ Streaming output sink test passed\n";
+}
+
+void testParallelCodegenIsByteIdentical() {
+    // Many small classes parallelize at the top level, the wide class per method
+    std::string source;
+    for (int i = 0; i < 150; ++i) {
+        std::string n = std::to_string(i);
+        source += "class Node" + n + " {\n"
+                  "    int value;\n"
+                  "public:\n"
+                  "    Node" + n + "(int v) : value(v) {}\n"
+                  "    int get() const { return value; }\n"
+                  "    void set(int v) { value = v + " + n + "; }\n"
+                  "};\n";
+    }
+    source += "class Wide {\npublic:\n";
+    for (int i = 0; i < 200; ++i) {
+        source += "    int m" + std::to_string(i) + "(int x) { return x * " + std::to_string(i) + "; }\n";
+    }
+    source += "};\n";
+    for (int i = 0; i < 100; ++i) {
+        source += "double f" + std::to_string(i) + "(double a, double b) { return a + b; }\n";
+    }
+    IR ir = Parser::parseString(source);
+
+    RustCodeGenerator rust_serial, rust_parallel;
+    rust_parallel.setJobs(4);
+    assert(rust_parallel.generate(ir) == rust_serial.generate(ir));
+
+    GoCodeGenerator go_serial, go_parallel;
+    go_parallel.setJobs(4);
+    assert(go_parallel.generate(ir) == go_serial.generate(ir));
+
+    // Generators stay reusable after a parallel run
+    assert(rust_parallel.generate(ir) == rust_serial.generate(ir));
+    std::cout << "  ✓ Parallel codegen test passed\n";
+}
+
+void testBuildCache() {
+    // Reference vectors of 128-bit FNV-1a
+    assert(BuildCache::contentHash("") == "6c62272e07bb014262b821756295c58d");
+    assert(BuildCache::contentHash("a") == "d228cb696f1a8caf78912b704e4a8964");
+    assert(BuildCache::contentHash("foobar") == "343e1662793c64bf6f0d3597ba446f18");
+
+    // Source and every output-affecting option take part in the key
+    TranspilerOptions options;
+    std::string source = "class A { int x; };\n";
+    std::string key = BuildCache::computeKey(source, options);
+    assert(key.size() == 32);
+    assert(key == BuildCache::computeKey(source, options));
+    assert(key != BuildCache::computeKey("class A { int y; };\n", options));
+    TranspilerOptions changed = options;
+    changed.target = TargetLanguage::Go;
+    assert(key != BuildCache::computeKey(source, changed));
+    changed = options;
+    changed.optimization_level = 2;
+    assert(key != BuildCache::computeKey(source, changed));
+    changed = options;
+    changed.emit_ir = true;
+    assert(key != BuildCache::computeKey(source, changed));
+    changed = options;
+    changed.jobs = 8;       // Changes how, not what
+    assert(key == BuildCache::computeKey(source, changed));
+
+    std::string cache_dir = "test_build_cache";
+    std::filesystem::remove_all(cache_dir);
+    BuildCache cache(cache_dir);
+    std::string output;
+    assert(!cache.lookup(key, output));
+    cache.store(key, "fn a() {}\n");
+    assert(cache.lookup(key, output) && output == "fn a() {}\n");
+    assert(!cache.lookup(BuildCache::computeKey("class B {};\n", options), output));
+
+    // Concurrent writers rename whole entries into place and leave no temporaries
+    std::string large(1 << 20, 'x');
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&cache, &key, &large, t]() {
+            for (int i = 0; i < 8; ++i) {
+                cache.store(key, std::string(1, static_cast<char>('a' + t)) + large);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    assert(cache.lookup(key, output) && output.size() == large.size() + 1 && output.substr(1) == large);
+    size_t files = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(cache_dir)) {
+        if (entry.is_regular_file()) {
+            files++;
+            assert(entry.path().filename().string().find(".tmp.") == std::string::npos);
+        }
+    }
+    assert(files == 1);
+    (void)files;
+
+    std::filesystem::remove_all(cache_dir);
+    std::cout << "  ✓ Build cache test passed\n";
+}
+
+void testMultiTargetBatch() {
+    std::string source = "class Pair { int a; int b; public: int sum() const { return a + b; } };\n";
+    std::string input = "test_multi_target.cpp";
+    {
+        std::ofstream out(input, std::ios::binary);
+        out << source;
+    }
+    auto read = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    };
+
+    TranspilerOptions options;
+    options.targets = {TargetLanguage::Rust, TargetLanguage::Go};
+    options.jobs = 0;
+    options.cache_dir = "test_multi_target_cache";
+    IR ir = Parser::parseString(source);
+
+    // One parse, both outputs; the second run is served from the per-target cache entries
+    for (int run = 0; run < 2; ++run) {
+        Transpiler transpiler(options);
+        bool ok = transpiler.transpileBatch({input}, {"test_multi_target.out.rs"});
+        assert(ok);
+        (void)ok;
+        const FileResult& result = transpiler.getBatchResults()[0];
+        assert(result.output_paths.size() == 2);
+        assert(result.output_paths[0] == "test_multi_target.out.rs");
+        assert(result.output_paths[1] == "test_multi_target.out.go");
+        assert(result.cache_hit == (run == 1));
+        assert(read(result.output_paths[0]) == RustCodeGenerator().generate(ir));
+        assert(read(result.output_paths[1]) == GoCodeGenerator().generate(ir));
+    }
+
+    std::remove(input.c_str());
+    std::remove("test_multi_target.out.rs");
+    std::remove("test_multi_target.out.go");
+    std::filesystem::remove_all(options.cache_dir);
+    std::cout << "  ✓ Multi-target batch test passed\n";
+}
+
+void testInputCollection() {
+    std::filesystem::remove_all("test_inputs");
+    std::filesystem::create_directories("test_inputs/src/sub/deep");
+    for (const char* path : {"test_inputs/src/a.cpp", "test_inputs/src/b.h", "test_inputs/src/sub/c.cc",
+                             "test_inputs/src/sub/deep/d.hpp", "test_inputs/src/notes.txt"}) {
+        std::ofstream(path) << "class X {};\n";
+    }
+    std::ofstream("test_inputs/list.rsp") << "# inputs\n\n  test_inputs/src/a.cpp  \ntest_inputs/src/sub\n";
+
+    // Paths and mirrored outputs of everything one spec collects
+    auto collect = [](const std::string& spec, std::vector<std::string>& outputs) {
+        InputCollector collector;
+        std::string error;
+        bool ok = collector.addSpec(spec, error);
+        assert(ok);
+        (void)ok;
+        std::vector<std::string> paths;
+        outputs.clear();
+        for (const auto& input : collector.getFiles()) {
+            paths.push_back(input.path);
+            outputs.push_back(InputCollector::mirrorOutputPath(input, "out", ".rs"));
+        }
+        return paths;
+    };
+    std::vector<std::string> outputs;
+
+    // A directory is searched recursively for sources, sorted, and mirrored from its root
+    assert((collect("test_inputs/src", outputs) ==
+            std::vector<std::string>{"test_inputs/src/a.cpp", "test_inputs/src/b.h", "test_inputs/src/sub/c.cc",
+                                     "test_inputs/src/sub/deep/d.hpp"}));
+    assert((outputs == std::vector<std::string>{"out/a.rs", "out/b.rs", "out/sub/c.rs", "out/sub/deep/d.rs"}));
+
+    // '*' stays in one directory; '**' spans any number; the root is the part before the wildcard
+    assert((collect("test_inputs/src/*.c*", outputs) == std::vector<std::string>{"test_inputs/src/a.cpp"}));
+    assert((outputs == std::vector<std::string>{"out/a.rs"}));
+    assert((collect("test_inputs/src/**/*.h*", outputs) ==
+            std::vector<std::string>{"test_inputs/src/b.h", "test_inputs/src/sub/deep/d.hpp"}));
+    assert((outputs == std::vector<std::string>{"out/b.rs", "out/sub/deep/d.rs"}));
+
+    // A response file lists specs; each keeps its own root
+    assert((collect("@test_inputs/list.rsp", outputs) ==
+            std::vector<std::string>{"test_inputs/src/a.cpp", "test_inputs/src/sub/c.cc",
+                                     "test_inputs/src/sub/deep/d.hpp"}));
+    assert((outputs == std::vector<std::string>{"out/a.rs", "out/c.rs", "out/deep/d.rs"}));
+
+    // A file named twice is collected once; specs matching nothing fail
+    InputCollector collector;
+    std::string error;
+    bool ok = collector.addSpec("test_inputs/src/a.cpp", error) && collector.addSpec("test_inputs/src/./a.cpp", error);
+    assert(ok && collector.getFiles().size() == 1);
+    assert(!collector.addSpec("test_inputs/src/*.rs", error) && error.find("No files match") != std::string::npos);
+    assert(!collector.addSpec("test_inputs/missing.cpp", error) && error.find("not found") != std::string::npos);
+    assert(!collector.addSpec("@test_inputs/missing.rsp", error));
+    (void)ok;
+
+    std::filesystem::remove_all("test_inputs");
+    std::cout << "  ✓ Input collection test passed\n";
+}
+
+void testOutputPathCollisions() {
+    // foo.h and foo.cpp mirror to the same file; the header steps aside
+    std::vector<InputFile> inputs = {{"src/foo.h", "src"}, {"src/foo.cpp", "src"}, {"src/bar.cpp", "src"}};
+    std::vector<std::string> outputs;
+    for (const auto& input : inputs) {
+        outputs.push_back(InputCollector::mirrorOutputPath(input, "out", ".rs"));
+    }
+    std::string error;
+    bool ok = InputCollector::disambiguateOutputs(inputs, outputs, error);
+    assert(ok);
+    assert(outputs[0] == "out/foo_h.rs");
+    assert(outputs[1] == "out/foo.rs");
+    assert(outputs[2] == "out/bar.rs");
+
+    // Same name under two roots has nothing to tell them apart
+    std::vector<InputFile> twins = {{"a/x.cpp", "a"}, {"b/x.cpp", "b"}};
+    std::vector<std::string> twin_outputs = {"out/x.rs", "out/x.rs"};
+    ok = InputCollector::disambiguateOutputs(twins, twin_outputs, error);
+    assert(!ok);
+    assert(error.find("a/x.cpp and b/x.cpp") != std::string::npos);
+
+    // The batch refuses duplicates before anything is written
+    Transpiler transpiler{TranspilerOptions()};
+    ok = transpiler.transpileBatch({"a/x.cpp", "b/x.cpp"}, {"out/x.rs", "out/./x.rs"});
+    assert(!ok);
+    assert(transpiler.getLastError().find("would both be written to") != std::string::npos);
+    (void)ok;
+    std::cout << "  ✓ Output path collision test passed\n";
+}
+
+void testPoolRethrowsTaskFailures() {
+    for (size_t threads : {1, 4}) {
+        std::vector<int> ran(16, 0);
+        std::string caught;
+        try {
+            WorkStealingPool(threads).parallelFor(ran.size(), [&](size_t i) {
+                ran[i] = 1;
+                if (i == 5 || i == 11) {
+                    throw std::runtime_error("task " + std::to_string(i));
+                }
+            });
+        } catch (const std::runtime_error& e) {
+            caught = e.what();
+        }
+        // Every task still runs, and the lowest failing index is reported
+        assert(caught == "task 5");
+        assert(std::count(ran.begin(), ran.end(), 1) == 16);
+    }
+    std::cout << "  ✓ Pool task failure test passed\n";
+}
+
+void testTypeSpellingsAreCached() {
+    std::string source =
+        "class Store {\n"
+        "public:\n"
+        "    unsigned int count(const std::string& key, const std::string& scope) const;\n"
+        "    void put(const std::string& key, unsigned int value);\n"
+        "    long long get(const std::string& key) const;\n"
+        "};\n";
+    IR ir = Parser::parseString(source);
+
+    // Multi-word builtins come from the shared table; each distinct
+    // interned type is converted once, repeats are hits
+    RustCodeGenerator rust_gen;
+    std::string code = rust_gen.generate(ir);
+    assert(code.find("value: u32") != std::string::npos);
+    assert(rust_gen.getTypeSpellings().getMisses() == rust_gen.getTypeSpellings().size());
+    assert(rust_gen.getTypeSpellings().getHits() >= 4);
+
+    // A second IR with equal but distinct nodes gets the same spellings
+    assert(rust_gen.generate(Parser::parseString(source)) == code);
+
+    GoCodeGenerator go_gen;
+    std::string go_code = go_gen.generate(ir);
+    assert(go_code.find("value uint32") != std::string::npos);
+    assert(go_gen.getTypeSpellings().getHits() >= 4);
+    std::cout << "  ✓ Type spelling cache test passed\n";
+}
+
+void testTranspileSessionIsReentrant() {
+    std::vector<std::string> sources;
+    for (int i = 0; i < 8; ++i) {
+        sources.push_back("class Counter" + std::to_string(i) + " {\n"
+                          "public:\n"
+                          "    int next() { return value + " + std::to_string(i) + "; }\n"
+                          "private:\n"
+                          "    int value;\n"
+                          "};\n");
+    }
+
+    TranspilerOptions options;
+    options.targets = {TargetLanguage::Rust, TargetLanguage::Go};
+    TranspileSession session(options);
+
+    // Many callers at once, each call complete on its own
+    const size_t kThreads = 4;
+    std::vector<std::vector<SessionResult>> results(kThreads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < 3; ++round) {
+                for (const auto& source : sources) {
+                    results[t].push_back(session.transpile(SourceBuffer::fromString(source, "counter.cpp")));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& per_thread : results) {
+        assert(per_thread.size() == 3 * sources.size());
+        for (size_t i = 0; i < per_thread.size(); ++i) {
+            const SessionResult& result = per_thread[i];
+            IR ir = Parser::parseString(sources[i % sources.size()]);
+            assert(result.success && result.error.empty());
+            assert(result.classes == 1);
+            assert(result.outputs.size() == 2);
+            assert(result.outputs[0].target == TargetLanguage::Rust);
+            assert(result.outputs[0].code == RustCodeGenerator().generate(ir));
+            assert(result.outputs[1].code == GoCodeGenerator().generate(ir));
+        }
+    }
+    // Workspaces are reused, not made per call
+    assert(session.getWorkspaceCount() >= 1 && session.getWorkspaceCount() <= kThreads);
+
+    // Requests choose their targets and may ask for a single class
+    SessionRequest request;
+    request.source = SourceBuffer::fromString(sources[0] + sources[1], "pair.cpp");
+    request.targets = {TargetLanguage::Go};
+    request.declaration = "Counter1";
+    SessionResult single = session.transpile(request);
+    assert(single.success && single.outputs.size() == 1);
+    assert(single.outputs[0].code.find("Counter1") != std::string::npos);
+    assert(single.outputs[0].code.find("Counter0") == std::string::npos);
+
+    request.declaration = "Missing";
+    SessionResult missing = session.transpile(request);
+    assert(!missing.success && missing.outputs.empty() && !missing.error.empty());
+    std::cout << "  ✓ Reentrant transpile session test passed\n";
+}
+
+void testOverBudgetFileFallsBack() {
+    std::string large;
+    for (int i = 0; i < 4000; ++i) {
+        large += "class Node" + std::to_string(i) + " {\n"
+                 "public:\n"
+                 "    int weight(int scale) const { return value * scale + " + std::to_string(i) + "; }\n"
+                 "private:\n"
+                 "    int value;\n"
+                 "};\n";
+    }
+    std::string small = "class Leaf { public: int get() const { return 1; } };\n";
+    std::vector<std::string> inputs = {"test_budget_large.cpp", "test_budget_small.cpp"};
+    std::vector<std::string> outputs = {"test_budget_large.rs", "test_budget_small.rs"};
+    std::ofstream(inputs[0], std::ios::binary) << large;
+    std::ofstream(inputs[1], std::ios::binary) << small;
+    auto read = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    };
+
+    // The large file stops partway through parsing; the batch goes on
+    TranspilerOptions options;
+    options.jobs = 2;
+    options.memory_budget_mb = 1;
+    Transpiler transpiler(options);
+    bool ok = transpiler.transpileBatch(inputs, outputs);
+    assert(ok);
+    (void)ok;
+    const FileResult& over = transpiler.getBatchResults()[0];
+    assert(over.success && over.over_budget);
+    assert(over.error.find("memory budget during parse") != std::string::npos);
+    std::string fallback = read(outputs[0]);
+    assert(fallback.rfind("// Signatures only: ", 0) == 0);
+    assert(fallback.find("value * scale") == std::string::npos);
+
+    const FileResult& within = transpiler.getBatchResults()[1];
+    assert(within.success && !within.over_budget);
+    assert(read(outputs[1]) == RustCodeGenerator().generate(Parser::parseString(small)));
+
+    // Declarations survive the fallback, bodies do not
+    IR leaf = Parser::parseString(small);
+    std::string stub = Transpiler::generateSignaturesOnly(leaf, TargetLanguage::Rust, TranspilerOptions(), "test");
+    assert(stub.rfind("// Signatures only: test\n", 0) == 0);
+    assert(stub.find("pub fn get(&self) -> i32") != std::string::npos);
+    assert(stub.find("return 1") == std::string::npos);
+
+    // Sessions apply the same budget per call
+    SessionResult session_result = TranspileSession(options).transpile(SourceBuffer::fromString(large, "large.cpp"));
+    assert(session_result.success && session_result.over_budget);
+    assert(session_result.outputs[0].code.rfind("// Signatures only: ", 0) == 0);
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        std::remove(inputs[i].c_str());
+        std::remove(outputs[i].c_str());
+    }
+    std::cout << "  ✓ Over-budget fallback test passed\n";
+}
+
+void testRustOptimizationLevels() {
+    auto source = SourceBuffer::fromString(
+        "class Stats {\n"
+        "    std::mutex mtx;\n"
+        "    long hits;\n"
+        "public:\n"
+        "    void hit() { std::lock_guard<std::mutex> lock(mtx); ++hits; }\n"
+        "    long get() const { std::lock_guard<std::mutex> lock(mtx); return hits; }\n"
+        "};\n"
+        "class Registry {\n"
+        "    std::mutex mtx;\n"
+        "    std::vector<std::string> names;\n"
+        "public:\n"
+        "    size_t count() const { std::lock_guard<std::mutex> lock(mtx); return names.size(); }\n"
+        "    void add(std::string name) { std::lock_guard<std::mutex> lock(mtx); names.push_back(name); }\n"
+        "};\n"
+        "class Text {\n"
+        "public:\n"
+        "    int score(std::string word, int n) {\n"
+        "        std::vector<int> out;\n"
+        "        out.reserve(n);\n"
+        "        return word.size() + out.size();\n"
+        "    }\n"
+        "};\n"
+        "class Meter {\n"
+        "    std::mutex meter_mtx;\n"
+        "    long ticks;\n"
+        "public:\n"
+        "    void tick() { std::lock_guard<std::mutex> lock(meter_mtx); ++ticks; }\n"
+        "    void reset() { meter_mtx.lock(); ticks = 0; meter_mtx.unlock(); }\n"
+        "};\n", "levels.cpp");
+    auto generate = [&](int level) {
+        TranspilerOptions options;
+        options.optimization_level = level;
+        SessionResult result = TranspileSession(options).transpile(source);
+        assert(result.success);
+        return result.outputs[0].code;
+    };
+
+    // -O0 is the readable translation, as before
+    std::string readable = generate(0);
+    assert(readable == RustCodeGenerator().generate(Parser::parseString(std::string(source->text()))));
+    assert(readable.find("hits: i64") != std::string::npos);
+    assert(readable.find("with_capacity") == std::string::npos);
+
+    std::string optimized = generate(2);
+    assert(optimized.find("pub hits: std::sync::atomic::AtomicI64,") != std::string::npos);
+    assert(optimized.find("self.hits.fetch_add(1, std::sync::atomic::Ordering::Relaxed);") != std::string::npos);
+    assert(optimized.find("self.hits.load(std::sync::atomic::Ordering::Relaxed)") != std::string::npos);
+    // Locking in a const method stays exclusive: it may update mutable state
+    assert(optimized.find("pub mtx: std::sync::Mutex<()>,") != std::string::npos);
+    assert(optimized.find("let _lock = mtx.lock().unwrap();") != std::string::npos);
+    assert(optimized.find(".read()") == std::string::npos);
+    // A manual lock()/unlock() is not a lock scope, so the mutex and counter stay
+    assert(optimized.find("pub meter_mtx: std::sync::Mutex<()>,") != std::string::npos);
+    assert(optimized.find("pub ticks: i64,") != std::string::npos);
+    assert(optimized.find("pub fn score(&mut self, word: &str, n: i32) -> i32") != std::string::npos);
+    assert(optimized.find("let mut out = Vec::with_capacity(n);") != std::string::npos);
+    assert(optimized.find("#[inline]") == std::string::npos);
+
+    std::string aggressive = generate(3);
+    assert(aggressive.find("#[inline]\n    pub fn hit(&self)") != std::string::npos);
+    std::cout << "  ✓ Rust optimization level test passed\n";
+}
+
+void testOptimizedExamples() {
+    // Analysis runs from -O2 up; constructors (no return type) with try/catch used to crash
+    std::vector<std::shared_ptr<const SourceBuffer>> sources = {SourceBuffer::fromString(
+        "class R { public: R() { try {} catch (...) {} } };\n", "ctor_try.cpp")};
+    for (const auto& entry : std::filesystem::directory_iterator(HYBRID_EXAMPLES_DIR)) {
+        if (entry.path().extension() == ".cpp") {
+            sources.push_back(SourceBuffer::fromFile(entry.path().string()));
+        }
+    }
+    assert(sources.size() > 1);
+
+    for (int level = 2; level <= 3; ++level) {
+        TranspilerOptions options;
+        options.optimization_level = level;
+        options.targets = {TargetLanguage::Rust, TargetLanguage::Go};
+        for (const auto& source : sources) {
+            SessionResult result = TranspileSession(options).transpile(source);
+            assert(result.success);
+            assert(result.outputs.size() == 2);
+            (void)result;
+        }
+    }
+    std::cout << "  ✓ Optimized examples test passed\n";
+}
+
+void testGoOptimizationLevels() {
+    auto source = SourceBuffer::fromString(
+        "class Stats {\n"
+        "    std::mutex mtx;\n"
+        "    long hits;\n"
+        "public:\n"
+        "    void drop(long n) { std::lock_guard<std::mutex> lock(mtx); hits -= n; }\n"
+        "    long get() const { std::lock_guard<std::mutex> lock(mtx); return hits; }\n"
+        "};\n"
+        "class Registry {\n"
+        "    std::mutex mtx;\n"
+        "public:\n"
+        "    size_t count() const { std::lock_guard<std::mutex> lock(mtx); return total; }\n"
+        "    void add(int n) { std::lock_guard<std::mutex> lock(mtx); total = total + n; }\n"
+        "    int score(std::vector<int> weights) {\n"
+        "        std::vector<int> out;\n"
+        "        out.reserve(weights.size());\n"
+        "        for (int w : weights) out.push_back(w * 2);\n"
+        "        return out.size();\n"
+        "    }\n"
+        "    std::vector<int> keep(int n) { std::vector<int> kept; kept.reserve(n); return kept; }\n"
+        "    int both() {\n"
+        "        auto a = std::async(std::launch::async, fetch, 1);\n"
+        "        auto b = std::async(std::launch::async, fetch, 2);\n"
+        "        return a.get() + b.get();\n"
+        "    }\n"
+        "    int chained() {\n"
+        "        auto c = std::async(std::launch::async, fetch, 1);\n"
+        "        int first = c.get();\n"
+        "        auto d = std::async(std::launch::async, fetch, first);\n"
+        "        return d.get();\n"
+        "    }\n"
+        "};\n"
+        "class Cache {\n"
+        "    std::shared_mutex lookup_mtx;\n"
+        "    int entries;\n"
+        "public:\n"
+        "    int size() const { std::shared_lock<std::shared_mutex> lock(lookup_mtx); return entries; }\n"
+        "};\n", "levels.cpp");
+    auto generate = [&](int level) {
+        TranspilerOptions options;
+        options.target = TargetLanguage::Go;
+        options.optimization_level = level;
+        SessionResult result = TranspileSession(options).transpile(source);
+        assert(result.success);
+        return result.outputs[0].code;
+    };
+
+    std::string readable = generate(0);
+    assert(readable == GoCodeGenerator().generate(Parser::parseString(std::string(source->text()))));
+    assert(readable.find("make(") == std::string::npos);
+
+    std::string optimized = generate(2);
+    assert(optimized.find("import (\n    \"sync\"\n    \"sync/atomic\"\n)") != std::string::npos);
+    assert(optimized.find("    Hits atomic.Int64\n") != std::string::npos);
+    assert(optimized.find("this.Hits.Add(-n)") != std::string::npos);
+    assert(optimized.find("return this.Hits.Load()") != std::string::npos);
+    assert(optimized.find("    Mtx sync.Mutex\n") != std::string::npos);
+    assert(optimized.find(" mtx.RLock()") == std::string::npos);   // A const method may still write
+    assert(optimized.find("lookup_mtx.RLock()") != std::string::npos);
+    assert(optimized.find("out := make([]int32, 0, len(weights))") != std::string::npos);
+    assert(optimized.find("kept := make([]int32, 0, n)") != std::string::npos);
+    assert(optimized.find("<-a\n        <-b\n") != std::string::npos);
+    assert(optimized.find("<-c\n        <-d\n") == std::string::npos);     // d needs c's result
+    assert(optimized.find("c := Fetch(1)\n\n        // Wait for task completion\n        <-c\n") != std::string::npos);
+    assert(optimized.find("sync.Pool") == std::string::npos);
+
+    // -O3 recycles the temporary, but not the slice that is returned
+    std::string aggressive = generate(3);
+    assert(aggressive.find("var registryScoreOutPool = sync.Pool{") != std::string::npos);
+    assert(aggressive.find("outBuf := registryScoreOutPool.Get().(*[]int32)") != std::string::npos);
+    assert(aggressive.find("kept := make([]int32, 0, n)") != std::string::npos);
+    std::cout << "  ✓ Go optimization level test passed\n";
+}
+
+void testBenchmarkHarnesses() {
+    std::string source =
+        "class Meter {\n"
+        "public:\n"
+        "    Meter(int scale) : scale_(scale) {}\n"
+        "    int read(int raw) const { return raw * scale_; }\n"
+        "    void reset() { scale_ = 1; }\n"
+        "    static int unit() { return 1; }\n"
+        "private:\n"
+        "    void tune() {}\n"
+        "    int scale_;\n"
+        "};\n"
+        "class Shape {\n"
+        "public:\n"
+        "    virtual double area() const = 0;\n"
+        "};\n";
+    IR ir = Parser::parseString(source);
+
+    std::string rust = RustCodeGenerator().generateBenchmarks(ir, "meter.rs");
+    assert(rust.find("#[path = \"meter.rs\"]\nmod generated;") != std::string::npos);
+    assert(rust.find("let target = meter::new(black_box(Default::default()));") != std::string::npos);
+    assert(rust.find("c.bench_function(\"Meter_read\", |b| b.iter(|| target.read(black_box(Default::default()))));")
+           != std::string::npos);
+    assert(rust.find("let mut target = meter::new(") != std::string::npos);
+    assert(rust.find("b.iter(|| meter::unit())") != std::string::npos);
+    assert(rust.find("criterion_group!(benches, meter_read, meter_reset, meter_unit);") != std::string::npos);
+
+    // Private methods and abstract classes are left out, in every language
+    std::string go = GoCodeGenerator().generateBenchmarks(ir, "meter.go");
+    assert(go.find("func BenchmarkMeter_read(b *testing.B) {\n    target := NewMeter(0)\n") != std::string::npos);
+    assert(go.find("        benchmarkSink = target.Read(0)\n") != std::string::npos);
+    assert(go.find("        target.Reset()\n") != std::string::npos);
+    std::string cpp = CodeGenerator::generateCppBenchmarks(ir, "meter.h");
+    assert(cpp.find("    int init0{};\n    Meter target(init0);\n") != std::string::npos);
+    assert(cpp.find("benchmark::DoNotOptimize(target.read(arg0));") != std::string::npos);
+    assert(cpp.find("BENCHMARK(BM_Meter_read)->Name(\"Meter_read\");") != std::string::npos);
+    for (const std::string* harness : {&rust, &go, &cpp}) {
+        assert(harness->find("unit") != std::string::npos);
+        assert(harness->find("tune") == std::string::npos);
+        assert(harness->find("area") == std::string::npos);
+    }
+    assert(RustCodeGenerator().generateBenchmarks(Parser::parseString("class Empty {};\n"), "e.rs").empty());
+
+    // A batch writes one harness per target, and the stubs include the input
+    std::filesystem::create_directories("test_bench_out");
+    {
+        std::ofstream out("test_bench.cpp", std::ios::binary);
+        out << source;
+    }
+    TranspilerOptions options;
+    options.targets = {TargetLanguage::Rust, TargetLanguage::Go};
+    options.generate_benchmarks = true;
+    Transpiler transpiler(options);
+    bool ok = transpiler.transpileBatch({"test_bench.cpp"}, {"test_bench_out/meter.rs"});
+    assert(ok);
+    (void)ok;
+    const FileResult& result = transpiler.getBatchResults()[0];
+    assert((result.benchmark_paths == std::vector<std::string>{
+        "test_bench_out/meter_bench.rs", "test_bench_out/meter_test.go", "test_bench_out/meter_bench.cpp"}));
+    std::ifstream stubs("test_bench_out/meter_bench.cpp", std::ios::binary);
+    std::stringstream text;
+    text << stubs.rdbuf();
+    assert(text.str() == CodeGenerator::generateCppBenchmarks(ir, "../test_bench.cpp"));
+
+    std::remove("test_bench.cpp");
+    std::filesystem::remove_all("test_bench_out");
+    std::cout << "  ✓ Benchmark harness test passed\n";
+}
+
+void testFFIBindings() {
+    using namespace hybrid_transpiler::ffi;
+    FFIAnalyzer analyzer;
+    std::vector<FFIClass> classes = {analyzer.analyzeClass(
+        "class Calculator {\n"
+        "public:\n"
+        "    Calculator(int base) : base_(base) {}\n"
+        "    int add(int a, int b) const { return a + b + base_; }\n"
+        "    int64_t sum(std::span<const int32_t> values) const { return 0; }\n"
+        "    size_t count(std::string_view text) const { return text.size(); }\n"
+        "    void merge(const Calculator& other) { base_ += other.base_; }\n"
+        "    void fail() { throw 1; }\n"
+        "private:\n"
+        "    int base_;\n"
+        "};\n")};
+    std::vector<FFIFunction> functions = {analyzer.analyzeFunction("double mean(const std::vector<double>& xs)")};
+    const FFIClass& calculator = classes[0];
+    assert(calculator.c_name == "calculator" && calculator.constructors.size() == 1);
+    assert(calculator.methods.size() == 5 && !calculator.methods[4].can_use_ffi);
+
+    // Views cross as (pointer, length); the class crosses as a handle
+    std::string header = CWrapperGenerator().generateHeader(functions, classes, "calc");
+    assert(header.find("typedef struct Calculator Calculator;") != std::string::npos);
+    assert(header.find("Calculator* calculator_new(int base);") != std::string::npos);
+    assert(header.find("void calculator_delete(Calculator* self);") != std::string::npos);
+    assert(header.find("int64_t calculator_sum(const Calculator* self, const int32_t* values, size_t values_len);")
+           != std::string::npos);
+    assert(header.find("size_t calculator_count(const Calculator* self, const char* text, size_t text_len);")
+           != std::string::npos);
+    assert(header.find("void calculator_merge(Calculator* self, const Calculator* other);") != std::string::npos);
+    assert(header.find("fail") == std::string::npos);
+    assert(header.find("_batch") == std::string::npos);
+    std::string wrappers = CWrapperGenerator().generateImplementation(functions, classes, "calc");
+    assert(wrappers.find("return self->sum(std::span<const int32_t>(values, values_len));") != std::string::npos);
+    assert(wrappers.find("return self->count(std::string_view(text, text_len));") != std::string::npos);
+    assert(wrappers.find("return mean(std::vector<double>(xs, xs + xs_len));") != std::string::npos);
+
+    std::string rust = RustFFIGenerator().generateModule(functions, classes, "calc");
+    assert(rust.find("pub fn sum(&self, values: &[i32]) -> i64 {") != std::string::npos);
+    assert(rust.find("pub fn count(&self, text: &str) -> usize {") != std::string::npos);
+    assert(rust.find("pub fn merge(&mut self, other: &Calculator) {") != std::string::npos);
+    assert(rust.find("unsafe { sys::calculator_delete(self.ptr) }") != std::string::npos);
+    std::string go = GoFFIGenerator().generatePackage(functions, classes, "calc");
+    assert(go.find("func (c *Calculator) Sum(values []int32) int64 {") != std::string::npos);
+    assert(go.find("(*C.int32_t)(unsafe.Pointer(unsafe.SliceData(values))), C.size_t(len(values))")
+           != std::string::npos);
+    assert(go.find("unsafe.StringData(text)") != std::string::npos);
+
+    // Batched entry points only for all-scalar signatures
+    FFIOptions options;
+    options.batched = true;
+    header = CWrapperGenerator(options).generateHeader(functions, classes, "calc");
+    assert(header.find("void calculator_add_batch(const Calculator* self, const int* a, const int* b, "
+                       "int* results, size_t count);") != std::string::npos);
+    assert(header.find("calculator_sum_batch") == std::string::npos);
+    wrappers = CWrapperGenerator(options).generateImplementation(functions, classes, "calc");
+    assert(wrappers.find("        results[i] = self->add(a[i], b[i]);\n") != std::string::npos);
+    rust = RustFFIGenerator(options).generateModule(functions, classes, "calc");
+    assert(rust.find("pub fn add_batch(&self, a: &[i32], b: &[i32], results: &mut [i32]) {") != std::string::npos);
+    go = GoFFIGenerator(options).generatePackage(functions, classes, "calc");
+    assert(go.find("func (c *Calculator) AddBatch(a []C.int, b []C.int, results []C.int) {") != std::string::npos);
+    std::cout << "  ✓ FFI bindings test passed\n";
+}
+
+void testSharedHeaderDeclarations() {
+    std::filesystem::create_directories("test_headers/include");
+    auto write = [](const std::string& path, const std::string& text) {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    };
+    write("test_headers/include/shape.h", "class Shape {\npublic:\n    virtual double area() const = 0;\n};\n");
+    write("test_headers/base.h", "#include \"shape.h\"\n#include <vector>\n");
+    std::vector<std::string> inputs;
+    for (const char* name : {"circle", "square", "disc"}) {
+        inputs.push_back(std::string("test_headers/") + name + ".cpp");
+        write(inputs.back(), std::string("#include \"base.h\"\n\nclass ") + name +
+                             " : public Shape {\npublic:\n    double area() const { return 1.0; }\n};\n");
+    }
+    assert((HeaderCache::quotedIncludes("  #  include \"a.h\"\n#include <b>\n#include \"c/d.h\" // x\n") ==
+            std::vector<std::string>{"a.h", "c/d.h"}));
+
+    // The override is known only through the header; each header is parsed once for the batch
+    TranspilerOptions options;
+    options.jobs = 0;
+    options.include_dirs = {"test_headers/include"};
+    options.resolve_includes = true;
+    Transpiler transpiler(options);
+    bool ok = transpiler.transpileBatch(inputs, {"test_headers/circle.rs", "test_headers/square.rs",
+                                                 "test_headers/disc.rs"});
+    assert(ok);
+    (void)ok;
+    assert(transpiler.getHeaderCache()->getParseCount() == 2);
+    assert(transpiler.getHeaderCache()->getReuseCount() == 4);
+    for (const char* name : {"circle", "square", "disc"}) {
+        std::ifstream in(std::string("test_headers/") + name + ".rs", std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        assert(text.str().find("pub trait Shape {\n    fn area(&self) -> f64;\n}") != std::string::npos);
+    }
+
+    // Same content, same declarations; the includer's own classes come first
+    HeaderCache cache;
+    auto first = cache.declarations(SourceBuffer::fromString("class Shape {};\n", "one.h"), false);
+    auto second = cache.declarations(SourceBuffer::fromString("class Shape {};\n", "two.h"), false);
+    assert(first && first == second && cache.getParseCount() == 1);
+    IR ir = Parser::parseString("class Shape { int sides; };\n");
+    ir.addIncluded(first);
+    assert(ir.findClass("Shape") == &ir.getClasses()[0]);
+    ir = Parser::parseString("class Circle : public Shape {};\n");
+    ir.addIncluded(first);
+    assert(ir.findClass("Shape") == &first->getClasses()[0]);
+    assert(RustCodeGenerator().generate(ir).find("pub struct shape") == std::string::npos);
+
+    // Cached outputs are keyed by the headers too, so editing one is a miss
+    options.cache_dir = "test_headers/cache";
+    auto run = [&]() {
+        Transpiler cached(options);
+        bool built = cached.transpileBatch({inputs[0]}, {"test_headers/circle.rs"});
+        assert(built);
+        (void)built;
+        return cached.getBatchResults()[0].cache_hit;
+    };
+    assert(!run() && run());
+    write("test_headers/include/shape.h", "class Shape {\npublic:\n    virtual double size() const = 0;\n};\n");
+    assert(!run() && run());
+    std::ifstream edited("test_headers/circle.rs", std::ios::binary);
+    std::stringstream edited_text;
+    edited_text << edited.rdbuf();
+    assert(edited_text.str().find("fn area(&self) -> f64;") == std::string::npos);   // No longer an override
+
+    std::filesystem::remove_all("test_headers");
+    std::cout << "  ✓ Shared header declarations test passed\n";
+}
+
+void testShardedBatchMerge() {
+    // Largest first to the lightest shard; every machine computes the same split
+    std::vector<std::string> names = {"d.cpp", "a.cpp", "c.cpp", "b.cpp"};
+    std::vector<size_t> split = ShardSpec::assign(names, {10, 40, 10, 30}, 2);
+    assert((split == std::vector<size_t>{0, 0, 1, 1}));
+    ShardSpec spec;
+    std::string error;
+    assert(ShardSpec::parse("2/3", spec, error) && spec.index == 1 && spec.count == 3 && spec.toString() == "2/3");
+    assert(!ShardSpec::parse("0/3", spec, error) && !ShardSpec::parse("4/3", spec, error) &&
+           !ShardSpec::parse("1/", spec, error));
+
+    // Base and derived class in files of different shards
+    std::filesystem::create_directories("test_shards");
+    auto write = [](const std::string& path, const std::string& text) {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    };
+    write("test_shards/shape.cpp", "class Shape {\npublic:\n    virtual double area() const = 0;\n};\n");
+    write("test_shards/circle.cpp", "class Circle : public Shape {\npublic:\n"
+                                    "    double area() const { return 1.0; }\n};\n");
+    std::vector<ShardManifest> shards;
+    for (size_t index = 0; index < 2; ++index) {
+        TranspilerOptions options;
+        options.keep_ir = true;
+        Transpiler transpiler(options);
+        std::string name = index == 0 ? "shape" : "circle";
+        bool ok = transpiler.transpileBatch({"test_shards/" + name + ".cpp"}, {"test_shards/" + name + ".rs"});
+        assert(ok);
+        (void)ok;
+        assert(transpiler.getBatchResults()[0].ir_path == "test_shards/" + name + ".hir");
+        shards.push_back(ShardManifest::fromBatch({index, 2}, options, transpiler.getBatchResults()));
+    }
+    auto read = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    };
+    const std::string trait = "pub trait Shape {\n    fn area(&self) -> f64;\n}";
+    assert(read("test_shards/circle.rs").find(trait) == std::string::npos);
+
+    // Manifests survive the trip through JSON
+    ShardManifest parsed;
+    assert(ShardManifest::fromJson(shards[1].toJson(), parsed, error));
+    assert(parsed.shard.toString() == "2/2" && parsed.entries.size() == 1);
+    assert(parsed.entries[0].source_hash == shards[1].entries[0].source_hash && parsed.entries[0].success);
+    assert(parsed.toJson().dump() == shards[1].toJson().dump());
+
+    // Only the file that needed another file's base is regenerated
+    std::vector<ShardManifest> incomplete = {shards[1]};
+    assert(!ShardMerger::merge(incomplete).success);
+    MergeResult merged = ShardMerger::merge({shards[1], shards[0]});
+    assert(merged.success && merged.regenerated == 1 && merged.unresolved.empty());
+    assert(merged.manifest.shard.count == 1 && merged.manifest.entries[0].input_path == "test_shards/shape.cpp");
+    assert((merged.manifest.entries[1].resolved_bases == std::vector<std::string>{"Shape"}));
+    assert(read("test_shards/circle.rs").find(trait) != std::string::npos);
+
+    std::filesystem::remove_all("test_shards");
+    std::cout << "  ✓ Sharded batch merge test passed\n";
+}
+
+void testTemplateInstantiations() {
+    std::string source =
+        "template <typename T>\n"
+        "class Box {\n"
+        "public:\n"
+        "    T value;\n"
+        "    bool less(const Box<T>& other) const { return value < other.value; }\n"
+        "};\n"
+        "template <> class Box<int> { public: int value; int twice() const { return value * 2; } };\n"
+        "template <> class Box<int32_t> { public: int value; int twice() const { return value * 2; } };\n"
+        "template <> class Box<double> {\n"
+        "public:\n"
+        "    double value;\n"
+        "    bool less(const Box<double>& other) const { return value < other.value; }\n"
+        "};\n"
+        "template <typename T, int N = 4> class Tag { T label; public: std::string show() const { return std::to_string(label); } };\n"
+        "class User {\n"
+        "public:\n"
+        "    Box<unsigned> a;\n"
+        "    Box<std::int32_t> b;\n"
+        "    Tag<float> c;\n"
+        "    Tag<long> d;\n"
+        "    Tag<int> e;\n"
+        "};\n";
+    IR ir = Parser::parseString(source);
+    const ClassDecl& box = ir.getClasses()[0];
+    assert(box.is_template && box.template_parameters.size() == 1);
+    assert(box.template_parameters[0].kind == TemplateParameter::Type && box.template_parameters[0].name == "T");
+    const ClassDecl& tag = ir.getClasses()[4];
+    assert(tag.template_parameters.size() == 2 && tag.template_parameters[1].kind == TemplateParameter::NonType);
+    assert(tag.template_parameters[1].default_value == "4");
+    assert(CodeGenerator::canonicalSpelling("Pair< long long , std::uint32_t >") == "Pair<long,unsigned int>");
+
+    // Box<int32_t> repeats Box<int>, and Box<double> is the primary with T = double
+    std::string rust = RustCodeGenerator().generate(ir);
+    assert(rust.find("impl<T: PartialOrd> box<T> {") != std::string::npos);
+    size_t specialized = rust.find("pub struct box_i32 {");
+    assert(specialized != std::string::npos && rust.find("pub struct box_i32 {", specialized + 1) == std::string::npos);
+    assert(rust.find("box_f64") == std::string::npos);
+    assert(rust.find("pub a: box<u32>,") != std::string::npos);
+    assert(rust.find("pub b: box_i32,") != std::string::npos);
+    assert(rust.find("pub c: tag<f32>,") != std::string::npos);
+    assert(rust.find("impl<T: std::fmt::Display, const N: i32> tag<T, N> {") != std::string::npos);
+
+    std::string go = GoCodeGenerator().generate(ir);
+    assert(go.find("type Box[T ordered] struct {") != std::string::npos);
+    assert(go.find("type ordered interface {") != std::string::npos);
+    assert(go.find("func (this *Box[T]) Less(other *Box[T]) bool {") != std::string::npos);
+    assert(go.find("B BoxInt32") != std::string::npos);
+
+    // Over the budget, a template whose parameters are only printed is erased; an ordered one stays generic
+    std::string source_erased = source;
+    source_erased.replace(source_erased.find("template <typename T, int N = 4> class Tag"),
+                          std::string("template <typename T, int N = 4> class Tag").size(),
+                          "template <typename T> class Tag");
+    IR erased_ir = Parser::parseString(source_erased);
+    RustCodeGenerator rust_budget;
+    rust_budget.setMonomorphizationBudget(2);
+    std::string erased = rust_budget.generate(erased_ir);
+    assert(erased.find("pub struct tag {\n    pub label: Box<dyn std::fmt::Display>,") != std::string::npos);
+    assert(erased.find("pub c: tag,") != std::string::npos);
+    assert(erased.find("// Box: 3 instantiations exceed the monomorphization budget of 2; kept generic") !=
+           std::string::npos);
+    GoCodeGenerator go_budget;
+    go_budget.setMonomorphizationBudget(2);
+    std::string go_erased = go_budget.generate(erased_ir);
+    assert(go_erased.find("type Tag struct {\n    Label any") != std::string::npos);
+    assert(go_erased.find("type Box[T ordered] struct {") != std::string::npos);
+
+    // Declaration by declaration, the plan made by the prologue gives the same bytes
+    StringSink pieces;
+    rust_budget.generatePrologue(erased_ir, pieces);
+    for (const auto& class_decl : erased_ir.getClasses()) {
+        rust_budget.generateDeclaration(erased_ir, class_decl, pieces);
+    }
+    rust_budget.generateEpilogue(erased_ir, pieces);
+    assert(pieces.take() == erased);
+    std::cout << "  ✓ Template instantiation test passed\n";
+}
+
 void runAllCodegenTests() {
     std::cout << "\nRunning Code Generation Tests:\n";
     testRustCodeGeneration();
     testGoCodeGeneration();
+    testStreamingOutputSinks();
+    testParallelCodegenIsByteIdentical();
+    testBuildCache();
+    testMultiTargetBatch();
+    testInputCollection();
+    testOutputPathCollisions();
+    testPoolRethrowsTaskFailures();
+    testTypeSpellingsAreCached();
+    testTranspileSessionIsReentrant();
+    testOverBudgetFileFallsBack();
+    testRustOptimizationLevels();
+    testGoOptimizationLevels();
+    testOptimizedExamples();
+    testBenchmarkHarnesses();
+    testFFIBindings();
+    testSharedHeaderDeclarations();
+    testShardedBatchMerge();
+    testTemplateInstantiations();
     std::cout << "All code generation tests passed!\n";
 }
 
@@ -0,0 +1,633 @@
+#include "analysis_pass.h"
+#include "build_cache.h"
+#include "clang_frontend.h"
+#include "declaration_index.h"
+#include "incremental_session.h"
+#include "ir_serializer.h"
+#include "lexer.h"
+#include "parser.h"
+#include "profiler.h"
+#include "source_buffer.h"
+#include "transpiler.h"
+#include "codegen.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+namespace hybrid {
+namespace test {
+
+void testLexerTokenKinds() {
+    Lexer lexer("#include <vector>\n"
+                "// comment\n"
+                "auto s = R\"x(a \"quoted\" )x\"; int n = 1'000; std::map<int, std::vector<int>> m;");
+    auto tokens = lexer.tokenize(false);
+
+    assert(tokens.front().kind == TokenKind::Preprocessor);
+    assert(tokens.back().kind == TokenKind::EndOfFile);
+
+    bool saw_raw = false;
+    bool saw_number = false;
+    int closers = 0;
+    for (const auto& token : tokens) {
+        assert(token.kind != TokenKind::Comment);
+        if (token.kind == TokenKind::String && token.text == "R\"x(a \"quoted\" )x\"") saw_raw = true;
+        if (token.kind == TokenKind::Number && token.text == "1'000") saw_number = true;
+        if (token.isPunct(">")) closers++;
+    }
+    assert(saw_raw);
+    assert(saw_number);
+    assert(closers == 2);  // ">>" is split for nested templates
+    std::cout << "  ✓ Lexer token kinds test passed\n";
+}
+
+void testLexerBlockScanning() {
+    // Comments, literals and directives longer than one 16-byte scan block,
+    // with their terminators and escapes landing at every block offset
+    std::string source;
+    for (size_t pad = 0; pad < 40; ++pad) {
+        std::string fill(pad, 'x');
+        source += "/* " + fill + "\n" + fill + " */ a\n";
+        source += "// " + fill + " \\\n continued\n";
+        source += "\"" + fill + "\\\"" + fill + "\" b\n";
+        source += "#define M" + std::to_string(pad) + " " + fill + " /* x\n y */ 1\n";
+    }
+    auto tokens = Lexer(source).tokenize(true);
+
+    size_t comments = 0;
+    size_t strings = 0;
+    size_t directives = 0;
+    uint32_t line = 1;
+    for (const auto& token : tokens) {
+        if (token.kind == TokenKind::Comment) comments++;
+        if (token.kind == TokenKind::String) strings++;
+        if (token.kind == TokenKind::Preprocessor) directives++;
+        if (token.isIdentifier("a")) {
+            assert(token.line == line + 1);
+            line += 7;  // Block comment, spliced line comment, string and spliced directive
+        }
+    }
+    assert(comments == 80 && strings == 40 && directives == 40);
+    assert(tokens.back().kind == TokenKind::EndOfFile && tokens.back().line == 40 * 7 + 1);
+    std::cout << "  ✓ Lexer block scanning test passed\n";
+}
+
+void testParseClassMembers() {
+    IR ir = Parser::parseString(
+        "class Widget : public Base<Widget> {\n"
+        "public:\n"
+        "    Widget(int w) : width_(w), name_{\"w\"} { if (w) { width_ = w; } }\n"
+        "    ~Widget() {}\n"
+        "    int width() const { return width_; }\n"
+        "    bool operator==(const Widget& other) const;\n"
+        "    virtual void draw() = 0;\n"
+        "private:\n"
+        "    int width_ = 0;\n"
+        "    std::string name_;\n"
+        "};\n");
+
+    assert(ir.getClasses().size() == 1);
+    const auto& widget = ir.getClasses()[0];
+    assert(widget.name == "Widget");
+    assert(widget.base_classes.size() == 1 && widget.base_classes[0] == "Base");
+
+    assert(widget.fields.size() == 2);
+    assert(widget.fields[0].name == "width_");
+    assert(widget.fields[1].name == "name_");
+
+    assert(widget.methods.size() == 5);
+    assert(widget.methods[0].is_constructor);
+    assert(widget.methods[1].is_destructor);
+    assert(widget.methods[2].name == "width" && widget.methods[2].is_const);
+    assert(widget.methods[3].name == "operator==");
+    assert(widget.methods[4].is_virtual && widget.methods[4].is_pure_virtual);
+    std::cout << "  ✓ Class member parsing test passed\n";
+}
+
+void testParseIgnoresCommentsAndStrings() {
+    IR ir = Parser::parseString(
+        "// class Commented { int x; };\n"
+        "const char* text = \"class InString {}\";\n"
+        "class Real { int value; };\n");
+
+    assert(ir.getClasses().size() == 1);
+    assert(ir.getClasses()[0].name == "Real");
+    std::cout << "  ✓ Comment and string skipping test passed\n";
+}
+
+void testTypesAreInterned() {
+    IR ir = Parser::parseString(
+        "class Pair {\n"
+        "    int first;\n"
+        "    int second;\n"
+        "    void set(const std::string& a, const std::string& b);\n"
+        "};\n");
+
+    const auto& pair = ir.getClasses()[0];
+    assert(pair.fields[0].type == pair.fields[1].type);
+
+    const auto& params = pair.methods[0].parameters;
+    assert(params.size() == 2);
+    assert(params[0].type == params[1].type);
+    assert(params[0].type->element_type == params[1].type->element_type);
+
+    // Interning the same structure again yields the existing node
+    auto again = std::make_shared<Type>(TypeKind::Integer);
+    again->name = "int";
+    assert(ir.getTypeArena().intern(again) == pair.fields[0].type);
+    std::cout << "  ✓ Type interning test passed\n";
+}
+
+void testSymbolIndexes() {
+    IR ir = Parser::parseString(
+        "class Shape { public: virtual double area() const; };\n"
+        "class Circle : public Shape { public: double area() const override; };\n");
+
+    const ClassDecl* circle = ir.findClass("Circle");
+    assert(circle != nullptr && circle->name == "Circle");
+    assert(circle == &ir.getClasses()[1]);
+    assert(ir.findClass("Square") == nullptr);
+    assert(ir.findType("Shape") != nullptr);
+
+    // The override is virtual through Shape, so it becomes a trait method
+    RustCodeGenerator rust_gen;
+    std::string code = rust_gen.generate(ir);
+    assert(code.find("fn area(&self) -> f64;") != std::string::npos);
+
+    Function helper;
+    helper.name = "helper";
+    ir.addFunction(helper);
+    ir.addFunction(helper);
+    assert(ir.findFunction("helper") == &ir.getFunctions()[0]);
+    assert(ir.findFunctionOverloads("helper")->size() == 2);
+    std::cout << "  ✓ Symbol index test passed\n";
+}
+
+void testBodiesAreSourceSpans() {
+    IR ir = Parser::parseString(
+        "class Counter {\n"
+        "    int count = 0;\n"
+        "    void add(int n = 1) { count += n; }\n"
+        "    void reset() { /* clear */ count = 0; }\n"
+        "};\n");
+
+    const auto& counter = ir.getClasses()[0];
+    const auto& add = counter.methods[0];
+    assert(ir.getSource() != nullptr);
+    assert(add.body.isView() && add.body.getBuffer() == ir.getSource().get());
+    assert(add.body == " count += n; ");
+    assert(add.parameters[0].default_value == "1");
+    assert(counter.fields[0].initializer == "0");
+
+    // Comments are stripped into owned text, but the span still locates it
+    const auto& reset = counter.methods[1];
+    assert(!reset.body.isView());
+    assert(reset.body.find("clear") == std::string::npos);
+    assert(ir.getSource()->locate(reset.location.offset).line == 4);
+    std::cout << "  ✓ Source span test passed\n";
+}
+
+void testMappedFileInput() {
+    std::string source;
+    for (int i = 0; source.size() < SourceBuffer::kMapThreshold; ++i) {
+        source += "class C" + std::to_string(i) + " { public: int get() { return " + std::to_string(i) + "; } };\n";
+    }
+    std::string path = "test_mapped_input.cpp";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << source;
+    }
+
+    auto mapped = SourceBuffer::fromFile(path);
+    auto copied = SourceBuffer::fromFile(path, false);
+    assert(mapped->isMapped() && !copied->isMapped());
+    assert(mapped->text() == source && copied->text() == source);
+
+    // Bodies point straight into the mapping
+    IR ir = Parser::parseBuffer(mapped);
+    const auto& body = ir.getClasses().back().methods[0].body;
+    assert(body.isView() && body.getBuffer() == mapped.get());
+    assert(RustCodeGenerator().generate(ir) == RustCodeGenerator().generate(Parser::parseString(source)));
+    std::remove(path.c_str());
+
+    // Small files are read instead
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "class Small {};\n";
+    }
+    assert(!SourceBuffer::fromFile(path)->isMapped());
+    std::remove(path.c_str());
+    std::cout << "  ✓ Mapped file input test passed\n";
+}
+
+void testDeclarationIndex() {
+    auto buffer = SourceBuffer::fromString(
+        "// class Commented { };\n"
+        "enum class Color { Red };\n"
+        "template <class T> class Holder { T value; };\n"
+        "class Fwd;\n"
+        "class Shape { public: virtual double area() { return 0; } };\n"
+        "class Unrelated { const char* s = \"class Fake { }\"; };\n"
+        "class Circle : public Shape {\n"
+        "public:\n"
+        "    double radius;\n"
+        "    double area() { return radius * radius; }\n"
+        "};\n");
+
+    // The index finds exactly the classes the full parser finds
+    IR full = Parser::parseBuffer(buffer);
+    DeclarationIndex index(buffer);
+    assert(index.getEntries().size() == full.getClasses().size());
+    for (size_t i = 0; i < full.getClasses().size(); ++i) {
+        assert(index.getEntries()[i].name == full.getClasses()[i].name);
+    }
+    assert(index.find("Fwd") == nullptr);
+    assert(index.find("Circle")->line == 7);
+
+    // Only the class and its bases are parsed, and the fragment is identical
+    IR lazy = index.parseDeclaration("Circle");
+    assert(lazy.getClasses().size() == 2);
+    assert(lazy.getClasses()[0].name == "Circle");
+    assert(lazy.getClasses()[1].name == "Shape");
+
+    RustCodeGenerator from_full;
+    RustCodeGenerator from_lazy;
+    StringSink full_fragment;
+    StringSink lazy_fragment;
+    bool generated = from_full.generateDeclaration(full, "Circle", full_fragment) &&
+                     from_lazy.generateDeclaration(lazy, "Circle", lazy_fragment);
+    assert(generated);
+    std::string fragment = lazy_fragment.take();
+    assert(fragment == full_fragment.take());
+    assert(fragment.find("Unrelated") == std::string::npos);
+
+    bool threw = false;
+    try {
+        index.parseDeclaration("Missing");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "  ✓ Declaration index test passed\n";
+}
+
+void testIncrementalSession() {
+    auto fullOutput = [](const std::string& source, TargetLanguage target) {
+        IR ir = Parser::parseString(source);
+        AnalysisPassManager manager = AnalysisPassManager::createDefault();
+        manager.run(ir);
+        return Transpiler::createCodeGenerator(target)->generate(ir);
+    };
+
+    std::string shape = "class Shape {\npublic:\n    virtual double area() const { return 0; }\n};\n";
+    std::string circle = "class Circle : public Shape {\n    double r;\npublic:\n"
+                         "    double area() const { return r * r; }\n};\n";
+    std::string point = "class Point {\n    int x;\npublic:\n    int get() { return x; }\n};\n";
+    std::string loader = "class Loader {\n    std::mutex lock;\npublic:\n"
+                         "    Task<int> load() {\n        int n = co_await fetch();\n        co_return n;\n    }\n};\n";
+    std::string sized = "class Shape {\npublic:\n    virtual double size() const { return 0; }\n};\n";
+    std::vector<std::string> versions = {
+        shape + circle + point + loader,
+        // Edit one body and shift everything below it
+        shape + circle + "\n\n" + "class Point {\n    int x;\npublic:\n    int get() { return x + 1; }\n};\n" + loader,
+        // Editing a base invalidates the fragments of derived classes too
+        sized + circle + point + loader,
+        // Reordered, one removed
+        loader + sized + circle,
+    };
+
+    AnalysisPassManager manager = AnalysisPassManager::createDefault();
+    for (TargetLanguage target : {TargetLanguage::Rust, TargetLanguage::Go}) {
+        IncrementalSession session(target);
+        session.setAnalysis(&manager);
+        for (const auto& version : versions) {
+            bool updated = session.update(SourceBuffer::fromString(version));
+            assert(updated);
+            assert(session.getOutput() == fullOutput(version, target));
+        }
+    }
+
+    IncrementalSession session(TargetLanguage::Rust);
+    session.setAnalysis(&manager);
+    session.update(SourceBuffer::fromString(versions[0]));
+    assert(session.getLastStats().reparsed == 4);
+
+    session.update(SourceBuffer::fromString(versions[1]));
+    const IncrementalStats& edit = session.getLastStats();
+    assert(edit.declarations == 4 && edit.reparsed == 1 && edit.regenerated == 1 && edit.discarded == 1);
+
+    // Carried-over classes point into the new buffer, analyzer lines included
+    IR expected = Parser::parseString(versions[1]);
+    manager.run(expected);
+    const Function& load = session.getIR().getClasses()[3].methods[0];
+    assert(load.body == expected.getClasses()[3].methods[0].body.view());
+    assert(load.body.getBuffer() == session.getIR().getSource().get());
+    assert(load.coroutine_info.async_operations[0].line_number ==
+           expected.getClasses()[3].methods[0].coroutine_info.async_operations[0].line_number);
+
+    session.update(SourceBuffer::fromString(versions[2]));
+    assert(session.getLastStats().reparsed == 2);       // Shape, and Point edited back
+    assert(session.getLastStats().regenerated == 3);    // Plus Circle through its base
+
+    session.update(SourceBuffer::fromString(versions[3]));
+    assert(session.getLastStats().reparsed == 0 && session.getLastStats().discarded == 1);
+    std::cout << "  ✓ Incremental session test passed\n";
+}
+
+void testSerializedIRRoundTrip() {
+    std::string source =
+        "template <typename T> class Box { T value; public: T get() const { return value; } };\n"
+        "class Worker {\n"
+        "    std::mutex lock;\n"
+        "    std::atomic<int> count;\n"
+        "public:\n"
+        "    void run() { std::lock_guard<std::mutex> guard(lock); count++; /* tick */ }\n"
+        "    int parse(const std::string& s) { if (s.empty()) throw std::runtime_error(\"empty\"); return 1; }\n"
+        "    Task<int> load() { int n = co_await fetch(); co_return n; }\n"
+        "};\n";
+    IR ir = Parser::parseString(source);
+    AnalysisPassManager::createDefault().run(ir);
+
+    std::string data = IRSerializer::serialize(ir);
+    assert(IRSerializer::isSerialized(data) && !IRSerializer::isSerialized(source));
+
+    IR loaded;
+    std::string error;
+    bool ok = IRSerializer::deserialize(SourceBuffer::fromString(data), loaded, error);
+    assert(ok);
+    (void)ok;
+
+    // Analysis results survive, and one load feeds either generator
+    const Function& parse = loaded.findClass("Worker")->methods[1];
+    assert(parse.may_throw && !parse.body.empty());
+    assert(loaded.findClass("Worker")->methods[2].coroutine_info.is_coroutine);
+    for (TargetLanguage target : {TargetLanguage::Rust, TargetLanguage::Go}) {
+        assert(Transpiler::createCodeGenerator(target)->generate(loaded) ==
+               Transpiler::createCodeGenerator(target)->generate(ir));
+    }
+
+    // Bodies are views into the embedded source; types are interned again
+    assert(loaded.findClass("Box")->methods[0].body.isView());
+    assert(loaded.findClass("Box")->methods[0].body.getBuffer() == loaded.getSource().get());
+    assert(loaded.getSource()->text() == source);
+    assert(loaded.getTypeArena().size() == ir.getTypeArena().size());
+    assert(IRSerializer::serialize(loaded) == data);
+
+    // Damaged input is rejected and leaves the target untouched
+    IR untouched = Parser::parseString("class Kept {};");
+    std::string bad_version = data;
+    bad_version[4] = 9;
+    assert(!IRSerializer::deserialize(SourceBuffer::fromString(data.substr(0, data.size() / 2)), untouched, error));
+    assert(!IRSerializer::deserialize(SourceBuffer::fromString(bad_version), untouched, error));
+    assert(error.find("version") != std::string::npos);
+    assert(untouched.getClasses().size() == 1);
+    std::cout << "  ✓ Serialized IR round trip test passed\n";
+}
+
+void testFusedAnalysisPasses() {
+    IR ir = Parser::parseString(
+        "class Worker {\n"
+        "    void run() {\n"
+        "        std::lock_guard<std::mutex> guard(mtx);\n"
+        "        std::thread t(work, std::ref(data), 2);\n"
+        "        t.detach();\n"
+        "        counter.fetch_add(1);\n"
+        "        auto f = std::async(std::launch::async, compute, 7);\n"
+        "        try { step(); } catch (const std::runtime_error& e) { log(e); } catch (...) { throw; }\n"
+        "    }\n"
+        "    void idle(int n) { n = 0; }\n"
+        "};\n");
+
+    AnalysisPassManager manager = AnalysisPassManager::createDefault();
+    manager.run(ir);
+
+    const auto& run = ir.getClasses()[0].methods[0];
+    assert(run.uses_threading);
+    assert(run.lock_scopes.size() == 1 && run.lock_scopes[0].mutex_name == "mtx");
+    assert(run.threads_created.size() == 1);
+    assert(run.threads_created[0].function_name == "work");
+    assert(run.threads_created[0].arguments.size() == 2);
+    assert(run.threads_created[0].arguments[0] == "std::ref(data)");
+    assert(run.threads_created[0].detached);
+    assert(run.atomic_operations.size() == 1 && run.atomic_operations[0].operations[0] == "fetch_add");
+
+    assert(run.is_async && run.async_tasks.size() == 1);
+    assert(run.async_tasks[0].task_var_name == "f");
+    assert(run.async_tasks[0].async_function_name == "compute");
+
+    assert(run.may_throw && run.try_catch_blocks.size() == 1);
+    const auto& clauses = run.try_catch_blocks[0].catch_clauses;
+    assert(clauses.size() == 2);
+    assert(clauses[0].exception_type == "std::runtime_error" && clauses[0].exception_var == "e");
+    assert(clauses[1].exception_type == "...");
+    assert(run.try_catch_blocks[0].try_body == " step(); ");
+    assert(run.try_catch_blocks[0].try_body.isView());
+
+    const auto& idle = ir.getClasses()[0].methods[1];
+    assert(!idle.uses_threading && !idle.is_async && !idle.may_throw);
+    assert(idle.borrowed_params.empty() && idle.moved_params.empty());
+
+    // One timing slot per pass; only passes with matching tokens were dispatched.
+    // The clock is not read unless profiling.
+    assert(manager.getTimings().size() == 4);
+    assert(manager.getFunctionCount() == 2);
+    assert(!Profiler::enabled());
+    for (const auto& timing : manager.getTimings()) {
+        assert(timing.dispatches > 0);
+        assert(timing.nanoseconds == 0);
+    }
+    assert(manager.getScanNanoseconds() == 0);
+    std::cout << "  ✓ Fused analysis pass test passed\n";
+}
+
+void testOwnershipAnalysis() {
+    IR ir = Parser::parseString(
+        "class Store {\n"
+        "    std::mutex mtx;\n"
+        "    long hits;\n"
+        "public:\n"
+        "    int score(std::string word, std::vector<int> extra, std::string name, std::string key) {\n"
+        "        std::vector<int> out;\n"
+        "        out.reserve(extra.size() + 1);\n"
+        "        extra.push_back(1);\n"
+        "        names.push_back(std::move(name));\n"
+        "        return word.size() + lookup(key);\n"
+        "    }\n"
+        "    std::vector<std::string> keep(int n) { std::vector<std::string> kept; kept.reserve(n); return kept; }\n"
+        "    void hit(long n) { std::lock_guard<std::mutex> lock(mtx); hits += n; }\n"
+        "    long get() const { std::lock_guard<std::mutex> lock(mtx); return hits; }\n"
+        "    void reset() { std::lock_guard<std::mutex> lock(mtx); hits = 0; log(); }\n"
+        "};\n");
+    AnalysisPassManager::createDefault().run(ir);
+    const auto& methods = ir.getClasses()[0].methods;
+
+    // word is only read; extra is modified, name moved, key passed on
+    const auto& score = methods[0];
+    assert(score.borrowed_params == std::vector<std::string>{"word"});
+    assert(score.moved_params == std::vector<std::string>{"name"});
+    assert(score.capacity_hints.size() == 1);
+    assert(score.capacity_hints[0].var_name == "out");
+    assert(score.capacity_hints[0].container == TypeKind::StdVector);
+    assert(score.capacity_hints[0].capacity == "extra.size() + 1");
+    assert(score.capacity_hints[0].type_args == std::vector<std::string>{"int"});
+    assert(!score.capacity_hints[0].escapes);
+
+    // A returned container outlives the call
+    assert(methods[1].capacity_hints.size() == 1 && methods[1].capacity_hints[0].escapes);
+    assert(methods[1].capacity_hints[0].type_args == std::vector<std::string>{"std::string"});
+
+    // Bodies that are only the lock and one counter update
+    assert(methods[2].guarded_updates.size() == 1);
+    assert(methods[2].guarded_updates[0].operation == GuardedUpdate::Add);
+    assert(methods[2].guarded_updates[0].var_name == "hits");
+    assert(methods[2].guarded_updates[0].operand == "n");
+    assert(methods[3].guarded_updates.size() == 1);
+    assert(methods[3].guarded_updates[0].operation == GuardedUpdate::Read);
+    assert(methods[4].guarded_updates.empty() && methods[4].lock_scopes.size() == 1);
+    std::cout << "  ✓ Ownership analysis test passed\n";
+}
+
+void testProfilerRecordsParserPhases() {
+    Profiler& profiler = Profiler::global();
+    profiler.start();
+    IR ir = Parser::parseString("class Timed { int a; /* note */ void f() { a = 1; } };\n");
+    profiler.stop();
+
+    bool saw_lex = false;
+    for (const auto& event : profiler.getEvents()) {
+        if (std::string(event.category) == "parse" && std::string(event.name) == "lex") {
+            saw_lex = true;
+            assert(event.bytes > 0);
+        }
+    }
+    assert(saw_lex);
+
+    // Nothing is recorded while stopped
+    size_t recorded = profiler.getEvents().size();
+    Parser::parseString("class Quiet {};");
+    assert(profiler.getEvents().size() == recorded);
+
+    std::string path = "test_profiler_trace.json";
+    std::string error;
+    assert(profiler.writeTrace(path, error));
+    std::ifstream in(path);
+    std::stringstream trace;
+    trace << in.rdbuf();
+    std::remove(path.c_str());
+    assert(trace.str().find("\"traceEvents\"") != std::string::npos);
+    assert(trace.str().find("\"name\":\"lex\"") != std::string::npos);
+    std::cout << "  ✓ Profiler phase test passed\n";
+}
+
+void testClangFrontEndSelection() {
+    std::string source =
+        "#include <string>\n"
+        "class Account {\n"
+        "public:\n"
+        "    int balance() const { return value + 1; }\n"
+        "    void rename(const std::string& name, int times = 2);\n"
+        "private:\n"
+        "    int value = 0;\n"
+        "};\n";
+    std::string path = "test_clang_frontend.cpp";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << source;
+    }
+
+    TranspilerOptions options;
+    options.frontend = FrontEnd::Clang;
+    options.quiet = true;
+    options.output_path = "test_clang_frontend.rs";
+    Transpiler transpiler(options);
+    bool ok = transpiler.transpile(path);
+
+    if (ClangFrontEnd::isAvailable()) {
+        // Members and bodies reach the IR as with the built-in parser
+        assert(ok);
+        std::ifstream in(options.output_path, std::ios::binary);
+        std::stringstream code;
+        code << in.rdbuf();
+        assert(code.str().find("pub fn balance(&self) -> i32") != std::string::npos);
+        assert(code.str().find("value + 1") != std::string::npos);
+    } else {
+        assert(!ok);
+        assert(transpiler.getLastError().find("Failed to parse input file: ") == 0);
+    }
+    (void)ok;
+
+    // Outputs of the two front ends are cached separately
+    TranspilerOptions simple;
+    assert(BuildCache::computeKey(source, simple) != BuildCache::computeKey(source, options));
+
+    std::remove(path.c_str());
+    std::remove(options.output_path.c_str());
+    std::cout << "  ✓ Clang front end selection test passed\n";
+}
+
+void testClangSharedPreamble() {
+    // No include guard: the block must be read once, from the PCH
+    std::string header = "test_preamble_point.inc";
+    {
+        std::ofstream out(header, std::ios::binary);
+        out << "struct Point { int x = 0; int y = 0; };\n";
+    }
+    std::string block = "#include <string>\n#include \"test_preamble_point.inc\"\n";
+
+    ClangFrontEndOptions options;
+    options.share_preambles = true;
+    ClangFrontEnd frontend(options);
+    const char* names[] = {"Path", "Shape"};
+    for (const char* name : names) {
+        auto source = SourceBuffer::fromString(
+            block + "class " + name + " {\npublic:\n    int count() const { return 1; }\nprivate:\n    Point origin;\n};\n",
+            std::string("test_preamble_") + name + ".cpp");
+        IR ir;
+        std::string error;
+        bool ok = frontend.parse(source, ir, error);
+        if (ClangFrontEnd::isAvailable()) {
+            assert(ok);
+            bool found = false;
+            for (const auto& class_decl : ir.getClasses()) {
+                found = found || class_decl.name == name;
+            }
+            assert(found);
+            (void)found;
+        } else {
+            assert(!ok && !error.empty());
+        }
+        (void)ok;
+    }
+
+    // Both inputs share the one precompiled block
+    assert(frontend.getPreambleCount() == (ClangFrontEnd::isAvailable() ? 1u : 0u));
+
+    std::remove(header.c_str());
+    std::cout << "  ✓ Clang shared preamble test passed\n";
+}
+
+void runAllParserTests() {
+    std::cout << "\nRunning Parser Tests:\n";
+    testLexerTokenKinds();
+    testLexerBlockScanning();
+    testParseClassMembers();
+    testParseIgnoresCommentsAndStrings();
+    testTypesAreInterned();
+    testSymbolIndexes();
+    testBodiesAreSourceSpans();
+    testMappedFileInput();
+    testDeclarationIndex();
+    testIncrementalSession();
+    testSerializedIRRoundTrip();
+    testFusedAnalysisPasses();
+    testOwnershipAnalysis();
+    testProfilerRecordsParserPhases();
+    testClangFrontEndSelection();
+    testClangSharedPreamble();
+    std::cout << "All parser tests passed!\n";
+}
+
+} // namespace test
+} // namespace hybrid
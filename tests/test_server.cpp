@@ -0,0 +1,193 @@
+#include "json.h"
+#include "server.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace hybrid {
+namespace test {
+
+void testJsonRoundTrip() {
+    JsonValue value;
+    std::string error;
+    bool parsed = JsonValue::parse(
+        "{\"id\": 7, \"text\": \"a\\\"b\\n\\u00e9\\ud83d\\ude00\", \"list\": [true, null, -1.5e2]}",
+        value, error);
+    assert(parsed);
+    assert(value["id"].asNumber() == 7);
+    assert(value["text"].asString() == "a\"b\n\xc3\xa9\xf0\x9f\x98\x80");
+    assert(value["list"].items().size() == 3);
+    assert(value["list"].items()[2].asNumber() == -150);
+    assert(value["missing"].isNull());
+
+    assert(value.dump() ==
+           "{\"id\":7,\"text\":\"a\\\"b\\n\xc3\xa9\xf0\x9f\x98\x80\",\"list\":[true,null,-150]}");
+
+    assert(!JsonValue::parse("{\"a\": }", value, error));
+    assert(!JsonValue::parse("[1, 2", value, error));
+    assert(!JsonValue::parse("{} trailing", value, error));
+    std::cout << "  ✓ JSON round trip test passed\n";
+}
+
+JsonValue send(TranspileServer& server, const std::string& request) {
+    JsonValue response;
+    std::string error;
+    bool parsed = JsonValue::parse(server.handleMessage(request), response, error);
+    assert(parsed);
+    (void)parsed;
+    return response;
+}
+
+void testServerHandlesRequests() {
+    TranspilerOptions options;
+    TranspileServer server(options);
+
+    const char* source = "class Point { public: int x; int y; int sum() { return x + y; } };";
+    std::string request = JsonValue::object()
+        .set("jsonrpc", "2.0")
+        .set("id", 1)
+        .set("method", "transpile")
+        .set("params", JsonValue::object().set("source", source).set("path", "point.cpp"))
+        .dump();
+
+    JsonValue first = send(server, request);
+    assert(first["id"].asNumber() == 1);
+    assert(first["result"]["code"].asString().find("pub struct") != std::string::npos);
+    assert(!first["result"]["cached"].asBool());
+
+    // Same source again: answered from the warm in-memory cache
+    JsonValue second = send(server, request);
+    assert(second["result"]["cached"].asBool());
+    assert(second["result"]["code"].asString() == first["result"]["code"].asString());
+
+    // Per-request target override uses a second warm transpiler
+    std::string go_request = JsonValue::object()
+        .set("jsonrpc", "2.0")
+        .set("id", 2)
+        .set("method", "transpile")
+        .set("params", JsonValue::object().set("source", source).set("target", "go"))
+        .dump();
+    JsonValue go = send(server, go_request);
+    assert(go["result"]["code"].asString().find("type Point struct") != std::string::npos);
+
+    // A single declaration comes back without the file header
+    const char* two_classes = "class Point { public: int x; }; class Line { public: int length; };";
+    JsonValue single = send(server, JsonValue::object()
+        .set("jsonrpc", "2.0")
+        .set("id", 7)
+        .set("method", "transpile")
+        .set("params", JsonValue::object().set("source", two_classes).set("declaration", "Line"))
+        .dump());
+    std::string fragment = single["result"]["code"].asString();
+    assert(fragment.find("pub length: i32") != std::string::npos);
+    assert(fragment.find("pub x: i32") == std::string::npos);
+    assert(fragment.find("Auto-generated") == std::string::npos);
+
+    // Errors follow JSON-RPC; notifications get no response
+    JsonValue unknown = send(server, "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"nope\"}");
+    assert(unknown["error"]["code"].asNumber() == -32601);
+    JsonValue malformed = send(server, "{not json");
+    assert(malformed["error"]["code"].asNumber() == -32700);
+    assert(server.handleMessage("{\"jsonrpc\":\"2.0\",\"method\":\"status\"}").empty());
+
+    // Line-oriented stream mode stops after shutdown
+    std::istringstream in("{\"jsonrpc\":\"2.0\",\"id\":4,\"method\":\"status\"}\n"
+                          "\n"
+                          "{\"jsonrpc\":\"2.0\",\"id\":5,\"method\":\"shutdown\"}\n"
+                          "{\"jsonrpc\":\"2.0\",\"id\":6,\"method\":\"status\"}\n");
+    std::ostringstream out;
+    server.serveStream(in, out);
+    assert(server.isShutdownRequested());
+
+    std::istringstream lines(out.str());
+    std::string line;
+    std::getline(lines, line);
+    JsonValue status;
+    std::string error;
+    bool parsed = JsonValue::parse(line, status, error);
+    assert(parsed);
+    assert(status["result"]["cache_hits"].asNumber() == 1);
+    assert(status["result"]["transpiled"].asNumber() == 3);
+    std::getline(lines, line);
+    assert(line.find("\"id\":5") != std::string::npos);
+    assert(!std::getline(lines, line));     // Nothing answered after shutdown
+    std::cout << "  ✓ Server request handling test passed\n";
+}
+
+// One request over a fresh connection to a socket server; the reply line
+std::string requestOverSocket(const std::string& path, const std::string& request) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = -1;
+    for (int attempt = 0; attempt < 200 && fd < 0; ++attempt) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            fd = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));     // Server still starting
+        }
+    }
+    assert(fd >= 0);
+
+    std::string line = request + "\n";
+    ssize_t sent = ::send(fd, line.data(), line.size(), 0);
+    assert(sent == static_cast<ssize_t>(line.size()));
+    (void)sent;
+    std::string reply;
+    char c;
+    while (::recv(fd, &c, 1, 0) == 1 && c != '\n') {
+        reply += c;
+    }
+    ::close(fd);
+    return reply;
+}
+
+void testSocketServerConnections() {
+    std::string path = "test_server_" + std::to_string(::getpid()) + ".sock";
+    TranspilerOptions options;
+    TranspileServer server(options);
+    bool served = false;
+    std::thread listener([&]() {
+        std::string error;
+        served = server.serveSocket(path, error);
+    });
+
+    // Connections come and go; each closed one's worker is joined on the next accept
+    for (int i = 0; i < 16; ++i) {
+        std::string reply = requestOverSocket(path, "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(i) +
+                                                    ",\"method\":\"status\"}");
+        JsonValue status;
+        std::string error;
+        bool parsed = JsonValue::parse(reply, status, error);
+        assert(parsed && status["id"].asNumber() == i);
+        (void)parsed;
+    }
+    std::string reply = requestOverSocket(path, "{\"jsonrpc\":\"2.0\",\"id\":99,\"method\":\"shutdown\"}");
+    assert(reply.find("\"id\":99") != std::string::npos);
+    listener.join();
+    assert(served);
+    assert(::access(path.c_str(), F_OK) != 0);     // Socket file removed on exit
+    std::cout << "  ✓ Socket server connection test passed\n";
+}
+
+void runAllServerTests() {
+    std::cout << "\nRunning Server Tests:\n";
+    testJsonRoundTrip();
+    testServerHandlesRequests();
+    testSocketServerConnections();
+    std::cout << "All server tests passed!\n";
+}
+
+} // namespace test
+} // namespace hybrid
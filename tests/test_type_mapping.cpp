@@ -14,6 +14,26 @@ void testBuiltinTypeMapping() {
     std::cout << "  ✓ Builtin type mapping test passed\n";
 }
 
+void testBuiltinTypeTable() {
+    // The table is usable at compile time
+    static_assert(findBuiltinType("unsigned long long")->size_bytes == 8, "");
+    static_assert(findSTLTypeKind("unordered_map") == TypeKind::StdUnorderedMap, "");
+
+    for (const auto& builtin : kBuiltinTypeNames) {
+        assert(findBuiltinType(builtin.name) == &builtin);
+    }
+    for (const auto& container : kSTLTypeNames) {
+        assert(findSTLTypeKind(container.name) == container.kind);
+    }
+    assert(findBuiltinType("Widget") == nullptr);
+    assert(findBuiltinType("") == nullptr);
+    assert(findSTLTypeKind("std::vector") == TypeKind::Template);
+
+    auto size_type = TypeMapper::mapBuiltinType("size_t");
+    assert(size_type->size_bytes == 8 && size_type->alignment == 8);
+    std::cout << "  ✓ Builtin type table test passed\n";
+}
+
 void testPointerTypeMapping() {
     auto int_type = TypeMapper::mapBuiltinType("int");
     auto ptr_type = TypeMapper::mapPointerType(int_type);
@@ -59,6 +79,7 @@ void testSmartPointerMapping() {
 void runAllTypeMappingTests() {
     std::cout << "\nRunning Type Mapping Tests:\n";
     testBuiltinTypeMapping();
+    testBuiltinTypeTable();
     testPointerTypeMapping();
     testReferenceTypeMapping();
     testArrayTypeMapping();
@@ -0,0 +1,109 @@
+#include "codegen.h"
+#include "file_watcher.h"
+#include "parser.h"
+#include "watch_mode.h"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace hybrid {
+namespace test {
+
+namespace fs = std::filesystem;
+
+fs::path makeTempDir(const std::string& name) {
+    fs::path dir = fs::temp_directory_path() / (name + "_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+void writeText(const fs::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+std::string readText(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+void testFileWatcherSeesChanges() {
+    fs::path dir = makeTempDir("hybrid_watcher_test");
+    FileWatcher watcher;
+    std::string error;
+    bool watching = watcher.watchDirectory(dir.string(), true, error);
+    assert(watching);
+    (void)watching;
+
+    // A subdirectory created after the watch started is watched once its event is read
+    fs::create_directories(dir / "sub");
+    watcher.wait(1000);
+    writeText(dir / "sub" / "a.cpp", "class A {};\n");
+
+    std::string expected = (fs::weakly_canonical(dir) / "sub" / "a.cpp").string();
+    bool seen = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!seen && std::chrono::steady_clock::now() < deadline) {
+        for (const auto& event : watcher.wait(200)) {
+            seen |= event.path == expected;
+        }
+    }
+    assert(seen);
+
+    fs::remove_all(dir);
+    std::cout << "  ✓ File watcher test passed\n";
+}
+
+void testWatchModeRebuildsChangedFiles() {
+    fs::path dir = makeTempDir("hybrid_watch_mode_test");
+    writeText(dir / "a.cpp", "class A { public: int x; };\nclass B { public: int y; };\n");
+    writeText(dir / "b.cpp", "class C { public: int z; };\n");
+
+    TranspilerOptions options;
+    options.quiet = true;
+    WatchMode watch(options, [&](std::vector<std::string>& inputs, std::vector<std::string>& outputs,
+                                 std::string&) {
+        inputs = {(dir / "a.cpp").string(), (dir / "b.cpp").string()};
+        outputs = {(dir / "a.rs").string(), (dir / "b.rs").string()};
+        return true;
+    });
+    std::string error;
+    bool refreshed = watch.refresh(error);
+    assert(refreshed);
+    (void)refreshed;
+
+    std::vector<WatchResult> first = watch.rebuild({});
+    assert(first.size() == 2 && first[0].file.success && first[1].file.success);
+
+    // Only the edited file is rebuilt, and only its edited class reparsed
+    std::string edited = "class A { public: int x; };\nclass B { public: int y; int w; };\n";
+    writeText(dir / "a.cpp", edited);
+    std::vector<WatchResult> second = watch.rebuild({(dir / "a.cpp").string()});
+    assert(second.size() == 1 && second[0].file.success);
+    assert(second[0].reparsed == 1 && second[0].declarations == 2);
+    assert(readText(dir / "a.rs") == RustCodeGenerator().generate(Parser::parseString(edited)));
+
+    // A save without changes is skipped on its content hash
+    std::vector<WatchResult> third = watch.rebuild({(dir / "a.cpp").string(), (dir / "b.cpp").string()});
+    assert(third.size() == 2 && third[0].unchanged && third[1].unchanged);
+
+    fs::remove_all(dir);
+    std::cout << "  ✓ Watch mode rebuild test passed\n";
+}
+
+void runAllWatchTests() {
+    std::cout << "\nRunning Watch Tests:\n";
+    testFileWatcherSeesChanges();
+    testWatchModeRebuildsChangedFiles();
+    std::cout << "All watch tests passed!\n";
+}
+
+} // namespace test
+} // namespace hybrid